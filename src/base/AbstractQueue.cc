@@ -24,6 +24,9 @@ AbstractQueue::AbstractQueue()
 {
     msgServiced = NULL;
     endServiceMsg = NULL;
+    serviceQuantum = 0;
+    exactDepartures = false;
+    departureOffset = 0;
 }
 
 AbstractQueue::~AbstractQueue()
@@ -36,6 +39,7 @@ void AbstractQueue::initialize()
 {
     msgServiced = NULL;
     endServiceMsg = new cMessage("end-service");
+    busyUntil = 0;
     queue.setName("queue");
 }
 
@@ -63,11 +67,45 @@ void AbstractQueue::handleMessage(cMessage *msg)
 
 void AbstractQueue::doStartService()
 {
-    simtime_t serviceTime = startService( msgServiced );
-    if (serviceTime != 0)
-        scheduleAt( simTime()+serviceTime, endServiceMsg );
+    // with zero service time or in batched mode, several (possibly all)
+    // queued packets get processed in this event; we loop instead of
+    // recursing via doEndService() to keep the stack depth constant
+    while (true)
+    {
+        simtime_t now = simTime();
+        simtime_t serviceTime = startService( msgServiced );
+        simtime_t serviceStart = busyUntil > now ? busyUntil : now;
+        busyUntil = serviceStart + serviceTime;
+        if (busyUntil - now > serviceQuantum)
+        {
+            scheduleAt( busyUntil, endServiceMsg );
+            return;
+        }
+
+        if (exactDepartures)
+            departureOffset = busyUntil - now;
+        endService( msgServiced );
+        departureOffset = 0;
+        if (queue.empty())
+        {
+            msgServiced = NULL;
+            return;
+        }
+        msgServiced = queue.pop();
+    }
+}
+
+void AbstractQueue::sendDeparture(cMessage *msg, cGate *outputGate)
+{
+    if (departureOffset > 0)
+        sendDelayed(msg, departureOffset, outputGate);
     else
-        doEndService();
+        send(msg, outputGate);
+}
+
+void AbstractQueue::sendDeparture(cMessage *msg, const char *gateName, int gateIndex)
+{
+    sendDeparture(msg, gate(gateName, gateIndex));
 }
 
 void AbstractQueue::doEndService()
@@ -26,6 +26,22 @@
  * Abstract base class for single-server queues. Contains special
  * optimization for zero service time (i.e. it does not schedule the
  * endService timer then).
+ *
+ * Batched service: if serviceQuantum is set to a positive value, all
+ * packets whose (cumulative) service would end within serviceQuantum of
+ * the current simulation time are completed in the current event, instead
+ * of scheduling an endService timer for each. Service times are still
+ * accumulated exactly (the server stays busy for the sum of the service
+ * times), only departures may happen up to serviceQuantum earlier.
+ * With serviceQuantum=0 (the default) timing is exact.
+ *
+ * Exact departures: if exactDepartures is also set, packets completed
+ * ahead of time in a batch still leave at their exact departure time:
+ * while endService() runs, departureOffset holds the time remaining until
+ * the packet's departure, and subclasses send with sendDeparture(), which
+ * uses sendDelayed(). Only the messages sent this way are delayed; other
+ * side effects of endService() (e.g. method calls into other modules)
+ * happen when the batch is processed.
  */
 class INET_API AbstractQueue : public cSimpleModule
 {
@@ -36,6 +52,7 @@ class INET_API AbstractQueue : public cSimpleModule
   private:
     cPacket *msgServiced;
     cMessage *endServiceMsg;
+    simtime_t busyUntil;  // end of the last service started
 
   private:
     void doStartService();
@@ -47,9 +64,37 @@ class INET_API AbstractQueue : public cSimpleModule
      */
     cPacketQueue queue;
 
+    /**
+     * Packets whose service ends within this interval are completed in the
+     * current event; see class documentation. Zero means exact timing.
+     */
+    simtime_t serviceQuantum;
+
+    /**
+     * If true, packets completed ahead of time by batched service are sent
+     * with their exact departure time; see class documentation.
+     */
+    bool exactDepartures;
+
+    /**
+     * Time until the departure of the packet passed to endService(); zero
+     * unless it was completed ahead of time with exactDepartures set.
+     */
+    simtime_t departureOffset;
+
     virtual void initialize();
     virtual void handleMessage(cMessage *msg);
 
+    /**
+     * Sends a message at the departure time of the packet being serviced,
+     * i.e. with sendDelayed() if departureOffset is nonzero. Subclasses
+     * should use these instead of send() in endService().
+     */
+    //@{
+    void sendDeparture(cMessage *msg, cGate *outputGate);
+    void sendDeparture(cMessage *msg, const char *gateName, int gateIndex=-1);
+    //@}
+
     /** Functions to (re)define behaviour */
 
     //@{
@@ -0,0 +1,47 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_INETHASHMAP_H
+#define __INET_INETHASHMAP_H
+
+//
+// Portable access to the TR1 hash containers. Both GCC (>=4.0) and
+// MSVC (>=2008 SP1) provide std::tr1::unordered_map, only the header
+// location differs.
+//
+
+#include "INETDefs.h"
+
+#ifdef _MSC_VER
+#  include <unordered_map>
+#  include <unordered_set>
+#else
+#  include <tr1/unordered_map>
+#  include <tr1/unordered_set>
+#endif
+
+/**
+ * Mixes v into the hash value h. Use it to build hash functions
+ * for compound keys (e.g. address pairs plus an id).
+ */
+inline size_t inet_hashCombine(size_t h, size_t v)
+{
+    return h ^ (v + 0x9e3779b9 + (h << 6) + (h >> 2));
+}
+
+#endif
+
@@ -36,6 +36,15 @@ class INET_API IPassiveQueue
      * when one becomes available.
      */
     virtual void requestPacket() = 0;
+
+    /**
+     * Removes the next packet from the queue and returns it instead of
+     * sending it. Returns NULL if the queue is empty, or if the queue does
+     * not support this operation (this is the default). The caller must
+     * take ownership of the packet. Used by MACs in packet train mode,
+     * to drain the queue in one event.
+     */
+    virtual cMessage *pop() {return NULL;}
 };
 
 #endif
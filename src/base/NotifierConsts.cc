@@ -50,8 +50,10 @@ const char *notificationCategoryName(int category)
 
         case NF_IPv4_ROUTE_ADDED: return "IPv4-ROUTE-ADD";
         case NF_IPv4_ROUTE_DELETED: return "IPv4-ROUTE-DEL";
+        case NF_IPv4_ROUTES_CHANGED: return "IPv4-ROUTES-CHANGED";
         case NF_IPv6_ROUTE_ADDED: return "IPv6-ROUTE-ADD";
         case NF_IPv6_ROUTE_DELETED: return "IPv6-ROUTE-DEL";
+        case NF_IPv6_ROUTES_CHANGED: return "IPv6-ROUTES-CHANGED";
 
         case NF_IPv6_HANDOVER_OCCURRED: return "IPv6-HANDOVER";
 
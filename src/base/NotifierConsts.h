@@ -66,8 +66,10 @@ enum
     // layer 3 - IPv4
     NF_IPv4_ROUTE_ADDED,
     NF_IPv4_ROUTE_DELETED,
+    NF_IPv4_ROUTES_CHANGED,  // batch of route changes committed (see IRoutingTable::commit())
     NF_IPv6_ROUTE_ADDED,
     NF_IPv6_ROUTE_DELETED,
+    NF_IPv6_ROUTES_CHANGED,  // batch of route changes committed (see RoutingTable6::commit())
 
     // layer 3 - IPv6
     NF_IPv6_HANDOVER_OCCURRED,
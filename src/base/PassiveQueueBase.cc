@@ -71,6 +71,12 @@ void PassiveQueueBase::requestPacket()
     }
 }
 
+cMessage *PassiveQueueBase::pop()
+{
+    Enter_Method("pop()");
+    return dequeue();
+}
+
 void PassiveQueueBase::finish()
 {
     recordScalar("packets received by queue", numQueueReceived);
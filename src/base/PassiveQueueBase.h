@@ -67,6 +67,11 @@ class INET_API PassiveQueueBase : public cSimpleModule, public IPassiveQueue
      * when one becomes available.
      */
     virtual void requestPacket();
+
+    /**
+     * Removes the next packet from the queue and returns it, see IPassiveQueue.
+     */
+    virtual cMessage *pop();
 };
 
 #endif
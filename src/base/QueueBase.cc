@@ -23,6 +23,8 @@ void QueueBase::initialize()
 {
     AbstractQueue::initialize();
     delay = par("procDelay");
+    serviceQuantum = par("serviceQuantum");
+    exactDepartures = par("exactDepartures");
 }
 
 void QueueBase::arrival(cPacket *msg)
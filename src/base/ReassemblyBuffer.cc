@@ -19,6 +19,7 @@
 #include <omnetpp.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include "ReassemblyBuffer.h"
 
 
@@ -42,6 +43,38 @@ bool ReassemblyBuffer::addFragment(ushort beg, ushort end, bool islast)
     return main.beg==0 && main.islast;
 }
 
+static bool regionLess(const std::pair<ushort,ushort>& a, const std::pair<ushort,ushort>& b)
+{
+    return a.first < b.first;
+}
+
+ushort ReassemblyBuffer::getStoredLength() const
+{
+    if (!fragments || fragments->empty())
+        return main.end - main.beg;
+
+    // disjoint fragments may overlap each other or main: count their union
+    std::vector<std::pair<ushort,ushort> > regions;
+    regions.reserve(fragments->size()+1);
+    regions.push_back(std::make_pair(main.beg, main.end));
+    for (RegionVector::const_iterator i=fragments->begin(); i!=fragments->end(); ++i)
+        regions.push_back(std::make_pair(i->beg, i->end));
+    std::sort(regions.begin(), regions.end(), regionLess);
+
+    int length = 0;
+    ushort end = 0;
+    for (unsigned int i=0; i<regions.size(); i++)
+    {
+        ushort beg = std::max(regions[i].first, end);
+        if (regions[i].second > beg)
+        {
+            length += regions[i].second - beg;
+            end = regions[i].second;
+        }
+    }
+    return length;
+}
+
 void ReassemblyBuffer::merge(ushort beg, ushort end, bool islast)
 {
     if (main.end==beg)
@@ -79,6 +79,12 @@ class INET_API ReassemblyBuffer
      * Can only be called after addFragment() returned true.
      */
     ushort getTotalLength() const {return main.end;}
+
+    /**
+     * Returns the number of distinct bytes received so far, i.e. duplicate
+     * and overlapping fragments are only counted once.
+     */
+    ushort getStoredLength() const;
 };
 
 #endif
@@ -33,14 +33,17 @@ class TxNotifDetails : public cPolymorphic
   protected:
     cPacket *msg;
     InterfaceEntry *ie;
+    int numPackets;  // >1 for packet trains: msg is then the first packet of the train
 
   public:
-    TxNotifDetails() {msg=NULL; ie=NULL;}
+    TxNotifDetails() {msg=NULL; ie=NULL; numPackets=1;}
 
     cPacket *getPacket() const {return msg;}
     InterfaceEntry *getInterfaceEntry() const {return ie;}
+    int getNumPackets() const {return numPackets;}
     void setPacket(cPacket *m) {msg = m;}
     void setInterfaceEntry(InterfaceEntry *e) {ie = e;}
+    void setNumPackets(int n) {numPackets = n;}
 };
 
 #endif
@@ -17,6 +17,7 @@
 
 #include "EtherBus.h"
 #include "EtherFrame_m.h"  // for EtherAutoconfig only
+#include "EtherFrameSharing.h"
 
 Define_Module(EtherBus);
 
@@ -155,8 +156,11 @@ void EtherBus::handleMessage (cMessage *msg)
         EV << "Event " << msg << " on tap " << tapPoint << ", sending out frame\n";
 
         // send out on gate
+        // copies share the encapsulated packet (see EtherFrameSharing)
         bool isLast = (direction==UPSTREAM) ? (tapPoint==0) : (tapPoint==taps-1);
-        cPacket *msg2 = isLast ? PK(msg) : PK(msg->dup());
+        if (isLast)
+            EtherFrameSharing::lastCopyForFlooding(PK(msg));
+        cPacket *msg2 = isLast ? PK(msg) : EtherFrameSharing::copyForFlooding(PK(msg));
         send(msg2, "ethg$o", tapPoint);
 
         // if not end of the bus, schedule for next tap
@@ -0,0 +1,134 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <sstream>
+#include "EtherFrameSharing.h"
+
+#ifdef CHECK_SHARED_PAYLOAD
+
+// flood records not completed within this time are discarded
+#define FLOOD_RECORD_TIMEOUT  10.0
+
+EtherFrameSharing::FloodRecords EtherFrameSharing::floodRecords;
+EtherFrameSharing::ExpiryQueue EtherFrameSharing::expiryQueue;
+
+std::string EtherFrameSharing::computeFingerprint(cPacket *frame)
+{
+    // fields inherited from cPacket (ids, timestamps, gates, etc.) are
+    // different in each copy anyway, so we skip them
+    cClassDescriptor *packetDesc = cClassDescriptor::getDescriptorFor("cPacket");
+
+    std::stringstream out;
+    for (cPacket *pk = frame->getEncapsulatedPacket(); pk; pk = pk->getEncapsulatedPacket())
+    {
+        out << pk->getClassName() << " " << pk->getName() << " kind=" << pk->getKind()
+            << " bits=" << pk->getBitLength() << " biterror=" << pk->hasBitError() << " {";
+
+        cClassDescriptor *desc = cClassDescriptor::getDescriptorFor(pk);
+        int firstField = packetDesc ? packetDesc->getFieldCount(pk) : 0;
+        int numFields = desc ? desc->getFieldCount(pk) : 0;
+        for (int i=firstField; i<numFields; i++)
+        {
+            out << " " << desc->getFieldName(pk, i) << "=";
+            if (desc->getFieldTypeFlags(pk, i) & cClassDescriptor::FD_ISARRAY)
+            {
+                int n = desc->getArraySize(pk, i);
+                for (int j=0; j<n; j++)
+                    out << (j==0 ? "[" : ",") << desc->getFieldAsString(pk, i, j);
+                out << "]";
+            }
+            else
+            {
+                out << desc->getFieldAsString(pk, i, 0);
+            }
+        }
+        out << " }\n";
+    }
+    return out.str();
+}
+
+void EtherFrameSharing::registerCopy(cPacket *frame)
+{
+    if (!frame->hasEncapsulatedPacket())
+        return;
+
+    purgeExpiredRecords();
+
+    // compute the fingerprint only at the first copy of the flood: after
+    // that, the payload is already shared, and computing it again would
+    // break the sharing
+    simtime_t now = simTime();
+    FloodRecords::iterator it = floodRecords.find(frame->getTreeId());
+    if (it==floodRecords.end())
+    {
+        FloodRecord& rec = floodRecords[frame->getTreeId()];
+        rec.fingerprint = computeFingerprint(frame);
+        rec.pendingCopies = 1;
+        rec.lastFloodTime = now;
+        expiryQueue.push_back(std::make_pair(now, frame->getTreeId()));
+    }
+    else
+    {
+        FloodRecord& rec = it->second;
+        rec.pendingCopies++;
+        if (rec.lastFloodTime!=now)
+        {
+            // flooded again (e.g. by the next switch): extend its lifetime
+            rec.lastFloodTime = now;
+            expiryQueue.push_back(std::make_pair(now, frame->getTreeId()));
+        }
+    }
+}
+
+void EtherFrameSharing::purgeExpiredRecords()
+{
+    // copies dropped before reaching a MAC never get verified, so their
+    // records would stay forever; discard records that are too old
+    if (!expiryQueue.empty() && expiryQueue.back().first > simTime())
+    {
+        // simulation time went backwards: records are from a previous run
+        floodRecords.clear();
+        expiryQueue.clear();
+    }
+
+    simtime_t limit = simTime() - FLOOD_RECORD_TIMEOUT;
+    while (!expiryQueue.empty() && expiryQueue.front().first < limit)
+    {
+        FloodRecords::iterator it = floodRecords.find(expiryQueue.front().second);
+        if (it!=floodRecords.end() && it->second.lastFloodTime < limit)
+            floodRecords.erase(it);
+        expiryQueue.pop_front();
+    }
+}
+
+void EtherFrameSharing::verifyCopy(cPacket *frame)
+{
+    FloodRecords::iterator it = floodRecords.find(frame->getTreeId());
+    if (it==floodRecords.end())
+        return;  // not a flooded frame
+
+    FloodRecord& rec = it->second;
+    if (computeFingerprint(frame)!=rec.fingerprint)
+        opp_error("shared payload of flooded frame (%s)%s has been modified after flooding",
+                  frame->getClassName(), frame->getFullName());
+
+    if (--rec.pendingCopies==0)
+        floodRecords.erase(it);
+}
+
+#endif
+
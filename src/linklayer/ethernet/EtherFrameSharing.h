@@ -0,0 +1,113 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_ETHERFRAMESHARING_H
+#define __INET_ETHERFRAMESHARING_H
+
+#include <map>
+#include <deque>
+#include <string>
+#include <omnetpp.h>
+#include "INETDefs.h"
+
+
+/**
+ * Utility functions for flooding a frame on several ports (switches,
+ * hubs, buses) without deep-copying its contents for every port.
+ *
+ * cPacket::dup() does not copy the encapsulated packet but shares it among
+ * the copies (reference counting). A copy gets its own private instance of
+ * the payload only when it is accessed via getEncapsulatedPacket() or
+ * decapsulate() (copy-on-write). So as long as the flooding component and
+ * the MACs leave the payload alone, a flooded frame costs one outer frame
+ * object per port, and only stations that actually accept the frame pay for
+ * copying its payload.
+ *
+ * Accidental mutation of a shared payload can be caught by compiling
+ * with CHECK_SHARED_PAYLOAD defined (normally undefined). Then every flood
+ * records a fingerprint of the payload (all fields of all encapsulated
+ * packets, obtained via class descriptors), and every copy is verified
+ * against it when it is received from the network by an Ethernet MAC.
+ * The check is expensive: computing the fingerprint of a copy makes
+ * a private copy of its payload. Copies may also be dropped before they
+ * reach a MAC (queue overflow, disabled port, etc.), so records are
+ * expired FLOOD_RECORD_TIMEOUT after the last flood of the frame; copies
+ * that arrive later than that are simply not checked.
+ */
+class INET_API EtherFrameSharing
+{
+  protected:
+#ifdef CHECK_SHARED_PAYLOAD
+    struct FloodRecord
+    {
+        std::string fingerprint;
+        int pendingCopies;
+        simtime_t lastFloodTime;
+    };
+    typedef std::map<long, FloodRecord> FloodRecords; // key: message tree id
+    static FloodRecords floodRecords;
+
+    // (flood time, tree id) pairs in flood time order, for expiring records
+    typedef std::deque<std::pair<simtime_t, long> > ExpiryQueue;
+    static ExpiryQueue expiryQueue;
+
+    static std::string computeFingerprint(cPacket *frame);
+    static void purgeExpiredRecords();
+#endif
+
+  public:
+    /**
+     * Returns a copy of the frame to be sent on another port. The copy
+     * shares the encapsulated packet with the original.
+     */
+    static cPacket *copyForFlooding(cPacket *frame) {
+#ifdef CHECK_SHARED_PAYLOAD
+        registerCopy(frame);
+#endif
+        return frame->dup();
+    }
+
+    /**
+     * To be called for the last port of a flood, where the original frame
+     * itself is sent out. Does nothing unless CHECK_SHARED_PAYLOAD is defined.
+     */
+    static void lastCopyForFlooding(cPacket *frame) {
+#ifdef CHECK_SHARED_PAYLOAD
+        registerCopy(frame);
+#endif
+    }
+
+    /**
+     * Verifies that the payload of a frame received from the network is
+     * the same as it was when the frame was flooded. Does nothing unless
+     * CHECK_SHARED_PAYLOAD is defined.
+     */
+    static void checkReceivedFrame(cPacket *frame) {
+#ifdef CHECK_SHARED_PAYLOAD
+        verifyCopy(frame);
+#endif
+    }
+
+#ifdef CHECK_SHARED_PAYLOAD
+  protected:
+    static void registerCopy(cPacket *frame);
+    static void verifyCopy(cPacket *frame);
+#endif
+};
+
+#endif
+
@@ -17,6 +17,7 @@
 
 #include "EtherHub.h"
 #include "EtherFrame_m.h"  // for EtherAutoconfig only
+#include "EtherFrameSharing.h"
 
 
 Define_Module(EtherHub);
@@ -62,8 +63,11 @@ void EtherHub::handleMessage(cMessage *msg)
     {
         if (i!=arrivalPort)
         {
+            // copies share the encapsulated packet (see EtherFrameSharing)
             bool isLast = (arrivalPort==ports-1) ? (i==ports-2) : (i==ports-1);
-            cMessage *msg2 = isLast ? msg : (cMessage*) msg->dup();
+            if (isLast)
+                EtherFrameSharing::lastCopyForFlooding(PK(msg));
+            cMessage *msg2 = isLast ? msg : EtherFrameSharing::copyForFlooding(PK(msg));
             send(msg2,"ethg$o",i);
         }
     }
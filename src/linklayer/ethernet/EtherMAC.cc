@@ -36,6 +36,8 @@ Define_Module( EtherMAC );
 EtherMAC::EtherMAC()
 {
     frameBeingReceived = NULL;
+    curTxFrameBytes = 0;
+    curTxFrameIsPause = false;
     endJammingMsg = endRxMsg = endBackoffMsg = NULL;
 }
 
@@ -55,6 +57,8 @@ void EtherMAC::initialize()
     endBackoffMsg = new cMessage("EndBackoff", ENDBACKOFF);
     endJammingMsg = new cMessage("EndJamming", ENDJAMMING);
 
+    duplexTxPath = par("duplexTxPath");
+
     // check: datarate is forbidden with EtherMAC -- module's txrate must be used
     cGate *g = physOutGate;
     while (g)
@@ -271,7 +275,13 @@ void EtherMAC::processFrameFromUpperLayer(EtherFrame *frame)
 {
     EtherMACBase::processFrameFromUpperLayer(frame);
 
-    if (!autoconfigInProgress && (duplexMode || receiveState==RX_IDLE_STATE) && transmitState==TX_IDLE_STATE)
+    if (!autoconfigInProgress && duplexMode && duplexTxPath && transmitState==TX_IDLE_STATE)
+    {
+        // no need for a separate end-of-IFG event: send the frame with IFG delay
+        EV << "Full duplex, frame clear to send after IFG\n";
+        startDuplexFrameTransmission(interFrameGap);
+    }
+    else if (!autoconfigInProgress && receiveState==RX_IDLE_STATE && transmitState==TX_IDLE_STATE)
     {
         EV << "No incoming carrier signals detected, frame clear to send, wait IFG first\n";
         scheduleEndIFGPeriod();
@@ -411,6 +421,12 @@ void EtherMAC::handleEndIFGPeriod()
 
 void EtherMAC::startFrameTransmission()
 {
+    if (duplexMode && duplexTxPath)
+    {
+        startDuplexFrameTransmission(0);
+        return;
+    }
+
     cPacket *origFrame = (cPacket *)txQueue.front();
     EV << "Transmitting a copy of frame " << origFrame << endl;
     cPacket *frame = origFrame->dup();
@@ -462,8 +478,71 @@ void EtherMAC::startFrameTransmission()
     }
 }
 
+void EtherMAC::startDuplexFrameTransmission(simtime_t delay)
+{
+    // In full-duplex mode there are no collisions, so the frame will never
+    // need to be retransmitted: we can send the original instead of a copy,
+    // and only remember its length for the statistics.
+    cPacket *frame = (cPacket *)txQueue.pop();
+    EV << "Transmitting frame " << frame << endl;
+
+    curTxFrameBytes = frame->getByteLength();
+    curTxFrameIsPause = dynamic_cast<EtherPauseFrame*>(frame)!=NULL;
+
+    // update burst variables; a nonzero delay means IFG, i.e. a new burst
+    if (frameBursting)
+    {
+        if (delay>0)
+        {
+            framesSentInBurst = 0;
+            bytesSentInBurst = 0;
+        }
+        bytesSentInBurst = curTxFrameBytes;
+        framesSentInBurst++;
+    }
+
+    // add preamble and SFD (Starting Frame Delimiter), then send out
+    frame->addByteLength(PREAMBLE_BYTES+SFD_BYTES);
+    if (ev.isGUI())  updateConnectionColor(TRANSMITTING_STATE);
+    sendDelayed(frame, delay, physOutGate);
+
+    scheduleAt(simTime()+delay+frame->getBitLength()*bitTime, endTxMsg);
+    transmitState = TRANSMITTING_STATE;
+}
+
+void EtherMAC::handleEndDuplexTxPeriod()
+{
+    if (transmitState!=TRANSMITTING_STATE)
+        error("End of transmission, and incorrect state detected");
+
+    updateTxStatistics(curTxFrameBytes, curTxFrameIsPause);
+    EV << "Transmission of frame successfully completed\n";
+
+    // check for and obey received PAUSE frames after each transmission
+    if (checkAndScheduleEndPausePeriod())
+        return;
+
+    if (txQueue.empty())
+    {
+        // go idle, and ask the queue module for more frames
+        beginSendFrames();
+        return;
+    }
+
+    // Gigabit Ethernet: transmit next frame right away if it fits in the burst
+    // (see FIXME in handleEndTxPeriod()), otherwise after IFG
+    bool burstFrame = frameBursting && bytesSentInBurst<GIGABIT_MAX_BURST_BYTES;
+    startDuplexFrameTransmission(burstFrame ? SIMTIME_ZERO : interFrameGap);
+}
+
 void EtherMAC::handleEndTxPeriod()
 {
+    if (duplexMode && duplexTxPath)
+    {
+        handleEndDuplexTxPeriod();
+        return;
+    }
+
     EtherMACBase::handleEndTxPeriod();
 
     // only count transmissions in totalSuccessfulRxTxTime if channel is half-duplex
@@ -56,6 +56,14 @@ class INET_API EtherMAC : public EtherMACBase
     int  backoffs;          // Value of backoff for exponential back-off algorithm
     int  numConcurrentTransmissions; // number of colliding frames -- we must receive this many jams
 
+    // if true, full-duplex mode uses its own transmit path (see startDuplexFrameTransmission())
+    bool duplexTxPath;
+
+    // frame under transmission in full-duplex mode (the frame itself is
+    // already in the channel, we only remember what statistics need)
+    long curTxFrameBytes;
+    bool curTxFrameIsPause;
+
     // other variables
     EtherFrame *frameBeingReceived;
     cMessage *endRxMsg, *endBackoffMsg, *endJammingMsg;
@@ -89,6 +97,10 @@ class INET_API EtherMAC : public EtherMACBase
     virtual void handleRetransmission();
     virtual void startFrameTransmission();
 
+    // full-duplex transmit path: no copies, no collision handling
+    virtual void startDuplexFrameTransmission(simtime_t delay);
+    virtual void handleEndDuplexTxPeriod();
+
     // notifications
     virtual void updateHasSubcribers();
 };
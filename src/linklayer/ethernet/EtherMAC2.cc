@@ -27,12 +27,18 @@ Define_Module(EtherMAC2);
 
 EtherMAC2::EtherMAC2()
 {
+    maxTrainLength = 1;
+    trainLength = 0;
 }
 
 void EtherMAC2::initialize()
 {
     EtherMACBase::initialize();
 
+    maxTrainLength = par("maxTrainLength");
+    if (maxTrainLength<1)
+        error("maxTrainLength must be at least 1");
+
     duplexMode = true;
     calculateParameters();
 
@@ -89,6 +95,12 @@ void EtherMAC2::handleMessage(cMessage *msg)
 
 void EtherMAC2::startFrameTransmission()
 {
+    if (maxTrainLength>1)
+    {
+        startFrameTrain(0);
+        return;
+    }
+
     EtherFrame *origFrame = (EtherFrame *)txQueue.front();
     EV << "Transmitting a copy of frame " << origFrame << endl;
 
@@ -99,6 +111,7 @@ void EtherMAC2::startFrameTransmission()
     {
         // fire notification
         notifDetails.setPacket(frame);
+        notifDetails.setNumPackets(1);
         nb->fireChangeNotification(NF_PP_TX_BEGIN, &notifDetails);
     }
 
@@ -119,6 +132,64 @@ void EtherMAC2::startFrameTransmission()
     }
 }
 
+void EtherMAC2::startFrameTrain(simtime_t delay)
+{
+    // Packet train: take all frames waiting for transmission (up to
+    // maxTrainLength), and send them at once with sendDelayed(), each one
+    // an IFG after the previous one has left. Arrival times at the peer
+    // are the same as with one-by-one transmission, but the train costs only
+    // one end-of-transmission event. Frames are sent out themselves, not
+    // copies: there are no collisions, so they never need to be retransmitted.
+    simtime_t now = simTime();
+    simtime_t startTime = now + delay;
+    EtherFrame *firstFrame = NULL;
+    trainLength = 0;
+    while (true)
+    {
+        EtherFrame *frame = (EtherFrame *)txQueue.pop();
+        if (!firstFrame)
+            firstFrame = frame;
+
+        // statistics are updated now, as we won't see the frame again
+        updateTxStatistics(frame->getByteLength(), dynamic_cast<EtherPauseFrame*>(frame)!=NULL);
+
+        // add preamble and SFD, then send
+        frame->addByteLength(PREAMBLE_BYTES+SFD_BYTES);
+        EV << "Starting transmission of " << frame << " (" << trainLength+1 << ". frame of packet train)\n";
+        sendDelayed(frame, startTime-now, physOutGate);
+        startTime += frame->getBitLength()*bitTime;
+        trainLength++;
+
+        if (trainLength>=maxTrainLength || (txQueue.empty() && !pullFrameFromQueueModule()))
+            break;
+        startTime += interFrameGap;
+    }
+
+    if (hasSubscribers)
+    {
+        // fire a single notification for the whole train
+        notifDetails.setPacket(firstFrame);
+        notifDetails.setNumPackets(trainLength);
+        nb->fireChangeNotification(NF_PP_TX_BEGIN, &notifDetails);
+    }
+
+    // startTime is now the end of the last frame
+    scheduleAt(startTime, endTxMsg);
+    transmitState = TRANSMITTING_STATE;
+}
+
+bool EtherMAC2::pullFrameFromQueueModule()
+{
+    if (!queueModule)
+        return false;
+    cMessage *msg = queueModule->pop();
+    if (!msg)
+        return false;
+    take(msg);
+    EtherMACBase::processFrameFromUpperLayer(check_and_cast<EtherFrame *>(msg));
+    return true;
+}
+
 void EtherMAC2::processFrameFromUpperLayer(EtherFrame *frame)
 {
     EtherMACBase::processFrameFromUpperLayer(frame);
@@ -136,6 +207,7 @@ void EtherMAC2::processMsgFromNetwork(cPacket *msg)
     {
         // fire notification
         notifDetails.setPacket(frame);
+        notifDetails.setNumPackets(1);
         nb->fireChangeNotification(NF_PP_RX_END, &notifDetails);
     }
 
@@ -152,10 +224,34 @@ void EtherMAC2::handleEndIFGPeriod()
 
 void EtherMAC2::handleEndTxPeriod()
 {
+    if (maxTrainLength>1)
+    {
+        // end of packet train: frames are already accounted for
+        if (hasSubscribers)
+        {
+            notifDetails.setPacket(NULL);
+            notifDetails.setNumPackets(trainLength);
+            nb->fireChangeNotification(NF_PP_TX_END, &notifDetails);
+        }
+        trainLength = 0;
+
+        if (checkAndScheduleEndPausePeriod())
+            return;
+
+        // continue with the next train after the IFG, without
+        // a separate end-of-IFG event
+        if (!txQueue.empty() || pullFrameFromQueueModule())
+            startFrameTrain(interFrameGap);
+        else
+            beginSendFrames();  // go idle and ask the queue module for more
+        return;
+    }
+
     if (hasSubscribers)
     {
         // fire notification
         notifDetails.setPacket((cPacket *)txQueue.front());
+        notifDetails.setNumPackets(1);
         nb->fireChangeNotification(NF_PP_TX_END, &notifDetails);
     }
 
@@ -34,6 +34,10 @@ class INET_API EtherMAC2 : public EtherMACBase
   public:
     EtherMAC2();
 
+  protected:
+    int maxTrainLength;  // max number of frames sent in one go; 1 means no packet trains
+    int trainLength;     // number of frames in the train being transmitted
+
   protected:
     virtual void initialize();
     virtual void initializeTxrate();
@@ -46,6 +50,10 @@ class INET_API EtherMAC2 : public EtherMACBase
     virtual void handleEndIFGPeriod();
     virtual void handleEndTxPeriod();
 
+    // packet trains
+    virtual void startFrameTrain(simtime_t delay);
+    virtual bool pullFrameFromQueueModule();
+
     // notifications
     virtual void updateHasSubcribers();
 };
@@ -20,6 +20,7 @@
 #include <string.h>
 #include <omnetpp.h>
 #include "EtherMACBase.h"
+#include "EtherFrameSharing.h"
 #include "IPassiveQueue.h"
 #include "IInterfaceTable.h"
 #include "InterfaceTableAccess.h"
@@ -344,6 +345,10 @@ void EtherMACBase::processMsgFromNetwork(cPacket *frame)
               "(%lgs corresponds to an approx. %lgm cable)",
               SIMTIME_STR(simTime() - frame->getSendingTime()),
               SIMTIME_STR((simTime() - frame->getSendingTime())*SPEED_OF_LIGHT));
+
+    // catch modification of payloads shared by flooded frames (no-op unless
+    // compiled with CHECK_SHARED_PAYLOAD)
+    EtherFrameSharing::checkReceivedFrame(frame);
 }
 
 void EtherMACBase::frameReceptionComplete(EtherFrame *frame)
@@ -458,20 +463,24 @@ void EtherMACBase::handleEndTxPeriod()
 
     // get frame from buffer
     cPacket *frame = (cPacket *)txQueue.pop();
+    updateTxStatistics(frame->getByteLength(), dynamic_cast<EtherPauseFrame*>(frame)!=NULL);
+
+    EV << "Transmission of " << frame << " successfully completed\n";
+    delete frame;
+}
 
+void EtherMACBase::updateTxStatistics(long bytes, bool isPauseFrame)
+{
     numFramesSent++;
-    numBytesSent += frame->getByteLength();
+    numBytesSent += bytes;
     numFramesSentVector.record(numFramesSent);
     numBytesSentVector.record(numBytesSent);
 
-    if (dynamic_cast<EtherPauseFrame*>(frame)!=NULL)
+    if (isPauseFrame)
     {
         numPauseFramesSent++;
         numPauseFramesSentVector.record(numPauseFramesSent);
     }
-
-    EV << "Transmission of " << frame << " successfully completed\n";
-    delete frame;
 }
 
 void EtherMACBase::handleEndPausePeriod()
@@ -163,6 +163,7 @@ class INET_API EtherMACBase : public cSimpleModule, public INotifiable
 
     // helpers
     virtual bool checkAndScheduleEndPausePeriod();
+    virtual void updateTxStatistics(long bytes, bool isPauseFrame);
     virtual void fireChangeNotification(int type, cPacket *msg);
     virtual void beginSendFrames();
     virtual void frameReceptionComplete(EtherFrame *frame);
@@ -19,6 +19,7 @@
 #include "MACAddress.h"
 #include "EtherFrame_m.h"
 #include "Ethernet.h"
+#include "EtherFrameSharing.h"
 
 
 #define MAX_LINE 100
@@ -122,10 +123,19 @@ void MACRelayUnitBase::handleAndDispatchFrame(EtherFrame *frame, int inputport)
 
 void MACRelayUnitBase::broadcastFrame(EtherFrame *frame, int inputport)
 {
-    for (int i=0; i<numPorts; ++i)
+    // copies share the encapsulated packet (see EtherFrameSharing);
+    // the original frame goes out on the last port
+    int lastport = (inputport==numPorts-1) ? numPorts-2 : numPorts-1;
+    if (lastport<0)
+    {
+        delete frame;
+        return;
+    }
+    for (int i=0; i<lastport; ++i)
         if (i!=inputport)
-            send((EtherFrame*)frame->dup(), "lowerLayerOut", i);
-    delete frame;
+            send((EtherFrame*)EtherFrameSharing::copyForFlooding(frame), "lowerLayerOut", i);
+    EtherFrameSharing::lastCopyForFlooding(frame);
+    send(frame, "lowerLayerOut", lastport);
 }
 
 void MACRelayUnitBase::printAddressTable()
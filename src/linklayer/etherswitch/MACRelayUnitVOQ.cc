@@ -0,0 +1,339 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "MACRelayUnitVOQ.h"
+#include "EtherFrame_m.h"
+#include "EtherFrameSharing.h"
+#include "Ethernet.h"
+#include "MACAddress.h"
+
+
+Define_Module( MACRelayUnitVOQ );
+
+
+MACRelayUnitVOQ::MACRelayUnitVOQ()
+{
+    scheduleMsg = NULL;
+}
+
+MACRelayUnitVOQ::~MACRelayUnitVOQ()
+{
+    cancelAndDelete(scheduleMsg);
+    for (unsigned int i=0; i<queues.size(); i++)
+        for (FrameQueue::iterator it=queues[i].begin(); it!=queues[i].end(); ++it)
+            delete *it;
+}
+
+void MACRelayUnitVOQ::initialize()
+{
+    MACRelayUnitBase::initialize();
+
+    const char *schedulerName = par("scheduler");
+    if (!strcmp(schedulerName, "iSLIP"))
+        scheduler = ISLIP;
+    else if (!strcmp(schedulerName, "sharedBuffer"))
+        scheduler = SHARED_BUFFER;
+    else
+        error("invalid scheduler '%s', must be \"iSLIP\" or \"sharedBuffer\"", schedulerName);
+
+    iSLIPIterations = par("iSLIPIterations");
+    if (iSLIPIterations<1)
+        error("iSLIPIterations must be at least 1");
+    fabricDatarate = par("fabricDatarate");
+    if (fabricDatarate<=0)
+        error("fabricDatarate must be positive");
+    maxBurstFrames = par("maxBurstFrames");
+    if (maxBurstFrames<1)
+        error("maxBurstFrames must be at least 1");
+
+    bufferSize = par("bufferSize");
+    highWatermark = par("highWatermark");
+    pauseUnits = par("pauseUnits");
+
+    // 1 pause unit is 512 bit times; we assume the ports run at fabric speed.
+    // We send a pause again when previous one is about to expire.
+    pauseInterval = pauseUnits*512.0/fabricDatarate;
+
+    queues.resize(scheduler==ISLIP ? numPorts*numPorts : numPorts);
+    inputBusyUntil.resize(numPorts, 0);
+    outputBusyUntil.resize(numPorts, 0);
+    grantPointer.resize(numPorts, 0);
+    acceptPointer.resize(numPorts, 0);
+    inputMatch.resize(numPorts, -1);
+    outputMatch.resize(numPorts, -1);
+    outputGrant.resize(numPorts, -1);
+
+    scheduleMsg = new cMessage("scheduleFabric");
+
+    bufferUsed = 0;
+    WATCH(bufferUsed);
+    pauseLastSent = 0;
+    WATCH(pauseLastSent);
+
+    numProcessedFrames = numDroppedFrames = numSchedulingRounds = 0;
+    WATCH(numProcessedFrames);
+    WATCH(numDroppedFrames);
+    WATCH(numSchedulingRounds);
+    bufferLevel.setName("buffer level");
+
+    EV << "Parameters of (" << getClassName() << ") " << getFullPath() << "\n";
+    EV << "scheduler: " << schedulerName << "\n";
+    EV << "fabric datarate: " << fabricDatarate << "\n";
+    EV << "max burst: " << maxBurstFrames << " frames\n";
+    EV << "ports: " << numPorts << "\n";
+    EV << "buffer size: " << bufferSize << "\n";
+    EV << "address table size: " << addressTableSize << "\n";
+    EV << "aging time: " << agingTime << "\n";
+    EV << "high watermark: " << highWatermark << "\n";
+    EV << "pause time: " << pauseUnits << "\n";
+    EV << "\n";
+}
+
+void MACRelayUnitVOQ::handleMessage(cMessage *msg)
+{
+    if (msg==scheduleMsg)
+        scheduleFabric();
+    else
+        handleIncomingFrame(check_and_cast<EtherFrame *>(msg));
+}
+
+void MACRelayUnitVOQ::handleIncomingFrame(EtherFrame *frame)
+{
+    int inputport = frame->getArrivalGate()->getIndex();
+
+    // address lookup is done on arrival, as we need to know the output port
+    // to select the virtual output queue
+    updateTableWithAddress(frame->getSrc(), inputport);
+    int outputport = frame->getDest().isBroadcast() ? -1 : getPortForAddress(frame->getDest());
+
+    if (outputport==inputport)
+    {
+        EV << "Output port is same as input port, " << frame->getFullName() <<
+              " dest " << frame->getDest() << ", discarding frame\n";
+        delete frame;
+        return;
+    }
+
+    // broadcast and unknown destination: one copy for every other port
+    long length = frame->getByteLength();
+    int numCopies = (outputport>=0) ? 1 : numPorts-1;
+    if (numCopies==0)
+    {
+        delete frame;
+        return;
+    }
+    if (bufferUsed + numCopies*length > bufferSize)
+    {
+        EV << "Buffer full, dropping frame " << frame << endl;
+        delete frame;
+        ++numDroppedFrames;
+        return;
+    }
+
+    if (outputport>=0)
+    {
+        EV << "Frame " << frame << " with dest address " << frame->getDest() << " queued for port " << outputport << endl;
+        enqueueFrame(frame, inputport, outputport);
+    }
+    else
+    {
+        EV << "Dest address " << frame->getDest() << " unknown or broadcast, queueing frame " << frame << " for all ports\n";
+
+        // copies share the encapsulated packet (see EtherFrameSharing);
+        // the original frame goes into the last port's queue
+        int lastport = (inputport==numPorts-1) ? numPorts-2 : numPorts-1;
+        for (int i=0; i<lastport; i++)
+            if (i!=inputport)
+                enqueueFrame((EtherFrame *)EtherFrameSharing::copyForFlooding(frame), inputport, i);
+        EtherFrameSharing::lastCopyForFlooding(frame);
+        enqueueFrame(frame, inputport, lastport);
+    }
+
+    bufferUsed += numCopies*length;
+    bufferLevel.record(bufferUsed);
+    checkPause();
+
+    // run the scheduler now, unless the ports involved are busy anyway
+    // and the next round is already scheduled
+    simtime_t now = simTime();
+    if (!scheduleMsg->isScheduled())
+    {
+        scheduleAt(now, scheduleMsg);
+    }
+    else if (scheduleMsg->getArrivalTime()>now &&
+             (scheduler==SHARED_BUFFER || inputBusyUntil[inputport]<=now) &&
+             (outputport<0 || outputBusyUntil[outputport]<=now))
+    {
+        cancelEvent(scheduleMsg);
+        scheduleAt(now, scheduleMsg);
+    }
+}
+
+void MACRelayUnitVOQ::enqueueFrame(EtherFrame *frame, int inputport, int outputport)
+{
+    queues[queueIndex(inputport, outputport)].push_back(frame);
+}
+
+void MACRelayUnitVOQ::scheduleFabric()
+{
+    numSchedulingRounds++;
+    simtime_t now = simTime();
+
+    if (scheduler==ISLIP)
+    {
+        computeISLIPMatching();
+        for (int i=0; i<numPorts; i++)
+            if (inputMatch[i]>=0)
+                transferBurst(queues[queueIndex(i, inputMatch[i])], i, inputMatch[i]);
+    }
+    else
+    {
+        // shared buffer: every free output serves its own queue, there's
+        // no constraint on the input side
+        for (int o=0; o<numPorts; o++)
+            if (outputBusyUntil[o]<=now && !queues[o].empty())
+                transferBurst(queues[o], -1, o);
+    }
+
+    scheduleNextRound();
+}
+
+void MACRelayUnitVOQ::computeISLIPMatching()
+{
+    simtime_t now = simTime();
+
+    for (int i=0; i<numPorts; i++)
+        inputMatch[i] = outputMatch[i] = -1;
+
+    for (int iter=0; iter<iSLIPIterations; iter++)
+    {
+        // request + grant: every free unmatched output grants the first free
+        // unmatched input (in round-robin order, starting from its grant
+        // pointer) that has a frame queued for it
+        bool anyGrant = false;
+        for (int o=0; o<numPorts; o++)
+        {
+            outputGrant[o] = -1;
+            if (outputMatch[o]>=0 || outputBusyUntil[o]>now)
+                continue;
+            for (int k=0; k<numPorts; k++)
+            {
+                int i = (grantPointer[o]+k) % numPorts;
+                if (inputMatch[i]<0 && inputBusyUntil[i]<=now && !queues[i*numPorts+o].empty())
+                {
+                    outputGrant[o] = i;
+                    anyGrant = true;
+                    break;
+                }
+            }
+        }
+        if (!anyGrant)
+            break;
+
+        // accept: every input accepts the first granting output, in round-robin
+        // order starting from its accept pointer. Pointers are only updated in
+        // the first iteration, which is what makes iSLIP starvation-free.
+        for (int i=0; i<numPorts; i++)
+        {
+            if (inputMatch[i]>=0 || inputBusyUntil[i]>now)
+                continue;
+            for (int k=0; k<numPorts; k++)
+            {
+                int o = (acceptPointer[i]+k) % numPorts;
+                if (outputGrant[o]==i)
+                {
+                    inputMatch[i] = o;
+                    outputMatch[o] = i;
+                    if (iter==0)
+                    {
+                        grantPointer[o] = (i+1) % numPorts;
+                        acceptPointer[i] = (o+1) % numPorts;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void MACRelayUnitVOQ::transferBurst(FrameQueue& queue, int inputport, int outputport)
+{
+    // Transfer back-to-back frames in one go: each frame is handed over to
+    // the output MAC at the time its transfer through the fabric completes,
+    // but that's done with sendDelayed() so it costs no extra events here.
+    simtime_t now = simTime();
+    simtime_t t = now;
+    for (int k=0; k<maxBurstFrames && !queue.empty(); k++)
+    {
+        EtherFrame *frame = queue.front();
+        queue.pop_front();
+
+        t += frame->getBitLength() / fabricDatarate;
+        bufferUsed -= frame->getByteLength();
+        numProcessedFrames++;
+
+        EV << "Sending frame " << frame << " with dest address " << frame->getDest() << " to port " << outputport << endl;
+        sendDelayed(frame, t-now, "lowerLayerOut", outputport);
+    }
+    bufferLevel.record(bufferUsed);
+
+    outputBusyUntil[outputport] = t;
+    if (inputport>=0)
+        inputBusyUntil[inputport] = t;
+}
+
+void MACRelayUnitVOQ::scheduleNextRound()
+{
+    // nothing to do if there are no frames waiting
+    if (bufferUsed==0)
+        return;
+
+    // frames are waiting, so some port must be busy (otherwise
+    // the round would have started a transfer for them)
+    simtime_t now = simTime();
+    simtime_t next = MAXTIME;
+    for (int p=0; p<numPorts; p++)
+    {
+        if (outputBusyUntil[p]>now && outputBusyUntil[p]<next)
+            next = outputBusyUntil[p];
+        if (inputBusyUntil[p]>now && inputBusyUntil[p]<next)
+            next = inputBusyUntil[p];
+    }
+    ASSERT(next<MAXTIME);
+    scheduleAt(next, scheduleMsg);
+}
+
+void MACRelayUnitVOQ::checkPause()
+{
+    // send PAUSE on all ports if above watermark
+    if (pauseUnits>0 && highWatermark>0 && bufferUsed>=highWatermark && simTime()-pauseLastSent>pauseInterval)
+    {
+        for (int i=0; i<numPorts; i++)
+            sendPauseFrame(i, pauseUnits);
+        pauseLastSent = simTime();
+    }
+}
+
+void MACRelayUnitVOQ::finish()
+{
+    recordScalar("processed frames", numProcessedFrames);
+    recordScalar("dropped frames", numDroppedFrames);
+    recordScalar("scheduling rounds", numSchedulingRounds);
+    if (numSchedulingRounds>0)
+        recordScalar("frames per round", numProcessedFrames/(double)numSchedulingRounds);
+}
+
@@ -0,0 +1,129 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_MACRELAYUNITVOQ_H
+#define __INET_MACRELAYUNITVOQ_H
+
+#include <deque>
+#include <vector>
+#include "MACRelayUnitBase.h"
+
+class EtherFrame;
+
+/**
+ * MAC relay unit modelling a crossbar switch fabric, with virtual output
+ * queues and iSLIP scheduling, or a shared-buffer (output queued) fabric.
+ * See the NED file for details.
+ */
+class INET_API MACRelayUnitVOQ : public MACRelayUnitBase
+{
+  public:
+    MACRelayUnitVOQ();
+    virtual ~MACRelayUnitVOQ();
+
+  protected:
+    enum Scheduler {ISLIP, SHARED_BUFFER};
+
+    typedef std::deque<EtherFrame *> FrameQueue;
+
+    // parameters
+    Scheduler scheduler;
+    int iSLIPIterations;        // number of request-grant-accept iterations
+    double fabricDatarate;      // per-port speed of the fabric, bit/s
+    int maxBurstFrames;         // max frames transferred per queue in one scheduling round
+    long bufferSize;            // max size of the buffer
+    long highWatermark;         // if buffer goes above this level, send PAUSE frames
+    int pauseUnits;             // "units" field in PAUSE frames
+    simtime_t pauseInterval;    // min time between sending PAUSE frames
+
+    // queues: iSLIP: one per (input, output) pair, at index input*numPorts+output;
+    // shared buffer: one per output
+    std::vector<FrameQueue> queues;
+
+    // fabric state
+    std::vector<simtime_t> inputBusyUntil;
+    std::vector<simtime_t> outputBusyUntil;
+    std::vector<int> grantPointer;   // iSLIP round-robin pointer, per output
+    std::vector<int> acceptPointer;  // iSLIP round-robin pointer, per input
+    std::vector<int> inputMatch;     // scratch: output matched with input, or -1
+    std::vector<int> outputMatch;    // scratch: input matched with output, or -1
+    std::vector<int> outputGrant;    // scratch: input granted by output, or -1
+    cMessage *scheduleMsg;
+
+    // other variables
+    long bufferUsed;
+    simtime_t pauseLastSent;
+
+    // statistics
+    long numProcessedFrames;
+    long numDroppedFrames;
+    long numSchedulingRounds;
+    cOutVector bufferLevel;
+
+  protected:
+    virtual void initialize();
+    virtual void handleMessage(cMessage *msg);
+    virtual void finish();
+
+    /**
+     * Looks up the output port(s) of the frame, and stores it in the
+     * queue(s), or drops it if there's not enough buffer space.
+     */
+    virtual void handleIncomingFrame(EtherFrame *frame);
+
+    /**
+     * Stores the frame in the queue for the given input-output pair.
+     */
+    virtual void enqueueFrame(EtherFrame *frame, int inputport, int outputport);
+
+    /**
+     * Computes a matching between free inputs and free outputs, and starts
+     * the transfer on the matched pairs.
+     */
+    virtual void scheduleFabric();
+
+    /**
+     * iSLIP matching between free inputs and free outputs; result is
+     * in inputMatch[] and outputMatch[].
+     */
+    virtual void computeISLIPMatching();
+
+    /**
+     * Transfers up to maxBurstFrames frames from the given queue to
+     * the output port, and marks the input and output port busy until
+     * the transfer completes.
+     */
+    virtual void transferBurst(FrameQueue& queue, int inputport, int outputport);
+
+    /**
+     * Schedules the next scheduling round at the time the next busy port
+     * becomes free.
+     */
+    virtual void scheduleNextRound();
+
+    /**
+     * Sends PAUSE frames if the buffer level is above the high watermark.
+     */
+    virtual void checkPause();
+
+    int queueIndex(int inputport, int outputport) const {
+        return scheduler==ISLIP ? inputport*numPorts+outputport : outputport;
+    }
+};
+
+#endif
+
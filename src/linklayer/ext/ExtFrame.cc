@@ -0,0 +1,38 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "ExtFrame.h"
+
+void ExtFrame::setDataFromBuffer(const void *ptr, unsigned int length)
+{
+    if (length != data_arraysize)
+    {
+        delete[] data_var;
+        data_var = length ? new uint8[length] : NULL;
+        data_arraysize = length;
+    }
+    if (length)
+        memcpy(data_var, ptr, length);
+}
+
+void ExtFrame::copyDataToBuffer(void *ptr, unsigned int length) const
+{
+    ASSERT(length <= data_arraysize);
+
+    if (length)
+        memcpy(ptr, data_var, length);
+}
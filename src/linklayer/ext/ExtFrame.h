@@ -0,0 +1,47 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_EXTFRAME_H
+#define __INET_EXTFRAME_H
+
+#include "ExtFrame_m.h"
+
+/**
+ * Raw bytes of an IP packet captured by cSocketRTScheduler. Adds bulk
+ * access to the data[] array, so that frames don't need to be filled
+ * and read one byte at a time.
+ */
+class ExtFrame : public ExtFrame_Base
+{
+  public:
+    ExtFrame(const char *name=NULL, int kind=0) : ExtFrame_Base(name,kind) {}
+    ExtFrame(const ExtFrame& other) : ExtFrame_Base(other.getName()) {operator=(other);}
+    ExtFrame& operator=(const ExtFrame& other) {ExtFrame_Base::operator=(other); return *this;}
+    virtual ExtFrame *dup() const {return new ExtFrame(*this);}
+
+    /**
+     * Replaces the contents of the data[] array with the given bytes.
+     */
+    virtual void setDataFromBuffer(const void *ptr, unsigned int length);
+
+    /**
+     * Copies the first length bytes of the data[] array into the buffer.
+     */
+    virtual void copyDataToBuffer(void *ptr, unsigned int length) const;
+};
+
+#endif
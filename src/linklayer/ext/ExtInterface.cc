@@ -44,13 +44,19 @@ void ExtInterface::initialize(int stage)
             device = par("device");
             //const char *filter = ev.config()->getAsString("Capture", "filter-string", "ip");
             const char *filter = par("filterString");
-            rtScheduler->setInterfaceModule(this, device, filter);
+            const char *replayFile = par("replayFile");
+            replaying = replayFile[0] != '\0';
+            if (replaying)
+                rtScheduler->setReplayInterfaceModule(this, replayFile, filter);
+            else
+                rtScheduler->setInterfaceModule(this, device, filter);
             connected = true;
         }
         else
         {
             // this simulation run works without external interface..
             connected = false;
+            replaying = false;
         }
     }
 
@@ -113,8 +119,14 @@ void ExtInterface::handleMessage(cMessage *msg)
         ExtFrame *rawPacket = check_and_cast<ExtFrame *>(msg);
 
         packetLength = rawPacket->getDataArraySize();
-        for(uint32 i=0; i < packetLength; i++)
-            buffer[i] = rawPacket->getData(i);
+        if (packetLength > sizeof(buffer))
+        {
+            EV << "Captured packet of " << packetLength << " bytes is too long, dropping it.\n";
+            numDropped++;
+            delete msg;
+            return;
+        }
+        rawPacket->copyDataToBuffer(buffer, packetLength);
 
         IPDatagram *ipPacket = new IPDatagram("ip-from-wire");
         IPSerializer().parse(buffer, packetLength, (IPDatagram *)ipPacket);
@@ -130,7 +142,6 @@ void ExtInterface::handleMessage(cMessage *msg)
     }
     else
     {
-        memset(buffer, 0, 1<<16);
         IPDatagram *ipPacket = check_and_cast<IPDatagram *>(msg);
 
         if ((ipPacket->getTransportProtocol() != IP_PROT_ICMP) &&
@@ -161,7 +172,8 @@ void ExtInterface::handleMessage(cMessage *msg)
                << " and length of "
                << ipPacket->getByteLength()
                << " bytes to link layer.\n";
-            rtScheduler->sendBytes(buffer, packetLength, (struct sockaddr *) &addr, sizeof(struct sockaddr_in));
+            if (!replaying)
+                rtScheduler->sendBytes(buffer, packetLength, (struct sockaddr *) &addr, sizeof(struct sockaddr_in));
             numSent++;
         }
         else
@@ -194,7 +206,9 @@ void ExtInterface::updateDisplayString()
     char buf[80];
     if (ev.disable_tracing)
         getDisplayString().setTagArg("t",0,"");
-    if(connected)
+    if (replaying)
+        sprintf(buf, "replaying pcap file\nrcv:%d snt:%d", numRcvd, numSent);
+    else if(connected)
         sprintf(buf, "pcap device: %s\nrcv:%d snt:%d", device, numRcvd, numSent);
     else
         sprintf(buf, "not connected");
@@ -27,7 +27,7 @@
 #endif
 
 #include <omnetpp.h>
-#include "ExtFrame_m.h"
+#include "ExtFrame.h"
 #include "cSocketRTScheduler.h"
 #include "IPDatagram.h"
 
@@ -40,6 +40,7 @@ class ExtInterface : public cSimpleModule
 {
   protected:
     bool connected;
+    bool replaying;   // packets come from a pcap file, nothing is sent to the wire
     uint8 buffer[1<<16];
     const char *device;
 
@@ -29,18 +29,31 @@
 
 #include <headers/ethernet.h>
 
+#ifdef LINUX
+#include <sys/epoll.h>
+#endif
+
 #if defined(_WIN32) || defined(__WIN32__) || defined(WIN32) || defined(__CYGWIN__) || defined(_WIN64)
 #include <ws2tcpip.h>
 #endif
 
 #define PCAP_SNAPLEN 65536 /* capture all data packets with up to pcap_snaplen bytes */
 #define PCAP_TIMEOUT 10    /* Timeout in ms */
+#define MAX_SEND_DELAY 1000 /* max time an outgoing packet may wait for the batch to fill up, in us */
+
+Register_PerRunConfigOption(CFGID_SOCKETRTSCHEDULER_REALTIME, "socketrtscheduler-realtime", CFG_BOOL, "true", "When cSocketRTScheduler is selected as scheduler class: whether to synchronize the simulation to the wall clock. Turning it off only makes sense if all external interfaces replay pcap files.");
+Register_PerRunConfigOption(CFGID_SOCKETRTSCHEDULER_BATCH_SIZE, "socketrtscheduler-batch-size", CFG_INT, "64", "When cSocketRTScheduler is selected as scheduler class: max number of packets read from a capture device at once, and max number of packets sent with one system call.");
+Register_PerRunConfigOption(CFGID_SOCKETRTSCHEDULER_PCAP_BUFFER_SIZE, "socketrtscheduler-pcap-buffer-size", CFG_INT, "0", "When cSocketRTScheduler is selected as scheduler class: size of the capture buffer (ring buffer on Linux) in bytes; 0 means libpcap's default.");
 
 #ifdef HAVE_PCAP
 std::vector<cModule *>cSocketRTScheduler::modules;
 std::vector<pcap_t *>cSocketRTScheduler::pds;
 std::vector<int32>cSocketRTScheduler::datalinks;
 std::vector<int32>cSocketRTScheduler::headerLengths;
+std::vector<int32>cSocketRTScheduler::fds;
+std::vector<timeval>cSocketRTScheduler::replayStartTimes;
+std::vector<simtime_t>cSocketRTScheduler::replayLastTimes;
+std::vector<long>cSocketRTScheduler::replayCounts;
 #endif
 timeval cSocketRTScheduler::baseTime;
 
@@ -55,6 +68,15 @@ inline std::ostream& operator<<(std::ostream& out, const timeval& tv)
 cSocketRTScheduler::cSocketRTScheduler() : cScheduler()
 {
     fd = INVALID_SOCKET;
+    realtime = true;
+    batchSize = 1;
+    pcapBufferSize = 0;
+    numPendingSends = 0;
+#ifdef HAVE_PCAP
+#ifdef LINUX
+    epollFd = -1;
+#endif
+#endif
 }
 
 cSocketRTScheduler::~cSocketRTScheduler()
@@ -63,35 +85,63 @@ cSocketRTScheduler::~cSocketRTScheduler()
 
 void cSocketRTScheduler::startRun()
 {
-#ifdef HAVE_PCAP
-    const int32 on = 1;
-
-#endif
     gettimeofday(&baseTime, NULL);
+
+    realtime = ev.getConfig()->getAsBool(CFGID_SOCKETRTSCHEDULER_REALTIME);
+    batchSize = ev.getConfig()->getAsInt(CFGID_SOCKETRTSCHEDULER_BATCH_SIZE);
+    if (batchSize < 1)
+        throw cRuntimeError("cSocketRTScheduler: socketrtscheduler-batch-size must be at least 1");
+    pcapBufferSize = ev.getConfig()->getAsInt(CFGID_SOCKETRTSCHEDULER_PCAP_BUFFER_SIZE);
+
+    pendingSends.resize(batchSize);
+    numPendingSends = 0;
+
 #ifdef HAVE_PCAP
-    // Enabling sending makes no sense when we can't receive...
+#ifdef LINUX
+    epollFd = epoll_create(16);
+    if (epollFd < 0)
+        throw cRuntimeError("cSocketRTScheduler: epoll_create() failed: %s", strerror(errno));
+#endif
+#endif
+}
+
+void cSocketRTScheduler::openRawSocket()
+{
+    // Enabling sending makes no sense when we can't receive, so the raw
+    // socket is opened together with the first live capture device
+    const int32 on = 1;
     fd = socket(AF_INET, SOCK_RAW, IPPROTO_RAW);
     if (fd == INVALID_SOCKET)
         throw cRuntimeError("cSocketRTScheduler: Root priviledges needed");
     if (setsockopt(fd, IPPROTO_IP, IP_HDRINCL, (char *)&on, sizeof(on)) < 0)
         throw cRuntimeError("cSocketRTScheduler: couldn't set sockopt for raw socket");
-#endif
 }
 
-
 void cSocketRTScheduler::endRun()
 {
 #ifdef HAVE_PCAP
     pcap_stat ps;
 
 #endif
-    close(fd);
+    if (fd != INVALID_SOCKET)
+    {
+        flushSends();
+        close(fd);
+    }
     fd = INVALID_SOCKET;
+    numPendingSends = 0;
 #ifdef HAVE_PCAP
+#ifdef LINUX
+    if (epollFd >= 0)
+        close(epollFd);
+    epollFd = -1;
+#endif
 
     for (uint16 i=0; i<pds.size(); i++)
     {
-        if (pcap_stats(pds.at(i), &ps) < 0)
+        if (fds.at(i) < 0)
+            EV << modules.at(i)->getFullPath() << ": Replayed Packets: " << replayCounts.at(i) << ".\n";
+        else if (pcap_stats(pds.at(i), &ps) < 0)
             throw cRuntimeError("cSocketRTScheduler::endRun(): Can not get pcap statistics: %s", pcap_geterr(pds.at(i)));
         else
             EV << modules.at(i)->getFullPath() << ": Received Packets: " << ps.ps_recv << " Dropped Packets: " << ps.ps_drop << ".\n";
@@ -100,9 +150,12 @@ void cSocketRTScheduler::endRun()
 
     pds.clear();
     modules.clear();
-    pds.clear();
     datalinks.clear();
     headerLengths.clear();
+    fds.clear();
+    replayStartTimes.clear();
+    replayLastTimes.clear();
+    replayCounts.clear();
 #endif
 }
 
@@ -112,61 +165,100 @@ void cSocketRTScheduler::executionResumed()
     baseTime = timeval_substract(baseTime, sim->getSimTime().dbl());
 }
 
+#ifdef HAVE_PCAP
+static int32 getHeaderLength(int32 datalink)
+{
+    switch (datalink) {
+    case DLT_NULL:
+        return 4;
+    case DLT_EN10MB:
+        return 14;
+    case DLT_SLIP:
+        return 24;
+    case DLT_PPP:
+        return 24;
+    default:
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Unsupported datalink: %d", datalink);
+    }
+}
+
+static void setFilter(pcap_t *pd, const char *filter)
+{
+    struct bpf_program fcode;
+
+    /* compile this command into a filter program */
+    if (pcap_compile(pd, &fcode, (char *)filter, 0, 0) < 0)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Can not compile filter: %s", pcap_geterr(pd));
+
+    /* apply the compiled filter to the packet capture device */
+    if (pcap_setfilter(pd, &fcode) < 0)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Can not apply compiled filter: %s", pcap_geterr(pd));
+    pcap_freecode(&fcode);
+}
+#endif
+
 void cSocketRTScheduler::setInterfaceModule(cModule *mod, const char *dev, const char *filter)
 {
 #ifdef HAVE_PCAP
     char errbuf[PCAP_ERRBUF_SIZE];
-    struct bpf_program fcode;
     pcap_t * pd;
     int32 datalink;
     int32 headerLength;
+    int32 selectableFd;
 
     if (!mod || !dev || !filter)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): arguments must be non-NULL");
+    if (!realtime)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): live capture on %s requires socketrtscheduler-realtime=true", dev);
 
-    /* get pcap handle */
+    /* get pcap handle; with a large enough buffer, libpcap on Linux
+       captures into a memory-mapped ring that is read without copying */
     memset(&errbuf, 0, sizeof(errbuf));
-    if ((pd = pcap_open_live(dev, PCAP_SNAPLEN, 0, PCAP_TIMEOUT, errbuf)) == NULL)
+    if ((pd = pcap_create(dev, errbuf)) == NULL)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Can not open pcap device, error = %s", errbuf);
-    else if(strlen(errbuf) > 0)
-        EV << "cSocketRTScheduler::setInterfaceModule: pcap_open_live returned waring: " << errbuf << "\n";
-
-    /* compile this command into a filter program */
-    if (pcap_compile(pd, &fcode, (char *)filter, 0, 0) < 0)
-        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Can not compile filter: %s", pcap_geterr(pd));
-
-    /* apply the compiled filter to the packet capture device */
-    if (pcap_setfilter(pd, &fcode) < 0)
-        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Can not apply compiled filter: %s", pcap_geterr(pd));
+    pcap_set_snaplen(pd, PCAP_SNAPLEN);
+    pcap_set_promisc(pd, 0);
+    pcap_set_timeout(pd, PCAP_TIMEOUT);
+    if (pcapBufferSize > 0 && pcap_set_buffer_size(pd, pcapBufferSize) != 0)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Can not set pcap buffer size: %s", pcap_geterr(pd));
+    int status = pcap_activate(pd);
+    if (status < 0)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Can not open pcap device, error = %s", pcap_geterr(pd));
+    else if (status > 0)
+        EV << "cSocketRTScheduler::setInterfaceModule: pcap_activate returned warning: " << pcap_geterr(pd) << "\n";
+
+    setFilter(pd, filter);
 
     if ((datalink = pcap_datalink(pd)) < 0)
         throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Can not get datalink: %s", pcap_geterr(pd));
 
-#ifndef LINUX
+    // packets are read in batches until there are no more, so reads must not block
     if (pcap_setnonblock(pd, 1, errbuf) < 0)
         throw cRuntimeError("cSocketRTScheduler::pcap_setnonblock(): Can not put pcap device into non-blocking mode, error = %s", errbuf);
+
+    headerLength = getHeaderLength(datalink);
+    selectableFd = pcap_get_selectable_fd(pd);
+
+#ifdef LINUX
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u32 = pds.size();
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, selectableFd, &event) < 0)
+        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): epoll_ctl() failed: %s", strerror(errno));
 #endif
 
-    switch (datalink) {
-    case DLT_NULL:
-        headerLength = 4;
-        break;
-    case DLT_EN10MB:
-        headerLength = 14;
-        break;
-    case DLT_SLIP:
-        headerLength = 24;
-        break;
-    case DLT_PPP:
-        headerLength = 24;
-        break;
-    default:
-        throw cRuntimeError("cSocketRTScheduler::setInterfaceModule(): Unsupported datalink: %d", datalink);
-    }
     modules.push_back(mod);
     pds.push_back(pd);
     datalinks.push_back(datalink);
     headerLengths.push_back(headerLength);
+    fds.push_back(selectableFd);
+    replayStartTimes.push_back(timeval());
+    replayLastTimes.push_back(0.0);
+    replayCounts.push_back(0);
+
+    if (fd == INVALID_SOCKET)
+        openRawSocket();
 
     EV << "Opened pcap device " << dev << " with filter " << filter << " and datalink " << datalink << ".\n";
 #else
@@ -174,45 +266,129 @@ void cSocketRTScheduler::setInterfaceModule(cModule *mod, const char *dev, const
 #endif
 }
 
-#ifdef HAVE_PCAP
-static void packet_handler(u_char *user, const struct pcap_pkthdr *hdr, const u_char *bytes)
+void cSocketRTScheduler::setReplayInterfaceModule(cModule *mod, const char *fileName, const char *filter)
 {
-    unsigned i;
-    int32 headerLength;
+#ifdef HAVE_PCAP
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t * pd;
     int32 datalink;
-    cModule *module;
-    struct ether_header *ethernet_hdr;
 
-    i = *(uint16 *)user;
-    datalink = cSocketRTScheduler::datalinks.at(i);
-    headerLength = cSocketRTScheduler::headerLengths.at(i);
-    module = cSocketRTScheduler::modules.at(i);
+    if (!mod || !fileName || !filter)
+        throw cRuntimeError("cSocketRTScheduler::setReplayInterfaceModule(): arguments must be non-NULL");
+
+    memset(&errbuf, 0, sizeof(errbuf));
+    if ((pd = pcap_open_offline(fileName, errbuf)) == NULL)
+        throw cRuntimeError("cSocketRTScheduler::setReplayInterfaceModule(): Can not open pcap file %s, error = %s", fileName, errbuf);
+
+    setFilter(pd, filter);
+
+    if ((datalink = pcap_datalink(pd)) < 0)
+        throw cRuntimeError("cSocketRTScheduler::setReplayInterfaceModule(): Can not get datalink: %s", pcap_geterr(pd));
+
+    modules.push_back(mod);
+    pds.push_back(pd);
+    datalinks.push_back(datalink);
+    headerLengths.push_back(getHeaderLength(datalink));
+    fds.push_back(-1);
+    replayStartTimes.push_back(timeval());
+    replayLastTimes.push_back(-1.0);
+    replayCounts.push_back(0);
+
+    EV << "Opened pcap file " << fileName << " with filter " << filter << " and datalink " << datalink << " for replay.\n";
+#else
+    throw cRuntimeError("cSocketRTScheduler::setReplayInterfaceModule(): pcap not supported");
+#endif
+}
+
+#ifdef HAVE_PCAP
+static ExtFrame *createFrame(size_t i, const struct pcap_pkthdr *hdr, const u_char *bytes)
+{
+    int32 headerLength = cSocketRTScheduler::headerLengths.at(i);
+    int32 datalink = cSocketRTScheduler::datalinks.at(i);
+
+    if (hdr->caplen <= (bpf_u_int32)headerLength)
+        return NULL;
 
     // skip ethernet frames not encapsulating an IP packet.
     if (datalink == DLT_EN10MB)
     {
-        ethernet_hdr = (struct ether_header *)bytes;
+        struct ether_header *ethernet_hdr = (struct ether_header *)bytes;
         if (ntohs(ethernet_hdr->ether_type) != ETHERTYPE_IP)
-            return;
+            return NULL;
     }
 
     // put the IP packet from wire into data[] array of ExtFrame
     ExtFrame *notificationMsg = new ExtFrame("rtEvent");
-    notificationMsg->setDataArraySize(hdr->caplen - headerLength);
-    for (uint16 j=0; j< hdr->caplen - headerLength; j++)
-        notificationMsg->setData(j, bytes[j + headerLength]);
+    notificationMsg->setDataFromBuffer(bytes + headerLength, hdr->caplen - headerLength);
+    return notificationMsg;
+}
 
-    // signalize new incoming packet to the interface via cMessage
-    EV << "Captured " << hdr->caplen - headerLength << " bytes for an IP packet.\n";
-    timeval curTime;
-    gettimeofday(&curTime, NULL);
-    curTime = timeval_substract(curTime, cSocketRTScheduler::baseTime);
-    simtime_t t = curTime.tv_sec + curTime.tv_usec*1e-6;
-    // TBD assert that it's somehow not smaller than previous event's time
-    notificationMsg->setArrival(module, -1, t);
+static void packet_handler(u_char *user, const struct pcap_pkthdr *hdr, const u_char *bytes)
+{
+    size_t i = *(size_t *)user;
+    ExtFrame *notificationMsg = createFrame(i, hdr, bytes);
+    if (!notificationMsg)
+        return;
+
+    // signalize new incoming packet to the interface via cMessage. The
+    // capture timestamp is used, as the packet may have waited in the capture
+    // buffer while the rest of the batch was processed; but the arrival time
+    // cannot be earlier than the event being executed.
+    EV << "Captured " << notificationMsg->getDataArraySize() << " bytes for an IP packet.\n";
+    timeval captureTime = timeval_substract(hdr->ts, cSocketRTScheduler::baseTime);
+    simtime_t t = captureTime.tv_sec + captureTime.tv_usec*1e-6;
+    if (t < simulation.getSimTime())
+        t = simulation.getSimTime();
+    notificationMsg->setArrival(cSocketRTScheduler::modules.at(i), -1, t);
 
     simulation.msgQueue.insert(notificationMsg);
 }
+
+void cSocketRTScheduler::replayPackets()
+{
+    // Keep every replay source ahead of the event to be executed next: insert
+    // packets from the file until the last one inserted is later than that
+    for (size_t i = 0; i < pds.size(); i++)
+    {
+        if (fds[i] != -1)
+            continue;  // live device, or end of file reached
+        cMessage *first = sim->msgQueue.peekFirst();
+        while (!first || replayLastTimes[i] <= first->getArrivalTime())
+        {
+            struct pcap_pkthdr *hdr;
+            const u_char *bytes;
+            int result = pcap_next_ex(pds[i], &hdr, &bytes);
+            if (result == -2)
+            {
+                // end of file: pcap handle is kept open for statistics, but not read again
+                EV << modules[i]->getFullPath() << ": end of replay file\n";
+                fds[i] = -2;
+                break;
+            }
+            if (result < 0)
+                throw cRuntimeError("cSocketRTScheduler::replayPackets(): An error occured: %s", pcap_geterr(pds[i]));
+
+            if (replayCounts[i] == 0 && replayLastTimes[i] < 0)
+                replayStartTimes[i] = hdr->ts;
+            timeval offset = timeval_substract(hdr->ts, replayStartTimes[i]);
+            simtime_t t = offset.tv_sec + offset.tv_usec*1e-6;
+            if (t < replayLastTimes[i])
+                t = replayLastTimes[i];  // timestamps going backwards
+            replayLastTimes[i] = t;
+
+            ExtFrame *notificationMsg = createFrame(i, hdr, bytes);
+            if (notificationMsg)
+            {
+                if (t < sim->getSimTime())
+                    t = sim->getSimTime();
+                notificationMsg->setArrival(modules[i], -1, t);
+                sim->msgQueue.insert(notificationMsg);
+                replayCounts[i]++;
+            }
+            first = sim->msgQueue.peekFirst();
+        }
+    }
+}
 #endif
 
 bool cSocketRTScheduler::receiveWithTimeout()
@@ -222,8 +398,8 @@ bool cSocketRTScheduler::receiveWithTimeout()
 #ifdef HAVE_PCAP
     int32 n;
 #ifdef LINUX
-    int32 fd[FD_SETSIZE], maxfd;
-    fd_set rdfds;
+    struct epoll_event events[16];
+    int32 numEvents;
 #endif
 #endif
 
@@ -232,32 +408,29 @@ bool cSocketRTScheduler::receiveWithTimeout()
     timeout.tv_usec = PCAP_TIMEOUT * 1000;
 #ifdef HAVE_PCAP
 #ifdef LINUX
-    FD_ZERO(&rdfds);
-    maxfd = -1;
-    for (uint16 i = 0; i < pds.size(); i++)
-    {
-        fd[i] = pcap_get_selectable_fd(pds.at(i));
-        if (fd[i] > maxfd)
-            maxfd = fd[i];
-        FD_SET(fd[i], &rdfds);
-    }
-    if (select(maxfd + 1, &rdfds, NULL, NULL, &timeout) < 0)
-    {
+    // wait for any of the capture devices, then read a batch from each ready
+    // one; if there are more packets, epoll will return immediately next time
+    numEvents = epoll_wait(epollFd, events, 16, PCAP_TIMEOUT);
+    if (numEvents < 0)
         return found;
+    for (int32 k = 0; k < numEvents; k++)
+    {
+        size_t i = events[k].data.u32;
+        if ((n = pcap_dispatch(pds.at(i), batchSize, packet_handler, (uint8 *)&i)) < 0)
+            throw cRuntimeError("cSocketRTScheduler::pcap_dispatch(): An error occurred: %s", pcap_geterr(pds.at(i)));
+        if (n > 0)
+            found = true;
     }
-#endif
-    for (uint16 i = 0; i < pds.size(); i++)
+#else
+    for (size_t i = 0; i < pds.size(); i++)
     {
-#ifdef LINUX
-        if (!(FD_ISSET(fd[i], &rdfds)))
-            continue;
-#endif
-        if ((n = pcap_dispatch(pds.at(i), 1, packet_handler, (uint8 *)&i)) < 0)
-            throw cRuntimeError("cSocketRTScheduler::pcap_dispatch(): An error occired: %s", pcap_geterr(pds.at(i)));
+        if (fds[i] < 0)
+            continue;  // replayed from file
+        if ((n = pcap_dispatch(pds.at(i), batchSize, packet_handler, (uint8 *)&i)) < 0)
+            throw cRuntimeError("cSocketRTScheduler::pcap_dispatch(): An error occurred: %s", pcap_geterr(pds.at(i)));
         if (n > 0)
             found = true;
     }
-#ifndef LINUX
     if (!found)
         select(0, NULL, NULL, NULL, &timeout);
 #endif
@@ -288,8 +461,20 @@ cMessage *cSocketRTScheduler::getNextEvent()
 {
     timeval targetTime, curTime, diffTime;
 
+#ifdef HAVE_PCAP
+    replayPackets();
+#endif
+
     // calculate target time
     cMessage *msg = sim->msgQueue.peekFirst();
+    if (!realtime)
+    {
+        // replay only: run as fast as possible
+        if (!msg)
+            throw cTerminationException(eENDEDOK);
+        return msg;
+    }
+
     if (!msg)
     {
         targetTime.tv_sec = LONG_MAX;
@@ -304,6 +489,9 @@ cMessage *cSocketRTScheduler::getNextEvent()
     gettimeofday(&curTime, NULL);
     if (timeval_greater(targetTime, curTime))
     {
+        // nothing to do until the next event: good time to send out what we have
+        flushSends();
+
         int32 status = receiveUntil(targetTime);
         if (status == -1)
             return NULL; // interrupted by user
@@ -316,6 +504,14 @@ cMessage *cSocketRTScheduler::getNextEvent()
         // alert if we're too much behind, whatever that means
         diffTime = timeval_substract(curTime, targetTime);
         EV << "We are behind: " << diffTime.tv_sec + diffTime.tv_usec * 1e-6 << " seconds\n";
+
+        // don't let outgoing packets wait for too long
+        if (numPendingSends > 0)
+        {
+            diffTime = timeval_substract(curTime, firstPendingSendTime);
+            if (diffTime.tv_sec > 0 || diffTime.tv_usec > MAX_SEND_DELAY)
+                flushSends();
+        }
     }
     return msg;
 }
@@ -324,11 +520,73 @@ void cSocketRTScheduler::sendBytes(uint8 *buf, size_t numBytes, struct sockaddr
 {
     if (fd == INVALID_SOCKET)
         throw cRuntimeError("cSocketRTScheduler::sendBytes(): no raw socket.");
+    if (addrlen > sizeof(sockaddr_storage))
+        throw cRuntimeError("cSocketRTScheduler::sendBytes(): address too long.");
+
+    // store a copy; buffers are reused, so this doesn't allocate in the long run
+    if (numPendingSends == 0)
+        gettimeofday(&firstPendingSendTime, NULL);
+    PendingSend& pending = pendingSends[numPendingSends++];
+    pending.data.assign(buf, buf + numBytes);
+    memcpy(&pending.to, to, addrlen);
+    pending.addrlen = addrlen;
+
+    if (numPendingSends == batchSize)
+        flushSends();
+}
 
-    int sent = sendto(fd, (char *)buf, numBytes, 0, to, addrlen);  //note: no ssize_t on MSVC
+void cSocketRTScheduler::flushSends()
+{
+    if (numPendingSends == 0)
+        return;
 
-    if (sent == numBytes)
-        EV << "Sent an IP packet with length of " << sent << " bytes.\n";
-    else
-        EV << "Sending of an IP packet FAILED! (sendto returned " << sent << " (" << strerror(errno) << ") instead of " << numBytes << ").\n";
+#ifdef LINUX
+    // hand over the whole batch with as few system calls as possible
+    std::vector<struct mmsghdr> msgs(numPendingSends);
+    std::vector<struct iovec> iovecs(numPendingSends);
+    for (int i = 0; i < numPendingSends; i++)
+    {
+        iovecs[i].iov_base = &pendingSends[i].data[0];
+        iovecs[i].iov_len = pendingSends[i].data.size();
+        memset(&msgs[i], 0, sizeof(struct mmsghdr));
+        msgs[i].msg_hdr.msg_name = &pendingSends[i].to;
+        msgs[i].msg_hdr.msg_namelen = pendingSends[i].addrlen;
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int i = 0;
+    while (i < numPendingSends)
+    {
+        int n = sendmmsg(fd, &msgs[i], numPendingSends - i, 0);
+        if (n <= 0)
+        {
+            // sending the first packet of the rest failed: report and skip it
+            EV << "Sending of an IP packet FAILED! (sendmmsg returned " << n << " (" << strerror(errno) << ") for " << pendingSends[i].data.size() << " bytes).\n";
+            i++;
+            continue;
+        }
+        for (int k = i; k < i + n; k++)
+        {
+            if (msgs[k].msg_len == pendingSends[k].data.size())
+                EV << "Sent an IP packet with length of " << msgs[k].msg_len << " bytes.\n";
+            else
+                EV << "Sending of an IP packet FAILED! (sent " << msgs[k].msg_len << " bytes instead of " << pendingSends[k].data.size() << ").\n";
+        }
+        i += n;
+    }
+#else
+    for (int i = 0; i < numPendingSends; i++)
+    {
+        PendingSend& pending = pendingSends[i];
+        size_t numBytes = pending.data.size();
+        int sent = sendto(fd, (char *)&pending.data[0], numBytes, 0, (struct sockaddr *)&pending.to, pending.addrlen);  //note: no ssize_t on MSVC
+
+        if (sent == numBytes)
+            EV << "Sent an IP packet with length of " << sent << " bytes.\n";
+        else
+            EV << "Sending of an IP packet FAILED! (sendto returned " << sent << " (" << strerror(errno) << ") instead of " << numBytes << ").\n";
+    }
+#endif
+    numPendingSends = 0;
 }
@@ -35,15 +35,63 @@
 #ifdef HAVE_PCAP
 #include <pcap.h>
 #endif
-#include "ExtFrame_m.h"
+#include "ExtFrame.h"
 
+/**
+ * Real-time scheduler that exchanges IP packets with real networks:
+ * packets are captured with libpcap on the devices registered by
+ * ExtInterface modules, and sent out via a raw socket.
+ *
+ * Capture devices are drained in batches of up to
+ * "socketrtscheduler-batch-size" packets per wakeup (on Linux, readiness is
+ * waited for with epoll). With libpcap versions that support it, capture on
+ * Linux goes through a memory-mapped ring buffer; its size can be set with
+ * "socketrtscheduler-pcap-buffer-size". Outgoing packets are collected and
+ * sent in batches (with sendmmsg() on Linux) before the scheduler waits for
+ * the next event, when the batch is full, or when the oldest one has waited
+ * for more than a millisecond.
+ *
+ * Instead of a live device, packets can also be replayed from a pcap file
+ * (see ExtInterface's replayFile parameter). Replayed packets arrive at the
+ * simulation time of their capture timestamp, measured from the first packet
+ * in the file. With "socketrtscheduler-realtime=false" the scheduler does not
+ * synchronize to the wall clock, so replay runs as fast as possible; this is
+ * useful for benchmarking. Live capture requires real-time mode.
+ */
 class cSocketRTScheduler : public cScheduler
 {
     protected:
         int fd;
 
+        // configuration
+        bool realtime;
+        int batchSize;
+        int pcapBufferSize;
+
+#ifdef HAVE_PCAP
+#ifdef LINUX
+        int epollFd;
+#endif
+#endif
+
+        // outgoing packets not yet handed over to the raw socket
+        struct PendingSend
+        {
+            std::vector<uint8> data;
+            sockaddr_storage to;
+            socklen_t addrlen;
+        };
+        std::vector<PendingSend> pendingSends;
+        int numPendingSends;
+        timeval firstPendingSendTime;
+
         virtual bool receiveWithTimeout();
         virtual int receiveUntil(const timeval& targetTime);
+        virtual void openRawSocket();
+        virtual void flushSends();
+#ifdef HAVE_PCAP
+        virtual void replayPackets();
+#endif
     public:
         /**
          * Constructor.
@@ -59,6 +107,10 @@ class cSocketRTScheduler : public cScheduler
         static std::vector<pcap_t *> pds;
         static std::vector<int> datalinks;
         static std::vector<int> headerLengths;
+        static std::vector<int> fds;                  // selectable fd; -1 for replay, -2 at end of file
+        static std::vector<timeval> replayStartTimes; // timestamp of first packet in file
+        static std::vector<simtime_t> replayLastTimes;// arrival time of last packet inserted
+        static std::vector<long> replayCounts;        // number of packets replayed
 #endif
         static timeval baseTime;
 
@@ -84,13 +136,21 @@ class cSocketRTScheduler : public cScheduler
          */
         void setInterfaceModule(cModule *mod, const char *dev, const char *filter);
 
+        /**
+         * Like setInterfaceModule(), but packets are read from the given pcap
+         * file instead of a live device. Packets sent by the module are not
+         * written to the wire.
+         */
+        void setReplayInterfaceModule(cModule *mod, const char *fileName, const char *filter);
+
         /**
          * Scheduler function -- it comes from cScheduler interface.
          */
         virtual cMessage *getNextEvent();
 
         /**
-         * Send on the currently open connection
+         * Send on the currently open connection. The packet may be sent later,
+         * together with other packets; see class documentation.
          */
         void sendBytes(unsigned char *buf, size_t numBytes, struct sockaddr *from, socklen_t addrlen);
 };
@@ -0,0 +1,101 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "Ieee80211AggregateFrame.h"
+
+Register_Class(Ieee80211AggregateFrame);
+
+
+Ieee80211AggregateFrame& Ieee80211AggregateFrame::operator=(const Ieee80211AggregateFrame& other)
+{
+    if (this==&other) return *this;
+    Ieee80211AggregateFrame_Base::operator=(other);
+    clear();
+    copy(other);
+    return *this;
+}
+
+void Ieee80211AggregateFrame::copy(const Ieee80211AggregateFrame& other)
+{
+    for (unsigned int i = 0; i < other.subframes.size(); i++)
+    {
+        Ieee80211DataFrame *frame = other.subframes[i]->dup();
+        take(frame);
+        subframes.push_back(frame);
+    }
+    numTransmissions = other.numTransmissions;
+}
+
+void Ieee80211AggregateFrame::clear()
+{
+    for (unsigned int i = 0; i < subframes.size(); i++)
+        dropAndDelete(subframes[i]);
+    subframes.clear();
+    numTransmissions.clear();
+}
+
+void Ieee80211AggregateFrame::forEachChild(cVisitor *v)
+{
+    Ieee80211AggregateFrame_Base::forEachChild(v);
+    for (unsigned int i = 0; i < subframes.size(); i++)
+        v->visit(subframes[i]);
+}
+
+int Ieee80211AggregateFrame::getSubframeLength(Ieee80211DataFrame *frame) const
+{
+    int length;
+    if (getAmpdu())
+    {
+        // MPDU delimiter (4 bytes) + MPDU
+        length = 4 + frame->getByteLength();
+    }
+    else
+    {
+        // subframe header (DA, SA, length: 14 bytes) + MSDU
+        cPacket *msdu = frame->getEncapsulatedPacket();
+        length = 14 + (msdu ? msdu->getByteLength() : 0);
+    }
+    return (length + 3) & ~3;
+}
+
+void Ieee80211AggregateFrame::addSubframe(Ieee80211DataFrame *frame)
+{
+    take(frame);
+    subframes.push_back(frame);
+    numTransmissions.push_back(0);
+    addByteLength(getSubframeLength(frame));
+}
+
+Ieee80211DataFrame *Ieee80211AggregateFrame::removeSubframe(unsigned int k)
+{
+    Ieee80211DataFrame *frame = subframes.at(k);
+    subframes.erase(subframes.begin() + k);
+    numTransmissions.erase(numTransmissions.begin() + k);
+    addByteLength(-getSubframeLength(frame));
+    drop(frame);
+    return frame;
+}
+
+void Ieee80211AggregateFrame::countTransmission()
+{
+    for (unsigned int i = 0; i < subframes.size(); i++)
+    {
+        if (numTransmissions[i] > 0)
+            subframes[i]->setRetry(true);
+        numTransmissions[i]++;
+    }
+}
@@ -0,0 +1,87 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_IEEE80211AGGREGATEFRAME_H
+#define __INET_IEEE80211AGGREGATEFRAME_H
+
+#include <vector>
+#include "INETDefs.h"
+#include "Ieee80211Frame_m.h"
+
+
+/**
+ * An A-MSDU or A-MPDU. More info in the Ieee80211Frame.msg file
+ * (and the documentation generated from it).
+ *
+ * Owns the aggregated frames (subframes); the byte length of the aggregate
+ * is updated as subframes are added and removed. The ampdu flag must be
+ * set before the first subframe is added.
+ *
+ * The aggregate also counts the transmissions of each subframe; this is
+ * the sender's bookkeeping for selective retransmission, not part of the
+ * frame format.
+ */
+class INET_API Ieee80211AggregateFrame : public Ieee80211AggregateFrame_Base
+{
+  protected:
+    std::vector<Ieee80211DataFrame *> subframes;
+    std::vector<int> numTransmissions;
+
+  private:
+    void copy(const Ieee80211AggregateFrame& other);
+    void clear();
+
+  public:
+    Ieee80211AggregateFrame(const char *name=NULL, int kind=0) : Ieee80211AggregateFrame_Base(name,kind) {}
+    Ieee80211AggregateFrame(const Ieee80211AggregateFrame& other) : Ieee80211AggregateFrame_Base(other.getName()) {operator=(other);}
+    virtual ~Ieee80211AggregateFrame() {clear();}
+    Ieee80211AggregateFrame& operator=(const Ieee80211AggregateFrame& other);
+    virtual Ieee80211AggregateFrame *dup() const {return new Ieee80211AggregateFrame(*this);}
+    virtual void forEachChild(cVisitor *v);
+
+    /**
+     * Returns the number of bytes the frame would occupy in this aggregate:
+     * the MPDU with its delimiter for an A-MPDU, or the frame body with
+     * the subframe header for an A-MSDU; both padded to 4 bytes.
+     */
+    virtual int getSubframeLength(Ieee80211DataFrame *frame) const;
+
+    /** Adds a frame to the aggregate, and increases the length accordingly. */
+    virtual void addSubframe(Ieee80211DataFrame *frame);
+
+    /** Returns the number of aggregated frames. */
+    unsigned int getNumSubframes() const {return subframes.size();}
+
+    /** Returns the kth aggregated frame. */
+    Ieee80211DataFrame *getSubframe(unsigned int k) const {return subframes.at(k);}
+
+    /** Removes the kth aggregated frame from the aggregate, and returns it. */
+    virtual Ieee80211DataFrame *removeSubframe(unsigned int k);
+
+    /** Returns the number of times the kth aggregated frame has been sent. */
+    int getNumTransmissions(unsigned int k) const {return numTransmissions.at(k);}
+
+    /**
+     * To be called by the sender on every transmission of the aggregate:
+     * sets the retry flag of subframes sent before, and counts the
+     * transmission for every subframe.
+     */
+    virtual void countTransmission();
+};
+
+#endif
+
@@ -29,6 +29,7 @@
 const unsigned int LENGTH_RTS = 160;
 const unsigned int LENGTH_CTS = 112;
 const unsigned int LENGTH_ACK = 112;
+const unsigned int LENGTH_BLOCKACK = 256;  // compressed bitmap variant
 
 // time slot ST, short interframe space SIFS, distributed interframe
 // space DIFS, and extended interframe space EIFS
@@ -46,6 +47,13 @@ const int CW_MIN = 31;
 /** Maximum size of contention window */
 const int CW_MAX = 1023;
 
+/** Maximum length of an A-MSDU and an A-MPDU, in bytes */
+const int MAX_AMSDU_LENGTH = 7935;
+const int MAX_AMPDU_LENGTH = 65535;
+
+/** Block Ack window size (number of sequence numbers covered by the bitmap) */
+const int BLOCKACK_WINDOW = 64;
+
 const int PHY_HEADER_LENGTH = 192;
 const int HEADER_WITHOUT_PREAMBLE = 48;
 const double BITRATE_HEADER = 1E+6;
@@ -43,6 +43,14 @@ Register_Enum(RadioState,
     RadioState::TRANSMIT,
     RadioState::SLEEP));
 
+std::ostream& operator<<(std::ostream& os, const Ieee80211Mac::Edcaf& edcaf)
+{
+    os << "queue=" << edcaf.transmissionQueue.size() << " backoff=" << edcaf.backoff
+       << " backoffPeriod=" << edcaf.backoffPeriod << " retryCounter=" << edcaf.retryCounter
+       << " sent=" << edcaf.numSent;
+    return os;
+}
+
 /****************************************************************
  * Construction functions.
  */
@@ -55,6 +63,8 @@ Ieee80211Mac::Ieee80211Mac()
     endReserve = NULL;
     mediumStateChange = NULL;
     pendingRadioConfigMsg = NULL;
+    queueModule = NULL;
+    classifier = NULL;
 }
 
 Ieee80211Mac::~Ieee80211Mac()
@@ -68,6 +78,8 @@ Ieee80211Mac::~Ieee80211Mac()
 
     if (pendingRadioConfigMsg)
         delete pendingRadioConfigMsg;
+
+    delete classifier;
 }
 
 /****************************************************************
@@ -101,6 +113,30 @@ void Ieee80211Mac::initialize(int stage)
         if (cwMinBroadcast == -1) cwMinBroadcast = 31;
         ASSERT(cwMinBroadcast >= 0);
 
+        const char *aggregationString = par("aggregation");
+        if (!strcmp(aggregationString, "none"))
+            aggregation = NO_AGGREGATION;
+        else if (!strcmp(aggregationString, "A-MSDU"))
+            aggregation = AMSDU;
+        else if (!strcmp(aggregationString, "A-MPDU"))
+            aggregation = AMPDU;
+        else
+            error("invalid aggregation '%s', must be \"none\", \"A-MSDU\" or \"A-MPDU\"", aggregationString);
+
+        maxAggregateSize = par("maxAggregateSize");
+        if (aggregation == AMSDU && maxAggregateSize > MAX_AMSDU_LENGTH)
+            error("maxAggregateSize must not exceed %d bytes with A-MSDU", MAX_AMSDU_LENGTH);
+        if (aggregation == AMPDU && maxAggregateSize > MAX_AMPDU_LENGTH)
+            error("maxAggregateSize must not exceed %d bytes with A-MPDU", MAX_AMPDU_LENGTH);
+        maxAggregatedFrames = par("maxAggregatedFrames");
+        if (maxAggregatedFrames < 1 || (aggregation == AMPDU && maxAggregatedFrames > BLOCKACK_WINDOW))
+            error("maxAggregatedFrames must be at least 1, and at most %d with A-MPDU", BLOCKACK_WINDOW);
+        maxAggregateDuration = par("maxAggregateDuration");
+
+        // access categories (a single one with DCF)
+        initializeEdcafs();
+        arithmeticBackoff = par("arithmeticBackoff");
+
         const char *addressString = par("address");
         if (!strcmp(addressString, "auto")) {
             // assign automatic address
@@ -133,9 +169,8 @@ void Ieee80211Mac::initialize(int stage)
         mode = DCF;
         sequenceNumber = 0;
         radioState = RadioState::IDLE;
-        retryCounter = 0;
-        backoffPeriod = -1;
-        backoff = false;
+        currentAC = numEdcafs - 1;
+        aifsStart = txopStart = 0;
         lastReceiveFailed = false;
         nav = false;
 
@@ -148,6 +183,9 @@ void Ieee80211Mac::initialize(int stage)
         numReceived = 0;
         numSentBroadcast = 0;
         numReceivedBroadcast = 0;
+        numSentAggregates = 0;
+        numAggregatedFrames = 0;
+        numReceivedDuplicates = 0;
         stateVector.setName("State");
         stateVector.setEnum("Ieee80211Mac");
         radioStateVector.setName("RadioState");
@@ -156,9 +194,10 @@ void Ieee80211Mac::initialize(int stage)
         // initialize watches
         WATCH(fsm);
         WATCH(radioState);
-        WATCH(retryCounter);
-        WATCH(backoff);
+        WATCH(currentAC);
         WATCH(nav);
+        for (int ac = 0; ac < numEdcafs; ac++)
+            createWatch(getAccessCategoryName(ac), edcafs[ac]);
 
         WATCH(numRetry);
         WATCH(numSentWithoutRetry);
@@ -168,6 +207,9 @@ void Ieee80211Mac::initialize(int stage)
         WATCH(numReceived);
         WATCH(numSentBroadcast);
         WATCH(numReceivedBroadcast);
+        WATCH(numSentAggregates);
+        WATCH(numAggregatedFrames);
+        WATCH(numReceivedDuplicates);
     }
 }
 
@@ -214,11 +256,114 @@ void Ieee80211Mac::initializeQueueModule()
         cModule *module = getParentModule()->getSubmodule(par("queueModule").stringValue());
         queueModule = check_and_cast<IPassiveQueue *>(module);
 
-        EV << "Requesting first two frames from queue module\n";
-        queueModule->requestPacket();
-        // needed for backoff: mandatory if next message is already present
-        queueModule->requestPacket();
+        // two frames are needed for backoff: mandatory if next message is already
+        // present; with aggregation, enough frames to fill an aggregate; with
+        // EDCA, as many as possible, so that they get sorted into access categories
+        int n = (aggregation == NO_AGGREGATION) ? 2 : maxAggregatedFrames + 1;
+        if (numEdcafs > 1 && maxQueueSize)
+            n = maxQueueSize;
+        if (maxQueueSize && n > maxQueueSize)
+            n = maxQueueSize;
+        EV << "Requesting first " << n << " frames from queue module\n";
+        requestFramesFromQueueModule(n);
+    }
+}
+
+void Ieee80211Mac::initializeEdcafs()
+{
+    if (!par("EDCA").boolValue())
+    {
+        // DCF: a single channel access function, with AIFS=DIFS
+        numEdcafs = 1;
+        edcafs[0].aifsn = 2;
+        edcafs[0].cwMin = cwMinData;
+        edcafs[0].cwMax = CW_MAX;
+        edcafs[0].txopLimit = 0;
+    }
+    else
+    {
+        numEdcafs = 4;
+
+        classifier = check_and_cast<IQoSClassifier *>(createOne(par("classifierClass")));
+        cStringTokenizer tokenizer(par("classifierAccessCategories"));
+        while (tokenizer.hasMoreTokens())
+        {
+            const char *token = tokenizer.nextToken();
+            static const char *names[] = {"BK", "BE", "VI", "VO"};
+            int ac;
+            for (ac = 0; ac < numEdcafs; ac++)
+                if (!strcmp(token, names[ac]))
+                    break;
+            if (ac == numEdcafs)
+                error("invalid access category '%s' in classifierAccessCategories, must be BK, BE, VI or VO", token);
+            classifierAccessCategories.push_back(ac);
+        }
+        if ((int)classifierAccessCategories.size() != classifier->getNumQueues())
+            error("classifierAccessCategories must contain %d access categories, one for each output of the classifier",
+                  classifier->getNumQueues());
+
+        // defaults are from spec 7.3.2.29 (802.11e), with aCWmin=cwMinData and aCWmax=CW_MAX
+        int defaultCwMin[] = {cwMinData, cwMinData, (cwMinData + 1) / 2 - 1, (cwMinData + 1) / 4 - 1};
+        int defaultCwMax[] = {CW_MAX, CW_MAX, cwMinData, (cwMinData + 1) / 2 - 1};
+        for (int ac = 0; ac < numEdcafs; ac++)
+        {
+            Edcaf& edcaf = edcafs[ac];
+            char parName[16];
+            sprintf(parName, "AIFSN%d", ac);
+            edcaf.aifsn = par(parName);
+            if (edcaf.aifsn < 1)
+                error("%s must be at least 1", parName);
+            sprintf(parName, "cwMin%d", ac);
+            edcaf.cwMin = par(parName);
+            if (edcaf.cwMin == -1) edcaf.cwMin = defaultCwMin[ac];
+            sprintf(parName, "cwMax%d", ac);
+            edcaf.cwMax = par(parName);
+            if (edcaf.cwMax == -1) edcaf.cwMax = defaultCwMax[ac];
+            if (edcaf.cwMin < 0 || edcaf.cwMax < edcaf.cwMin)
+                error("invalid contention window for %s", getAccessCategoryName(ac));
+            sprintf(parName, "TXOP%d", ac);
+            edcaf.txopLimit = par(parName);
+        }
+    }
+
+    for (int ac = 0; ac < numEdcafs; ac++)
+    {
+        Edcaf& edcaf = edcafs[ac];
+        edcaf.backoff = false;
+        edcaf.backoffPeriod = -1;
+        edcaf.retryCounter = 0;
+
+        edcaf.numSent = 0;
+        edcaf.numSentBytes = 0;
+        edcaf.numInternalCollision = 0;
+        std::string prefix = numEdcafs > 1 ? std::string(getAccessCategoryName(ac)) + " " : "";
+        edcaf.delayStats.setName((prefix + "delay").c_str());
+        edcaf.delayVector.setName((prefix + "delay").c_str());
+
+        EV << getAccessCategoryName(ac) << ": AIFSN=" << edcaf.aifsn << " CWmin=" << edcaf.cwMin
+           << " CWmax=" << edcaf.cwMax << " TXOP limit=" << edcaf.txopLimit << endl;
+    }
+}
+
+void Ieee80211Mac::finish()
+{
+    for (int ac = 0; ac < numEdcafs; ac++)
+    {
+        Edcaf& edcaf = edcafs[ac];
+        std::string prefix = numEdcafs > 1 ? std::string(getAccessCategoryName(ac)) + " " : "";
+        recordScalar((prefix + "sent frames").c_str(), edcaf.numSent);
+        if (simTime() > 0)
+            recordScalar((prefix + "throughput (bps)").c_str(), edcaf.numSentBytes * 8 / simTime());
+        if (numEdcafs > 1)
+            recordScalar((prefix + "internal collisions").c_str(), edcaf.numInternalCollision);
+        if (edcaf.delayStats.getCount() > 0)
+            edcaf.delayStats.record();
     }
+    recordScalar("collisions", numCollision);
+    recordScalar("retries", numRetry);
+    recordScalar("given up", numGivenUp);
+    if (aggregation != NO_AGGREGATION)
+        recordScalar("received duplicates", numReceivedDuplicates);
 }
 
 /****************************************************************
@@ -237,7 +382,10 @@ void Ieee80211Mac::handleSelfMsg(cMessage *msg)
 void Ieee80211Mac::handleUpperMsg(cPacket *msg)
 {
     // check for queue overflow
-    if (maxQueueSize && (int)transmissionQueue.size() == maxQueueSize)
+    int queueLength = 0;
+    for (int ac = 0; ac < numEdcafs; ac++)
+        queueLength += transmissionQueue(ac).size();
+    if (maxQueueSize && queueLength == maxQueueSize)
     {
         EV << "message " << msg << " received from higher layer but MAC queue is full, dropping message\n";
         delete msg;
@@ -255,10 +403,20 @@ void Ieee80211Mac::handleUpperMsg(cPacket *msg)
 
     // fill in missing fields (receiver address, seq number), and insert into the queue
     frame->setTransmitterAddress(address);
-    frame->setSequenceNumber(sequenceNumber);
-    sequenceNumber = (sequenceNumber+1) % 4096;  //XXX seqNum must be checked upon reception of frames!
+    frame->setSequenceNumber(nextSequenceNumber(frame));
 
-    transmissionQueue.push_back(frame);
+    int ac = classifyFrame(frame);
+    if (transmissionQueue(ac).empty())
+    {
+        // a new backoff period will be needed; if other access categories are
+        // already contending, this one joins them with a backoff
+        invalidateBackoffPeriod(ac);
+        if (fsm.getState() == IDLE || !hasFrameToTransmit())
+            currentAC = ac;
+        else
+            backoff(ac) = true;
+    }
+    transmissionQueue(ac).push_back(frame);
 
     handleWithFSM(frame);
 }
@@ -364,6 +522,17 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
         scheduleReservePeriod(frame);
     }
 
+    // channel access: select the access category that transmits, and build
+    // aggregates right before the transmission decision, so that frames
+    // queued during contention get into them as well
+    if (msg == endDIFS || msg == endBackoff)
+    {
+        selectAccessCategory();
+        txopStart = simTime();
+        if (aggregation != NO_AGGREGATION && !transmissionQueue().empty())
+            aggregateCurrentTransmission();
+    }
+
     // TODO: fix bug according to the message: [omnetpp] A possible bug in the Ieee80211's FSM.
     FSMA_Switch(fsm)
     {
@@ -373,11 +542,11 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
             FSMA_Event_Transition(Data-Ready,
                                   isUpperMsg(msg),
                                   DEFER,
-                ASSERT(isInvalidBackoffPeriod() || backoffPeriod == 0);
+                ASSERT(isInvalidBackoffPeriod() || backoffPeriod() == 0);
                 invalidateBackoffPeriod();
             );
             FSMA_No_Event_Transition(Immediate-Data-Ready,
-                                     !transmissionQueue.empty(),
+                                     hasFrameToTransmit(),
                                      DEFER,
                 invalidateBackoffPeriod();
             );
@@ -394,7 +563,7 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
                                   WAITDIFS,
             ;);
             FSMA_No_Event_Transition(Immediate-Wait-DIFS,
-                                     isMediumFree() || !backoff,
+                                     isMediumFree() || !backoff(),
                                      WAITDIFS,
             ;);
             FSMA_Event_Transition(Receive,
@@ -407,19 +576,19 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
             FSMA_Enter(scheduleDIFSPeriod());
             FSMA_Event_Transition(Immediate-Transmit-RTS,
                                   msg == endDIFS && !isBroadcast(getCurrentTransmission())
-                                  && getCurrentTransmission()->getByteLength() >= rtsThreshold && !backoff,
+                                  && getCurrentTransmission()->getByteLength() >= rtsThreshold && (!backoff() || arithmeticBackoff),
                                   WAITCTS,
                 sendRTSFrame(getCurrentTransmission());
                 cancelDIFSPeriod();
             );
             FSMA_Event_Transition(Immediate-Transmit-Broadcast,
-                                  msg == endDIFS && isBroadcast(getCurrentTransmission()) && !backoff,
+                                  msg == endDIFS && isBroadcast(getCurrentTransmission()) && (!backoff() || arithmeticBackoff),
                                   WAITBROADCAST,
                 sendBroadcastFrame(getCurrentTransmission());
                 cancelDIFSPeriod();
             );
             FSMA_Event_Transition(Immediate-Transmit-Data,
-                                  msg == endDIFS && !isBroadcast(getCurrentTransmission()) && !backoff,
+                                  msg == endDIFS && !isBroadcast(getCurrentTransmission()) && (!backoff() || arithmeticBackoff),
                                   WAITACK,
                 sendDataFrame(getCurrentTransmission());
                 cancelDIFSPeriod();
@@ -427,27 +596,28 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
             FSMA_Event_Transition(DIFS-Over,
                                   msg == endDIFS,
                                   BACKOFF,
-                ASSERT(backoff);
-                if (isInvalidBackoffPeriod())
-                    generateBackoffPeriod();
+                ASSERT(backoff());
+                generateBackoffPeriods();
             );
             FSMA_Event_Transition(Busy,
                                   isMediumStateChange(msg) && !isMediumFree(),
                                   DEFER,
-                backoff = true;
                 cancelDIFSPeriod();
+                decreaseBackoffPeriods();
             );
             FSMA_No_Event_Transition(Immediate-Busy,
                                      !isMediumFree(),
                                      DEFER,
-                backoff = true;
                 cancelDIFSPeriod();
+                decreaseBackoffPeriods();
             );
             // radio state changes before we actually get the message, so this must be here
             FSMA_Event_Transition(Receive,
                                   isLowerMsg(msg),
                                   RECEIVE,
                 cancelDIFSPeriod();
+                if (arithmeticBackoff)
+                    decreaseBackoffPeriods();
             ;);
         }
         FSMA_State(BACKOFF)
@@ -473,22 +643,38 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
                                   isMediumStateChange(msg) && !isMediumFree(),
                                   DEFER,
                 cancelBackoffPeriod();
-                decreaseBackoffPeriod();
+                decreaseBackoffPeriods();
             );
         }
         FSMA_State(WAITACK)
         {
             FSMA_Enter(scheduleDataTimeoutPeriod(getCurrentTransmission()));
+            FSMA_Event_Transition(Receive-ACK-Continue-TXOP,
+                                  isLowerMsg(msg) && isForUs(frame) && frameType == ST_ACK && isTXOPContinuable(),
+                                  WAITSIFS,
+                if (retryCounter() == 0) numSentWithoutRetry++;
+                numSent++;
+                cancelTimeoutPeriod();
+                finishCurrentTransmission();
+            );
             FSMA_Event_Transition(Receive-ACK,
                                   isLowerMsg(msg) && isForUs(frame) && frameType == ST_ACK,
                                   IDLE,
-                if (retryCounter == 0) numSentWithoutRetry++;
+                if (retryCounter() == 0) numSentWithoutRetry++;
                 numSent++;
                 cancelTimeoutPeriod();
                 finishCurrentTransmission();
             );
+            FSMA_Event_Transition(Receive-BlockAck,
+                                  isLowerMsg(msg) && isForUs(frame) && frameType == ST_BLOCKACK,
+                                  IDLE,
+                if (retryCounter() == 0) numSentWithoutRetry++;
+                numSent++;
+                cancelTimeoutPeriod();
+                processBlockAck(check_and_cast<Ieee80211BlockAckFrame *>(frame));
+            );
             FSMA_Event_Transition(Transmit-Data-Failed,
-                                  msg == endTimeout && retryCounter == transmissionLimit - 1,
+                                  msg == endTimeout && retryCounter() == transmissionLimit - 1,
                                   IDLE,
                 giveUpCurrentTransmission();
             );
@@ -519,7 +705,7 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
                 cancelTimeoutPeriod();
             );
             FSMA_Event_Transition(Transmit-RTS-Failed,
-                                  msg == endTimeout && retryCounter == transmissionLimit - 1,
+                                  msg == endTimeout && retryCounter() == transmissionLimit - 1,
                                   IDLE,
                 giveUpCurrentTransmission();
             );
@@ -543,6 +729,11 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
                                   WAITACK,
                 sendDataFrameOnEndSIFS(getCurrentTransmission());
             );
+            FSMA_Event_Transition(Transmit-Data-TXOP,
+                                  msg == endSIFS && getFrameReceivedBeforeSIFS()->getType() == ST_ACK,
+                                  WAITACK,
+                sendDataFrameOnEndSIFS(getCurrentTransmission());
+            );
             FSMA_Event_Transition(Transmit-ACK,
                                   msg == endSIFS && isDataOrMgmtFrame(getFrameReceivedBeforeSIFS()),
                                   IDLE,
@@ -570,7 +761,7 @@ void Ieee80211Mac::handleWithFSM(cMessage *msg)
             FSMA_No_Event_Transition(Immediate-Receive-Data,
                                      isLowerMsg(msg) && isForUs(frame) && isDataOrMgmtFrame(frame),
                                      WAITSIFS,
-                sendUp(frame);
+                sendUpFrame(check_and_cast<Ieee80211DataOrMgmtFrame *>(frame));
                 numReceived++;
             );
             FSMA_No_Event_Transition(Immediate-Receive-RTS,
@@ -620,22 +811,28 @@ simtime_t Ieee80211Mac::getEIFS()
     return getSIFS() + getDIFS() + (8 * LENGTH_ACK + PHY_HEADER_LENGTH) / 1E+6;
 }
 
-simtime_t Ieee80211Mac::computeBackoffPeriod(Ieee80211Frame *msg, int r)
+simtime_t Ieee80211Mac::getAIFS(int ac)
+{
+    return getSIFS() + edcafs[ac].aifsn * getSlotTime();
+}
+
+simtime_t Ieee80211Mac::computeBackoffPeriod(Ieee80211Frame *msg, int r, int ac)
 {
     int cw;
 
     EV << "generating backoff slot number for retry: " << r << endl;
 
+    Edcaf& edcaf = edcafs[ac];
     if (isBroadcast(msg))
-        cw = cwMinBroadcast;
+        cw = numEdcafs == 1 ? cwMinBroadcast : edcaf.cwMin;
     else
     {
         ASSERT(0 <= r && r < transmissionLimit);
 
-        cw = (cwMinData + 1) * (1 << r) - 1;
+        cw = (edcaf.cwMin + 1) * (1 << r) - 1;
 
-        if (cw > CW_MAX)
-            cw = CW_MAX;
+        if (cw > edcaf.cwMax)
+            cw = edcaf.cwMax;
     }
 
     int c = intrand(cw + 1);
@@ -645,6 +842,23 @@ simtime_t Ieee80211Mac::computeBackoffPeriod(Ieee80211Frame *msg, int r)
     return ((double)c) * getSlotTime();
 }
 
+simtime_t Ieee80211Mac::getTransmissionStartTime(int ac)
+{
+    simtime_t aifsEnd = aifsStart + getAIFS(ac);
+    if (!backoff(ac))
+        return aifsEnd;
+    return isInvalidBackoffPeriod(ac) ? MAXTIME : aifsEnd + backoffPeriod(ac);
+}
+
+simtime_t Ieee80211Mac::getNextTransmissionStartTime()
+{
+    simtime_t t = MAXTIME;
+    for (int ac = 0; ac < numEdcafs; ac++)
+        if (!transmissionQueue(ac).empty() && getTransmissionStartTime(ac) < t)
+            t = getTransmissionStartTime(ac);
+    return t;
+}
+
 /****************************************************************
  * Timer functions.
  */
@@ -657,16 +871,36 @@ void Ieee80211Mac::scheduleSIFSPeriod(Ieee80211Frame *frame)
 
 void Ieee80211Mac::scheduleDIFSPeriod()
 {
+    // EIFS is used instead of DIFS after an erroneous reception; AIFS periods get longer the same way
+    aifsStart = simTime();
     if (lastReceiveFailed)
     {
         EV << "receiption of last frame failed, scheduling EIFS period\n";
-        scheduleAt(simTime() + getEIFS(), endDIFS);
+        aifsStart += getEIFS() - getDIFS();
     }
     else
     {
         EV << "scheduling DIFS period\n";
-        scheduleAt(simTime() + getDIFS(), endDIFS);
     }
+
+    if (arithmeticBackoff && hasFrameToTransmit())
+    {
+        // the period ends when the first access category may transmit; backoff
+        // periods are decreased from the elapsed idle time if the medium gets busy before
+        generateBackoffPeriods();
+        simtime_t t = getNextTransmissionStartTime();
+        ASSERT(t >= simTime() && t < MAXTIME);
+        EV << "scheduling end of DIFS and backoff period at " << t << endl;
+        scheduleAt(t, endDIFS);
+        return;
+    }
+
+    // the period ends with the shortest AIFS of the access categories that have frames to send
+    int aifsAC = -1;
+    for (int ac = 0; ac < numEdcafs; ac++)
+        if (!transmissionQueue(ac).empty() && (aifsAC == -1 || edcafs[ac].aifsn < edcafs[aifsAC].aifsn))
+            aifsAC = ac;
+    scheduleAt(aifsStart + (aifsAC == -1 ? getDIFS() : getAIFS(aifsAC)), endDIFS);
 }
 
 void Ieee80211Mac::cancelDIFSPeriod()
@@ -678,7 +912,7 @@ void Ieee80211Mac::cancelDIFSPeriod()
 void Ieee80211Mac::scheduleDataTimeoutPeriod(Ieee80211DataOrMgmtFrame *frameToSend)
 {
     EV << "scheduling data timeout period\n";
-    scheduleAt(simTime() + computeFrameDuration(frameToSend) + getSIFS() + computeFrameDuration(LENGTH_ACK, basicBitrate) + MAX_PROPAGATION_DELAY * 2, endTimeout);
+    scheduleAt(simTime() + computeFrameDuration(frameToSend) + getSIFS() + computeResponseDuration(frameToSend) + MAX_PROPAGATION_DELAY * 2, endTimeout);
 }
 
 void Ieee80211Mac::scheduleBroadcastTimeoutPeriod(Ieee80211DataOrMgmtFrame *frameToSend)
@@ -729,36 +963,63 @@ void Ieee80211Mac::scheduleReservePeriod(Ieee80211Frame *frame)
     }
 }
 
-void Ieee80211Mac::invalidateBackoffPeriod()
+void Ieee80211Mac::invalidateBackoffPeriod(int ac)
 {
-    backoffPeriod = -1;
+    backoffPeriod(ac) = -1;
 }
 
-bool Ieee80211Mac::isInvalidBackoffPeriod()
+bool Ieee80211Mac::isInvalidBackoffPeriod(int ac)
 {
-    return backoffPeriod == -1;
+    return backoffPeriod(ac) == -1;
 }
 
-void Ieee80211Mac::generateBackoffPeriod()
+void Ieee80211Mac::generateBackoffPeriod(int ac)
 {
-    backoffPeriod = computeBackoffPeriod(getCurrentTransmission(), retryCounter);
-    ASSERT(backoffPeriod >= 0);
-    EV << "backoff period set to " << backoffPeriod << endl;
+    if (ac < 0) ac = currentAC;
+    backoffPeriod(ac) = computeBackoffPeriod(getCurrentTransmission(ac), retryCounter(ac), ac);
+    ASSERT(backoffPeriod(ac) >= 0);
+    EV << "backoff period set to " << backoffPeriod(ac) << endl;
 }
 
-void Ieee80211Mac::decreaseBackoffPeriod()
+void Ieee80211Mac::generateBackoffPeriods()
 {
-    // see spec 9.2.5.2
-    simtime_t elapsedBackoffTime = simTime() - endBackoff->getSendingTime();
-    backoffPeriod -= ((int)(elapsedBackoffTime / getSlotTime())) * getSlotTime();
-    ASSERT(backoffPeriod >= 0);
-    EV << "backoff period decreased to " << backoffPeriod << endl;
+    for (int ac = 0; ac < numEdcafs; ac++)
+        if (!transmissionQueue(ac).empty() && backoff(ac) && isInvalidBackoffPeriod(ac))
+            generateBackoffPeriod(ac);
+}
+
+void Ieee80211Mac::decreaseBackoffPeriods()
+{
+    // see spec 9.2.5.2: idle slots are counted from the end of the AIFS
+    for (int ac = 0; ac < numEdcafs; ac++)
+    {
+        if (transmissionQueue(ac).empty())
+            continue;
+        if (!backoff(ac))
+        {
+            // missed the idle medium, needs a backoff next time
+            backoff(ac) = true;
+            continue;
+        }
+        if (isInvalidBackoffPeriod(ac))
+            continue;
+
+        simtime_t elapsedBackoffTime = simTime() - (aifsStart + getAIFS(ac));
+        if (elapsedBackoffTime > 0)
+        {
+            backoffPeriod(ac) -= ((int)(elapsedBackoffTime / getSlotTime())) * getSlotTime();
+            ASSERT(backoffPeriod(ac) >= 0);
+            EV << "backoff period decreased to " << backoffPeriod(ac) << endl;
+        }
+    }
 }
 
 void Ieee80211Mac::scheduleBackoffPeriod()
 {
     EV << "scheduling backoff period\n";
-    scheduleAt(simTime() + backoffPeriod, endBackoff);
+    simtime_t t = getNextTransmissionStartTime();
+    ASSERT(t >= simTime() && t < MAXTIME);
+    scheduleAt(t, endBackoff);
 }
 
 void Ieee80211Mac::cancelBackoffPeriod()
@@ -780,6 +1041,13 @@ void Ieee80211Mac::sendACKFrameOnEndSIFS()
 
 void Ieee80211Mac::sendACKFrame(Ieee80211DataOrMgmtFrame *frameToACK)
 {
+    // an A-MPDU is answered with a Block Ack
+    if (isAMPDU(frameToACK))
+    {
+        sendBlockAckFrame(check_and_cast<Ieee80211AggregateFrame *>(frameToACK));
+        return;
+    }
+
     EV << "sending ACK frame\n";
     sendDown(setBasicBitrate(buildACKFrame(frameToACK)));
 }
@@ -795,6 +1063,15 @@ void Ieee80211Mac::sendDataFrameOnEndSIFS(Ieee80211DataOrMgmtFrame *frameToSend)
 void Ieee80211Mac::sendDataFrame(Ieee80211DataOrMgmtFrame *frameToSend)
 {
     EV << "sending Data frame\n";
+
+    Ieee80211AggregateFrame *aggregate = dynamic_cast<Ieee80211AggregateFrame *>(frameToSend);
+    if (aggregate)
+    {
+        aggregate->countTransmission();
+        numSentAggregates++;
+        numAggregatedFrames += aggregate->getNumSubframes();
+    }
+
     sendDown(buildDataFrame(frameToSend));
 }
 
@@ -824,6 +1101,12 @@ void Ieee80211Mac::sendCTSFrame(Ieee80211RTSFrame *rtsFrame)
     sendDown(setBasicBitrate(buildCTSFrame(rtsFrame)));
 }
 
+void Ieee80211Mac::sendBlockAckFrame(Ieee80211AggregateFrame *aggregate)
+{
+    EV << "sending Block Ack frame\n";
+    sendDown(setBasicBitrate(buildBlockAckFrame(aggregate)));
+}
+
 /****************************************************************
  * Frame builder functions.
  */
@@ -834,7 +1117,7 @@ Ieee80211DataOrMgmtFrame *Ieee80211Mac::buildDataFrame(Ieee80211DataOrMgmtFrame
     if (isBroadcast(frameToSend))
         frame->setDuration(0);
     else if (!frameToSend->getMoreFragments())
-        frame->setDuration(getSIFS() + computeFrameDuration(LENGTH_ACK, basicBitrate));
+        frame->setDuration(getSIFS() + computeResponseDuration(frameToSend));
     else
         // FIXME: shouldn't we use the next frame to be sent?
         frame->setDuration(3 * getSIFS() + 2 * computeFrameDuration(LENGTH_ACK, basicBitrate) + computeFrameDuration(frameToSend));
@@ -862,7 +1145,7 @@ Ieee80211RTSFrame *Ieee80211Mac::buildRTSFrame(Ieee80211DataOrMgmtFrame *frameTo
     frame->setReceiverAddress(frameToSend->getReceiverAddress());
     frame->setDuration(3 * getSIFS() + computeFrameDuration(LENGTH_CTS, basicBitrate) +
                        computeFrameDuration(frameToSend) +
-                       computeFrameDuration(LENGTH_ACK, basicBitrate));
+                       computeResponseDuration(frameToSend));
 
     return frame;
 }
@@ -883,6 +1166,25 @@ Ieee80211DataOrMgmtFrame *Ieee80211Mac::buildBroadcastFrame(Ieee80211DataOrMgmtF
     return frame;
 }
 
+Ieee80211BlockAckFrame *Ieee80211Mac::buildBlockAckFrame(Ieee80211AggregateFrame *aggregate)
+{
+    Ieee80211BlockAckFrame *frame = new Ieee80211BlockAckFrame("wlan-blockack");
+    frame->setTransmitterAddress(address);
+    frame->setReceiverAddress(aggregate->getTransmitterAddress());
+    frame->setDuration(0);
+
+    // report the whole scoreboard, so MPDUs received in earlier
+    // transmissions get acknowledged as well
+    BlockAckRecordMap::iterator it = blockAckRecords.find(aggregate->getTransmitterAddress());
+    if (it != blockAckRecords.end())
+    {
+        frame->setStartingSequenceNumber(it->second.winStart);
+        frame->setBitmap(it->second.bitmap);
+    }
+
+    return frame;
+}
+
 Ieee80211Frame *Ieee80211Mac::setBasicBitrate(Ieee80211Frame *frame)
 {
     ASSERT(frame->getControlInfo()==NULL);
@@ -892,35 +1194,363 @@ Ieee80211Frame *Ieee80211Mac::setBasicBitrate(Ieee80211Frame *frame)
     return frame;
 }
 
+/****************************************************************
+ * EDCA functions.
+ */
+int Ieee80211Mac::classifyFrame(Ieee80211DataOrMgmtFrame *frame)
+{
+    if (numEdcafs == 1)
+        return 0;
+
+    // management frames are sent with the highest priority
+    if (!dynamic_cast<Ieee80211DataFrame *>(frame))
+        return AC_VO;
+
+    cPacket *payload = frame->getEncapsulatedPacket();
+    if (!payload)
+        return AC_BE;
+    int queueIndex = classifier->classifyPacket(payload);
+    ASSERT(queueIndex >= 0 && queueIndex < (int)classifierAccessCategories.size());
+    return classifierAccessCategories[queueIndex];
+}
+
+void Ieee80211Mac::selectAccessCategory()
+{
+    if (numEdcafs == 1)
+        return;
+
+    // the highest access category that may start transmitting now wins
+    simtime_t now = simTime();
+    bool ready[4];
+    int winner = -1;
+    for (int ac = numEdcafs - 1; ac >= 0; ac--)
+    {
+        ready[ac] = !transmissionQueue(ac).empty() && getTransmissionStartTime(ac) <= now;
+        if (ready[ac] && winner == -1)
+            winner = ac;
+    }
+
+    // at the end of DIFS only the ones without backoff transmit, unless
+    // the DIFS timer also covers the backoff
+    bool transmitting = winner != -1 && (fsm.getState() == BACKOFF || arithmeticBackoff || !backoff(winner));
+    if (!transmitting)
+    {
+        // contention goes on with the backoff
+        if (winner == -1)
+            for (int ac = numEdcafs - 1; ac >= 0 && winner == -1; ac--)
+                if (!transmissionQueue(ac).empty() && backoff(ac))
+                    winner = ac;
+        ASSERT(winner != -1);
+        currentAC = winner;
+        return;
+    }
+
+    currentAC = winner;
+    EV << getAccessCategoryName(winner) << " gets access to the channel\n";
+
+    // the others count the idle slots so far, and freeze
+    decreaseBackoffPeriods();
+
+    // internal collision: the lower ones that would transmit now behave as if
+    // their transmission failed, see spec 9.9.1.3 (802.11e)
+    for (int ac = winner - 1; ac >= 0; ac--)
+    {
+        if (!ready[ac])
+            continue;
+        EV << "internal collision of " << getAccessCategoryName(ac) << " with " << getAccessCategoryName(winner) << endl;
+        edcafs[ac].numInternalCollision++;
+        if (retryCounter(ac) == transmissionLimit - 1)
+        {
+            giveUpCurrentTransmission(ac);
+            invalidateBackoffPeriod(ac);
+        }
+        else
+            retryCurrentTransmission(ac);
+    }
+}
+
+bool Ieee80211Mac::isTXOPContinuable()
+{
+    // the frame just acknowledged is still at the front of the queue
+    Edcaf& edcaf = edcafs[currentAC];
+    if (edcaf.txopLimit == 0 || edcaf.transmissionQueue.size() < 2)
+        return false;
+
+    Ieee80211DataOrMgmtFrame *next = *(++edcaf.transmissionQueue.begin());
+    if (isBroadcast(next))
+        return false;
+
+    simtime_t end = simTime() + getSIFS() + computeFrameDuration(next) + getSIFS() + computeResponseDuration(next);
+    return end <= txopStart + edcaf.txopLimit;
+}
+
+void Ieee80211Mac::recordSentFrame(int ac, Ieee80211DataOrMgmtFrame *frame)
+{
+    Ieee80211AggregateFrame *aggregate = dynamic_cast<Ieee80211AggregateFrame *>(frame);
+    if (aggregate)
+    {
+        for (unsigned int i = 0; i < aggregate->getNumSubframes(); i++)
+            recordSentFrame(ac, aggregate->getSubframe(i));
+        return;
+    }
+
+    // the delay includes queueing in the management module, where the frame was created
+    Edcaf& edcaf = edcafs[ac];
+    simtime_t delay = simTime() - frame->getCreationTime();
+    edcaf.numSent++;
+    edcaf.numSentBytes += frame->getByteLength();
+    edcaf.delayStats.collect(delay);
+    edcaf.delayVector.record(delay);
+}
+
+const char *Ieee80211Mac::getAccessCategoryName(int ac)
+{
+    static const char *names[] = {"AC_BK", "AC_BE", "AC_VI", "AC_VO"};
+    return numEdcafs == 1 ? "DCF" : names[ac];
+}
+
+bool Ieee80211Mac::hasFrameToTransmit()
+{
+    for (int ac = 0; ac < numEdcafs; ac++)
+        if (!transmissionQueue(ac).empty())
+            return true;
+    return false;
+}
+
+/****************************************************************
+ * Frame aggregation functions.
+ */
+void Ieee80211Mac::aggregateCurrentTransmission()
+{
+    // only unicast data frames are aggregated, and an A-MSDU
+    // that has already been sent must be retransmitted unchanged
+    Ieee80211DataOrMgmtFrame *head = getCurrentTransmission();
+    Ieee80211DataFrame *headDataFrame = dynamic_cast<Ieee80211DataFrame *>(head);
+    if (!headDataFrame || isBroadcast(head) || (aggregation == AMSDU && head->getRetry()))
+        return;
+
+    Ieee80211AggregateFrame *aggregate = dynamic_cast<Ieee80211AggregateFrame *>(head);
+    bool isNew = !aggregate;
+    if (isNew)
+    {
+        aggregate = new Ieee80211AggregateFrame(aggregation == AMPDU ? "wlan-ampdu" : "wlan-amsdu");
+        aggregate->setAmpdu(aggregation == AMPDU);
+        if (aggregation == AMPDU)
+            aggregate->setByteLength(0);  // the MPDUs carry their own MAC headers
+        aggregate->setReceiverAddress(headDataFrame->getReceiverAddress());
+        aggregate->setTransmitterAddress(address);
+        aggregate->setToDS(headDataFrame->getToDS());
+        aggregate->setFromDS(headDataFrame->getFromDS());
+        aggregate->setAddress3(headDataFrame->getAddress3());
+        aggregate->setAddress4(headDataFrame->getAddress4());
+        aggregate->setSequenceNumber(headDataFrame->getSequenceNumber());
+        aggregate->addSubframe(headDataFrame);
+    }
+
+    // frames to other receivers are skipped, but frames to the same
+    // receiver must stay in order: stop at the first one that doesn't fit
+    Ieee80211DataOrMgmtFrameList& queue = transmissionQueue();
+    Ieee80211DataOrMgmtFrameList::iterator it = queue.begin();
+    for (++it; it != queue.end() && (int)aggregate->getNumSubframes() < maxAggregatedFrames; )
+    {
+        if ((*it)->getReceiverAddress() != aggregate->getReceiverAddress())
+        {
+            ++it;
+            continue;
+        }
+
+        Ieee80211DataFrame *frame = dynamic_cast<Ieee80211DataFrame *>(*it);
+        if (!frame || dynamic_cast<Ieee80211AggregateFrame *>(frame))
+            break;
+
+        // the Block Ack bitmap must cover all MPDUs of the aggregate
+        if (aggregation == AMPDU && (frame->getSequenceNumber() - aggregate->getSubframe(0)->getSequenceNumber() + 4096) % 4096 >= BLOCKACK_WINDOW)
+            break;
+
+        int64 length = aggregate->getByteLength() + aggregate->getSubframeLength(frame);
+        if (length > maxAggregateSize || computeFrameDuration((int)(8 * length), bitrate) > maxAggregateDuration)
+            break;
+
+        aggregate->addSubframe(frame);
+        it = queue.erase(it);
+    }
+
+    if (isNew)
+    {
+        if (aggregate->getNumSubframes() == 1)
+        {
+            // nothing to aggregate with, send the frame as it is
+            aggregate->removeSubframe(0);
+            delete aggregate;
+            return;
+        }
+        queue.front() = aggregate;
+    }
+
+    EV << "aggregated " << aggregate->getNumSubframes() << " frames into " << aggregate
+       << ", length " << aggregate->getByteLength() << " bytes\n";
+}
+
+bool Ieee80211Mac::isAMPDU(Ieee80211Frame *frame)
+{
+    Ieee80211AggregateFrame *aggregate = dynamic_cast<Ieee80211AggregateFrame *>(frame);
+    return aggregate && aggregate->getAmpdu();
+}
+
+void Ieee80211Mac::processBlockAck(Ieee80211BlockAckFrame *blockAck)
+{
+    Ieee80211AggregateFrame *aggregate = check_and_cast<Ieee80211AggregateFrame *>(getCurrentTransmission());
+    int startingSequenceNumber = blockAck->getStartingSequenceNumber();
+    uint64 bitmap = blockAck->getBitmap();
+
+    int numAcked = 0;
+    int numRemoved = 0;
+    for (int k = (int)aggregate->getNumSubframes() - 1; k >= 0; k--)
+    {
+        // MPDUs before the window are not expected by the receiver any more
+        int offset = (aggregate->getSubframe(k)->getSequenceNumber() - startingSequenceNumber + 4096) % 4096;
+        bool acked = offset >= 2048 || (offset < BLOCKACK_WINDOW && ((bitmap >> offset) & 1));
+        if (acked)
+        {
+            recordSentFrame(currentAC, aggregate->getSubframe(k));
+            numAcked++;
+        }
+        else if (aggregate->getNumTransmissions(k) >= transmissionLimit)
+        {
+            EV << "giving up frame " << aggregate->getSubframe(k) << " after " << aggregate->getNumTransmissions(k) << " transmissions\n";
+            numGivenUp++;
+        }
+        else
+            continue;
+
+        delete aggregate->removeSubframe(k);
+        numRemoved++;
+    }
+
+    EV << "Block Ack acknowledged " << numAcked << " frames, " << aggregate->getNumSubframes() << " to be retransmitted\n";
+
+    requestFramesFromQueueModule(numRemoved);
+    if (aggregate->getNumSubframes() == 0)
+        popTransmissionQueue();
+    resetStateVariables();
+}
+
+bool Ieee80211Mac::recordReceivedSequenceNumber(const MACAddress& originator, int seqNum)
+{
+    BlockAckRecordMap::iterator it = blockAckRecords.find(originator);
+    if (it == blockAckRecords.end())
+    {
+        BlockAckRecord record;
+        record.winStart = seqNum;
+        record.bitmap = 0;
+        it = blockAckRecords.insert(std::make_pair(originator, record)).first;
+    }
+    BlockAckRecord& record = it->second;
+
+    int offset = (seqNum - record.winStart + 4096) % 4096;
+    if (offset >= 2048)
+        return false;  // older than the window
+
+    if (offset >= BLOCKACK_WINDOW)
+    {
+        // move the window so that it ends at seqNum
+        int shift = offset - BLOCKACK_WINDOW + 1;
+        record.bitmap = shift >= BLOCKACK_WINDOW ? 0 : record.bitmap >> shift;
+        record.winStart = (record.winStart + shift) % 4096;
+        offset -= shift;
+    }
+
+    uint64 bit = (uint64)1 << offset;
+    if (record.bitmap & bit)
+        return false;
+    record.bitmap |= bit;
+    return true;
+}
+
+int Ieee80211Mac::nextSequenceNumber(Ieee80211DataOrMgmtFrame *frame)
+{
+    // unicast data frames are numbered per receiver (like per RA/TID in
+    // 802.11n), so frames sent to others don't open gaps in the receiver's
+    // Block Ack window; other frames use the MAC-wide counter
+    int *counter = &sequenceNumber;
+    if (dynamic_cast<Ieee80211DataFrame *>(frame) && !frame->getReceiverAddress().isMulticast())
+    {
+        SequenceNumberMap::iterator it = sequenceNumbers.find(frame->getReceiverAddress());
+        if (it == sequenceNumbers.end())
+            it = sequenceNumbers.insert(std::make_pair(frame->getReceiverAddress(), 0)).first;
+        counter = &it->second;
+    }
+    int seqNum = *counter;
+    *counter = (*counter + 1) % 4096;
+    return seqNum;
+}
+
+void Ieee80211Mac::sendUpFrame(Ieee80211DataOrMgmtFrame *frame)
+{
+    Ieee80211AggregateFrame *aggregate = dynamic_cast<Ieee80211AggregateFrame *>(frame);
+    if (!aggregate)
+    {
+        // keep the Block Ack window in step with frames sent outside
+        // aggregates; retransmissions whose ACK got lost are duplicates
+        if (dynamic_cast<Ieee80211DataFrame *>(frame) &&
+            !recordReceivedSequenceNumber(frame->getTransmitterAddress(), frame->getSequenceNumber()) &&
+            frame->getRetry())
+        {
+            EV << "frame " << frame << " already received, discarding duplicate\n";
+            numReceivedDuplicates++;
+            delete frame;
+            return;
+        }
+        sendUp(frame);
+        return;
+    }
+
+    EV << "deaggregating " << aggregate->getNumSubframes() << " frames from " << aggregate << endl;
+    while (aggregate->getNumSubframes() > 0)
+    {
+        Ieee80211DataFrame *subframe = aggregate->removeSubframe(0);
+        if (aggregate->getAmpdu() && !recordReceivedSequenceNumber(aggregate->getTransmitterAddress(), subframe->getSequenceNumber()))
+        {
+            EV << "frame " << subframe << " already received, discarding duplicate\n";
+            numReceivedDuplicates++;
+            delete subframe;
+        }
+        else
+            sendUp(subframe);
+    }
+}
+
 /****************************************************************
  * Helper functions.
  */
 void Ieee80211Mac::finishCurrentTransmission()
 {
+    recordSentFrame(currentAC, getCurrentTransmission());
     popTransmissionQueue();
     resetStateVariables();
 }
 
-void Ieee80211Mac::giveUpCurrentTransmission()
+void Ieee80211Mac::giveUpCurrentTransmission(int ac)
 {
-    popTransmissionQueue();
-    resetStateVariables();
-    numGivenUp++;
+    Ieee80211AggregateFrame *aggregate = dynamic_cast<Ieee80211AggregateFrame *>(getCurrentTransmission(ac));
+    numGivenUp += aggregate ? aggregate->getNumSubframes() : 1;
+    popTransmissionQueue(ac);
+    resetStateVariables(ac);
 }
 
-void Ieee80211Mac::retryCurrentTransmission()
+void Ieee80211Mac::retryCurrentTransmission(int ac)
 {
-    ASSERT(retryCounter < transmissionLimit - 1);
-    getCurrentTransmission()->setRetry(true);
-    retryCounter++;
+    ASSERT(retryCounter(ac) < transmissionLimit - 1);
+    getCurrentTransmission(ac)->setRetry(true);
+    retryCounter(ac)++;
     numRetry++;
-    backoff = true;
-    generateBackoffPeriod();
+    backoff(ac) = true;
+    generateBackoffPeriod(ac);
 }
 
-Ieee80211DataOrMgmtFrame *Ieee80211Mac::getCurrentTransmission()
+Ieee80211DataOrMgmtFrame *Ieee80211Mac::getCurrentTransmission(int ac)
 {
-    return (Ieee80211DataOrMgmtFrame *)transmissionQueue.front();
+    return (Ieee80211DataOrMgmtFrame *)transmissionQueue(ac).front();
 }
 
 void Ieee80211Mac::sendDownPendingRadioConfigMsg()
@@ -940,17 +1570,17 @@ void Ieee80211Mac::setMode(Mode mode)
     this->mode = mode;
 }
 
-void Ieee80211Mac::resetStateVariables()
+void Ieee80211Mac::resetStateVariables(int ac)
 {
-    backoffPeriod = 0;
-    retryCounter = 0;
+    backoffPeriod(ac) = 0;
+    retryCounter(ac) = 0;
 
-    if (!transmissionQueue.empty()) {
-        backoff = true;
-        getCurrentTransmission()->setRetry(false);
+    if (!transmissionQueue(ac).empty()) {
+        backoff(ac) = true;
+        getCurrentTransmission(ac)->setRetry(false);
     }
     else {
-        backoff = false;
+        backoff(ac) = false;
     }
 }
 
@@ -984,18 +1614,28 @@ Ieee80211Frame *Ieee80211Mac::getFrameReceivedBeforeSIFS()
     return (Ieee80211Frame *)endSIFS->getContextPointer();
 }
 
-void Ieee80211Mac::popTransmissionQueue()
+void Ieee80211Mac::popTransmissionQueue(int ac)
 {
     EV << "dropping frame from transmission queue\n";
-    Ieee80211Frame *temp = transmissionQueue.front();
-    transmissionQueue.pop_front();
+    Ieee80211Frame *temp = transmissionQueue(ac).front();
+    transmissionQueue(ac).pop_front();
+
+    // an aggregate stands for all frames in it
+    Ieee80211AggregateFrame *aggregate = dynamic_cast<Ieee80211AggregateFrame *>(temp);
+    int numFrames = aggregate ? aggregate->getNumSubframes() : 1;
     delete temp;
 
-    if (queueModule)
+    requestFramesFromQueueModule(numFrames);
+}
+
+void Ieee80211Mac::requestFramesFromQueueModule(int n)
+{
+    if (queueModule && n > 0)
     {
         // tell queue module that we've become idle
-        EV << "requesting another frame from queue module\n";
-        queueModule->requestPacket();
+        EV << "requesting " << n << " more frame(s) from queue module\n";
+        for (int i = 0; i < n; i++)
+            queueModule->requestPacket();
     }
 }
 
@@ -1009,11 +1649,17 @@ double Ieee80211Mac::computeFrameDuration(int bits, double bitrate)
     return bits / bitrate + PHY_HEADER_LENGTH / BITRATE_HEADER;
 }
 
+double Ieee80211Mac::computeResponseDuration(Ieee80211DataOrMgmtFrame *frame)
+{
+    return computeFrameDuration(isAMPDU(frame) ? LENGTH_BLOCKACK : LENGTH_ACK, basicBitrate);
+}
+
 void Ieee80211Mac::logState()
 {
     EV  << "state information: mode = " << modeName(mode) << ", state = " << fsm.getStateName()
-        << ", backoff = " << backoff << ", backoffPeriod = " << backoffPeriod
-        << ", retryCounter = " << retryCounter << ", radioState = " << radioState
+        << ", access category = " << getAccessCategoryName(currentAC)
+        << ", backoff = " << backoff() << ", backoffPeriod = " << backoffPeriod()
+        << ", retryCounter = " << retryCounter() << ", radioState = " << radioState
         << ", nav = " << nav << endl;
 }
 
@@ -22,9 +22,12 @@
 #define FSM_DEBUG
 
 #include <list>
+#include <map>
 #include "WirelessMacBase.h"
 #include "IPassiveQueue.h"
 #include "Ieee80211Frame_m.h"
+#include "Ieee80211AggregateFrame.h"
+#include "IQoSClassifier.h"
 #include "Ieee80211Consts.h"
 #include "NotificationBoard.h"
 #include "RadioState.h"
@@ -67,6 +70,21 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
 
   typedef std::list<Ieee80211ASFTuple*> Ieee80211ASFTupleList;
 
+  /**
+   * Receiver side Block Ack scoreboard of an originator: bit i of the bitmap
+   * is set if the MPDU with sequence number winStart+i has been received.
+   * See spec 9.10.7 (802.11n).
+   */
+  struct BlockAckRecord
+  {
+      int winStart;
+      uint64 bitmap;
+  };
+
+  typedef std::map<MACAddress, BlockAckRecord> BlockAckRecordMap;
+
+  typedef std::map<MACAddress, int> SequenceNumberMap;
+
   protected:
     /**
      * @name Configuration parameters
@@ -112,6 +130,36 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
 
     /** Messages longer than this threshold will be sent in multiple fragments. see spec 361 */
     static const int fragmentationThreshold = 2346;
+
+    /** Frame aggregation modes */
+    enum Aggregation {
+        NO_AGGREGATION,
+        AMSDU,  ///< frame bodies under one MAC header, acknowledged with ACK
+        AMPDU,  ///< complete MPDUs, acknowledged with Block Ack
+    };
+    Aggregation aggregation;
+
+    /** Maximum length of an aggregate in bytes */
+    int maxAggregateSize;
+
+    /** Maximum number of frames in an aggregate */
+    int maxAggregatedFrames;
+
+    /** Maximum transmission duration of an aggregate */
+    simtime_t maxAggregateDuration;
+
+    /** Classifies data frames into access categories with EDCA (NULL with DCF) */
+    IQoSClassifier *classifier;
+
+    /** Access category of each output of the classifier */
+    std::vector<int> classifierAccessCategories;
+
+    /**
+     * If true, the backoff is counted down arithmetically while the medium
+     * is idle: a single timer (endDIFS) covers the DIFS and the backoff, and
+     * expires when the station may transmit; the BACKOFF state is not used.
+     */
+    bool arithmeticBackoff;
     //@}
 
   public:
@@ -137,6 +185,51 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     cFSM fsm;
 
   public:
+    /** EDCA access categories, in increasing order of priority */
+    enum AccessCategory {
+        AC_BK,  ///< background
+        AC_BE,  ///< best effort
+        AC_VI,  ///< video
+        AC_VO,  ///< voice
+    };
+
+    /**
+     * Parameters and state of the channel access function of an access
+     * category (EDCAF, see spec 9.9.1 of 802.11e). DCF works with a single
+     * one whose AIFS is DIFS.
+     */
+    struct Edcaf
+    {
+        int aifsn;
+        int cwMin;
+        int cwMax;
+        simtime_t txopLimit;  // 0 means one frame per channel access
+
+        /** Frames received from upper layer and to be transmitted later */
+        Ieee80211DataOrMgmtFrameList transmissionQueue;
+
+        /** True if backoff is enabled */
+        bool backoff;
+
+        /** Remaining backoff period in seconds */
+        simtime_t backoffPeriod;
+
+        /**
+         * Number of frame retransmission attempts, this is a simpification of
+         * SLRC and SSRC, see 9.2.4 in the spec
+         */
+        int retryCounter;
+
+        /** @name Statistics */
+        //@{
+        long numSent;
+        int64 numSentBytes;
+        long numInternalCollision;
+        cStdDev delayStats;
+        cOutVector delayVector;
+        //@}
+    };
+
     /** 80211 MAC operation modes */
     enum Mode {
         DCF,  ///< Distributed Coordination Function
@@ -145,9 +238,32 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
   protected:
     Mode mode;
 
-    /** Sequence number to be assigned to the next frame */
+    /** Sequence number to be assigned to the next broadcast or management frame */
     int sequenceNumber;
 
+    /**
+     * Sequence numbers to be assigned to the next unicast data frame, per
+     * receiver. Separate counters keep the sequence numbers seen by each
+     * receiver contiguous, which the Block Ack window relies on.
+     */
+    SequenceNumberMap sequenceNumbers;
+
+    /** Channel access functions: four with EDCA, one with DCF */
+    Edcaf edcafs[4];
+    int numEdcafs;
+
+    /** The access category that is transmitting or was selected last */
+    int currentAC;
+
+    /**
+     * AIFS periods are counted from here: the start of the DIFS period,
+     * shifted by EIFS-DIFS after an erroneous reception.
+     */
+    simtime_t aifsStart;
+
+    /** Start of the current TXOP (the last channel access) */
+    simtime_t txopStart;
+
     /**
      * Indicates that the last frame received had bit errors in it or there was a
      * collision during receiving the frame. If this flag is set, then the MAC
@@ -155,27 +271,12 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
      */
     bool lastReceiveFailed;
 
-    /** True if backoff is enabled */
-    bool backoff;
-
     /** True during network allocation period. This flag is present to be able to watch this state. */
     bool nav;
 
-    /** Remaining backoff period in seconds */
-    simtime_t backoffPeriod;
-
-    /**
-     * Number of frame retransmission attempts, this is a simpification of
-     * SLRC and SSRC, see 9.2.4 in the spec
-     */
-    int retryCounter;
-
     /** Physical radio (medium) state copied from physical layer */
     RadioState::State radioState;
 
-    /** Messages received from upper layer and to be transmitted later */
-    Ieee80211DataOrMgmtFrameList transmissionQueue;
-
     /**
      * A list of last sender, sequence and fragment number tuples to identify
      * duplicates, see spec 9.2.9.
@@ -183,6 +284,9 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
      */
     Ieee80211ASFTupleList asfTuplesList;
 
+    /** Block Ack scoreboards of the originators that sent A-MPDUs to us */
+    BlockAckRecordMap blockAckRecords;
+
     /** Passive queue module to request messages from */
     IPassiveQueue *queueModule;
 
@@ -226,6 +330,9 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     long numReceived;
     long numSentBroadcast;
     long numReceivedBroadcast;
+    long numSentAggregates;
+    long numAggregatedFrames;
+    long numReceivedDuplicates;
     cOutVector stateVector;
     cOutVector radioStateVector;
     //@}
@@ -249,6 +356,8 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     virtual void initialize(int);
     virtual void registerInterface();
     virtual void initializeQueueModule();
+    virtual void initializeEdcafs();
+    virtual void finish();
     //@}
 
   protected:
@@ -287,7 +396,17 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     virtual simtime_t getDIFS();
     virtual simtime_t getEIFS();
     virtual simtime_t getPIFS();
-    virtual simtime_t computeBackoffPeriod(Ieee80211Frame *msg, int r);
+    virtual simtime_t getAIFS(int ac);
+    virtual simtime_t computeBackoffPeriod(Ieee80211Frame *msg, int r, int ac);
+
+    /**
+     * @brief The time the access category may start transmitting if the
+     * medium stays idle: at the end of its AIFS plus the backoff period.
+     */
+    virtual simtime_t getTransmissionStartTime(int ac);
+
+    /** @brief The earliest transmission start time of the access categories that have frames to send */
+    virtual simtime_t getNextTransmissionStartTime();
     //@}
 
   protected:
@@ -310,11 +429,15 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     /** @brief Schedule network allocation period according to 9.2.5.4. */
     virtual void scheduleReservePeriod(Ieee80211Frame *frame);
 
-    /** @brief Generates a new backoff period based on the contention window. */
-    virtual void invalidateBackoffPeriod();
-    virtual bool isInvalidBackoffPeriod();
-    virtual void generateBackoffPeriod();
-    virtual void decreaseBackoffPeriod();
+    /**
+     * @brief Generates a new backoff period based on the contention window.
+     * These functions work on the current access category by default.
+     */
+    virtual void invalidateBackoffPeriod(int ac = -1);
+    virtual bool isInvalidBackoffPeriod(int ac = -1);
+    virtual void generateBackoffPeriod(int ac = -1);
+    virtual void generateBackoffPeriods();
+    virtual void decreaseBackoffPeriods();
     virtual void scheduleBackoffPeriod();
     virtual void cancelBackoffPeriod();
     //@}
@@ -332,6 +455,7 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     virtual void sendDataFrameOnEndSIFS(Ieee80211DataOrMgmtFrame *frameToSend);
     virtual void sendDataFrame(Ieee80211DataOrMgmtFrame *frameToSend);
     virtual void sendBroadcastFrame(Ieee80211DataOrMgmtFrame *frameToSend);
+    virtual void sendBlockAckFrame(Ieee80211AggregateFrame *aggregate);
     //@}
 
   protected:
@@ -344,6 +468,7 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     virtual Ieee80211RTSFrame *buildRTSFrame(Ieee80211DataOrMgmtFrame *frameToSend);
     virtual Ieee80211CTSFrame *buildCTSFrame(Ieee80211RTSFrame *rtsFrame);
     virtual Ieee80211DataOrMgmtFrame *buildBroadcastFrame(Ieee80211DataOrMgmtFrame *frameToSend);
+    virtual Ieee80211BlockAckFrame *buildBlockAckFrame(Ieee80211AggregateFrame *aggregate);
     //@}
 
     /**
@@ -352,14 +477,86 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
      */
     virtual Ieee80211Frame *setBasicBitrate(Ieee80211Frame *frame);
 
+  protected:
+    /**
+     * @name EDCA functions
+     */
+    //@{
+    /** @brief Returns the access category of a frame received from the upper layer */
+    virtual int classifyFrame(Ieee80211DataOrMgmtFrame *frame);
+
+    /**
+     * @brief Called when the DIFS or backoff period ends: selects the access
+     * category that transmits now, if any, and resolves internal collisions.
+     */
+    virtual void selectAccessCategory();
+
+    /**
+     * @brief Returns true if the next frame of the current access category
+     * can be sent after SIFS in the current TXOP
+     */
+    virtual bool isTXOPContinuable();
+
+    /** @brief Updates the statistics of the access category with a successfully sent frame */
+    virtual void recordSentFrame(int ac, Ieee80211DataOrMgmtFrame *frame);
+
+    /** @brief Name of the access category, for statistics and logging */
+    const char *getAccessCategoryName(int ac);
+
+    /** @brief Accessors of the EDCAF state; the current access category by default */
+    Ieee80211DataOrMgmtFrameList& transmissionQueue(int ac = -1) {return edcafs[ac < 0 ? currentAC : ac].transmissionQueue;}
+    bool& backoff(int ac = -1) {return edcafs[ac < 0 ? currentAC : ac].backoff;}
+    simtime_t& backoffPeriod(int ac = -1) {return edcafs[ac < 0 ? currentAC : ac].backoffPeriod;}
+    int& retryCounter(int ac = -1) {return edcafs[ac < 0 ? currentAC : ac].retryCounter;}
+
+    /** @brief Returns true if any of the access categories has a frame to send */
+    virtual bool hasFrameToTransmit();
+    //@}
+
+  protected:
+    /**
+     * @name Frame aggregation functions
+     */
+    //@{
+    /**
+     * @brief Packs data frames queued for the receiver of the current
+     * transmission into it (turning it into an aggregate if needed), within
+     * the size, frame count and duration limits.
+     */
+    virtual void aggregateCurrentTransmission();
+
+    /** @brief Returns true if the frame is an A-MPDU */
+    virtual bool isAMPDU(Ieee80211Frame *frame);
+
+    /**
+     * @brief Removes the acknowledged frames from the current transmission,
+     * and drops the ones that reached the transmission limit.
+     */
+    virtual void processBlockAck(Ieee80211BlockAckFrame *blockAck);
+
+    /**
+     * @brief Records the sequence number in the originator's Block Ack
+     * scoreboard. Returns false if it was already received or is older
+     * than the window (duplicate). Called for every unicast data frame,
+     * aggregated or not, so the window follows the originator.
+     */
+    virtual bool recordReceivedSequenceNumber(const MACAddress& originator, int seqNum);
+
+    /** @brief Returns the sequence number for the next frame sent to the given receiver */
+    virtual int nextSequenceNumber(Ieee80211DataOrMgmtFrame *frame);
+
+    /** @brief Sends up the frame, or the frames in it if it is an aggregate */
+    virtual void sendUpFrame(Ieee80211DataOrMgmtFrame *frame);
+    //@}
+
   protected:
     /**
      * @name Utility functions
      */
     //@{
     virtual void finishCurrentTransmission();
-    virtual void giveUpCurrentTransmission();
-    virtual void retryCurrentTransmission();
+    virtual void giveUpCurrentTransmission(int ac = -1);
+    virtual void retryCurrentTransmission(int ac = -1);
 
    /** @brief Send down the change channel message to the physical layer if there is any. */
     virtual void sendDownPendingRadioConfigMsg();
@@ -367,11 +564,11 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     /** @brief Change the current MAC operation mode. */
     virtual void setMode(Mode mode);
 
-    /** @brief Returns the current frame being transmitted */
-    virtual Ieee80211DataOrMgmtFrame *getCurrentTransmission();
+    /** @brief Returns the current frame being transmitted (of the current access category by default) */
+    virtual Ieee80211DataOrMgmtFrame *getCurrentTransmission(int ac = -1);
 
-    /** @brief Reset backoff, backoffPeriod and retryCounter for IDLE state */
-    virtual void resetStateVariables();
+    /** @brief Reset backoff, backoffPeriod and retryCounter (of the current access category by default) for IDLE state */
+    virtual void resetStateVariables(int ac = -1);
 
     /** @brief Used by the state machine to identify medium state change events.
         This message is currently optimized away and not sent through the kernel. */
@@ -392,8 +589,11 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     /** @brief Returns the last frame received before the SIFS period. */
     virtual Ieee80211Frame *getFrameReceivedBeforeSIFS();
 
-    /** @brief Deletes frame at the front of queue. */
-    virtual void popTransmissionQueue();
+    /** @brief Deletes frame at the front of queue (of the current access category by default). */
+    virtual void popTransmissionQueue(int ac = -1);
+
+    /** @brief Requests the given number of frames from the queue module, if there is one. */
+    virtual void requestFramesFromQueueModule(int n);
 
     /**
      * @brief Computes the duration (in seconds) of the transmission of a frame
@@ -403,6 +603,9 @@ class INET_API Ieee80211Mac : public WirelessMacBase, public INotifiable
     virtual double computeFrameDuration(Ieee80211Frame *msg);
     virtual double computeFrameDuration(int bits, double bitrate);
 
+    /** @brief Duration of the ACK or Block Ack the frame is answered with */
+    virtual double computeResponseDuration(Ieee80211DataOrMgmtFrame *frame);
+
     /** @brief Logs all state information */
     virtual void logState();
 
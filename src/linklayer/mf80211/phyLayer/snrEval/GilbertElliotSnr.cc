@@ -68,7 +68,7 @@ void GilbertElliotSnr::handleSelfMsg(cMessage *msg)
     if (msg->getKind() == TRANSM_OVER)
     {
 
-        if (noiseLevel < sensitivity)
+        if (interference.getNoiseLevel() < sensitivity)
         {
             // set the RadioState to IDLE
             rs.setState(RadioState::IDLE);
@@ -92,8 +92,8 @@ void GilbertElliotSnr::handleSelfMsg(cMessage *msg)
         if (state == GOOD)
         {
             state = BAD;
-            for (RecvBuff::iterator it = recvBuff.begin(); it != recvBuff.end(); it++)
-                (it->first)->setBitError(true);
+            for (int i = 0; i < interference.getNumSignals(); i++)
+                interference.getSignal(i)->setBitError(true);
             scheduleAt(simTime() + exponential(meanBad, 0), stateChange);
         }
         else if (state == BAD)
@@ -112,7 +112,7 @@ void GilbertElliotSnr::handleSelfMsg(cMessage *msg)
  * before it is buffered for 'transmission time'.
  *
  * First the receive power of the packet has to be calculated and is
- * stored in the recvBuff. Afterwards it has to be decided whether the
+ * stored together with the frame. Afterwards it has to be decided whether the
  * packet is just noise or a "real" packet that needs to be received.
  *
  * The message is not treated as noise if all of the follwoing
@@ -135,35 +135,22 @@ void GilbertElliotSnr::handleSelfMsg(cMessage *msg)
 void GilbertElliotSnr::handleLowerMsgStart(AirFrame * frame)
 {
     // Calculate the receive power of the message
-
-    // calculate distance
-    const Coord& myPos = getMyPosition();
-    const Coord& framePos = frame->getSenderPos();
-    double distance = myPos.distance(framePos);
-
-    // receive power
-    double rcvdPower = calcRcvdPower(frame->getPSend(), distance);
+    double rcvdPower = getRcvdPower(frame);
 
     if (state == BAD)
         frame->setBitError(true);
 
-    // store the receive power in the recvBuff
-    recvBuff[frame] = rcvdPower;
+    // store the receive power
+    interference.addSignal(frame, rcvdPower);
 
     // if receive power is bigger than sensitivity and if not sending
     // and currently not receiving another message
-    if (rcvdPower >= sensitivity && rs.getState() != RadioState::TRANSMIT && snrInfo.ptr == NULL)
+    if (rcvdPower >= sensitivity && rs.getState() != RadioState::TRANSMIT && interference.getReceivedFrame() == NULL)
     {
         EV << "receiving frame\n";
 
-        // Put frame and related SnrList in receive buffer
-        SnrList snrList;        //defined in SnrList.h!!
-        snrInfo.ptr = frame;
-        snrInfo.rcvdPower = rcvdPower;
-        snrInfo.sList = snrList;
-
-        // add initial snr value
-        addNewSnr();
+        // start a new snr list, with the initial snr value
+        interference.startReception(frame);
 
         if (rs.getState() != RadioState::RECV)
         {
@@ -178,10 +165,10 @@ void GilbertElliotSnr::handleLowerMsgStart(AirFrame * frame)
     {
         EV << "frame is just noise\n";
         //add receive power to the noise level
-        noiseLevel += rcvdPower;
+        interference.addNoise(frame);
 
         // if a message is being received add a new snr value
-        if (snrInfo.ptr != NULL)
+        if (interference.getReceivedFrame() != NULL)
         {
             // update snr info for currently being received message
             EV << "add new snr value to snr list of message being received\n";
@@ -190,7 +177,7 @@ void GilbertElliotSnr::handleLowerMsgStart(AirFrame * frame)
 
         // update the RadioState if the noiseLevel exceeded the threshold
         // and the radio is currently not in receive or in send mode
-        if (noiseLevel >= sensitivity && rs.getState() == RadioState::IDLE)
+        if (interference.getNoiseLevel() >= sensitivity && rs.getState() == RadioState::IDLE)
         {
             // publish new RadioState
             rs.setState(RadioState::RECV);
@@ -220,23 +207,14 @@ void GilbertElliotSnr::handleLowerMsgEnd(AirFrame * frame)
         frame->setBitError(true);
 
     // check if message has to be send to the decider
-    if (snrInfo.ptr == frame)
+    if (interference.getReceivedFrame() == frame)
     {
         EV << "reception of frame over, preparing to send packet to upper layer\n";
-        // get Packet and list out of the receive buffer:
-        SnrList list;
-        list = snrInfo.sList;
-
-        // delete the pointer to indicate that no message is currently
-        // being received and clear the list
-        snrInfo.ptr = NULL;
-        snrInfo.sList.clear();
-
-        // delete the frame from the recvBuff
-        recvBuff.erase(frame);
+        // no message is currently being received
+        interference.endReception();
 
         //Don't forget to send:
-        sendUp(frame, list);
+        sendUp(frame, interference.getSnrList());
         EV << "packet sent to the decider\n";
     }
     // all other messages are noise
@@ -244,13 +222,10 @@ void GilbertElliotSnr::handleLowerMsgEnd(AirFrame * frame)
     {
         EV << "reception of noise message over, removing recvdPower from noiseLevel....\n";
         // get the rcvdPower and subtract it from the noiseLevel
-        noiseLevel -= recvBuff[frame];
-
-        // delete message from the recvBuff
-        recvBuff.erase(frame);
+        interference.removeNoise(frame);
 
         // update snr info for message currently being received if any
-        if (snrInfo.ptr != NULL)
+        if (interference.getReceivedFrame() != NULL)
         {
             addNewSnr();
         }
@@ -264,7 +239,7 @@ void GilbertElliotSnr::handleLowerMsgEnd(AirFrame * frame)
     // change to idle if noiseLevel smaller than threshold and state was
     // not idle before
     // do not change state if currently sending or receiving a message!!!
-    if (noiseLevel < sensitivity && rs.getState() == RadioState::RECV && snrInfo.ptr == NULL)
+    if (interference.getNoiseLevel() < sensitivity && rs.getState() == RadioState::RECV && interference.getReceivedFrame() == NULL)
     {
         // publish the new RadioState:
         EV << "new RadioState is IDLE\n";
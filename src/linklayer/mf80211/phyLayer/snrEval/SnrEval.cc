@@ -24,6 +24,13 @@
 
 
 
+// the path loss cache hit ratio is sampled over this many frames, and if it
+// is below the threshold (in mobile scenarios, where the cache costs more
+// than it saves), the cache is bypassed for PATHLOSS_CACHE_BYPASS frames
+#define PATHLOSS_CACHE_WINDOW        1000
+#define PATHLOSS_CACHE_MIN_HIT_RATIO 0.7
+#define PATHLOSS_CACHE_BYPASS        10000
+
 Define_Module(SnrEval);
 
 SnrEval::SnrEval() : rs(this->getId())
@@ -44,19 +51,20 @@ void SnrEval::initialize(int stage)
         carrierFrequency = cc->par("carrierFrequency");  // taken from ChannelControl
         sensitivity = FWMath::dBm2mW(par("sensitivity"));
         pathLossAlpha = par("pathLossAlpha");
+        usePathLossCache = par("usePathLossCache");
         if (pathLossAlpha < (double) (cc->par("alpha")))
             error("SnrEval::initialize(): pathLossAlpha can't be smaller than in "
                   "ChannelControl. Please adjust your omnetpp.ini file accordingly");
 
         // initialize noiseLevel
-        noiseLevel = thermalNoise;
+        interference.setThermalNoise(thermalNoise);
 
-        EV << "Initialized channel with noise: " << noiseLevel << " sensitivity: " << sensitivity <<
+        EV << "Initialized channel with noise: " << interference.getNoiseLevel() << " sensitivity: " << sensitivity <<
             endl;
 
-        // initialize the pointer of the snrInfo with NULL to indicate
-        // that currently no message is received
-        snrInfo.ptr = NULL;
+        pathLossCacheLookups = pathLossCacheHits = 0;
+        pathLossCacheBypassCount = 0;
+        numPathLossCacheHits = numPathLossCacheMisses = numPathLossCacheBypassed = 0;
 
         // no channel switch pending
         newChannel = -1;
@@ -64,10 +72,10 @@ void SnrEval::initialize(int stage)
         // Initialize radio state. If thermal noise is already to high, radio
         // state has to be initialized as RECV
         rs.setState(RadioState::IDLE);
-        if (noiseLevel >= sensitivity)
+        if (interference.getNoiseLevel() >= sensitivity)
             rs.setState(RadioState::RECV);
 
-        WATCH(noiseLevel);
+        WATCH(interference);
         WATCH(rs);
     }
     else if (stage == 1)
@@ -88,13 +96,20 @@ void SnrEval::initialize(int stage)
 void SnrEval::finish()
 {
     BasicSnrEval::finish();
+
+    if (usePathLossCache)
+    {
+        recordScalar("path loss cache hits", numPathLossCacheHits);
+        recordScalar("path loss cache misses", numPathLossCacheMisses);
+        recordScalar("path loss cache bypassed", numPathLossCacheBypassed);
+    }
 }
 
 SnrEval::~SnrEval()
 {
     // delete messages being received
-    for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
-        delete it->first;
+    for (int i = 0; i < interference.getNumSignals(); i++)
+        delete interference.getSignal(i);
 }
 
 void SnrEval::handleMessage(cMessage *msg)
@@ -131,20 +146,13 @@ void SnrEval::handleUpperMsg(AirFrame *frame)
         error("Setting control info (here: %s) on frames is not supported", frame->getControlInfo()->getClassName());
 
     // if a packet was being received, it is corrupted now as should be treated as noise
-    if (snrInfo.ptr != NULL)
+    if (interference.getReceivedFrame() != NULL)
     {
         EV << "Sending a message while receiving another. The received one is now corrupted.\n";
 
-        // remove the snr information stored for the message currently being
-        // received. This message is treated as noise now and the
-        // receive power has to be added to the noiseLevel
-
-        // delete the pointer to indicate that no message is being received
-        snrInfo.ptr = NULL;
-        // clear the snr list
-        snrInfo.sList.clear();
-        // add the receive power to the noise level
-        noiseLevel += snrInfo.rcvdPower;
+        // the message is treated as noise now: its receive power is added
+        // to the noiseLevel
+        interference.abortReception();
     }
 
     // now we are done with all the exception handling and can take care
@@ -213,7 +221,7 @@ void SnrEval::handleSelfMsg(cMessage *msg)
 {
     if (msg->getKind() == TRANSM_OVER)
     {
-        if (noiseLevel < sensitivity)
+        if (interference.getNoiseLevel() < sensitivity)
         {
             // set the RadioState to IDLE
             rs.setState(RadioState::IDLE);
@@ -248,7 +256,7 @@ void SnrEval::handleSelfMsg(cMessage *msg)
  * before it is buffered for 'transmission time'.
  *
  * First the receive power of the packet has to be calculated and is
- * stored in the recvBuff. Afterwards it has to be decided whether the
+ * stored together with the frame. Afterwards it has to be decided whether the
  * packet is just noise or a "real" packet that needs to be received.
  *
  * The message is not treated as noise if all of the following
@@ -269,35 +277,22 @@ void SnrEval::handleSelfMsg(cMessage *msg)
 void SnrEval::handleLowerMsgStart(AirFrame * frame)
 {
     // Calculate the receive power of the message
+    double rcvdPower = getRcvdPower(frame);
 
-    // calculate distance
-    const Coord& myPos = getMyPosition();
-    const Coord& framePos = frame->getSenderPos();
-    double distance = myPos.distance(framePos);
-
-    // calculate receive power
-    double rcvdPower = calcRcvdPower(frame->getPSend(), distance);
-
-    // store the receive power in the recvBuff
-    recvBuff[frame] = rcvdPower;
+    // store the receive power
+    interference.addSignal(frame, rcvdPower);
 
     // if receive power is bigger than sensitivity and if not sending
     // and currently not receiving another message and the message has
     // arrived in time
     // NOTE: a message may have arrival time in the past here when we are
     // processing ongoing transmissions during a channel change
-    if (frame->getArrivalTime() == simTime() && rcvdPower >= sensitivity && rs.getState() != RadioState::TRANSMIT && snrInfo.ptr == NULL)
+    if (frame->getArrivalTime() == simTime() && rcvdPower >= sensitivity && rs.getState() != RadioState::TRANSMIT && interference.getReceivedFrame() == NULL)
     {
         EV << "receiving frame " << frame->getName() << endl;
 
-        // Put frame and related SnrList in receive buffer
-        SnrList snrList;        //defined in SnrList.h!!
-        snrInfo.ptr = frame;
-        snrInfo.rcvdPower = rcvdPower;
-        snrInfo.sList = snrList;
-
-        // add initial snr value
-        addNewSnr();
+        // start a new snr list, with the initial snr value
+        interference.startReception(frame);
 
         if (rs.getState() != RadioState::RECV)
         {
@@ -312,10 +307,10 @@ void SnrEval::handleLowerMsgStart(AirFrame * frame)
     {
         EV << "frame " << frame->getName() << " is just noise\n";
         //add receive power to the noise level
-        noiseLevel += rcvdPower;
+        interference.addNoise(frame);
 
         // if a message is being received add a new snr value
-        if (snrInfo.ptr != NULL)
+        if (interference.getReceivedFrame() != NULL)
         {
             // update snr info for currently being received message
             EV << "add new snr value to snr list of message being received\n";
@@ -324,7 +319,7 @@ void SnrEval::handleLowerMsgStart(AirFrame * frame)
 
         // update the RadioState if the noiseLevel exceeded the threshold
         // and the radio is currently not in receive or in send mode
-        if (noiseLevel >= sensitivity && rs.getState() == RadioState::IDLE)
+        if (interference.getNoiseLevel() >= sensitivity && rs.getState() == RadioState::IDLE)
         {
             // publish new RadioState
             rs.setState(RadioState::RECV);
@@ -348,23 +343,14 @@ void SnrEval::handleLowerMsgStart(AirFrame * frame)
 void SnrEval::handleLowerMsgEnd(AirFrame * frame)
 {
     // check if message has to be send to the decider
-    if (snrInfo.ptr == frame)
+    if (interference.getReceivedFrame() == frame)
     {
         EV << "reception of frame over, preparing to send packet to upper layer\n";
-        // get Packet and list out of the receive buffer:
-        SnrList list;
-        list = snrInfo.sList;
-
-        // delete the pointer to indicate that no message is currently
-        // being received and clear the list
-        snrInfo.ptr = NULL;
-        snrInfo.sList.clear();
-
-        // delete the frame from the recvBuff
-        recvBuff.erase(frame);
+        // no message is currently being received
+        interference.endReception();
 
         //Don't forget to send:
-        sendUp(frame, list);
+        sendUp(frame, interference.getSnrList());
         EV << "packet sent to the decider\n";
     }
     // all other messages are noise
@@ -372,13 +358,10 @@ void SnrEval::handleLowerMsgEnd(AirFrame * frame)
     {
         EV << "reception of noise message over, removing recvdPower from noiseLevel....\n";
         // get the rcvdPower and subtract it from the noiseLevel
-        noiseLevel -= recvBuff[frame];
-
-        // delete message from the recvBuff
-        recvBuff.erase(frame);
+        interference.removeNoise(frame);
 
         // update snr info for message currently being received if any
-        if (snrInfo.ptr != NULL)
+        if (interference.getReceivedFrame() != NULL)
         {
             addNewSnr();
         }
@@ -392,7 +375,7 @@ void SnrEval::handleLowerMsgEnd(AirFrame * frame)
     // change to idle if noiseLevel smaller than threshold and state was
     // not idle before
     // do not change state if currently sending or receiving a message!!!
-    if (noiseLevel < sensitivity && rs.getState() == RadioState::RECV && snrInfo.ptr == NULL)
+    if (interference.getNoiseLevel() < sensitivity && rs.getState() == RadioState::RECV && interference.getReceivedFrame() == NULL)
     {
         // publish the new RadioState:
         EV << "new RadioState is IDLE\n";
@@ -407,10 +390,76 @@ void SnrEval::handleLowerMsgEnd(AirFrame * frame)
  */
 void SnrEval::addNewSnr()
 {
-    SnrListEntry listEntry;     // create a new entry
-    listEntry.time = simTime();
-    listEntry.snr = snrInfo.rcvdPower / noiseLevel;
-    snrInfo.sList.push_back(listEntry);
+    interference.recordSnr();
+}
+
+
+/**
+ * Hosts rarely move between two frames from the same sender, so the
+ * receive power is looked up in the path loss cache first. The entry of
+ * the sender is only used if the frame was sent from the same position
+ * with the same power; otherwise the receive power is calculated and
+ * the entry is updated. The cache is cleared when our position changes.
+ * (We don't rely on NF_HOSTPOSITION_UPDATED for the latter, because with
+ * lazy mobility updates the position changes between notifications.)
+ *
+ * When hosts move between most frames, the lookups cost more than they
+ * save. The hit ratio is therefore sampled, and while it is low the cache
+ * is bypassed, and sampled again from time to time.
+ */
+double SnrEval::getRcvdPower(AirFrame *frame)
+{
+    const Coord& myPos = getMyPosition();
+
+    if (!usePathLossCache)
+        return calcRcvdPower(frame->getPSend(), myPos.distance(frame->getSenderPos()));
+
+    if (pathLossCacheBypassCount > 0)
+    {
+        pathLossCacheBypassCount--;
+        numPathLossCacheBypassed++;
+        return calcRcvdPower(frame->getPSend(), myPos.distance(frame->getSenderPos()));
+    }
+
+    if (pathLossCacheLookups == PATHLOSS_CACHE_WINDOW)
+    {
+        if (pathLossCacheHits < PATHLOSS_CACHE_MIN_HIT_RATIO * PATHLOSS_CACHE_WINDOW)
+        {
+            EV << "path loss cache hit ratio " << (double)pathLossCacheHits / PATHLOSS_CACHE_WINDOW
+               << " too low, bypassing it for the next " << PATHLOSS_CACHE_BYPASS << " frames\n";
+            pathLossCacheBypassCount = PATHLOSS_CACHE_BYPASS;
+            pathLossCache.clear();
+        }
+        pathLossCacheLookups = pathLossCacheHits = 0;
+    }
+    pathLossCacheLookups++;
+
+    if (myPos.x != pathLossCachePos.x || myPos.y != pathLossCachePos.y)
+    {
+        // all cached receive powers were calculated from our old position
+        pathLossCache.clear();
+        pathLossCachePos = myPos;
+    }
+
+    const Coord& framePos = frame->getSenderPos();
+    PathLossCache::iterator it = pathLossCache.find(frame->getSenderModuleId());
+    if (it == pathLossCache.end())
+        it = pathLossCache.insert(std::make_pair(frame->getSenderModuleId(), PathLossCacheEntry())).first;
+    else if (it->second.senderPos.x == framePos.x && it->second.senderPos.y == framePos.y && it->second.pSend == frame->getPSend())
+    {
+        pathLossCacheHits++;
+        numPathLossCacheHits++;
+        return it->second.rcvdPower;
+    }
+
+    numPathLossCacheMisses++;
+
+    double distance = myPos.distance(framePos);
+    PathLossCacheEntry& entry = it->second;
+    entry.senderPos = framePos;
+    entry.pSend = frame->getPSend();
+    entry.rcvdPower = calcRcvdPower(frame->getPSend(), distance);
+    return entry.rcvdPower;
 }
 
 
@@ -440,19 +489,18 @@ void SnrEval::changeChannel(int channel)
     if (rs.getState() == RadioState::RECV)
     {
         // delete messages being received, and cancel associated self-messages
-        for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
+        for (int i = 0; i < interference.getNumSignals(); i++)
         {
-            AirFrame *frame = it->first;
+            AirFrame *frame = interference.getSignal(i);
             cMessage *endRxTimer = (cMessage *)frame->getContextPointer();
             delete frame;
             delete cancelEvent(endRxTimer);
         }
-        recvBuff.clear();
+        interference.clearSignals();
     }
 
     // clear snr info
-    snrInfo.ptr = NULL;
-    snrInfo.sList.clear();
+    interference.cancelReception();
 
     // do channel switch
     EV << "Changing channel to " << channel << "\n";
@@ -467,7 +515,7 @@ void SnrEval::changeChannel(int channel)
     {
         AirFrame *frame = *it;
         // time for the message to reach us
-        double distance = myHostRef->pos.distance(frame->getSenderPos());
+        double distance = getMyPosition().distance(frame->getSenderPos());
         simtime_t propagationDelay = distance / LIGHT_SPEED;
 
         // if this transmission is on our new channel and it would reach us in the future, then schedule it
@@ -22,6 +22,8 @@
 #define SNR_EVAL_H
 
 #include "BasicSnrEval.h"
+#include "INETHashMap.h"
+#include "InterferenceTracker.h"
 #include "RadioState.h"
 #include "PhyControlInfo_m.h"
 
@@ -92,16 +94,35 @@ class INET_API SnrEval : public BasicSnrEval
     /** @brief Unbuffer the frame and update noise levels and snr information*/
     virtual void handleLowerMsgEnd(AirFrame*);
 
-    /** @brief Calculates the power with which a packet is received.*/
+    /**
+     * @brief Returns the receive power of the frame, from the path loss cache
+     * if possible; calls calcRcvdPower() otherwise.
+     */
+    virtual double getRcvdPower(AirFrame *frame);
+
+    /**
+     * @brief Calculates the power with which a packet is received. The
+     * result must only depend on the arguments, because it is cached.
+     */
     virtual double calcRcvdPower(double pSend, double distance);
 
+
     /** Redefined from BasicSnrEval */
     virtual int getChannelNumber() const  {return rs.getChannelNumber();}
 
-    /** @brief updates the snr information of the relevant AirFrames*/
+    /** @brief records the snr of the frame being received, after a change of the noise level*/
     virtual void addNewSnr();
 
   protected:
+    /** @brief The receive power of the last frame from a given sender */
+    struct PathLossCacheEntry
+    {
+        Coord senderPos;
+        double pSend;
+        double rcvdPower;
+    };
+    typedef std::tr1::unordered_map<int, PathLossCacheEntry> PathLossCache;
+
     /** @brief Enum to store self message getKind()s*/
     enum
       {
@@ -110,36 +131,36 @@ class INET_API SnrEval : public BasicSnrEval
       };
 
     /**
-     * @brief Struct to store a pointer to the message, rcvdPower AND a
-     * SnrList, needed in SnrEval::addNewSnr
+     * @brief State: the frames on the air with their receive power, the
+     * frame currently being received with its snr list, and the noise
+     * level of the channel.
      */
-    struct SnrStruct {
-      /** @brief Pointer to the message this information belongs to*/
-      AirFrame* ptr;
-      /** @brief Received power of the message*/
-      double rcvdPower;
-      /** @brief Snr list to store the SNR values*/
-      SnrList sList;
-    };
+    InterferenceTracker interference;
 
     /**
-     * @brief State: SnrInfo stores the snrList and the the recvdPower for the
-     * message currently being received, together with a pointer to the
-     * message.
+     * @brief State: receive powers, keyed by the sender module id. An entry
+     * is valid while the sender's position and transmit power stay the
+     * same; the whole cache is cleared when this host moves.
      */
-    SnrStruct snrInfo;
+    PathLossCache pathLossCache;
 
-    /**
-     * @brief Typedef used to store received messages together with
-     * receive power.
-     */
-    typedef std::map<AirFrame*,double> RecvBuff;
+    /** @brief State: our position the path loss cache is valid for */
+    Coord pathLossCachePos;
 
-    /**
-     * @brief State: A buffer to store a pointer to a message and the related
-     * receive power.
-     */
-    RecvBuff recvBuff;
+    /** @brief Configuration: whether the path loss cache is used at all */
+    bool usePathLossCache;
+
+    /** @brief State: lookups and hits in the current path loss cache sampling window */
+    int pathLossCacheLookups;
+    int pathLossCacheHits;
+
+    /** @brief State: number of frames left for which the path loss cache is bypassed */
+    int pathLossCacheBypassCount;
+
+    /** @brief Statistics: path loss cache hits and misses, and frames that bypassed it */
+    long numPathLossCacheHits;
+    long numPathLossCacheMisses;
+    long numPathLossCacheBypassed;
 
     /** @brief State: the current RadioState of the NIC; includes channel number */
     RadioState rs;
@@ -150,9 +171,6 @@ class INET_API SnrEval : public BasicSnrEval
     /** @brief State: if not -1, we have to switch to that bitrate once we finished transmitting */
     double newBitrate;
 
-    /** @brief State: the current noise level of the channel.*/
-    double noiseLevel;
-
     /**
      * @brief Configuration: The carrier frequency used. It is read from the ChannelControl module.
      */
@@ -172,7 +172,7 @@ double BasicSnrEval::calcDuration(cPacket *af)
  *
  * to be called within @ref handleLowerMsgEnd.
  */
-void BasicSnrEval::sendUp(AirFrame *msg, SnrList& list)
+void BasicSnrEval::sendUp(AirFrame *msg, const SnrList& list)
 {
     // create ControlInfo
     SnrControlInfo *cInfo = new SnrControlInfo;
@@ -126,7 +126,7 @@ class INET_API BasicSnrEval : public ChannelAccess
     virtual AirFrame* unbufferMsg(cMessage *msg);
 
     /** @brief Sends a message to the upper layer*/
-    virtual void sendUp(AirFrame*, SnrList&);
+    virtual void sendUp(AirFrame*, const SnrList&);
 
     /** @brief Sends a message to the channel*/
     virtual void sendDown(AirFrame *msg);
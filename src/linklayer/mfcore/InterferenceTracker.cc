@@ -0,0 +1,96 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "InterferenceTracker.h"
+
+
+InterferenceTracker::InterferenceTracker()
+{
+    noiseLevel = 0;
+    receivedFrame = NULL;
+    receivedPower = 0;
+}
+
+int InterferenceTracker::findSignal(AirFrame *frame) const
+{
+    // only a few frames are on the air at the same time
+    for (int i = 0; i < (int)signals.size(); i++)
+        if (signals[i].frame == frame)
+            return i;
+    throw cRuntimeError("InterferenceTracker: frame (%s)%s not found", frame->getClassName(), frame->getName());
+}
+
+void InterferenceTracker::addSignal(AirFrame *frame, double power)
+{
+    Signal signal;
+    signal.frame = frame;
+    signal.power = power;
+    signals.push_back(signal);
+}
+
+void InterferenceTracker::addNoise(AirFrame *frame)
+{
+    noiseLevel += signals[findSignal(frame)].power;
+}
+
+void InterferenceTracker::removeNoise(AirFrame *frame)
+{
+    ASSERT(frame != receivedFrame);
+    int i = findSignal(frame);
+    noiseLevel -= signals[i].power;
+    removeSignal(i);
+}
+
+void InterferenceTracker::removeSignal(int i)
+{
+    // order doesn't matter: move the last one into the gap
+    signals[i] = signals.back();
+    signals.pop_back();
+}
+
+void InterferenceTracker::startReception(AirFrame *frame)
+{
+    ASSERT(receivedFrame == NULL);
+    receivedFrame = frame;
+    receivedPower = signals[findSignal(frame)].power;
+    snrList.clear();
+    recordSnr();
+}
+
+void InterferenceTracker::recordSnr()
+{
+    ASSERT(receivedFrame != NULL);
+    SnrListEntry entry;
+    entry.time = simTime();
+    entry.snr = receivedPower / noiseLevel;
+    snrList.push_back(entry);
+}
+
+void InterferenceTracker::endReception()
+{
+    ASSERT(receivedFrame != NULL);
+    removeSignal(findSignal(receivedFrame));
+    receivedFrame = NULL;
+}
+
+void InterferenceTracker::abortReception()
+{
+    ASSERT(receivedFrame != NULL);
+    receivedFrame = NULL;
+    noiseLevel += receivedPower;
+}
+
@@ -0,0 +1,130 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_INTERFERENCETRACKER_H
+#define __INET_INTERFERENCETRACKER_H
+
+#include <vector>
+#include "INETDefs.h"
+#include "AirFrame_m.h"
+#include "SnrList.h"
+
+
+/**
+ * Keeps track of the frames on the air at a receiver and of the noise
+ * level, for radio modules that receive one frame at a time and treat all
+ * other frames as noise (AbstractRadio, SnrEval and their subclasses).
+ *
+ * The frames are stored with their receive power in a vector. The noise
+ * level is a running sum: the power of a noise frame is added when the
+ * frame starts and subtracted when it ends. For the frame being received,
+ * the SNR is recorded at every change of the noise level into an SnrList,
+ * which is reused from one reception to the next.
+ */
+class INET_API InterferenceTracker
+{
+  public:
+    /** A frame on the air, with its receive power */
+    struct Signal
+    {
+        AirFrame *frame;
+        double power;
+    };
+
+  protected:
+    std::vector<Signal> signals;
+    double noiseLevel;
+    AirFrame *receivedFrame;
+    double receivedPower;
+    SnrList snrList;
+
+  protected:
+    int findSignal(AirFrame *frame) const;
+    void removeSignal(int i);
+
+  public:
+    InterferenceTracker();
+
+    /** Sets the noise level to the thermal noise; to be called before the first frame arrives */
+    void setThermalNoise(double thermalNoise) {noiseLevel = thermalNoise;}
+
+    /** Returns the thermal noise plus the power of the frames treated as noise */
+    double getNoiseLevel() const {return noiseLevel;}
+
+    /** @name Frames on the air */
+    //@{
+    /** Stores a frame; addNoise() or startReception() must follow */
+    void addSignal(AirFrame *frame, double power);
+
+    /** Treats a stored frame as noise: adds its power to the noise level */
+    void addNoise(AirFrame *frame);
+
+    /**
+     * Removes a frame treated as noise, and subtracts its power from the
+     * noise level. For the frame being received, see endReception().
+     */
+    void removeNoise(AirFrame *frame);
+
+    int getNumSignals() const {return signals.size();}
+    AirFrame *getSignal(int k) const {return signals[k].frame;}
+
+    /** Forgets all frames (but not their contribution to the noise level) */
+    void clearSignals() {signals.clear();}
+    //@}
+
+    /** @name The frame being received */
+    //@{
+    /** Starts receiving a stored frame, and records the initial SNR */
+    void startReception(AirFrame *frame);
+
+    /** Returns the frame being received, or NULL */
+    AirFrame *getReceivedFrame() const {return receivedFrame;}
+
+    /** Returns the receive power of the frame being received */
+    double getReceivedPower() const {return receivedPower;}
+
+    /** Records the current SNR of the frame being received */
+    void recordSnr();
+
+    /**
+     * Returns the SNR values recorded during the reception. The list is
+     * valid until the next reception starts.
+     */
+    const SnrList& getSnrList() const {return snrList;}
+
+    /**
+     * The reception is over: removes the received frame. The SNR list
+     * stays available.
+     */
+    void endReception();
+
+    /** The frame being received becomes noise (e.g. because we start transmitting) */
+    void abortReception();
+
+    /** Stops the reception without any change in the noise level (e.g. at a channel change) */
+    void cancelReception() {receivedFrame = NULL;}
+    //@}
+};
+
+inline std::ostream& operator<<(std::ostream& os, const InterferenceTracker& tracker)
+{
+    return os << "noiseLevel=" << tracker.getNoiseLevel() << " frames=" << tracker.getNumSignals()
+              << (tracker.getReceivedFrame() ? " receiving" : "");
+}
+
+#endif
+
@@ -52,6 +52,10 @@ void PPP::initialize(int stage)
         endTransmissionEvent = new cMessage("pppEndTxEvent");
 
         txQueueLimit = par("txQueueLimit");
+        maxTrainLength = par("maxTrainLength");
+        if (maxTrainLength<1)
+            error("maxTrainLength must be at least 1");
+        trainLength = 0;
 
         interfaceEntry = NULL;
 
@@ -156,6 +160,12 @@ InterfaceEntry *PPP::registerInterface(double datarate)
 
 void PPP::startTransmitting(cPacket *msg)
 {
+    if (maxTrainLength>1)
+    {
+        startTransmittingTrain(msg);
+        return;
+    }
+
     // if there's any control info, remove it; then encapsulate the packet
     delete msg->removeControlInfo();
     PPPFrame *pppFrame = encapsulate(msg);
@@ -165,6 +175,7 @@ void PPP::startTransmitting(cPacket *msg)
     {
         // fire notification
         notifDetails.setPacket(pppFrame);
+        notifDetails.setNumPackets(1);
         nb->fireChangeNotification(NF_PP_TX_BEGIN, &notifDetails);
     }
 
@@ -175,6 +186,67 @@ void PPP::startTransmitting(cPacket *msg)
     // schedule an event for the time when last bit will leave the gate.
     simtime_t endTransmissionTime = datarateChannel->getTransmissionFinishTime();
     scheduleAt(endTransmissionTime, endTransmissionEvent);
+    trainLength = 1;
+    numSent++;
+}
+
+void PPP::startTransmittingTrain(cPacket *msg)
+{
+    // Packet train: take all packets waiting for transmission (up to
+    // maxTrainLength), and send them back-to-back with sendDelayed(),
+    // each one at the time the previous one's last bit leaves the gate.
+    // Arrival times at the peer are the same as with one-by-one
+    // transmission, but we only need one end-of-transmission event.
+    if (ev.isGUI()) displayBusy();
+
+    simtime_t now = simTime();
+    simtime_t startTime = now;
+    PPPFrame *firstFrame = NULL;
+    trainLength = 0;
+    while (msg)
+    {
+        // if there's any control info, remove it; then encapsulate the packet
+        delete msg->removeControlInfo();
+        PPPFrame *pppFrame = encapsulate(msg);
+        if (!firstFrame)
+            firstFrame = pppFrame;
+
+        EV << "Starting transmission of " << pppFrame << " (" << trainLength+1 << ". frame of packet train)\n";
+        sendDelayed(pppFrame, startTime-now, physOutGate);
+        startTime = datarateChannel->getTransmissionFinishTime();
+        trainLength++;
+        numSent++;
+
+        msg = (trainLength<maxTrainLength) ? getNextTrainPacket() : NULL;
+    }
+
+    if (hasSubscribers)
+    {
+        // fire a single notification for the whole train
+        notifDetails.setPacket(firstFrame);
+        notifDetails.setNumPackets(trainLength);
+        nb->fireChangeNotification(NF_PP_TX_BEGIN, &notifDetails);
+    }
+
+    // schedule an event for the time when last bit of the train will leave the gate.
+    scheduleAt(startTime, endTransmissionEvent);
+}
+
+cPacket *PPP::getNextTrainPacket()
+{
+    if (!txQueue.empty())
+        return (cPacket *) txQueue.pop();
+
+    if (queueModule)
+    {
+        cMessage *msg = queueModule->pop();
+        if (msg)
+        {
+            take(msg);
+            return PK(msg);
+        }
+    }
+    return NULL;
 }
 
 void PPP::handleMessage(cMessage *msg)
@@ -195,6 +267,7 @@ void PPP::handleMessage(cMessage *msg)
         {
             // fire notification
             notifDetails.setPacket(NULL);
+            notifDetails.setNumPackets(trainLength);
             nb->fireChangeNotification(NF_PP_TX_END, &notifDetails);
         }
 
@@ -202,7 +275,6 @@ void PPP::handleMessage(cMessage *msg)
         {
             cPacket *pk = (cPacket *) txQueue.pop();
             startTransmitting(pk);
-            numSent++;
         }
         else if (queueModule)
         {
@@ -216,6 +288,7 @@ void PPP::handleMessage(cMessage *msg)
         {
             // fire notification
             notifDetails.setPacket(PK(msg));
+            notifDetails.setNumPackets(1);
             nb->fireChangeNotification(NF_PP_RX_END, &notifDetails);
         }
 
@@ -255,7 +328,6 @@ void PPP::handleMessage(cMessage *msg)
             // We are idle, so we can start transmitting right away.
             EV << "Received " << msg << " for transmission\n";
             startTransmitting(PK(msg));
-            numSent++;
         }
     }
 
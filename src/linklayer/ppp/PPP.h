@@ -36,11 +36,13 @@ class INET_API PPP : public cSimpleModule, public INotifiable
 {
   protected:
     long txQueueLimit;
+    int maxTrainLength;         // max number of frames sent in one go; 1 means no packet trains
     cGate *physOutGate;
     cChannel *datarateChannel; // NULL if we're not connected
 
     cQueue txQueue;
     cMessage *endTransmissionEvent;
+    int trainLength;            // number of frames in the train being transmitted
     IPassiveQueue *queueModule;
 
     InterfaceEntry *interfaceEntry;  // points into IInterfaceTable
@@ -60,6 +62,8 @@ class INET_API PPP : public cSimpleModule, public INotifiable
   protected:
     virtual InterfaceEntry *registerInterface(double datarate);
     virtual void startTransmitting(cPacket *msg);
+    virtual void startTransmittingTrain(cPacket *msg);
+    virtual cPacket *getNextTrainPacket();
     virtual PPPFrame *encapsulate(cPacket *msg);
     virtual cPacket *decapsulate(PPPFrame *pppFrame);
     virtual void displayBusy();
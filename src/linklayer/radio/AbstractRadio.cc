@@ -57,25 +57,21 @@ void AbstractRadio::initialize(int stage)
         sensitivity = FWMath::dBm2mW(par("sensitivity"));
 
         // initialize noiseLevel
-        noiseLevel = thermalNoise;
+        interference.setThermalNoise(thermalNoise);
 
-        EV << "Initialized channel with noise: " << noiseLevel << " sensitivity: " << sensitivity <<
+        EV << "Initialized channel with noise: " << interference.getNoiseLevel() << " sensitivity: " << sensitivity <<
             endl;
 
-        // initialize the pointer of the snrInfo with NULL to indicate
-        // that currently no message is received
-        snrInfo.ptr = NULL;
-
         // no channel switch pending
         newChannel = -1;
 
         // Initialize radio state. If thermal noise is already to high, radio
         // state has to be initialized as RECV
         rs.setState(RadioState::IDLE);
-        if (noiseLevel >= sensitivity)
+        if (interference.getNoiseLevel() >= sensitivity)
             rs.setState(RadioState::RECV);
 
-        WATCH(noiseLevel);
+        WATCH(interference);
         WATCH(rs);
 
         receptionModel = createReceptionModel();
@@ -109,8 +105,8 @@ AbstractRadio::~AbstractRadio()
     delete receptionModel;
 
     // delete messages being received
-    for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
-        delete it->first;
+    for (int i = 0; i < interference.getNumSignals(); i++)
+        delete interference.getSignal(i);
 }
 
 /**
@@ -247,20 +243,13 @@ void AbstractRadio::handleUpperMsg(AirFrame *airframe)
               "take care this does not happen");
 
     // if a packet was being received, it is corrupted now as should be treated as noise
-    if (snrInfo.ptr != NULL)
+    if (interference.getReceivedFrame() != NULL)
     {
         EV << "Sending a message while receiving another. The received one is now corrupted.\n";
 
-        // remove the snr information stored for the message currently being
-        // received. This message is treated as noise now and the
-        // receive power has to be added to the noiseLevel
-
-        // delete the pointer to indicate that no message is being received
-        snrInfo.ptr = NULL;
-        // clear the snr list
-        snrInfo.sList.clear();
-        // add the receive power to the noise level
-        noiseLevel += snrInfo.rcvdPower;
+        // the message is treated as noise now: its receive power is added
+        // to the noiseLevel
+        interference.abortReception();
     }
 
     // now we are done with all the exception handling and can take care
@@ -335,7 +324,7 @@ void AbstractRadio::handleSelfMsg(cMessage *msg)
         // to IDLE or RECV, based on the noise level on the channel.
         // If the noise level is bigger than the sensitivity switch to receive mode,
         // otherwise to idle mode.
-        if (noiseLevel < sensitivity)
+        if (interference.getNoiseLevel() < sensitivity)
         {
             // set the RadioState to IDLE
             EV << "transmission over, switch to idle mode (state:IDLE)\n";
@@ -370,7 +359,7 @@ void AbstractRadio::handleSelfMsg(cMessage *msg)
  * before it is buffered for 'transmission time'.
  *
  * First the receive power of the packet has to be calculated and is
- * stored in the recvBuff. Afterwards it has to be decided whether the
+ * stored together with the frame. Afterwards it has to be decided whether the
  * packet is just noise or a "real" packet that needs to be received.
  *
  * The message is not treated as noise if all of the following
@@ -400,26 +389,20 @@ void AbstractRadio::handleLowerMsgStart(AirFrame * airframe)
     // calculate receive power
     double rcvdPower = receptionModel->calculateReceivedPower(airframe->getPSend(), carrierFrequency, distance);
 
-    // store the receive power in the recvBuff
-    recvBuff[airframe] = rcvdPower;
+    // store the receive power
+    interference.addSignal(airframe, rcvdPower);
 
     // if receive power is bigger than sensitivity and if not sending
     // and currently not receiving another message and the message has
     // arrived in time
     // NOTE: a message may have arrival time in the past here when we are
     // processing ongoing transmissions during a channel change
-    if (airframe->getArrivalTime() == simTime() && rcvdPower >= sensitivity && rs.getState() != RadioState::TRANSMIT && snrInfo.ptr == NULL)
+    if (airframe->getArrivalTime() == simTime() && rcvdPower >= sensitivity && rs.getState() != RadioState::TRANSMIT && interference.getReceivedFrame() == NULL)
     {
         EV << "receiving frame " << airframe->getName() << endl;
 
-        // Put frame and related SnrList in receive buffer
-        SnrList snrList;
-        snrInfo.ptr = airframe;
-        snrInfo.rcvdPower = rcvdPower;
-        snrInfo.sList = snrList;
-
-        // add initial snr value
-        addNewSnr();
+        // start a new SnrList, with the initial snr value
+        interference.startReception(airframe);
 
         if (rs.getState() != RadioState::RECV)
         {
@@ -433,10 +416,10 @@ void AbstractRadio::handleLowerMsgStart(AirFrame * airframe)
     {
         EV << "frame " << airframe->getName() << " is just noise\n";
         //add receive power to the noise level
-        noiseLevel += rcvdPower;
+        interference.addNoise(airframe);
 
         // if a message is being received add a new snr value
-        if (snrInfo.ptr != NULL)
+        if (interference.getReceivedFrame() != NULL)
         {
             // update snr info for currently being received message
             EV << "adding new snr value to snr list of message being received\n";
@@ -445,7 +428,7 @@ void AbstractRadio::handleLowerMsgStart(AirFrame * airframe)
 
         // update the RadioState if the noiseLevel exceeded the threshold
         // and the radio is currently not in receive or in send mode
-        if (noiseLevel >= sensitivity && rs.getState() == RadioState::IDLE)
+        if (interference.getNoiseLevel() >= sensitivity && rs.getState() == RadioState::IDLE)
         {
             EV << "setting radio state to RECV\n";
             setRadioState(RadioState::RECV);
@@ -467,20 +450,13 @@ void AbstractRadio::handleLowerMsgStart(AirFrame * airframe)
 void AbstractRadio::handleLowerMsgEnd(AirFrame * airframe)
 {
     // check if message has to be send to the decider
-    if (snrInfo.ptr == airframe)
+    if (interference.getReceivedFrame() == airframe)
     {
         EV << "reception of frame over, preparing to send packet to upper layer\n";
-        // get Packet and list out of the receive buffer:
-        SnrList list;
-        list = snrInfo.sList;
-
-        // delete the pointer to indicate that no message is currently
-        // being received and clear the list
-        snrInfo.ptr = NULL;
-        snrInfo.sList.clear();
-
-        // delete the frame from the recvBuff
-        recvBuff.erase(airframe);
+        // no message is currently being received; the list stays valid
+        // until the next reception starts, so it needn't be copied
+        interference.endReception();
+        const SnrList& list = interference.getSnrList();
 
         //XXX send up the frame:
         //if (radioModel->isReceivedCorrectly(airframe, list))
@@ -499,13 +475,10 @@ void AbstractRadio::handleLowerMsgEnd(AirFrame * airframe)
     {
         EV << "reception of noise message over, removing recvdPower from noiseLevel....\n";
         // get the rcvdPower and subtract it from the noiseLevel
-        noiseLevel -= recvBuff[airframe];
-
-        // delete message from the recvBuff
-        recvBuff.erase(airframe);
+        interference.removeNoise(airframe);
 
         // update snr info for message currently being received if any
-        if (snrInfo.ptr != NULL)
+        if (interference.getReceivedFrame() != NULL)
         {
             addNewSnr();
         }
@@ -519,7 +492,7 @@ void AbstractRadio::handleLowerMsgEnd(AirFrame * airframe)
     // change to idle if noiseLevel smaller than threshold and state was
     // not idle before
     // do not change state if currently sending or receiving a message!!!
-    if (noiseLevel < sensitivity && rs.getState() == RadioState::RECV && snrInfo.ptr == NULL)
+    if (interference.getNoiseLevel() < sensitivity && rs.getState() == RadioState::RECV && interference.getReceivedFrame() == NULL)
     {
         // publish the new RadioState:
         EV << "new RadioState is IDLE\n";
@@ -529,10 +502,7 @@ void AbstractRadio::handleLowerMsgEnd(AirFrame * airframe)
 
 void AbstractRadio::addNewSnr()
 {
-    SnrListEntry listEntry;     // create a new entry
-    listEntry.time = simTime();
-    listEntry.snr = snrInfo.rcvdPower / noiseLevel;
-    snrInfo.sList.push_back(listEntry);
+    interference.recordSnr();
 }
 
 void AbstractRadio::changeChannel(int channel)
@@ -548,19 +518,18 @@ void AbstractRadio::changeChannel(int channel)
     if (rs.getState() == RadioState::RECV)
     {
         // delete messages being received, and cancel associated self-messages
-        for (RecvBuff::iterator it = recvBuff.begin(); it!=recvBuff.end(); ++it)
+        for (int i = 0; i < interference.getNumSignals(); i++)
         {
-            AirFrame *airframe = it->first;
+            AirFrame *airframe = interference.getSignal(i);
             cMessage *endRxTimer = (cMessage *)airframe->getContextPointer();
             delete airframe;
             delete cancelEvent(endRxTimer);
         }
-        recvBuff.clear();
+        interference.clearSignals();
     }
 
     // clear snr info
-    snrInfo.ptr = NULL;
-    snrInfo.sList.clear();
+    interference.cancelReception();
 
     // do channel switch
     EV << "Changing to channel #" << channel << "\n";
@@ -578,7 +547,7 @@ void AbstractRadio::changeChannel(int channel)
     {
         AirFrame *airframe = *it;
         // time for the message to reach us
-        double distance = myHostRef->pos.distance(airframe->getSenderPos());
+        double distance = getMyPosition().distance(airframe->getSenderPos());
         simtime_t propagationDelay = distance / LIGHT_SPEED;
 
         // if this transmission is on our new channel and it would reach us in the future, then schedule it
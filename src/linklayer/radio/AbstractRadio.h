@@ -24,7 +24,7 @@
 #include "AirFrame_m.h"
 #include "IRadioModel.h"
 #include "IReceptionModel.h"
-#include "SnrList.h"
+#include "InterferenceTracker.h"
 
 
 
@@ -98,7 +98,7 @@ class INET_API AbstractRadio : public ChannelAccess
     /** Returns the current channel the radio is tuned to */
     virtual int getChannelNumber() const {return rs.getChannelNumber();}
 
-    /** Updates the SNR information of the relevant AirFrame */
+    /** Records the SNR of the frame being received, after a change of the noise level */
     virtual void addNewSnr();
 
     /** Create a new AirFrame */
@@ -147,34 +147,11 @@ class INET_API AbstractRadio : public ChannelAccess
     //@}
 
     /**
-     * Struct to store a pointer to the message, rcvdPower AND a SnrList,
-     * needed in addNewSnr().
+     * State: the frames on the air with their receive power, the frame
+     * currently being received with its SNR over time, and the noise level
+     * of the channel.
      */
-    struct SnrStruct
-    {
-        AirFrame *ptr;    ///< pointer to the message this information belongs to
-        double rcvdPower; ///< received power of the message
-        SnrList sList;    ///< stores SNR over time
-    };
-
-    /**
-     * State: SnrInfo stores the snrList and the the recvdPower for the
-     * message currently being received, together with a pointer to the
-     * message.
-     */
-    SnrStruct snrInfo;
-
-    /**
-     * Typedef used to store received messages together with
-     * receive power.
-     */
-    typedef std::map<AirFrame*,double> RecvBuff;
-
-    /**
-     * State: A buffer to store a pointer to a message and the related
-     * receive power.
-     */
-    RecvBuff recvBuff;
+    InterferenceTracker interference;
 
     /** State: the current RadioState of the NIC; includes channel number */
     RadioState rs;
@@ -185,9 +162,6 @@ class INET_API AbstractRadio : public ChannelAccess
     /** State: if not -1, we have to switch to that bitrate once we finished transmitting */
     double newBitrate;
 
-    /** State: the current noise level of the channel.*/
-    double noiseLevel;
-
     /**
      * Configuration: The carrier frequency used. It is read from the ChannelControl module.
      */
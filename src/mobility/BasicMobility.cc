@@ -49,6 +49,13 @@ void BasicMobility::initialize(int stage)
         // get a pointer to the host
         hostPtr = findHost();
         myHostRef = cc->registerHost(hostPtr, Coord());
+
+        // not all mobility models support lazy updates
+        lazyUpdate = hasPar("lazyUpdate") && par("lazyUpdate").boolValue();
+        maxDrift = lazyUpdate ? par("maxDrift").doubleValue() : 0;
+        if (lazyUpdate)
+            cc->registerLazyMobility(myHostRef, this, maxDrift);
+        lastUpdateTime = currentPosTime = simTime();
     }
     else if (stage == 1)
     {
@@ -96,6 +103,8 @@ void BasicMobility::handleMessage(cMessage * msg)
 void BasicMobility::updatePosition()
 {
     cc->updateHostPosition(myHostRef, pos);
+    lastUpdateTime = currentPosTime = simTime();
+    currentPos = pos;
 
     if (ev.isGUI())
     {
@@ -108,6 +117,30 @@ void BasicMobility::updatePosition()
 }
 
 
+const Coord& BasicMobility::getCurrentPosition()
+{
+    if (!lazyUpdate)
+        return pos;
+
+    if (currentPosTime != simTime())
+    {
+        currentPos = calculatePosition(simTime());
+        currentPosTime = simTime();
+    }
+    return currentPos;
+}
+
+Coord BasicMobility::calculatePosition(simtime_t t)
+{
+    throw cRuntimeError(this, "lazyUpdate is not supported by %s", getClassName());
+}
+
+simtime_t BasicMobility::getDriftTime(double speed)
+{
+    ASSERT(speed > 0);
+    return simTime() + maxDrift / speed;
+}
+
 /**
  * You can redefine this function if you want to use another
  * calculation
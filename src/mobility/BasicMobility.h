@@ -28,6 +28,7 @@
 #include "BasicModule.h"
 #include "ChannelControl.h"
 #include "Coord.h"
+#include "ILazyMobility.h"
 
 
 /**
@@ -42,11 +43,23 @@
  * Change notifications about position changes are also posted to
  * NotificationBoard.
  *
+ * Models may support lazy position updates (the "lazyUpdate" parameter).
+ * Then the position is not updated every updateInterval: the model
+ * calculates the position from the current movement in
+ * calculatePosition() when it is asked for (i.e. when a frame is sent
+ * or received), and only reports it to ChannelControl when the host has
+ * got maxDrift meters away from the last reported position, or when the
+ * movement changes. Border policies are applied at these updates, so
+ * between two updates the host may be outside the playground by up to
+ * maxDrift. The display string and NF_HOSTPOSITION_UPDATED also only
+ * follow the updates; the current position is returned by
+ * getCurrentPosition() and ChannelControl::getHostPosition().
+ *
  * @ingroup mobility
  * @ingroup basicModules
  * @author Daniel Willkomm, Andras Varga
  */
-class INET_API BasicMobility : public BasicModule
+class INET_API BasicMobility : public BasicModule, public ILazyMobility
 {
   public:
     /**
@@ -70,9 +83,22 @@ class INET_API BasicMobility : public BasicModule
     /** @brief Pointer to host module, to speed up repeated access*/
     cModule* hostPtr;
 
-    /** @brief Stores the actual position of the host*/
+    /** @brief Stores the actual position of the host (with lazyUpdate, the position at the last update)*/
     Coord pos;
 
+    /** @brief If true, the position is only calculated when it is needed */
+    bool lazyUpdate;
+
+    /** @brief With lazyUpdate: the max distance between the last reported and the actual position */
+    double maxDrift;
+
+    /** @brief With lazyUpdate: the time of the last updatePosition() call */
+    simtime_t lastUpdateTime;
+
+    /** @brief With lazyUpdate: the position at currentPosTime, as returned by getCurrentPosition() */
+    Coord currentPos;
+    simtime_t currentPosTime;
+
   protected:
     /** @brief This modules should only receive self-messages*/
     virtual void handleMessage(cMessage *msg);
@@ -97,6 +123,22 @@ class INET_API BasicMobility : public BasicModule
      */
     virtual void updatePosition();
 
+    /**
+     * @brief With lazyUpdate: calculates the position at the given time,
+     * which is not earlier than the last updatePosition() call, and not
+     * later than the next self-message. Models that support lazyUpdate must
+     * redefine it.
+     */
+    virtual Coord calculatePosition(simtime_t t);
+
+    /**
+     * @brief With lazyUpdate: returns when the host, moving at the given
+     * speed (m/s, must be positive), gets maxDrift away from the current
+     * position; the next position update must be scheduled no later than
+     * that.
+     */
+    virtual simtime_t getDriftTime(double speed);
+
     /** @brief Returns the width of the playground */
     virtual double getPlaygroundSizeX() const  {return cc->getPgs()->x;}
 
@@ -140,6 +182,12 @@ class INET_API BasicMobility : public BasicModule
      */
     virtual void handleIfOutside(BorderPolicy policy, Coord& targetPos, Coord& step, double& angle);
 
+  public:
+    /**
+     * @brief Implements ILazyMobility: returns pos, or with lazyUpdate, the
+     * position calculated by calculatePosition() for the current time.
+     */
+    virtual const Coord& getCurrentPosition();
 };
 
 #endif
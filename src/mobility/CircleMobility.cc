@@ -59,14 +59,27 @@ void CircleMobility::handleSelfMsg(cMessage * msg)
 {
     move();
     updatePosition();
-    scheduleAt(simTime() + updateInterval, msg);
+    if (!lazyUpdate)
+        scheduleAt(simTime() + updateInterval, msg);
+    else
+        scheduleAt(getDriftTime(fabs(omega * r)), msg);
 }
 
 void CircleMobility::move()
 {
-    angle += omega * updateInterval;
+    if (!lazyUpdate)
+        angle += omega * updateInterval;
+    else
+        angle += omega * SIMTIME_DBL(simTime() - lastUpdateTime);
     pos.x = cx + r * cos(angle);
     pos.y = cy + r * sin(angle);
 
     EV << " xpos= " << pos.x << " ypos=" << pos.y << endl;
 }
+
+Coord CircleMobility::calculatePosition(simtime_t t)
+{
+    double a = angle + omega * SIMTIME_DBL(t - lastUpdateTime);
+    return Coord(cx + r * cos(a), cy + r * sin(a));
+}
+
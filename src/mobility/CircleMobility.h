@@ -40,7 +40,7 @@ class INET_API CircleMobility : public BasicMobility
     bool stationary;       ///< if true, the host doesn't move
 
     // state
-    double angle;  ///< direction from the centre of the circle
+    double angle;  ///< direction from the centre of the circle (with lazyUpdate, at the last update)
 
   protected:
     /** @brief Initializes mobility model parameters.*/
@@ -52,6 +52,9 @@ class INET_API CircleMobility : public BasicMobility
 
     /** @brief Move the host*/
     virtual void move();
+
+    /** @brief Redefined from BasicMobility, for lazyUpdate */
+    virtual Coord calculatePosition(simtime_t t);
 };
 
 #endif
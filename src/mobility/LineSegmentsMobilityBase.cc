@@ -30,6 +30,7 @@ void LineSegmentsMobilityBase::initialize(int stage)
         stationary = false;
         targetPos = pos;
         targetTime = simTime();
+        step.x = step.y = 0;
 
         // host moves the first time after some random delay to avoid synchronized movements
         scheduleAt(simTime() + uniform(0, updateInterval), new cMessage("move"));
@@ -72,7 +73,14 @@ void LineSegmentsMobilityBase::beginNextMove(cMessage *msg)
         //        = (targetPos-pos) / (targetTime-now) * updateInterval =
         //        = (targetPos-pos) / numIntervals
         step = (targetPos - pos) / numIntervals;
-        scheduleAt(simTime() + updateInterval, msg);
+        if (!lazyUpdate)
+            scheduleAt(simTime() + updateInterval, msg);
+        else
+        {
+            // next update at the end of the segment, or when we get maxDrift away
+            double speed = pos.distance(targetPos) / SIMTIME_DBL(targetTime-now);
+            scheduleAt(std::max(simTime(), std::min(targetTime, getDriftTime(speed))), msg);
+        }
     }
 }
 
@@ -83,6 +91,19 @@ void LineSegmentsMobilityBase::handleSelfMsg(cMessage *msg)
         delete msg;
         return;
     }
+    else if (lazyUpdate)
+    {
+        if (simTime() >= targetTime)
+            beginNextMove(msg);
+        else
+            scheduleAt(std::min(targetTime, getDriftTime(step.distance(Coord()) / updateInterval)), msg);
+
+        // update position
+        pos = calculatePosition(simTime());
+        fixIfHostGetsOutside();
+        updatePosition();
+        return;
+    }
     else if (simTime()+updateInterval >= targetTime)
     {
         beginNextMove(msg);
@@ -103,4 +124,13 @@ void LineSegmentsMobilityBase::handleSelfMsg(cMessage *msg)
     updatePosition();
 }
 
+/**
+ * Step is the movement during updateInterval, and the segment ends at
+ * targetPos at targetTime. The border policies keep these consistent
+ * when they reflect or move the host.
+ */
+Coord LineSegmentsMobilityBase::calculatePosition(simtime_t t)
+{
+    return targetPos - step * (SIMTIME_DBL(targetTime - t) / updateInterval);
+}
 
@@ -29,6 +29,9 @@
  * Subclasses must redefine setTargetPosition() which is suppsed to set
  * a new target position and target time once the previous one is reached.
  *
+ * Supports lazyUpdate: the position is then interpolated between the
+ * start and the end of the current line segment.
+ *
  * @ingroup mobility
  * @author Andras Varga
  */
@@ -54,6 +57,9 @@ class INET_API LineSegmentsMobilityBase : public BasicMobility
     /** @brief Begin new line segment after previous one finished */
     virtual void beginNextMove(cMessage *msg);
 
+    /** @brief Redefined from BasicMobility, for lazyUpdate */
+    virtual Coord calculatePosition(simtime_t t);
+
     /**
      * @brief Should be redefined in subclasses. This method gets called
      * when targetPos and targetTime has been reached, and its task is
@@ -54,7 +54,8 @@ void MassMobility::initialize(int stage)
         step.x = currentSpeed * cos(PI * currentAngle / 180) * updateInterval;
         step.y = currentSpeed * sin(PI * currentAngle / 180) * updateInterval;
 
-        scheduleAt(simTime() + uniform(0, updateInterval), new cMessage("move", MK_UPDATE_POS));
+        moveMsg = new cMessage("move", MK_UPDATE_POS);
+        scheduleAt(simTime() + uniform(0, updateInterval), moveMsg);
         scheduleAt(simTime() + uniform(0, changeInterval->doubleValue()), new cMessage("turn", MK_CHANGE_DIR));
     }
 }
@@ -70,13 +71,25 @@ void MassMobility::handleSelfMsg(cMessage * msg)
     case MK_UPDATE_POS:
         move();
         updatePosition();
-        scheduleAt(simTime() + updateInterval, msg);
+        scheduleMove();
         break;
     case MK_CHANGE_DIR:
+        if (lazyUpdate)
+        {
+            // finish the movement in the old direction
+            move();
+            updatePosition();
+        }
         currentAngle += changeAngleBy->doubleValue();
         currentSpeed = speed->doubleValue();
         step.x = currentSpeed * cos(PI * currentAngle / 180) * updateInterval;
         step.y = currentSpeed * sin(PI * currentAngle / 180) * updateInterval;
+        if (lazyUpdate)
+        {
+            // the next update depends on the new speed
+            cancelEvent(moveMsg);
+            scheduleMove();
+        }
         scheduleAt(simTime() + changeInterval->doubleValue(), msg);
         break;
     default:
@@ -92,7 +105,10 @@ void MassMobility::handleSelfMsg(cMessage * msg)
  */
 void MassMobility::move()
 {
-    pos += step;
+    if (!lazyUpdate)
+        pos += step;
+    else
+        pos = calculatePosition(simTime());
 
     // do something if we reach the wall
     Coord dummy;
@@ -101,3 +117,16 @@ void MassMobility::move()
     EV << " xpos= " << pos.x << " ypos=" << pos.y << " speed=" << currentSpeed << endl;
 }
 
+void MassMobility::scheduleMove()
+{
+    if (!lazyUpdate)
+        scheduleAt(simTime() + updateInterval, moveMsg);
+    else if (currentSpeed != 0)
+        scheduleAt(getDriftTime(fabs(currentSpeed)), moveMsg);
+}
+
+Coord MassMobility::calculatePosition(simtime_t t)
+{
+    return pos + step * (SIMTIME_DBL(t - lastUpdateTime) / updateInterval);
+}
+
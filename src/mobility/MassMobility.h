@@ -46,6 +46,7 @@ class INET_API MassMobility : public BasicMobility
     double currentAngle;   ///< angle of linear motion
     double updateInterval; ///< time interval to update the hosts position
     Coord step;            ///< calculated from speed, angle and updateInterval
+    cMessage *moveMsg;     ///< position update timer
 
   protected:
     /** @brief Initializes mobility model parameters.*/
@@ -57,6 +58,12 @@ class INET_API MassMobility : public BasicMobility
 
     /** @brief Move the host*/
     virtual void move();
+
+    /** @brief Redefined from BasicMobility, for lazyUpdate */
+    virtual Coord calculatePosition(simtime_t t);
+
+    /** @brief Schedules the next position update */
+    virtual void scheduleMove();
 };
 
 #endif
@@ -27,41 +27,58 @@ static std::ostream& operator<< (std::ostream& out, cMessage *msg)
     return out;
 }
 
-static std::ostream& operator<< (std::ostream& out, const ARP::ARPCacheEntry& e)
-{
-    if (e.pending)
-        out << "pending (" << e.numRetries << " retries)";
-    else
-        out << "MAC:" << e.macAddress << "  age:" << floor(simTime()-e.lastUpdate) << "s";
-    return out;
-}
-
-
 Define_Module (ARP);
 
-void ARP::initialize()
-{
-    ift = InterfaceTableAccess().get();
-    rt = RoutingTableAccess().get();
-
-    nicOutBaseGateId = gateSize("nicOut")==0 ? -1 : gate("nicOut",0)->getId();
-
-    retryTimeout = par("retryTimeout");
-    retryCount = par("retryCount");
-    cacheTimeout = par("cacheTimeout");
-    doProxyARP = par("proxyARP");
-
-    pendingQueue.setName("pendingQueue");
+ARP::GlobalARPTable ARP::globalARPTable;
+int ARP::numInstances = 0;
 
-    // init statistics
-    numRequestsSent = numRepliesSent = 0;
-    numResolutions = numFailedResolutions = 0;
-    WATCH(numRequestsSent);
-    WATCH(numRepliesSent);
-    WATCH(numResolutions);
-    WATCH(numFailedResolutions);
-
-    WATCH_PTRMAP(arpCache);
+void ARP::initialize(int stage)
+{
+    if (stage==0)
+    {
+        ift = InterfaceTableAccess().get();
+        rt = RoutingTableAccess().get();
+
+        nicOutBaseGateId = gateSize("nicOut")==0 ? -1 : gate("nicOut",0)->getId();
+
+        retryTimeout = par("retryTimeout");
+        retryCount = par("retryCount");
+        cacheTimeout = par("cacheTimeout");
+        doProxyARP = par("proxyARP");
+        precomputedARP = par("precomputedARP");
+
+        arpCache.resize(gateSize("nicOut"));
+        numCacheEntries = 0;
+        timerMsg = new cMessage("ARP timer");
+
+        pendingQueue.setName("pendingQueue");
+
+        // init statistics
+        numRequestsSent = numRepliesSent = 0;
+        numResolutions = numFailedResolutions = 0;
+        WATCH(numRequestsSent);
+        WATCH(numRepliesSent);
+        WATCH(numResolutions);
+        WATCH(numFailedResolutions);
+        WATCH(numCacheEntries);
+    }
+    else if (stage==3)
+    {
+        // addresses are assigned by now (configurators run in stage 2):
+        // register our interfaces for precomputed mode
+        if (precomputedARP)
+        {
+            for (int i=0; i<ift->getNumInterfaces(); i++)
+            {
+                InterfaceEntry *ie = ift->getInterface(i);
+                if (ie->isBroadcast() && ie->ipv4Data() && !ie->ipv4Data()->getIPAddress().isUnspecified())
+                {
+                    addGlobalEntry(ie->ipv4Data()->getIPAddress(), ie->getMacAddress());
+                    ownGlobalEntries.push_back(std::make_pair(ie->ipv4Data()->getIPAddress(), ie->getMacAddress()));
+                }
+            }
+        }
+    }
 }
 
 void ARP::finish()
@@ -74,19 +91,46 @@ void ARP::finish()
 
 ARP::~ARP()
 {
-    while (!arpCache.empty())
+    for (int i=0; i<(int)arpCache.size(); i++)
+        for (ARPCache::iterator it=arpCache[i].begin(); it!=arpCache[i].end(); ++it)
+            delete it->second;
+    cancelAndDelete(timerMsg);
+
+    // remove our addresses from the global table, unless they have been
+    // taken over by another node since; the last instance clears the table,
+    // so that it does not leak into the next run
+    for (int i=0; i<(int)ownGlobalEntries.size(); i++)
     {
-        ARPCache::iterator i = arpCache.begin();
-        delete (*i).second;
-        arpCache.erase(i);
+        GlobalARPTable::iterator it = globalARPTable.find(ownGlobalEntries[i].first);
+        if (it!=globalARPTable.end() && it->second==ownGlobalEntries[i].second)
+            globalARPTable.erase(it);
     }
+    if (--numInstances == 0)
+        globalARPTable.clear();
+}
+
+void ARP::addGlobalEntry(IPAddress ipAddress, const MACAddress& macAddress)
+{
+    globalARPTable[ipAddress] = macAddress;
+}
+
+void ARP::addStaticEntry(InterfaceEntry *ie, IPAddress ipAddress, const MACAddress& macAddress)
+{
+    Enter_Method("addStaticEntry(%s)", ipAddress.str().c_str());
+
+    ARPCacheEntry *entry = findEntry(ie, ipAddress);
+    if (!entry)
+        entry = createEntry(ie, ipAddress);
+    unscheduleEntry(entry);
+    entry->isStatic = true;
+    updateARPCache(entry, macAddress);
 }
 
 void ARP::handleMessage(cMessage *msg)
 {
-    if (msg->isSelfMessage())
+    if (msg==timerMsg)
     {
-        requestTimedOut(msg);
+        processTimer();
     }
     else if (dynamic_cast<ARPPacket *>(msg))
     {
@@ -105,11 +149,113 @@ void ARP::updateDisplayString()
 {
     std::stringstream os;
 
-    os << arpCache.size() << " cache entries\nsent req:" << numRequestsSent
+    os << numCacheEntries << " cache entries\nsent req:" << numRequestsSent
             << " repl:" << numRepliesSent << " fail:" << numFailedResolutions;
     getDisplayString().setTagArg("t", 0, os.str().c_str());
 }
 
+ARP::ARPCacheEntry *ARP::findEntry(InterfaceEntry *ie, IPAddress ipAddress)
+{
+    ARPCache& cache = arpCache[ie->getNetworkLayerGateIndex()];
+    ARPCache::iterator it = cache.find(ipAddress);
+    return it==cache.end() ? NULL : it->second;
+}
+
+ARP::ARPCacheEntry *ARP::createEntry(InterfaceEntry *ie, IPAddress ipAddress)
+{
+    ARPCacheEntry *entry = new ARPCacheEntry();
+    entry->ie = ie;
+    entry->ipAddress = ipAddress;
+    entry->pending = false;
+    entry->isStatic = false;
+    entry->numRetries = 0;
+    entry->prev = entry->next = NULL;
+    arpCache[ie->getNetworkLayerGateIndex()][ipAddress] = entry;
+    numCacheEntries++;
+    return entry;
+}
+
+void ARP::deleteEntry(ARPCacheEntry *entry)
+{
+    unscheduleEntry(entry);
+    arpCache[entry->ie->getNetworkLayerGateIndex()].erase(entry->ipAddress);
+    numCacheEntries--;
+    delete entry;
+}
+
+void ARP::scheduleEntry(TimerList& list, ARPCacheEntry *entry, simtime_t expiry)
+{
+    // timeouts are constant, so appending keeps the list ordered
+    ASSERT(!list.tail || list.tail->expiry <= expiry);
+    entry->expiry = expiry;
+    entry->prev = list.tail;
+    entry->next = NULL;
+    if (list.tail)
+        list.tail->next = entry;
+    else
+        list.head = entry;
+    list.tail = entry;
+
+    if (!timerMsg->isScheduled() || expiry < timerMsg->getArrivalTime())
+        rescheduleTimer();
+}
+
+void ARP::unscheduleEntry(ARPCacheEntry *entry)
+{
+    if (entry->isStatic)
+        return;
+
+    // note: the timer is left alone; if it fires early, processTimer() just reschedules it
+    TimerList& list = entry->pending ? retryList : agingList;
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else if (list.head==entry)
+        list.head = entry->next;
+    else
+        return; // not in the list
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        list.tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+void ARP::rescheduleTimer()
+{
+    simtime_t next = MAXTIME;
+    if (retryList.head)
+        next = retryList.head->expiry;
+    if (agingList.head && agingList.head->expiry < next)
+        next = agingList.head->expiry;
+
+    if (timerMsg->isScheduled())
+    {
+        if (timerMsg->getArrivalTime()==next)
+            return;
+        cancelEvent(timerMsg);
+    }
+    if (next != MAXTIME)
+        scheduleAt(next, timerMsg);
+}
+
+void ARP::processTimer()
+{
+    simtime_t now = simTime();
+
+    // note: requestTimedOut() re-appends the entry to retryList, with an
+    // expiry in the future, so the loop terminates
+    while (retryList.head && retryList.head->expiry <= now)
+        requestTimedOut(retryList.head);
+
+    while (agingList.head && agingList.head->expiry <= now)
+    {
+        EV << "ARP cache entry for " << agingList.head->ipAddress << " expired, removing it\n";
+        deleteEntry(agingList.head);
+    }
+
+    rescheduleTimer();
+}
+
 void ARP::processOutboundPacket(cMessage *msg)
 {
     EV << "Packet " << msg << " arrived from higher layer, ";
@@ -175,15 +321,23 @@ void ARP::processOutboundPacket(cMessage *msg)
     }
 
     // try look up
-    ARPCache::iterator it = arpCache.find(nextHopAddr);
-    //ASSERT(it==arpCache.end() || ie==(*it).second->ie); // verify: if arpCache gets keyed on InterfaceEntry* too, this becomes unnecessary
-    if (it==arpCache.end())
+    ARPCacheEntry *entry = findEntry(ie, nextHopAddr);
+    if (!entry && precomputedARP)
+    {
+        // precomputed mode: resolve from the global table, without ARP traffic
+        GlobalARPTable::iterator it = globalARPTable.find(nextHopAddr);
+        if (it!=globalARPTable.end())
+        {
+            EV << "precomputed ARP, MAC address for " << nextHopAddr << " is " << it->second << ", sending packet down\n";
+            sendPacketToNIC(msg, ie, it->second);
+            return;
+        }
+    }
+
+    if (!entry)
     {
         // no cache entry: launch ARP request
-        ARPCacheEntry *entry = new ARPCacheEntry();
-        ARPCache::iterator where = arpCache.insert(arpCache.begin(), std::make_pair(nextHopAddr,entry));
-        entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
-        entry->ie = ie;
+        entry = createEntry(ie, nextHopAddr);
 
         EV << "Starting ARP resolution for " << nextHopAddr << "\n";
         initiateARPResolution(entry);
@@ -192,20 +346,18 @@ void ARP::processOutboundPacket(cMessage *msg)
         entry->pendingPackets.push_back(msg);
         pendingQueue.insert(msg);
     }
-    else if ((*it).second->pending)
+    else if (entry->pending)
     {
         // an ARP request is already pending for this address -- just queue up packet
         EV << "ARP resolution for " << nextHopAddr << " is pending, queueing up packet\n";
-        (*it).second->pendingPackets.push_back(msg);
+        entry->pendingPackets.push_back(msg);
         pendingQueue.insert(msg);
     }
-    else if ((*it).second->lastUpdate+cacheTimeout<simTime())
+    else if (!entry->isStatic && entry->lastUpdate+cacheTimeout<simTime())
     {
         EV << "ARP cache entry for " << nextHopAddr << " expired, starting new ARP resolution\n";
 
         // cache entry stale, send new ARP request
-        ARPCacheEntry *entry = (*it).second;
-        entry->ie = ie; // routing table may have changed
         initiateARPResolution(entry);
 
         // and queue up packet
@@ -215,23 +367,21 @@ void ARP::processOutboundPacket(cMessage *msg)
     else
     {
         // valid ARP cache entry found, flag msg with MAC address and send it out
-        EV << "ARP cache hit, MAC address for " << nextHopAddr << " is " << (*it).second->macAddress << ", sending packet down\n";
-        sendPacketToNIC(msg, ie, (*it).second->macAddress);
+        EV << "ARP cache hit, MAC address for " << nextHopAddr << " is " << entry->macAddress << ", sending packet down\n";
+        sendPacketToNIC(msg, ie, entry->macAddress);
     }
 }
 
 void ARP::initiateARPResolution(ARPCacheEntry *entry)
 {
-    IPAddress nextHopAddr = entry->myIter->first;
+    unscheduleEntry(entry);
     entry->pending = true;
     entry->numRetries = 0;
     entry->lastUpdate = 0;
-    sendARPRequest(entry->ie, nextHopAddr);
+    sendARPRequest(entry->ie, entry->ipAddress);
 
     // start timer
-    cMessage *msg = entry->timer = new cMessage("ARP timeout");
-    msg->setContextPointer(entry);
-    scheduleAt(simTime()+retryTimeout, msg);
+    scheduleEntry(retryList, entry, simTime()+retryTimeout);
 
     numResolutions++;
 }
@@ -270,17 +420,16 @@ void ARP::sendARPRequest(InterfaceEntry *ie, IPAddress ipAddress)
     numRequestsSent++;
 }
 
-void ARP::requestTimedOut(cMessage *selfmsg)
+void ARP::requestTimedOut(ARPCacheEntry *entry)
 {
-    ARPCacheEntry *entry = (ARPCacheEntry *)selfmsg->getContextPointer();
+    unscheduleEntry(entry);
     entry->numRetries++;
     if (entry->numRetries < retryCount)
     {
         // retry
-        IPAddress nextHopAddr = entry->myIter->first;
-        EV << "ARP request for " << nextHopAddr << " timed out, resending\n";
-        sendARPRequest(entry->ie, nextHopAddr);
-        scheduleAt(simTime()+retryTimeout, selfmsg);
+        EV << "ARP request for " << entry->ipAddress << " timed out, resending\n";
+        sendARPRequest(entry->ie, entry->ipAddress);
+        scheduleEntry(retryList, entry, simTime()+retryTimeout);
         return;
     }
 
@@ -288,7 +437,7 @@ void ARP::requestTimedOut(cMessage *selfmsg)
     // throw out entry from cache, delete pending messages
     MsgPtrVector& pendingPackets = entry->pendingPackets;
     EV << "ARP timeout, max retry count " << retryCount << " for "
-       << entry->myIter->first << " reached. Dropping " << pendingPackets.size()
+       << entry->ipAddress << " reached. Dropping " << pendingPackets.size()
        << " waiting packets from the queue\n";
     while (!pendingPackets.empty())
     {
@@ -298,9 +447,7 @@ void ARP::requestTimedOut(cMessage *selfmsg)
         pendingQueue.remove(msg);
         delete msg;
     }
-    delete selfmsg;
-    arpCache.erase(entry->myIter);
-    delete entry;
+    deleteEntry(entry);
     numFailedResolutions++;
 }
 
@@ -374,11 +521,10 @@ void ARP::processARPPacket(ARPPacket *arp)
 
     bool mergeFlag = false;
     // "If ... sender protocol address is already in my translation table"
-    ARPCache::iterator it = arpCache.find(srcIPAddress);
-    if (it!=arpCache.end())
+    ARPCacheEntry *entry = findEntry(ie, srcIPAddress);
+    if (entry && !entry->isStatic)
     {
         // "update the sender hardware address field"
-        ARPCacheEntry *entry = (*it).second;
         updateARPCache(entry, srcMACAddress);
         mergeFlag = true;
     }
@@ -389,24 +535,9 @@ void ARP::processARPPacket(ARPPacket *arp)
     {
         // "If Merge_flag is false, add the triplet protocol type, sender
         // protocol address, sender hardware address to the translation table"
-        if (!mergeFlag)
+        if (!mergeFlag && !entry)
         {
-            ARPCacheEntry *entry;
-            if (it!=arpCache.end())
-            {
-                entry = (*it).second;
-            }
-            else
-            {
-                entry = new ARPCacheEntry();
-                ARPCache::iterator where = arpCache.insert(arpCache.begin(), std::make_pair(srcIPAddress,entry));
-                entry->myIter = where;
-                entry->ie = ie;
-
-                entry->pending = false;
-                entry->timer = NULL;
-                entry->numRetries = 0;
-            }
+            entry = createEntry(ie, srcIPAddress);
             updateARPCache(entry, srcMACAddress);
         }
 
@@ -455,18 +586,16 @@ void ARP::processARPPacket(ARPPacket *arp)
 
 void ARP::updateARPCache(ARPCacheEntry *entry, const MACAddress& macAddress)
 {
-    EV << "Updating ARP cache entry: " << entry->myIter->first << " <--> " << macAddress << "\n";
+    EV << "Updating ARP cache entry: " << entry->ipAddress << " <--> " << macAddress << "\n";
 
-    // update entry
-    if (entry->pending)
-    {
-        entry->pending = false;
-        delete cancelEvent(entry->timer);
-        entry->timer = NULL;
-        entry->numRetries = 0;
-    }
+    // update entry, and (re)start aging
+    unscheduleEntry(entry);
+    entry->pending = false;
+    entry->numRetries = 0;
     entry->macAddress = macAddress;
     entry->lastUpdate = simTime();
+    if (!entry->isStatic)
+        scheduleEntry(agingList, entry, entry->lastUpdate+cacheTimeout);
 
     // process queued packets
     MsgPtrVector& pendingPackets = entry->pendingPackets;
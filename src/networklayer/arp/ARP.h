@@ -21,8 +21,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <vector>
-#include <map>
 #include <omnetpp.h>
+#include "INETHashMap.h"
 #include "IPAddress.h"
 #include "ARPPacket_m.h"
 #include "IPControlInfo.h"
@@ -36,27 +36,52 @@
 
 /**
  * ARP implementation.
+ *
+ * The ARP cache is partitioned per interface (indexed by network layer
+ * gate index), and each partition is a hash table keyed by IP address.
+ * All request timeouts and entry aging is driven by a single self-message:
+ * since retryTimeout and cacheTimeout are constant, entries are simply
+ * appended to the retry resp. aging list when (re)scheduled, and the lists
+ * remain ordered by expiry time.
+ *
+ * In precomputed mode (precomputedARP=true) no ARP traffic is generated:
+ * all ARP modules register the addresses of their own interfaces in a
+ * global table during initialization, and address resolution is done
+ * from that table. These entries are removed when the ARP module is
+ * deleted (e.g. the node is replaced at runtime). Configurators can also
+ * install entries directly with addStaticEntry() or addGlobalEntry().
  */
 class INET_API ARP : public cSimpleModule
 {
   public:
     struct ARPCacheEntry;
-    typedef std::map<IPAddress, ARPCacheEntry*> ARPCache;
+    typedef std::tr1::unordered_map<IPAddress, ARPCacheEntry*, IPAddressHash> ARPCache;
+    typedef std::tr1::unordered_map<IPAddress, MACAddress, IPAddressHash> GlobalARPTable;
     typedef std::vector<cMessage*> MsgPtrVector;
 
-    // IPAddress -> MACAddress table
-    // TBD should we key it on (IPAddress, InterfaceEntry*)?
+    // IPAddress -> MACAddress table entry
     struct ARPCacheEntry
     {
         InterfaceEntry *ie; // NIC to send the packet to
+        IPAddress ipAddress;  // the address this entry resolves
         bool pending; // true if resolution is pending
+        bool isStatic; // static entries never time out
         MACAddress macAddress;  // MAC address
         simtime_t lastUpdate;  // entries should time out after cacheTimeout
         int numRetries; // if pending==true: 0 after first ARP request, 1 after second, etc.
-        cMessage *timer;  // if pending==true: request timeout msg
+        simtime_t expiry;  // next ARP request (if pending) or aging deadline
+        ARPCacheEntry *prev;  // retry list (if pending) or aging list
+        ARPCacheEntry *next;
         MsgPtrVector pendingPackets;  // if pending==true: ptrs to packets waiting for resolution
                                       // (packets are owned by pendingQueue)
-        ARPCache::iterator myIter;  // iterator pointing to this entry
+    };
+
+    // doubly linked list of cache entries, ordered by expiry
+    struct TimerList
+    {
+        ARPCacheEntry *head;
+        ARPCacheEntry *tail;
+        TimerList() {head = tail = NULL;}
     };
 
   protected:
@@ -64,13 +89,19 @@ class INET_API ARP : public cSimpleModule
     int retryCount;
     simtime_t cacheTimeout;
     bool doProxyARP;
+    bool precomputedARP;
 
     long numResolutions;
     long numFailedResolutions;
     long numRequestsSent;
     long numRepliesSent;
 
-    ARPCache arpCache;
+    std::vector<ARPCache> arpCache;  // indexed by network layer gate index
+    int numCacheEntries;
+
+    TimerList retryList;  // pending entries, ordered by time of next retry
+    TimerList agingList;  // resolved non-static entries, ordered by lastUpdate
+    cMessage *timerMsg;   // for both request timeouts and aging
 
     cQueue pendingQueue; // outbound packets waiting for ARP resolution
     int nicOutBaseGateId;  // id of the nicOut[0] gate
@@ -78,12 +109,29 @@ class INET_API ARP : public cSimpleModule
     IInterfaceTable *ift;
     IRoutingTable *rt;  // for Proxy ARP
 
+    // IP->MAC mapping of all interfaces, for precomputed mode
+    static GlobalARPTable globalARPTable;
+    static int numInstances;  // the global table is cleared when the last ARP is deleted
+    std::vector<std::pair<IPAddress, MACAddress> > ownGlobalEntries;  // registered by this instance
+
   public:
-    ARP() {}
+    ARP() {timerMsg = NULL; numInstances++;}
     virtual ~ARP();
 
+    /**
+     * Installs a static (never expiring) entry into the cache of the
+     * given interface. Meant to be called by configurators.
+     */
+    virtual void addStaticEntry(InterfaceEntry *ie, IPAddress ipAddress, const MACAddress& macAddress);
+
+    /**
+     * Adds an entry to the global address table used in precomputed mode.
+     */
+    static void addGlobalEntry(IPAddress ipAddress, const MACAddress& macAddress);
+
   protected:
-    virtual void initialize();
+    virtual int numInitStages() const {return 4;}
+    virtual void initialize(int stage);
     virtual void handleMessage(cMessage *msg);
     virtual void finish();
 
@@ -92,11 +140,20 @@ class INET_API ARP : public cSimpleModule
 
     virtual void initiateARPResolution(ARPCacheEntry *entry);
     virtual void sendARPRequest(InterfaceEntry *ie, IPAddress ipAddress);
-    virtual void requestTimedOut(cMessage *selfmsg);
+    virtual void processTimer();
+    virtual void requestTimedOut(ARPCacheEntry *entry);
     virtual bool addressRecognized(IPAddress destAddr, InterfaceEntry *ie);
     virtual void processARPPacket(ARPPacket *arp);
     virtual void updateARPCache(ARPCacheEntry *entry, const MACAddress& macAddress);
 
+    // cache and timer list manipulation
+    virtual ARPCacheEntry *findEntry(InterfaceEntry *ie, IPAddress ipAddress);
+    virtual ARPCacheEntry *createEntry(InterfaceEntry *ie, IPAddress ipAddress);
+    virtual void deleteEntry(ARPCacheEntry *entry);
+    virtual void scheduleEntry(TimerList& list, ARPCacheEntry *entry, simtime_t expiry);
+    virtual void unscheduleEntry(ARPCacheEntry *entry);
+    virtual void rescheduleTimer();
+
     virtual void dumpARPPacket(ARPPacket *arp);
     virtual void updateDisplayString();
 
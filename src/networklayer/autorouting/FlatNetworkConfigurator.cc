@@ -148,6 +148,11 @@ void FlatNetworkConfigurator::addDefaultRoutes(cTopology& topo, NodeInfoVector&
 
 void FlatNetworkConfigurator::fillRoutingTables(cTopology& topo, NodeInfoVector& nodeInfo)
 {
+    // routes are added to all tables in one batch each
+    for (int i=0; i<topo.getNumNodes(); i++)
+        if (nodeInfo[i].isIPNode)
+            nodeInfo[i].rt->beginUpdate();
+
     // fill in routing tables with static routes
     for (int i=0; i<topo.getNumNodes(); i++)
     {
@@ -201,6 +206,10 @@ void FlatNetworkConfigurator::fillRoutingTables(cTopology& topo, NodeInfoVector&
             rt->addRoute(e);
         }
     }
+
+    for (int i=0; i<topo.getNumNodes(); i++)
+        if (nodeInfo[i].isIPNode)
+            nodeInfo[i].rt->commit();
 }
 
 void FlatNetworkConfigurator::handleMessage(cMessage *msg)
@@ -47,8 +47,17 @@ void FlatNetworkConfigurator6::initialize(int stage)
     }
     else if (stage==3)
     {
+        // routes are added to all tables in one batch each
+        for (int i = 0; i < topo.getNumNodes(); i++)
+            if (isIPNode(topo.getNode(i)))
+                IPAddressResolver().routingTable6Of(topo.getNode(i)->getModule())->beginUpdate();
+
         addOwnAdvPrefixRoutes(topo);
         addStaticRoutes(topo);
+
+        for (int i = 0; i < topo.getNumNodes(); i++)
+            if (isIPNode(topo.getNode(i)))
+                IPAddressResolver().routingTable6Of(topo.getNode(i)->getModule())->commit();
     }
 #else
     error("FlatNetworkConfigurator6 not supported: WITHOUT_IPv6 option was defined during compilation");
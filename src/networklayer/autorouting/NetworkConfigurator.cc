@@ -40,6 +40,11 @@ void NetworkConfigurator::initialize(int stage)
         // assign addresses to IP nodes, and also store result in nodeInfo[].address
         assignAddresses(topo, nodeInfo);
 
+        // all routes below are added in one batch per routing table
+        for (int i=0; i<topo.getNumNodes(); i++)
+            if (nodeInfo[i].isIPNode)
+                nodeInfo[i].rt->beginUpdate();
+
         // add routes for point-to-point peers
         addPointToPointPeerRoutes(topo, nodeInfo);
 
@@ -54,6 +59,10 @@ void NetworkConfigurator::initialize(int stage)
         // calculate shortest paths, and add corresponding static routes
         fillRoutingTables(topo, nodeInfo);
 
+        for (int i=0; i<topo.getNumNodes(); i++)
+            if (nodeInfo[i].isIPNode)
+                nodeInfo[i].rt->commit();
+
         // update display string
         setDisplayString(topo, nodeInfo);
     }
@@ -116,6 +116,16 @@ class INET_API IInterfaceTable
      * loopback interface on startup.)
      */
     virtual InterfaceEntry *getFirstLoopbackInterface() = 0;
+
+    /**
+     * Returns a counter which is incremented whenever an interface is added
+     * or deleted, or any change (state, config, protocol data) is reported
+     * for an interface. Clients may store the value along with data they
+     * derive from interfaces (e.g. cached InterfaceEntry pointers or
+     * addresses), and consider that data valid as long as the counter
+     * has not changed.
+     */
+    virtual unsigned long getGeneration() = 0;
 };
 
 #endif
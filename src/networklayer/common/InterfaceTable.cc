@@ -42,6 +42,8 @@ InterfaceTable::InterfaceTable()
 {
     tmpNumInterfaces = -1;
     tmpInterfaceList = NULL;
+    lookupIndicesValid = false;
+    generation = 0;
 }
 
 InterfaceTable::~InterfaceTable()
@@ -149,6 +151,7 @@ void InterfaceTable::addInterface(InterfaceEntry *entry, cModule *ifmod)
     entry->setInterfaceTable(this);
     idToInterface.push_back(entry);
     invalidateTmpInterfaceList();
+    invalidateLookupIndices();
 
     // fill in networkLayerGateIndex, nodeOutputGateId, nodeInputGateId
     if (ifmod)
@@ -205,6 +208,7 @@ void InterfaceTable::deleteInterface(InterfaceEntry *entry)
     idToInterface[id - INTERFACEIDS_START] = NULL;
     delete entry;
     invalidateTmpInterfaceList();
+    invalidateLookupIndices();
 }
 
 void InterfaceTable::invalidateTmpInterfaceList()
@@ -214,42 +218,79 @@ void InterfaceTable::invalidateTmpInterfaceList()
     tmpInterfaceList = NULL;
 }
 
+void InterfaceTable::invalidateLookupIndices()
+{
+    lookupIndicesValid = false;
+    generation++;
+}
+
+void InterfaceTable::rebuildLookupIndices()
+{
+    nodeOutputGateIdToInterface.clear();
+    nodeInputGateIdToInterface.clear();
+    nwLayerGateIndexToInterface.clear();
+    nameToInterface.clear();
+
+    int n = idToInterface.size();
+    for (int i=0; i<n; i++)
+    {
+        InterfaceEntry *ie = idToInterface[i];
+        if (!ie)
+            continue;
+
+        // note: if several interfaces match, the linear search used to
+        // return the first one, so we don't overwrite existing entries
+        if (ie->getNodeOutputGateId()!=-1)
+            nodeOutputGateIdToInterface.insert(std::make_pair(ie->getNodeOutputGateId(), ie));
+        if (ie->getNodeInputGateId()!=-1)
+            nodeInputGateIdToInterface.insert(std::make_pair(ie->getNodeInputGateId(), ie));
+        int index = ie->getNetworkLayerGateIndex();
+        if (index>=0)
+        {
+            if (index>=(int)nwLayerGateIndexToInterface.size())
+                nwLayerGateIndexToInterface.resize(index+1, NULL);
+            if (!nwLayerGateIndexToInterface[index])
+                nwLayerGateIndexToInterface[index] = ie;
+        }
+        nameToInterface.insert(std::make_pair(std::string(ie->getName()), ie));
+    }
+    lookupIndicesValid = true;
+}
+
 void InterfaceTable::interfaceChanged(InterfaceEntry *entry, int category)
 {
+    // name or gate ids may have changed
+    if (category==NF_INTERFACE_CONFIG_CHANGED)
+        lookupIndicesValid = false;
+    generation++;
+
     nb->fireChangeNotification(category, entry);
 }
 
 InterfaceEntry *InterfaceTable::getInterfaceByNodeOutputGateId(int id)
 {
-    // linear search is OK because normally we have don't have many interfaces and this func is rarely called
     Enter_Method_Silent();
-    int n = idToInterface.size();
-    for (int i=0; i<n; i++)
-        if (idToInterface[i] && idToInterface[i]->getNodeOutputGateId()==id)
-            return idToInterface[i];
-    return NULL;
+    if (!lookupIndicesValid)
+        rebuildLookupIndices();
+    GateIdToInterfaceMap::iterator it = nodeOutputGateIdToInterface.find(id);
+    return it==nodeOutputGateIdToInterface.end() ? NULL : it->second;
 }
 
 InterfaceEntry *InterfaceTable::getInterfaceByNodeInputGateId(int id)
 {
-    // linear search is OK because normally we have don't have many interfaces and this func is rarely called
     Enter_Method_Silent();
-    int n = idToInterface.size();
-    for (int i=0; i<n; i++)
-        if (idToInterface[i] && idToInterface[i]->getNodeInputGateId()==id)
-            return idToInterface[i];
-    return NULL;
+    if (!lookupIndicesValid)
+        rebuildLookupIndices();
+    GateIdToInterfaceMap::iterator it = nodeInputGateIdToInterface.find(id);
+    return it==nodeInputGateIdToInterface.end() ? NULL : it->second;
 }
 
 InterfaceEntry *InterfaceTable::getInterfaceByNetworkLayerGateIndex(int index)
 {
-    // linear search is OK because normally we have don't have many interfaces and this func is rarely called
     Enter_Method_Silent();
-    int n = idToInterface.size();
-    for (int i=0; i<n; i++)
-        if (idToInterface[i] && idToInterface[i]->getNetworkLayerGateIndex()==index)
-            return idToInterface[i];
-    return NULL;
+    if (!lookupIndicesValid)
+        rebuildLookupIndices();
+    return (index<0 || index>=(int)nwLayerGateIndexToInterface.size()) ? NULL : nwLayerGateIndexToInterface[index];
 }
 
 InterfaceEntry *InterfaceTable::getInterfaceByName(const char *name)
@@ -257,11 +298,10 @@ InterfaceEntry *InterfaceTable::getInterfaceByName(const char *name)
     Enter_Method_Silent();
     if (!name)
         return NULL;
-    int n = idToInterface.size();
-    for (int i=0; i<n; i++)
-        if (idToInterface[i] && !strcmp(name, idToInterface[i]->getName()))
-            return idToInterface[i];
-    return NULL;
+    if (!lookupIndicesValid)
+        rebuildLookupIndices();
+    NameToInterfaceMap::iterator it = nameToInterface.find(name);
+    return it==nameToInterface.end() ? NULL : it->second;
 }
 
 InterfaceEntry *InterfaceTable::getFirstLoopbackInterface()
@@ -19,8 +19,10 @@
 #define __INET_INTERFACETABLE_H
 
 #include <vector>
+#include <string>
 #include <omnetpp.h>
 #include "INETDefs.h"
+#include "INETHashMap.h"
 #include "IInterfaceTable.h"
 #include "InterfaceEntry.h"
 #include "NotificationBoard.h"
@@ -61,6 +63,11 @@
  * State change gets fired for up/down events; all other changes fire as
  * config change.
  *
+ * Lookups by name, node input/output gate id and network layer gate index
+ * are served from hash tables resp. a vector. These indices are rebuilt
+ * lazily on the first lookup after an interface was added, deleted or
+ * its configuration changed.
+ *
  * @see InterfaceEntry
  */
 class INET_API InterfaceTable : public cSimpleModule, public IInterfaceTable, protected INotifiable
@@ -77,6 +84,18 @@ class INET_API InterfaceTable : public cSimpleModule, public IInterfaceTable, pr
     int tmpNumInterfaces; // caches number of non-NULL elements of idToInterface; -1 if invalid
     InterfaceEntry **tmpInterfaceList; // caches non-NULL elements of idToInterface; NULL if invalid
 
+    // lookup indices, see rebuildLookupIndices()
+    typedef std::tr1::unordered_map<int, InterfaceEntry *> GateIdToInterfaceMap;
+    typedef std::tr1::unordered_map<std::string, InterfaceEntry *> NameToInterfaceMap;
+    bool lookupIndicesValid;
+    GateIdToInterfaceMap nodeOutputGateIdToInterface;
+    GateIdToInterfaceMap nodeInputGateIdToInterface;
+    InterfaceVector nwLayerGateIndexToInterface;  // may contain NULLs
+    NameToInterfaceMap nameToInterface;
+
+    // incremented on every change, see getGeneration()
+    unsigned long generation;
+
   protected:
     // displays summary above the icon
     virtual void updateDisplayString();
@@ -89,6 +108,8 @@ class INET_API InterfaceTable : public cSimpleModule, public IInterfaceTable, pr
 
     // internal
     virtual void invalidateTmpInterfaceList();
+    virtual void invalidateLookupIndices();
+    virtual void rebuildLookupIndices();
 
   public:
     InterfaceTable();
@@ -180,6 +201,12 @@ class INET_API InterfaceTable : public cSimpleModule, public IInterfaceTable, pr
      * loopback interface on startup.)
      */
     virtual InterfaceEntry *getFirstLoopbackInterface();
+
+    /**
+     * Returns a counter that changes whenever anything changes in the
+     * interface table. See IInterfaceTable::getGeneration().
+     */
+    virtual unsigned long getGeneration() {return generation;}
 };
 
 #endif
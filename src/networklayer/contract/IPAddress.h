@@ -250,6 +250,15 @@ class INET_API IPAddress
     static bool isWellFormed(const char *text);
 };
 
+/**
+ * Hash function object for IPAddress, for use with hash containers
+ * (see INETHashMap.h).
+ */
+struct IPAddressHash
+{
+    size_t operator()(const IPAddress& addr) const {return addr.getInt();}
+};
+
 inline std::ostream& operator<<(std::ostream& os, const IPAddress& ip)
 {
     return os << ip.str();
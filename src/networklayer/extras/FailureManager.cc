@@ -15,6 +15,7 @@
 // along with this program; if not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
 #include "FailureManager.h"
 
 Define_Module(FailureManager);
@@ -38,31 +39,145 @@ cModule *FailureManager::getTargetNode(const char *target)
 
 void FailureManager::processCommand(const cXMLElement& node)
 {
-    cModule *target = getTargetNode(node.getAttribute("target"));
+    const char *tag = node.getTagName();
+    bool isShutdown = !strcmp(tag, "shutdown");
 
-    if (!strcmp(node.getTagName(), "shutdown"))
+    if (isShutdown || !strcmp(tag, "startup"))
     {
-        target->getDisplayString().setTagArg("i2",0,"status/cross");
-        if(!strcmp(target->getModuleType()->getName(), "RSVP_LSR"))
-            replaceNode(target, "inet.nodes.mpls.RSVP_FAILED");
-        else if(!strcmp(target->getModuleType()->getName(), "LDP_LSR"))
-            replaceNode(target, "inet.nodes.mpls.LDP_FAILED");
+        if (!node.getAttribute("target"))
+        {
+            processBulkNodeCommand(node, isShutdown);
+            return;
+        }
+
+        cModule *target = getTargetNode(node.getAttribute("target"));
+        const char *newNodeType = getReplacementNodeType(target, isShutdown);
+        if (!newNodeType)
+            error("<%s>: don't know how to %s module '%s' of type %s", tag, tag, target->getFullPath().c_str(), target->getModuleType()->getName());
+
+        if (isShutdown)
+            target->getDisplayString().setTagArg("i2",0,"status/cross");
         else
-            ASSERT(false);
+            target->getDisplayString().removeTag("i2");
+        replaceNode(target, newNodeType);
     }
-    else if(!strcmp(node.getTagName(), "startup"))
+    else if (!strcmp(tag, "linkdown"))
+        processLinkCommand(node, true);
+    else if (!strcmp(tag, "linkup"))
+        processLinkCommand(node, false);
+    else
+        ASSERT(false);
+
+}
+
+const char *FailureManager::getReplacementNodeType(cModule *mod, bool shutdown)
+{
+    const char *typeName = mod->getModuleType()->getName();
+    if (shutdown)
     {
-        target->getDisplayString().removeTag("i2");
-        if(!strcmp(target->getModuleType()->getName(), "RSVP_FAILED"))
-            replaceNode(target, "inet.nodes.mpls.RSVP_LSR");
-        else if(!strcmp(target->getModuleType()->getName(), "LDP_FAILED"))
-            replaceNode(target, "inet.nodes.mpls.LDP_LSR");
-        else
-            ASSERT(false);
+        if (!strcmp(typeName, "RSVP_LSR"))
+            return "inet.nodes.mpls.RSVP_FAILED";
+        else if (!strcmp(typeName, "LDP_LSR"))
+            return "inet.nodes.mpls.LDP_FAILED";
     }
     else
-        ASSERT(false);
+    {
+        if (!strcmp(typeName, "RSVP_FAILED"))
+            return "inet.nodes.mpls.RSVP_LSR";
+        else if (!strcmp(typeName, "LDP_FAILED"))
+            return "inet.nodes.mpls.LDP_LSR";
+    }
+    return NULL;
+}
+
+int FailureManager::getNumTargets(const cXMLElement& node, int numCandidates)
+{
+    // all candidates, or "count" of them, or "fraction" of them
+    const char *countAttr = node.getAttribute("count");
+    const char *fractionAttr = node.getAttribute("fraction");
+    if (countAttr && fractionAttr)
+        error("<%s>: attributes count and fraction are mutually exclusive at %s", node.getTagName(), node.getSourceLocation());
+
+    int n = numCandidates;
+    if (countAttr)
+        n = atoi(countAttr);
+    else if (fractionAttr)
+        n = (int)floor(atof(fractionAttr) * numCandidates + 0.5);
+
+    if (n < 0)
+        error("<%s>: negative number of targets at %s", node.getTagName(), node.getSourceLocation());
+    return std::min(n, numCandidates);
+}
 
+template<typename T>
+void FailureManager::selectRandomTargets(std::vector<T>& candidates, int n)
+{
+    // partial Fisher-Yates shuffle: the first n elements become a uniformly
+    // chosen random subset
+    for (int i = 0; i < n; i++)
+        std::swap(candidates[i], candidates[i + intrand(candidates.size() - i)]);
+    candidates.resize(n);
+}
+
+void FailureManager::processBulkNodeCommand(const cXMLElement& node, bool shutdown)
+{
+    // nodes are direct submodules of the network; a node is a candidate if
+    // its name matches and it can be shut down (or started up, respectively)
+    const char *targetsAttr = node.getAttribute("targets");
+    if (!targetsAttr)
+        error("<%s>: attribute target or targets required at %s", node.getTagName(), node.getSourceLocation());
+    cPatternMatcher matcher(targetsAttr, true, true, true);
+
+    std::vector<cModule *> candidates;
+    for (cModule::SubmoduleIterator it(simulation.getSystemModule()); !it.end(); it++)
+        if (matcher.matches(it()->getFullName()) && getReplacementNodeType(it(), shutdown))
+            candidates.push_back(it());
+
+    // the targets are replaced in one go; the iterator above must not be
+    // used while doing that
+    selectRandomTargets(candidates, getNumTargets(node, candidates.size()));
+    EV << (shutdown ? "Shutting down " : "Starting up ") << candidates.size() << " nodes matching " << targetsAttr << "\n";
+    for (unsigned int i = 0; i < candidates.size(); i++)
+    {
+        cModule *target = candidates[i];
+        if (shutdown)
+            target->getDisplayString().setTagArg("i2",0,"status/cross");
+        else
+            target->getDisplayString().removeTag("i2");
+        replaceNode(target, getReplacementNodeType(target, shutdown));
+    }
+}
+
+void FailureManager::processLinkCommand(const cXMLElement& node, bool down)
+{
+    // links are the channels of output gates of network nodes; the pattern
+    // is matched against "node.gate", e.g. "LSR*.pppg$o[*]"
+    const char *targetsAttr = node.getAttribute("targets");
+    if (!targetsAttr)
+        error("<%s>: attribute targets required at %s", node.getTagName(), node.getSourceLocation());
+    cPatternMatcher matcher(targetsAttr, true, true, true);
+
+    std::vector<cChannel *> candidates;
+    for (cModule::SubmoduleIterator it(simulation.getSystemModule()); !it.end(); it++)
+    {
+        for (cModule::GateIterator ig(it()); !ig.end(); ig++)
+        {
+            cGate *g = ig();
+            if (g->getType() != cGate::OUTPUT || !g->getChannel() || !g->getChannel()->hasPar("disabled"))
+                continue;
+            std::string name = std::string(it()->getFullName()) + "." + g->getFullName();
+            if (matcher.matches(name.c_str()) && g->getChannel()->par("disabled").boolValue() != down)
+                candidates.push_back(g->getChannel());
+        }
+    }
+
+    selectRandomTargets(candidates, getNumTargets(node, candidates.size()));
+    EV << (down ? "Disabling " : "Enabling ") << candidates.size() << " links matching " << targetsAttr << "\n";
+    for (unsigned int i = 0; i < candidates.size(); i++)
+    {
+        candidates[i]->par("disabled").setBoolValue(down);
+        candidates[i]->getDisplayString().setTagArg("ls", 2, down ? "da" : "s");
+    }
 }
 
 void FailureManager::replaceNode(cModule *mod, const char *newNodeType)
@@ -18,12 +18,14 @@
 #ifndef FAILUREMANAGER_H
 #define FAILUREMANAGER_H
 
+#include <vector>
 #include <omnetpp.h>
 
 #include "IScriptable.h"
 
 /**
- * TODO documentation
+ * Node and link failures, invoked from ScenarioManager scripts.
+ * See NED file for details.
  */
 class INET_API FailureManager : public cSimpleModule, public IScriptable
 {
@@ -41,6 +43,13 @@ class INET_API FailureManager : public cSimpleModule, public IScriptable
     virtual void reconnectGates(cModule *old, cModule *n, const char *gateName, int gateIndex=-1);
     virtual void reconnectGate(cGate *oldGate, cGate *newGate);
     virtual cModule* getTargetNode(const char *target);
+
+    // bulk commands
+    virtual const char *getReplacementNodeType(cModule *mod, bool shutdown);
+    virtual void processBulkNodeCommand(const cXMLElement& node, bool shutdown);
+    virtual void processLinkCommand(const cXMLElement& node, bool down);
+    virtual int getNumTargets(const cXMLElement& node, int numCandidates);
+    template<typename T> void selectRandomTargets(std::vector<T>& candidates, int n);
   private:
     static cChannel *copyChannel(cChannel *channel);
     static void copyParams(cComponent *from, cComponent *to);
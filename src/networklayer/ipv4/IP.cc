@@ -26,9 +26,16 @@
 #include "ICMPMessage_m.h"
 #include "IPv4InterfaceData.h"
 #include "ARPPacket_m.h"
+#include "NotificationBoard.h"
+#include "NotifierConsts.h"
 
 Define_Module(IP);
 
+IP::~IP()
+{
+    cancelAndDelete(fragmentPurgeTimer);
+}
+
 
 void IP::initialize()
 {
@@ -45,16 +52,75 @@ void IP::initialize()
     mapping.parseProtocolMapping(par("protocolMapping"));
 
     curFragmentId = 0;
-    lastCheckTime = 0;
     fragbuf.init(icmpAccess.get());
+    fragbuf.setMaxBufferedBytes(par("fragmentBufferSize"));
+    fragmentPurgeTimer = new cMessage("purge-fragments");
+
+    NotificationBoard *nb = NotificationBoardAccess().get();
+    nb->subscribe(this, NF_IPv4_ROUTE_ADDED);
+    nb->subscribe(this, NF_IPv4_ROUTE_DELETED);
+    nb->subscribe(this, NF_IPv4_ROUTES_CHANGED);
+    nb->subscribe(this, NF_INTERFACE_CREATED);
+    nb->subscribe(this, NF_INTERFACE_DELETED);
+    nb->subscribe(this, NF_INTERFACE_STATE_CHANGED);
+    nb->subscribe(this, NF_INTERFACE_CONFIG_CHANGED);
+    nb->subscribe(this, NF_INTERFACE_IPv4CONFIG_CHANGED);
 
     numMulticast = numLocalDeliver = numDropped = numUnroutable = numForwarded = 0;
+    numFibHits = numFibRebuilds = 0;
 
     WATCH(numMulticast);
     WATCH(numLocalDeliver);
     WATCH(numDropped);
     WATCH(numUnroutable);
     WATCH(numForwarded);
+    WATCH(numFibHits);
+    WATCH(numFibRebuilds);
+}
+
+void IP::finish()
+{
+    recordScalar("packets forwarded", numForwarded);
+    recordScalar("packets delivered", numLocalDeliver);
+    recordScalar("reassembly timeouts", fragbuf.getNumTimedOut());
+    recordScalar("reassembly buffer overflows", fragbuf.getNumEvicted());
+    recordScalar("FIB hits", numFibHits);
+    recordScalar("FIB rebuilds", numFibRebuilds);
+}
+
+void IP::receiveChangeNotification(int category, const cPolymorphic *details)
+{
+    // all subscribed categories affect routing decisions; the caches
+    // are refilled on demand
+    Enter_Method_Silent();
+    if (!fib.empty())
+    {
+        fib.clear();
+        numFibRebuilds++;
+    }
+    mcastCache.clear();
+}
+
+void IP::handleMessage(cMessage *msg)
+{
+    if (msg==fragmentPurgeTimer)
+    {
+        fragbuf.purgeStaleFragments(simTime()-fragmentTimeoutTime);
+        scheduleFragmentPurgeTimer();
+    }
+    else
+    {
+        QueueBase::handleMessage(msg);
+    }
+}
+
+void IP::scheduleFragmentPurgeTimer()
+{
+    // the oldest update time never decreases, so a timer that is already
+    // scheduled is never late; at worst it fires early and gets rescheduled
+    simtime_t oldest = fragbuf.getOldestUpdateTime();
+    if (oldest>=0 && !fragmentPurgeTimer->isScheduled())
+        scheduleAt(oldest+fragmentTimeoutTime, fragmentPurgeTimer);
 }
 
 void IP::updateDisplayString()
@@ -143,7 +209,7 @@ void IP::handleARP(ARPPacket *msg)
     routingDecision->setInterfaceId(fromIE->getInterfaceId());
     msg->setControlInfo(routingDecision);
 
-    send(msg, queueOutGate);
+    sendDeparture(msg, queueOutGate);
 }
 
 void IP::handleReceivedICMP(ICMPMessage *msg)
@@ -158,14 +224,14 @@ void IP::handleReceivedICMP(ICMPMessage *msg)
             IPDatagram *bogusPacket = check_and_cast<IPDatagram *>(msg->getEncapsulatedPacket());
             int protocol = bogusPacket->getTransportProtocol();
             int gateindex = mapping.getOutputGateForProtocol(protocol);
-            send(msg, "transportOut", gateindex);
+            sendDeparture(msg, "transportOut", gateindex);
             break;
         }
         default: {
             // all others are delivered to ICMP: ICMP_ECHO_REQUEST, ICMP_ECHO_REPLY,
             // ICMP_TIMESTAMP_REQUEST, ICMP_TIMESTAMP_REPLY, etc.
             int gateindex = mapping.getOutputGateForProtocol(IP_PROT_ICMP);
-            send(msg, "transportOut", gateindex);
+            sendDeparture(msg, "transportOut", gateindex);
         }
     }
 }
@@ -200,7 +266,8 @@ void IP::routePacket(IPDatagram *datagram, InterfaceEntry *destIE, bool fromHL)
     EV << "Routing datagram `" << datagram->getName() << "' with dest=" << destAddr << ": ";
 
     // check for local delivery
-    if (rt->isLocalAddress(destAddr))
+    const FIBEntry& fibEntry = getFIBEntry(destAddr);
+    if (fibEntry.isLocal)
     {
         EV << "local delivery\n";
         if (datagram->getSrcAddress().isUnspecified())
@@ -229,8 +296,8 @@ void IP::routePacket(IPDatagram *datagram, InterfaceEntry *destIE, bool fromHL)
     }
     else
     {
-        // use IP routing (lookup in routing table)
-        const IPRoute *re = rt->findBestMatchingRoute(destAddr);
+        // use IP routing (lookup in routing table, via the FIB)
+        const IPRoute *re = fibEntry.route;
 
         // error handling: destination address does not exist in routing table:
         // notify ICMP, throw packet away and continue
@@ -268,11 +335,12 @@ void IP::routeMulticastPacket(IPDatagram *datagram, InterfaceEntry *destIE, Inte
 
     numMulticast++;
 
+    const MulticastForwardingEntry& entry = getMulticastForwardingEntry(datagram->getSrcAddress(), destAddr);
+
     // DVMRP: process datagram only if sent locally or arrived on the shortest
     // route (provided routing table already contains srcAddr); otherwise
     // discard and continue.
-    InterfaceEntry *shortestPathIE = rt->getInterfaceForDestAddr(datagram->getSrcAddress());
-    if (fromIE!=NULL && shortestPathIE!=NULL && fromIE!=shortestPathIE)
+    if (fromIE!=NULL && entry.rpfInterface!=NULL && fromIE!=entry.rpfInterface)
     {
         // FIXME count dropped
         EV << "Packet dropped.\n";
@@ -280,34 +348,45 @@ void IP::routeMulticastPacket(IPDatagram *datagram, InterfaceEntry *destIE, Inte
         return;
     }
 
-    // if received from the network...
+    // count the outgoing interfaces, so that the datagram itself can be used
+    // instead of the last copy; copies share the encapsulated packet
+    // (cPacket::dup() does not copy it), so the payload is only duplicated
+    // where it gets accessed (e.g. at local delivery)
+    int numCopies = 0;
+    bool forward = true;
     if (fromIE!=NULL)
     {
-        // check for local delivery
-        if (rt->isLocalMulticastAddress(destAddr))
-        {
-            IPDatagram *datagramCopy = (IPDatagram *) datagram->dup();
-
-            // FIXME code from the MPLS model: set packet dest address to routerId (???)
-            datagramCopy->setDestAddress(rt->getRouterId());
+        // don't forward if IP forwarding is off, or if dest address is link-scope
+        forward = rt->isIPForwardingEnabled() && !destAddr.isLinkLocalMulticast();
+    }
+    if (forward)
+    {
+        if (destIE!=NULL)
+            numCopies = 1;
+        else
+            for (unsigned int i=0; i<entry.routes.size(); i++)
+                if (entry.routes[i].interf && entry.routes[i].interf!=fromIE)
+                    numCopies++;
+    }
 
-            reassembleAndDeliver(datagramCopy);
-        }
+    // if received from the network, check for local delivery
+    if (fromIE!=NULL && entry.isLocalMember)
+    {
+        IPDatagram *datagramCopy = numCopies>0 ? (IPDatagram *) datagram->dup() : datagram;
 
-        // don't forward if IP forwarding is off
-        if (!rt->isIPForwardingEnabled())
-        {
-            delete datagram;
-            return;
-        }
+        // FIXME code from the MPLS model: set packet dest address to routerId (???)
+        datagramCopy->setDestAddress(rt->getRouterId());
 
-        // don't forward if dest address is link-scope
-        if (destAddr.isLinkLocalMulticast())
-        {
-            delete datagram;
+        reassembleAndDeliver(datagramCopy);
+        if (numCopies==0)
             return;
-        }
+    }
 
+    if (numCopies==0)
+    {
+        // no destination: delete datagram
+        delete datagram;
+        return;
     }
 
     // routed explicitly via IP_MULTICAST_IF
@@ -327,38 +406,57 @@ void IP::routeMulticastPacket(IPDatagram *datagram, InterfaceEntry *destIE, Inte
         return;
     }
 
-    // now: routing
-    MulticastRoutes routes = rt->getMulticastRoutesFor(destAddr);
-    if (routes.size()==0)
+    // now: routing; copy original datagram for multiple destinations
+    for (unsigned int i=0; i<entry.routes.size(); i++)
     {
-        // no destination: delete datagram
-        delete datagram;
-    }
-    else
-    {
-        // copy original datagram for multiple destinations
-        for (unsigned int i=0; i<routes.size(); i++)
-        {
-            InterfaceEntry *destIE = routes[i].interf;
+        InterfaceEntry *destIE = entry.routes[i].interf;
 
-            // don't forward to input port
-            if (destIE && destIE!=fromIE)
-            {
-                IPDatagram *datagramCopy = (IPDatagram *) datagram->dup();
+        // don't forward to input port
+        if (destIE && destIE!=fromIE)
+        {
+            IPDatagram *datagramCopy = --numCopies>0 ? (IPDatagram *) datagram->dup() : datagram;
 
-                // set datagram source address if not yet set
-                if (datagramCopy->getSrcAddress().isUnspecified())
-                    datagramCopy->setSrcAddress(destIE->ipv4Data()->getIPAddress());
+            // set datagram source address if not yet set
+            if (datagramCopy->getSrcAddress().isUnspecified())
+                datagramCopy->setSrcAddress(destIE->ipv4Data()->getIPAddress());
 
-                // send
-                IPAddress nextHopAddr = routes[i].gateway;
-                fragmentAndSend(datagramCopy, destIE, nextHopAddr);
-            }
+            // send
+            IPAddress nextHopAddr = entry.routes[i].gateway;
+            fragmentAndSend(datagramCopy, destIE, nextHopAddr);
         }
+    }
+}
 
-        // only copies sent, delete original datagram
-        delete datagram;
+const IP::FIBEntry& IP::getFIBEntry(const IPAddress& dest)
+{
+    FIB::iterator it = fib.find(dest);
+    if (it!=fib.end())
+    {
+        numFibHits++;
+        return it->second;
     }
+
+    FIBEntry& entry = fib[dest];
+    entry.isLocal = rt->isLocalAddress(dest);
+    entry.route = entry.isLocal ? NULL : rt->findBestMatchingRoute(dest);
+    return entry;
+}
+
+const IP::MulticastForwardingEntry& IP::getMulticastForwardingEntry(const IPAddress& src, const IPAddress& group)
+{
+    MulticastKey key;
+    key.src = src;
+    key.group = group;
+
+    MulticastForwardingCache::iterator it = mcastCache.find(key);
+    if (it!=mcastCache.end())
+        return it->second;
+
+    MulticastForwardingEntry& entry = mcastCache[key];
+    entry.rpfInterface = rt->getInterfaceForDestAddr(src);
+    entry.isLocalMember = rt->isLocalMulticastAddress(group);
+    entry.routes = rt->getMulticastRoutesFor(group);
+    return entry;
 }
 
 void IP::reassembleAndDeliver(IPDatagram *datagram)
@@ -369,14 +467,12 @@ void IP::reassembleAndDeliver(IPDatagram *datagram)
         EV << "Datagram fragment: offset=" << datagram->getFragmentOffset()
            << ", MORE=" << (datagram->getMoreFragments() ? "true" : "false") << ".\n";
 
-        // erase timed out fragments in fragmentation buffer; check every 10 seconds max
-        if (simTime() >= lastCheckTime + 10)
-        {
-            lastCheckTime = simTime();
-            fragbuf.purgeStaleFragments(simTime()-fragmentTimeoutTime);
-        }
+        // erase timed out fragments in fragmentation buffer (this only
+        // touches the expired ones, so it is cheap to do it every time)
+        fragbuf.purgeStaleFragments(simTime()-fragmentTimeoutTime);
 
         datagram = fragbuf.addFragment(datagram, simTime());
+        scheduleFragmentPurgeTimer();
         if (!datagram)
         {
             EV << "No complete datagram yet.\n";
@@ -397,12 +493,12 @@ void IP::reassembleAndDeliver(IPDatagram *datagram)
     else if (protocol==IP_PROT_IP)
     {
         // tunnelled IP packets are handled separately
-        send(packet, "preRoutingOut");
+        sendDeparture(packet, "preRoutingOut");
     }
     else
     {
         int gateindex = mapping.getOutputGateForProtocol(protocol);
-        send(packet, "transportOut", gateindex);
+        sendDeparture(packet, "transportOut", gateindex);
     }
 }
 
@@ -574,7 +670,7 @@ void IP::sendDatagramToOutput(IPDatagram *datagram, InterfaceEntry *ie, IPAddres
     routingDecision->setNextHopAddr(nextHopAddr);
     datagram->setControlInfo(routingDecision);
 
-    send(datagram, queueOutGate);
+    sendDeparture(datagram, queueOutGate);
 }
 
 
@@ -19,6 +19,8 @@
 #define __INET_IP_H
 
 #include "QueueBase.h"
+#include "INETHashMap.h"
+#include "INotifiable.h"
 #include "InterfaceTableAccess.h"
 #include "RoutingTableAccess.h"
 #include "IRoutingTable.h"
@@ -39,8 +41,50 @@ const int ICMP_FRAGMENTATION_ERROR_CODE = 4;
 /**
  * Implements the IP protocol.
  */
-class INET_API IP : public QueueBase
+class INET_API IP : public QueueBase, protected INotifiable
 {
+  protected:
+    //
+    // Multicast forwarding cache entry: the result of the routing table
+    // lookups for a (source, group) pair
+    //
+    struct MulticastForwardingEntry
+    {
+        InterfaceEntry *rpfInterface; // interface towards the source, or NULL
+        bool isLocalMember;           // true if some interface is member of the group
+        MulticastRoutes routes;       // outgoing interfaces and next hops
+    };
+
+    struct MulticastKey
+    {
+        IPAddress src;
+        IPAddress group;
+
+        inline bool operator==(const MulticastKey& b) const {
+            return src==b.src && group==b.group;
+        }
+    };
+
+    struct MulticastKeyHash
+    {
+        size_t operator()(const MulticastKey& k) const {
+            return inet_hashCombine(k.src.getInt(), k.group.getInt());
+        }
+    };
+
+    typedef std::tr1::unordered_map<MulticastKey,MulticastForwardingEntry,MulticastKeyHash> MulticastForwardingCache;
+
+    //
+    // Forwarding information base entry: the result of the routing table
+    // lookups for a unicast destination address
+    //
+    struct FIBEntry
+    {
+        bool isLocal;          // true if the address belongs to this node
+        const IPRoute *route;  // best matching route, or NULL if unroutable
+    };
+    typedef std::tr1::unordered_map<IPAddress,FIBEntry,IPAddressHash> FIB;
+
   protected:
     IRoutingTable *rt;
     IInterfaceTable *ift;
@@ -55,8 +99,10 @@ class INET_API IP : public QueueBase
     // working vars
     long curFragmentId; // counter, used to assign unique fragmentIds to datagrams
     IPFragBuf fragbuf;  // fragmentation reassembly buffer
-    simtime_t lastCheckTime; // when fragbuf was last checked for state fragments
+    cMessage *fragmentPurgeTimer; // removes timed out datagrams from fragbuf
     ProtocolMapping mapping; // where to send packets after decapsulation
+    FIB fib; // cleared on route and interface changes
+    MulticastForwardingCache mcastCache; // cleared on route and interface changes
 
     // statistics
     int numMulticast;
@@ -64,6 +110,8 @@ class INET_API IP : public QueueBase
     int numDropped;
     int numUnroutable;
     int numForwarded;
+    long numFibHits;
+    long numFibRebuilds;
 
   protected:
     // utility: look up interface from getArrivalGate()
@@ -122,9 +170,24 @@ class INET_API IP : public QueueBase
 
     /**
      * Forwards packets to all multicast destinations, using fragmentAndSend().
+     * The copies share the encapsulated packet, and the last copy is the
+     * datagram itself.
      */
     virtual void routeMulticastPacket(IPDatagram *datagram, InterfaceEntry *destIE, InterfaceEntry *fromIE);
 
+    /**
+     * Returns the FIB entry for the given unicast destination, filling it in
+     * from the routing table if not yet cached. The FIB replaces the
+     * isLocalAddress() and findBestMatchingRoute() calls for every packet.
+     */
+    virtual const FIBEntry& getFIBEntry(const IPAddress& dest);
+
+    /**
+     * Returns the multicast forwarding cache entry for the given source and
+     * group, filling it in from the routing table if not yet cached.
+     */
+    virtual const MulticastForwardingEntry& getMulticastForwardingEntry(const IPAddress& src, const IPAddress& group);
+
     /**
      * Perform reassembly of fragmented datagrams, then send them up to the
      * higher layers using sendToHL().
@@ -148,7 +211,8 @@ class INET_API IP : public QueueBase
     virtual void sendDatagramToOutput(IPDatagram *datagram, InterfaceEntry *ie, IPAddress nextHopAddr);
 
   public:
-    IP() {}
+    IP() {fragmentPurgeTimer = NULL;}
+    virtual ~IP();
 
   protected:
     /**
@@ -156,11 +220,31 @@ class INET_API IP : public QueueBase
      */
     virtual void initialize();
 
+    /**
+     * Records forwarding and reassembly statistics.
+     */
+    virtual void finish();
+
+    /**
+     * Handles the fragment purge timer, and passes other messages to the queue.
+     */
+    virtual void handleMessage(cMessage *msg);
+
+    /**
+     * Schedules the fragment purge timer for the oldest incomplete datagram.
+     */
+    virtual void scheduleFragmentPurgeTimer();
+
     /**
      * Processing of IP datagrams. Called when a datagram reaches the front
      * of the queue.
      */
     virtual void endService(cPacket *msg);
+
+    /**
+     * Clears the forwarding caches on route and interface changes.
+     */
+    virtual void receiveChangeNotification(int category, const cPolymorphic *details);
 };
 
 #endif
@@ -27,6 +27,10 @@
 IPFragBuf::IPFragBuf()
 {
     icmpModule = NULL;
+    oldest = newest = NULL;
+    totalBytes = 0;
+    maxBufferedBytes = 0;
+    numTimedOut = numEvicted = 0;
 }
 
 IPFragBuf::~IPFragBuf()
@@ -38,6 +42,50 @@ void IPFragBuf::init(ICMP *icmp)
     icmpModule = icmp;
 }
 
+void IPFragBuf::unlink(DatagramBuffer *buf)
+{
+    if (buf->prev)
+        buf->prev->next = buf->next;
+    else
+        oldest = buf->next;
+    if (buf->next)
+        buf->next->prev = buf->prev;
+    else
+        newest = buf->prev;
+    buf->prev = buf->next = NULL;
+}
+
+void IPFragBuf::append(DatagramBuffer *buf)
+{
+    buf->prev = newest;
+    buf->next = NULL;
+    if (newest)
+        newest->next = buf;
+    else
+        oldest = buf;
+    newest = buf;
+}
+
+void IPFragBuf::remove(DatagramBuffer *buf, bool deleteDatagram)
+{
+    unlink(buf);
+    totalBytes -= buf->bytes;
+    if (deleteDatagram)
+        delete buf->datagram;
+    Key key = buf->key;
+    bufs.erase(key);
+}
+
+void IPFragBuf::evictOldest(DatagramBuffer *keep)
+{
+    while (totalBytes > maxBufferedBytes && oldest && oldest!=keep)
+    {
+        EV << "reassembly buffer full, dropping oldest incomplete datagram\n";
+        numEvicted++;
+        remove(oldest, true);
+    }
+}
+
 IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
 {
     // find datagram buffer
@@ -54,11 +102,17 @@ IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
         // this is the first fragment of that datagram, create reassembly buffer for it
         buf = &bufs[key];
         buf->datagram = NULL;
+        buf->bytes = 0;
+        buf->firstFragmentReceived = false;
+        buf->key = key;
+        append(buf);
     }
     else
     {
-        // use existing buffer
+        // use existing buffer; it becomes the most recently updated one
         buf = &(i->second);
+        unlink(buf);
+        append(buf);
     }
 
     // add fragment into reassembly buffer
@@ -67,6 +121,14 @@ IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
                                            datagram->getFragmentOffset() + bytes,
                                            !datagram->getMoreFragments());
 
+    // account only for newly covered bytes, so that duplicate or overlapping
+    // fragments don't inflate the memory usage
+    long stored = buf->buf.getStoredLength();
+    totalBytes += stored - buf->bytes;
+    buf->bytes = stored;
+    if (datagram->getFragmentOffset()==0)
+        buf->firstFragmentReceived = true;
+
     // store datagram. Only one fragment carries the actual modelled
     // content (getEncapsulatedPacket()), other (empty) ones are only
     // preserved so that we can send them in ICMP if reassembly times out.
@@ -75,6 +137,11 @@ IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
         delete buf->datagram;
         buf->datagram = datagram;
     }
+    else if (!buf->datagram)
+    {
+        // keep one fragment in any case, for the ICMP error message
+        buf->datagram = datagram;
+    }
     else
     {
         delete datagram;
@@ -88,45 +155,46 @@ IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
         ret->setByteLength(ret->getHeaderLength()+buf->buf.getTotalLength());
         ret->setFragmentOffset(0);
         ret->setMoreFragments(false);
-        bufs.erase(i);
+        remove(buf, false);
         return ret;
     }
     else
     {
         // there are still missing fragments
         buf->lastupdate = now;
+        if (maxBufferedBytes > 0 && totalBytes > maxBufferedBytes)
+            evictOldest(buf);
         return NULL;
     }
 }
 
 void IPFragBuf::purgeStaleFragments(simtime_t lastupdate)
 {
-    // this method shouldn't be called too often because iteration on
-    // an std::map is *very* slow...
+    // buffers are ordered by lastupdate, so we can stop at the first
+    // one which is not too old
 
     ASSERT(icmpModule);
 
-    for (Buffers::iterator i=bufs.begin(); i!=bufs.end(); )
+    while (oldest && oldest->lastupdate <= lastupdate)
     {
-        // if too old, remove it
-        DatagramBuffer& buf = i->second;
-        if (buf.lastupdate < lastupdate)
-        {
-            // send ICMP error.
-            // Note: receiver MUST NOT call decapsulate() on the datagram fragment,
-            // because its length (being a fragment) is smaller than the encapsulated
-            // packet, resulting in "length became negative" error. Use getEncapsulatedPacket().
-            EV << "datagram fragment timed out in reassembly buffer, sending ICMP_TIME_EXCEEDED\n";
-            icmpModule->sendErrorMessage(buf.datagram, ICMP_TIME_EXCEEDED, 0);
-
-            // delete
-            Buffers::iterator oldi = i++;
-            bufs.erase(oldi);
-        }
-        else
+        numTimedOut++;
+
+        // RFC 1122: the error may only be sent if fragment zero is available
+        if (!oldest->firstFragmentReceived || !oldest->datagram->getEncapsulatedPacket())
         {
-            ++i;
+            EV << "datagram fragment timed out in reassembly buffer, first fragment missing, dropping it\n";
+            remove(oldest, true);
+            continue;
         }
+
+        // send ICMP error.
+        // Note: receiver MUST NOT call decapsulate() on the datagram fragment,
+        // because its length (being a fragment) is smaller than the encapsulated
+        // packet, resulting in "length became negative" error. Use getEncapsulatedPacket().
+        EV << "datagram fragment timed out in reassembly buffer, sending ICMP_TIME_EXCEEDED\n";
+        icmpModule->sendErrorMessage(oldest->datagram, ICMP_TIME_EXCEEDED, 0);
+
+        // delete (the datagram is now owned by ICMP)
+        remove(oldest, false);
     }
 }
-
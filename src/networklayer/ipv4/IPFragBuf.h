@@ -21,6 +21,7 @@
 #include <map>
 #include <vector>
 #include "INETDefs.h"
+#include "INETHashMap.h"
 #include "ReassemblyBuffer.h"
 #include "IPDatagram.h"
 
@@ -30,6 +31,17 @@ class ICMP;
 
 /**
  * Reassembly buffer for fragmented IP datagrams.
+ *
+ * Buffers are kept in a hash table keyed by (id, src, dest), and are also
+ * chained into a list ordered by the time of the last fragment arrival.
+ * Since simulation time never decreases, moving a buffer to the tail of
+ * the list on every update keeps the list sorted, so purgeStaleFragments()
+ * only needs to look at the head of the list, and touches only expired
+ * buffers.
+ *
+ * An optional memory limit can be set with setMaxBufferedBytes(); when the
+ * total number of bytes held in incomplete datagrams exceeds the limit,
+ * the oldest datagrams are dropped first.
  */
 class INET_API IPFragBuf
 {
@@ -43,8 +55,15 @@ class INET_API IPFragBuf
         IPAddress src;
         IPAddress dest;
 
-        inline bool operator<(const Key& b) const {
-            return (id!=b.id) ? (id<b.id) : (src!=b.src) ? (src<b.src) : (dest<b.dest);
+        inline bool operator==(const Key& b) const {
+            return id==b.id && src==b.src && dest==b.dest;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const {
+            return inet_hashCombine(inet_hashCombine(k.id, k.src.getInt()), k.dest.getInt());
         }
     };
 
@@ -56,17 +75,46 @@ class INET_API IPFragBuf
         ReassemblyBuffer buf;  // reassembly buffer
         IPDatagram *datagram;  // the actual datagram
         simtime_t lastupdate;  // last time a new fragment arrived
+        long bytes;            // distinct fragment bytes received so far
+        bool firstFragmentReceived; // whether the fragment with offset 0 has arrived
+        Key key;               // our key in the hash table
+        DatagramBuffer *prev;  // expiry list: previous (older) buffer
+        DatagramBuffer *next;  // expiry list: next (newer) buffer
     };
 
-    // we use std::map for fast lookup by datagram Id
-    typedef std::map<Key,DatagramBuffer> Buffers;
+    // hash table for fast lookup by datagram Id; note that elements of
+    // unordered_map don't move on rehash, so list pointers stay valid
+    typedef std::tr1::unordered_map<Key,DatagramBuffer,KeyHash> Buffers;
 
     // the reassembly buffers
     Buffers bufs;
 
+    // expiry list, ordered by lastupdate (oldest first)
+    DatagramBuffer *oldest;
+    DatagramBuffer *newest;
+
+    // memory accounting
+    long totalBytes;        // bytes held in all reassembly buffers
+    long maxBufferedBytes;  // limit for totalBytes; 0 means unlimited
+
+    // statistics
+    long numTimedOut;  // datagrams dropped because of reassembly timeout
+    long numEvicted;   // datagrams dropped because of the memory limit
+
     // needed for TIME_EXCEEDED errors
     ICMP *icmpModule;
 
+  protected:
+    // expiry list manipulation
+    void unlink(DatagramBuffer *buf);
+    void append(DatagramBuffer *buf);
+
+    // unlinks and deletes the given buffer, together with its stored datagram
+    void remove(DatagramBuffer *buf, bool deleteDatagram);
+
+    // drops oldest buffers (but not keep) until totalBytes is within the limit
+    void evictOldest(DatagramBuffer *keep);
+
   public:
     /**
      * Ctor.
@@ -84,6 +132,13 @@ class INET_API IPFragBuf
      */
     void init(ICMP *icmp);
 
+    /**
+     * Limits the number of bytes held in incomplete datagrams. When the
+     * limit is exceeded, the oldest datagrams are dropped (without sending
+     * ICMP errors). Zero means no limit, which is the default.
+     */
+    void setMaxBufferedBytes(long bytes) {maxBufferedBytes = bytes;}
+
     /**
      * Takes a fragment and inserts it into the reassembly buffer.
      * If this fragment completes a datagram, the full reassembled
@@ -93,14 +148,30 @@ class INET_API IPFragBuf
 
     /**
      * Throws out all fragments which are incomplete and their
-     * last update (last fragment arrival) was before "lastupdate",
-     * and sends ICMP TIME EXCEEDED message about them.
+     * last update (last fragment arrival) was at or before "lastupdate",
+     * and sends ICMP TIME EXCEEDED message about them. As RFC 1122
+     * requires, the ICMP message is only sent if the first fragment
+     * (offset 0) of the datagram has been received.
      *
      * Timeout should be between 60 seconds and 120 seconds (RFC1122).
-     * This method should be called more frequently, maybe every
-     * 10..30 seconds or so.
+     * The cost of this method is proportional to the number of expired
+     * datagrams only, so it is cheap to call it on every fragment arrival.
      */
     void purgeStaleFragments(simtime_t lastupdate);
+
+    /**
+     * Returns the time of the oldest update among the incomplete datagrams,
+     * or -1 if the buffer is empty. Used for scheduling the purge timer.
+     */
+    simtime_t getOldestUpdateTime() const {return oldest ? oldest->lastupdate : -1;}
+
+    /** @name Statistics */
+    //@{
+    int getNumBuffers() const {return bufs.size();}
+    long getBufferedBytes() const {return totalBytes;}
+    long getNumTimedOut() const {return numTimedOut;}
+    long getNumEvicted() const {return numEvicted;}
+    //@}
 };
 
 #endif
@@ -162,6 +162,23 @@ class INET_API IRoutingTable
      */
     virtual bool deleteRoute(const IPRoute *entry) = 0;
 
+    /**
+     * Starts a batch of route changes. Until the matching commit(), addRoute()
+     * and deleteRoute() only record the change: caches are not invalidated,
+     * no per-route notifications are fired, and deleted routes are only
+     * removed (and destroyed) in commit(). getNumRoutes()/getRoute() may still
+     * return routes deleted in the batch, and route lookups may or may not
+     * reflect the changes made so far. Calls may be nested.
+     */
+    virtual void beginUpdate() = 0;
+
+    /**
+     * Applies the changes made since beginUpdate() in one pass, and fires
+     * a single NF_IPv4_ROUTES_CHANGED notification (instead of
+     * NF_IPv4_ROUTE_ADDED/NF_IPv4_ROUTE_DELETED for each route).
+     */
+    virtual void commit() = 0;
+
     /**
      * Utility function: Returns a vector of all addresses of the node.
      */
@@ -46,6 +46,10 @@ std::ostream& operator<<(std::ostream& os, const IPRoute& e)
 
 RoutingTable::RoutingTable()
 {
+    ift = NULL;
+    cachedInterfaceGeneration = 0;
+    updateDepth = 0;
+    routesChangedInUpdate = false;
 }
 
 RoutingTable::~RoutingTable()
@@ -182,14 +186,8 @@ void RoutingTable::receiveChangeNotification(int category, const cPolymorphic *d
         InterfaceEntry *entry = check_and_cast<InterfaceEntry*>(details);
         deleteInterfaceRoutes(entry);
     }
-    else if (category==NF_INTERFACE_STATE_CHANGED)
-    {
-        invalidateCache();
-    }
-    else if (category==NF_INTERFACE_CONFIG_CHANGED)
-    {
-        invalidateCache();
-    }
+    // note: NF_INTERFACE_STATE_CHANGED and NF_INTERFACE_CONFIG_CHANGED need not
+    // be handled here, caches are validated using the interface table's generation
     else if (category==NF_INTERFACE_IPv4CONFIG_CHANGED)
     {
         // if anything IPv4-related changes in the interfaces, interface netmask
@@ -288,6 +286,7 @@ bool RoutingTable::isLocalAddress(const IPAddress& dest) const
 {
     Enter_Method("isLocalAddress(%u.%u.%u.%u)", dest.getDByte(0), dest.getDByte(1), dest.getDByte(2), dest.getDByte(3)); // note: str().c_str() too slow here
 
+    checkInterfaceGeneration();
     if (localAddresses.empty())
     {
         // collect interface addresses if not yet done
@@ -320,6 +319,7 @@ const IPRoute *RoutingTable::findBestMatchingRoute(const IPAddress& dest) const
 {
     Enter_Method("findBestMatchingRoute(%u.%u.%u.%u)", dest.getDByte(0), dest.getDByte(1), dest.getDByte(2), dest.getDByte(3)); // note: str().c_str() too slow here
 
+    checkInterfaceGeneration();
     RoutingCache::iterator it = routingCache.find(dest);
     if (it != routingCache.end())
         return it->second;
@@ -399,7 +399,7 @@ const IPRoute *RoutingTable::getDefaultRoute() const
 {
     int n = (int)routes.size();
     for (int i=0; i<n; i++)
-        if (routes[i]->getNetmask().isUnspecified())
+        if (routes[i]->getNetmask().isUnspecified() && isLive(routes[i]))
             return routes[i];
     return NULL;
 }
@@ -409,7 +409,7 @@ const IPRoute *RoutingTable::findRoute(const IPAddress& target, const IPAddress&
 {
     int n = getNumRoutes();
     for (int i=0; i<n; i++)
-        if (routeMatches(getRoute(i), target, netmask, gw, metric, dev))
+        if (routeMatches(getRoute(i), target, netmask, gw, metric, dev) && isLive(getRoute(i)))
             return getRoute(i);
     return NULL;
 }
@@ -439,6 +439,13 @@ void RoutingTable::addRoute(const IPRoute *entry)
         routes.push_back(const_cast<IPRoute*>(entry));
     else
         multicastRoutes.push_back(const_cast<IPRoute*>(entry));
+    routeSet.insert(entry);
+
+    if (updateDepth>0)
+    {
+        routesChangedInUpdate = true;
+        return;
+    }
 
     invalidateCache();
     updateDisplayString();
@@ -451,6 +458,17 @@ bool RoutingTable::deleteRoute(const IPRoute *entry)
 {
     Enter_Method("deleteRoute(...)");
 
+    if (updateDepth>0)
+    {
+        // only mark it as deleted; it'll be removed from the arrays in commit()
+        if (routeSet.erase(entry)==0)
+            return false;
+        deletedRoutes.push_back(const_cast<IPRoute*>(entry));
+        routesChangedInUpdate = true;
+        return true;
+    }
+
+    routeSet.erase(entry);
     RouteVector::iterator i = std::find(routes.begin(), routes.end(), entry);
     if (i!=routes.end())
     {
@@ -474,6 +492,49 @@ bool RoutingTable::deleteRoute(const IPRoute *entry)
     return false;
 }
 
+void RoutingTable::beginUpdate()
+{
+    Enter_Method_Silent();
+    updateDepth++;
+}
+
+void RoutingTable::commit()
+{
+    Enter_Method("commit()");
+
+    if (updateDepth==0)
+        error("commit(): no update in progress (missing beginUpdate() call?)");
+    if (--updateDepth>0)
+        return;
+    if (!routesChangedInUpdate)
+        return;
+
+    if (!deletedRoutes.empty())
+    {
+        purgeDeletedRoutes(routes);
+        purgeDeletedRoutes(multicastRoutes);
+        for (unsigned int i=0; i<deletedRoutes.size(); i++)
+            delete deletedRoutes[i];
+        deletedRoutes.clear();
+    }
+    routesChangedInUpdate = false;
+
+    invalidateCache();
+    updateDisplayString();
+
+    nb->fireChangeNotification(NF_IPv4_ROUTES_CHANGED, NULL);
+}
+
+void RoutingTable::purgeDeletedRoutes(RouteVector& vec)
+{
+    int n = vec.size();
+    int k = 0;
+    for (int i=0; i<n; i++)
+        if (routeSet.find(vec[i])!=routeSet.end())
+            vec[k++] = vec[i];
+    vec.resize(k);
+}
+
 
 bool RoutingTable::routeMatches(const IPRoute *entry,
     const IPAddress& target, const IPAddress& nmask,
@@ -495,10 +556,19 @@ bool RoutingTable::routeMatches(const IPRoute *entry,
 
 void RoutingTable::updateNetmaskRoutes()
 {
-    // first, delete all routes with src=IFACENETMASK
-    for (unsigned int k=0; k<routes.size(); k++)
-        if (routes[k]->getSource()==IPRoute::IFACENETMASK)
-            routes.erase(routes.begin()+(k--));  // '--' is necessary because indices shift down
+    // first, delete all routes with src=IFACENETMASK (routes deleted in
+    // an ongoing update are only removed here, they'll be destroyed in commit())
+    int n = routes.size();
+    int k = 0;
+    for (int i=0; i<n; i++)
+    {
+        IPRoute *route = routes[i];
+        if (route->getSource()!=IPRoute::IFACENETMASK)
+            routes[k++] = route;
+        else if (routeSet.erase(route)!=0)
+            delete route;
+    }
+    routes.resize(k);
 
     // then re-add them, according to actual interface configuration
     for (int i=0; i<ift->getNumInterfaces(); i++)
@@ -515,6 +585,7 @@ void RoutingTable::updateNetmaskRoutes()
             route->setMetric(ie->ipv4Data()->getMetric());
             route->setInterface(ie);
             routes.push_back(route);
+            routeSet.insert(route);
         }
     }
 
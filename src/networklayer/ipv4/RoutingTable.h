@@ -31,6 +31,7 @@
 #include <vector>
 #include <omnetpp.h>
 #include "INETDefs.h"
+#include "INETHashMap.h"
 #include "IPAddress.h"
 #include "IInterfaceTable.h"
 #include "NotificationBoard.h"
@@ -85,6 +86,15 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     RouteVector routes;          // Unicast route array
     RouteVector multicastRoutes; // Multicast route array
 
+    // all routes in the above arrays, except those deleted in the ongoing update
+    typedef std::tr1::unordered_set<const IPRoute *> RouteSet;
+    RouteSet routeSet;
+
+    // batch updates, see beginUpdate()/commit()
+    int updateDepth;           // nesting level of beginUpdate() calls
+    bool routesChangedInUpdate;
+    RouteVector deletedRoutes; // routes deleted in the ongoing update
+
     // routing cache: maps destination address to the route
     typedef std::map<IPAddress, const IPRoute *> RoutingCache;
     mutable RoutingCache routingCache;
@@ -93,6 +103,9 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     typedef std::set<IPAddress> AddressSet;
     mutable AddressSet localAddresses;
 
+    // interface table generation the above caches were built with
+    mutable unsigned long cachedInterfaceGeneration;
+
   protected:
     // set IP address etc on local loopback
     virtual void configureLoopbackForIPv4();
@@ -117,6 +130,21 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
     // invalidates routing cache and local addresses cache
     virtual void invalidateCache();
 
+    // removes routes not in routeSet from the given array, in one pass
+    virtual void purgeDeletedRoutes(RouteVector& vec);
+
+    // false for routes deleted in the ongoing update
+    bool isLive(const IPRoute *entry) const {return updateDepth==0 || routeSet.find(entry)!=routeSet.end();}
+
+    // invalidates the caches if the interface table changed since they were built
+    void checkInterfaceGeneration() const {
+        if (ift->getGeneration()!=cachedInterfaceGeneration) {
+            routingCache.clear();
+            localAddresses.clear();
+            cachedInterfaceGeneration = ift->getGeneration();
+        }
+    }
+
   public:
     RoutingTable();
     virtual ~RoutingTable();
@@ -252,6 +280,16 @@ class INET_API RoutingTable: public cSimpleModule, public IRoutingTable, protect
      */
     virtual bool deleteRoute(const IPRoute *entry);
 
+    /**
+     * Starts a batch of route changes. See IRoutingTable::beginUpdate().
+     */
+    virtual void beginUpdate();
+
+    /**
+     * Applies route changes made since beginUpdate(). See IRoutingTable::commit().
+     */
+    virtual void commit();
+
     /**
      * Utility function: Returns a vector of all addresses of the node.
      */
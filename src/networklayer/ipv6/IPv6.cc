@@ -29,11 +29,13 @@
 #include "ICMPv6Message_m.h"
 
 
-#define FRAGMENT_TIMEOUT 60   // 60 sec, from IPv6 RFC
-
-
 Define_Module(IPv6);
 
+IPv6::~IPv6()
+{
+    cancelAndDelete(fragmentPurgeTimer);
+}
+
 void IPv6::initialize()
 {
     QueueBase::initialize();
@@ -43,11 +45,13 @@ void IPv6::initialize()
     nd = IPv6NeighbourDiscoveryAccess().get();
     icmp = ICMPv6Access().get();
 
+    fragmentTimeoutTime = par("fragmentTimeout");
     mapping.parseProtocolMapping(par("protocolMapping"));
 
     curFragmentId = 0;
-    lastCheckTime = 0;
     fragbuf.init(icmp);
+    fragbuf.setMaxBufferedBytes(par("fragmentBufferSize"));
+    fragmentPurgeTimer = new cMessage("purge-fragments");
 
     numMulticast = numLocalDeliver = numDropped = numUnroutable = numForwarded = 0;
 
@@ -58,6 +62,34 @@ void IPv6::initialize()
     WATCH(numForwarded);
 }
 
+void IPv6::finish()
+{
+    recordScalar("reassembly timeouts", fragbuf.getNumTimedOut());
+    recordScalar("reassembly buffer overflows", fragbuf.getNumEvicted());
+}
+
+void IPv6::handleMessage(cMessage *msg)
+{
+    if (msg==fragmentPurgeTimer)
+    {
+        fragbuf.purgeStaleFragments(simTime()-fragmentTimeoutTime);
+        scheduleFragmentPurgeTimer();
+    }
+    else
+    {
+        QueueBase::handleMessage(msg);
+    }
+}
+
+void IPv6::scheduleFragmentPurgeTimer()
+{
+    // the oldest update time never decreases, so a timer that is already
+    // scheduled is never late; at worst it fires early and gets rescheduled
+    simtime_t oldest = fragbuf.getOldestUpdateTime();
+    if (oldest>=0 && !fragmentPurgeTimer->isScheduled())
+        scheduleAt(oldest+fragmentTimeoutTime, fragmentPurgeTimer);
+}
+
 void IPv6::updateDisplayString()
 {
     char buf[80] = "";
@@ -229,7 +261,7 @@ void IPv6::routePacket(IPv6Datagram *datagram, InterfaceEntry *destIE, bool from
             else // host
             {
                 EV << "no match in routing table, passing datagram to Neighbour Discovery module for default router selection\n";
-                send(datagram, "ndOut");
+                sendDeparture(datagram, "ndOut");
             }
             return;
         }
@@ -251,7 +283,7 @@ void IPv6::routePacket(IPv6Datagram *datagram, InterfaceEntry *destIE, bool from
     if (macAddr.isUnspecified())
     {
         EV << "no link-layer address for next hop yet, passing datagram to Neighbour Discovery module\n";
-        send(datagram, "ndOut");
+        sendDeparture(datagram, "ndOut");
         return;
     }
     EV << "link-layer address: " << macAddr << "\n";
@@ -403,14 +435,12 @@ void IPv6::isLocalAddress(IPv6Datagram *datagram)
         EV << "Datagram fragment: offset=" << datagram->getFragmentOffset()
            << ", MORE=" << (datagram->getMoreFragments() ? "true" : "false") << ".\n";
 
-        // erase timed out fragments in fragmentation buffer; check every 10 seconds max
-        if (simTime() >= lastCheckTime + 10)
-        {
-            lastCheckTime = simTime();
-            fragbuf.purgeStaleFragments(simTime()-FRAGMENT_TIMEOUT);
-        }
+        // erase timed out fragments in fragmentation buffer (this only
+        // touches the expired ones, so it is cheap to do it every time)
+        fragbuf.purgeStaleFragments(simTime()-fragmentTimeoutTime);
 
         datagram = fragbuf.addFragment(datagram, simTime());
+        scheduleFragmentPurgeTimer();
         if (!datagram)
         {
             EV << "No complete datagram yet.\n";
@@ -426,12 +456,12 @@ void IPv6::isLocalAddress(IPv6Datagram *datagram)
     if (protocol==IP_PROT_IPv6_ICMP && dynamic_cast<IPv6NDMessage*>(packet))
     {
         EV << "Neigbour Discovery packet: passing it to ND module\n";
-        send(packet, "ndOut");
+        sendDeparture(packet, "ndOut");
     }
     else if (protocol==IP_PROT_IPv6_ICMP && dynamic_cast<ICMPv6Message*>(packet))
     {
         EV << "ICMPv6 packet: passing it to ICMPv6 module\n";
-        send(packet, "icmpOut");
+        sendDeparture(packet, "icmpOut");
     }//Added by WEI to forward ICMPv6 msgs to ICMPv6 module.
     else if (protocol==IP_PROT_IP || protocol==IP_PROT_IPv6)
     {
@@ -444,7 +474,7 @@ void IPv6::isLocalAddress(IPv6Datagram *datagram)
         int gateindex = mapping.getOutputGateForProtocol(protocol);
         EV << "Protocol " << protocol << ", passing up on gate " << gateindex << "\n";
         //TODO: Indication of forward progress
-        send(packet, "transportOut", gateindex);
+        sendDeparture(packet, "transportOut", gateindex);
     }
 }
 
@@ -461,7 +491,7 @@ void IPv6::handleReceivedICMP(ICMPv6Message *msg)
             IPv6Datagram *bogusPacket = check_and_cast<IPv6Datagram *>(msg->getEncapsulatedPacket());
             int protocol = bogusPacket->getTransportProtocol();
             int gateindex = mapping.getOutputGateForProtocol(protocol);
-            send(msg, "transportOut", gateindex);
+            sendDeparture(msg, "transportOut", gateindex);
             break;
         }
         default: {
@@ -470,7 +500,7 @@ void IPv6::handleReceivedICMP(ICMPv6Message *msg)
             // ICMPv6_MLD_DONE, ICMPv6_ROUTER_SOL, ICMPv6_ROUTER_AD, ICMPv6_NEIGHBOUR_SOL,
             // ICMPv6_NEIGHBOUR_AD, ICMPv6_MLDv2_REPORT
             int gateindex = mapping.getOutputGateForProtocol(IP_PROT_ICMP);
-            send(msg, "transportOut", gateindex);
+            sendDeparture(msg, "transportOut", gateindex);
         }
      }
 }
@@ -557,7 +587,7 @@ void IPv6::sendDatagramToOutput(IPv6Datagram *datagram, InterfaceEntry *ie, cons
     }
 
     // send datagram to link layer
-    send(datagram, "queueOut", ie->getNetworkLayerGateIndex());
+    sendDeparture(datagram, "queueOut", ie->getNetworkLayerGateIndex());
 }
 
 
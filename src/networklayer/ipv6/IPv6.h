@@ -41,10 +41,13 @@ class INET_API IPv6 : public QueueBase
     IPv6NeighbourDiscovery *nd;
     ICMPv6 *icmp;
 
+    // config
+    simtime_t fragmentTimeoutTime;
+
     // working vars
     long curFragmentId; // counter, used to assign unique fragmentIds to datagrams
     IPv6FragBuf fragbuf;  // fragmentation reassembly buffer
-    simtime_t lastCheckTime; // when fragbuf was last checked for state fragments
+    cMessage *fragmentPurgeTimer; // removes timed out datagrams from fragbuf
     ProtocolMapping mapping; // where to send packets after decapsulation
 
     // statistics
@@ -121,7 +124,8 @@ class INET_API IPv6 : public QueueBase
     virtual void sendDatagramToOutput(IPv6Datagram *datagram, InterfaceEntry *ie, const MACAddress& macAddr);
 
   public:
-    IPv6() {}
+    IPv6() {fragmentPurgeTimer = NULL;}
+    virtual ~IPv6();
 
   protected:
     /**
@@ -129,6 +133,21 @@ class INET_API IPv6 : public QueueBase
      */
     virtual void initialize();
 
+    /**
+     * Records reassembly statistics.
+     */
+    virtual void finish();
+
+    /**
+     * Handles the fragment purge timer, and passes other messages to the queue.
+     */
+    virtual void handleMessage(cMessage *msg);
+
+    /**
+     * Schedules the fragment purge timer for the oldest incomplete datagram.
+     */
+    virtual void scheduleFragmentPurgeTimer();
+
     /**
      * Processing of IPv6 datagrams. Called when a datagram reaches the front
      * of the queue.
@@ -29,6 +29,10 @@
 IPv6FragBuf::IPv6FragBuf()
 {
     icmpModule = NULL;
+    oldest = newest = NULL;
+    totalBytes = 0;
+    maxBufferedBytes = 0;
+    numTimedOut = numEvicted = 0;
 }
 
 IPv6FragBuf::~IPv6FragBuf()
@@ -40,6 +44,50 @@ void IPv6FragBuf::init(ICMPv6 *icmp)
     icmpModule = icmp;
 }
 
+void IPv6FragBuf::unlink(DatagramBuffer *buf)
+{
+    if (buf->prev)
+        buf->prev->next = buf->next;
+    else
+        oldest = buf->next;
+    if (buf->next)
+        buf->next->prev = buf->prev;
+    else
+        newest = buf->prev;
+    buf->prev = buf->next = NULL;
+}
+
+void IPv6FragBuf::append(DatagramBuffer *buf)
+{
+    buf->prev = newest;
+    buf->next = NULL;
+    if (newest)
+        newest->next = buf;
+    else
+        oldest = buf;
+    newest = buf;
+}
+
+void IPv6FragBuf::remove(DatagramBuffer *buf, bool deleteDatagram)
+{
+    unlink(buf);
+    totalBytes -= buf->bytes;
+    if (deleteDatagram)
+        delete buf->datagram;
+    Key key = buf->key;
+    bufs.erase(key);
+}
+
+void IPv6FragBuf::evictOldest(DatagramBuffer *keep)
+{
+    while (totalBytes > maxBufferedBytes && oldest && oldest!=keep)
+    {
+        EV << "reassembly buffer full, dropping oldest incomplete datagram\n";
+        numEvicted++;
+        remove(oldest, true);
+    }
+}
+
 IPv6Datagram *IPv6FragBuf::addFragment(IPv6Datagram *datagram, IPv6FragmentHeader *fh, simtime_t now)
 {
     // find datagram buffer
@@ -56,11 +104,17 @@ IPv6Datagram *IPv6FragBuf::addFragment(IPv6Datagram *datagram, IPv6FragmentHeade
         // this is the first fragment of that datagram, create reassembly buffer for it
         buf = &bufs[key];
         buf->datagram = NULL;
+        buf->bytes = 0;
+        buf->firstFragmentReceived = false;
+        buf->key = key;
+        append(buf);
     }
     else
     {
-        // use existing buffer
+        // use existing buffer; it becomes the most recently updated one
         buf = &(i->second);
+        unlink(buf);
+        append(buf);
     }
 
     // add fragment into reassembly buffer
@@ -70,6 +124,14 @@ IPv6Datagram *IPv6FragBuf::addFragment(IPv6Datagram *datagram, IPv6FragmentHeade
                                            fh->getFragmentOffset() + bytes,
                                            !fh->getMoreFragments());
 
+    // account only for newly covered bytes, so that duplicate or overlapping
+    // fragments don't inflate the memory usage
+    long stored = buf->buf.getStoredLength();
+    totalBytes += stored - buf->bytes;
+    buf->bytes = stored;
+    if (fh->getFragmentOffset()==0)
+        buf->firstFragmentReceived = true;
+
     // store datagram. Only one fragment carries the actual modelled
     // content (getEncapsulatedPacket()), other (empty) ones are only
     // preserved so that we can send them in ICMP if reassembly times out.
@@ -78,6 +140,11 @@ IPv6Datagram *IPv6FragBuf::addFragment(IPv6Datagram *datagram, IPv6FragmentHeade
         delete buf->datagram;
         buf->datagram = datagram;
     }
+    else if (!buf->datagram)
+    {
+        // keep one fragment in any case, for the ICMP error message
+        buf->datagram = datagram;
+    }
     else
     {
         delete datagram;
@@ -90,42 +157,43 @@ IPv6Datagram *IPv6FragBuf::addFragment(IPv6Datagram *datagram, IPv6FragmentHeade
         IPv6Datagram *ret = buf->datagram;
         ret->setByteLength(ret->calculateHeaderByteLength()+buf->buf.getTotalLength()); // FIXME cf with 4.5 of RFC 2460
         //TODO: remove extension header IPv6FragmentHeader; maybe not here but when datagram gets inserted into the reassembly buffer --Andras
-        bufs.erase(i);
+        remove(buf, false);
         return ret;
     }
     else
     {
         // there are still missing fragments
         buf->lastupdate = now;
+        if (maxBufferedBytes > 0 && totalBytes > maxBufferedBytes)
+            evictOldest(buf);
         return NULL;
     }
 }
 
 void IPv6FragBuf::purgeStaleFragments(simtime_t lastupdate)
 {
-    // this method shouldn't be called too often because iteration on
-    // an std::map is *very* slow...
+    // buffers are ordered by lastupdate, so we can stop at the first
+    // one which is not too old
 
     ASSERT(icmpModule);
 
-    for (Buffers::iterator i=bufs.begin(); i!=bufs.end(); )
+    while (oldest && oldest->lastupdate <= lastupdate)
     {
-        // if too old, remove it
-        DatagramBuffer& buf = i->second;
-        if (buf.lastupdate < lastupdate)
-        {
-            // send ICMP error
-            EV << "datagram fragment timed out in reassembly buffer, sending ICMP_TIME_EXCEEDED\n";
-            icmpModule->sendErrorMessage(buf.datagram, ICMPv6_TIME_EXCEEDED, 0);
+        numTimedOut++;
 
-            // delete
-            Buffers::iterator oldi = i++;
-            bufs.erase(oldi);
-        }
-        else
+        // RFC 2460: the error may only be sent if fragment zero is available
+        if (!oldest->firstFragmentReceived || !oldest->datagram->getEncapsulatedPacket())
         {
-            ++i;
+            EV << "datagram fragment timed out in reassembly buffer, first fragment missing, dropping it\n";
+            remove(oldest, true);
+            continue;
         }
+
+        // send ICMP error
+        EV << "datagram fragment timed out in reassembly buffer, sending ICMP_TIME_EXCEEDED\n";
+        icmpModule->sendErrorMessage(oldest->datagram, ICMPv6_TIME_EXCEEDED, 0);
+
+        // delete (the datagram is now owned by ICMP)
+        remove(oldest, false);
     }
 }
-
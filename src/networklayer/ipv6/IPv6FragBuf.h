@@ -21,6 +21,7 @@
 #include <map>
 #include <vector>
 #include "INETDefs.h"
+#include "INETHashMap.h"
 #include "ReassemblyBuffer.h"
 #include "IPv6Address.h"
 
@@ -30,6 +31,9 @@ class IPv6FragmentHeader;
 
 /**
  * Reassembly buffer for fragmented IPv6 datagrams.
+ *
+ * Buffers are looked up via a hash table, and expired/evicted in
+ * last-update order exactly like in IPFragBuf.
  */
 class INET_API IPv6FragBuf
 {
@@ -43,8 +47,20 @@ class INET_API IPv6FragBuf
         IPv6Address src;
         IPv6Address dest;
 
-        inline bool operator<(const Key& b) const {
-            return (id!=b.id) ? (id<b.id) : (src!=b.src) ? (src<b.src) : (dest<b.dest);
+        inline bool operator==(const Key& b) const {
+            return id==b.id && src==b.src && dest==b.dest;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const {
+            size_t h = k.id;
+            const uint32 *s = k.src.words();
+            const uint32 *d = k.dest.words();
+            for (int i=0; i<4; i++)
+                h = inet_hashCombine(inet_hashCombine(h, s[i]), d[i]);
+            return h;
         }
     };
 
@@ -56,17 +72,46 @@ class INET_API IPv6FragBuf
         ReassemblyBuffer buf;  // reassembly buffer
         IPv6Datagram *datagram;  // the actual datagram
         simtime_t lastupdate;  // last time a new fragment arrived
+        long bytes;            // distinct fragment bytes received so far
+        bool firstFragmentReceived; // whether the fragment with offset 0 has arrived
+        Key key;               // our key in the hash table
+        DatagramBuffer *prev;  // expiry list: previous (older) buffer
+        DatagramBuffer *next;  // expiry list: next (newer) buffer
     };
 
-    // we use std::map for fast lookup by datagram Id
-    typedef std::map<Key,DatagramBuffer> Buffers;
+    // hash table for fast lookup by datagram Id; note that elements of
+    // unordered_map don't move on rehash, so list pointers stay valid
+    typedef std::tr1::unordered_map<Key,DatagramBuffer,KeyHash> Buffers;
 
     // the reassembly buffers
     Buffers bufs;
 
+    // expiry list, ordered by lastupdate (oldest first)
+    DatagramBuffer *oldest;
+    DatagramBuffer *newest;
+
+    // memory accounting
+    long totalBytes;        // bytes held in all reassembly buffers
+    long maxBufferedBytes;  // limit for totalBytes; 0 means unlimited
+
+    // statistics
+    long numTimedOut;  // datagrams dropped because of reassembly timeout
+    long numEvicted;   // datagrams dropped because of the memory limit
+
     // needed for TIME_EXCEEDED errors
     ICMPv6 *icmpModule;
 
+  protected:
+    // expiry list manipulation
+    void unlink(DatagramBuffer *buf);
+    void append(DatagramBuffer *buf);
+
+    // unlinks and deletes the given buffer, together with its stored datagram
+    void remove(DatagramBuffer *buf, bool deleteDatagram);
+
+    // drops oldest buffers (but not keep) until totalBytes is within the limit
+    void evictOldest(DatagramBuffer *keep);
+
   public:
     /**
      * Ctor.
@@ -84,6 +129,13 @@ class INET_API IPv6FragBuf
      */
     void init(ICMPv6 *icmp);
 
+    /**
+     * Limits the number of bytes held in incomplete datagrams. When the
+     * limit is exceeded, the oldest datagrams are dropped (without sending
+     * ICMP errors). Zero means no limit, which is the default.
+     */
+    void setMaxBufferedBytes(long bytes) {maxBufferedBytes = bytes;}
+
     /**
      * Takes a fragment and inserts it into the reassembly buffer.
      * If this fragment completes a datagram, the full reassembled
@@ -93,14 +145,30 @@ class INET_API IPv6FragBuf
 
     /**
      * Throws out all fragments which are incomplete and their
-     * last update (last fragment arrival) was before "lastupdate",
-     * and sends ICMP TIME EXCEEDED message about them.
+     * last update (last fragment arrival) was at or before "lastupdate",
+     * and sends ICMP TIME EXCEEDED message about them. As RFC 1122
+     * requires, the ICMP message is only sent if the first fragment
+     * (offset 0) of the datagram has been received.
      *
      * Timeout should be between 60 seconds and 120 seconds (RFC1122).
-     * This method should be called more frequently, maybe every
-     * 10..30 seconds or so.
+     * The cost of this method is proportional to the number of expired
+     * datagrams only, so it is cheap to call it on every fragment arrival.
      */
     void purgeStaleFragments(simtime_t lastupdate);
+
+    /**
+     * Returns the time of the oldest update among the incomplete datagrams,
+     * or -1 if the buffer is empty. Used for scheduling the purge timer.
+     */
+    simtime_t getOldestUpdateTime() const {return oldest ? oldest->lastupdate : -1;}
+
+    /** @name Statistics */
+    //@{
+    int getNumBuffers() const {return bufs.size();}
+    long getBufferedBytes() const {return totalBytes;}
+    long getNumTimedOut() const {return numTimedOut;}
+    long getNumEvicted() const {return numEvicted;}
+    //@}
 };
 
 #endif
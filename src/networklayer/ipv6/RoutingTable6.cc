@@ -72,12 +72,16 @@ std::ostream& operator<<(std::ostream& os, const RoutingTable6::DestCacheEntry&
 
 RoutingTable6::RoutingTable6()
 {
+    updateDepth = 0;
+    routesChangedInUpdate = false;
+    expiryTimer = NULL;
 }
 
 RoutingTable6::~RoutingTable6()
 {
     for (unsigned int i=0; i<routeList.size(); i++)
         delete routeList[i];
+    cancelAndDelete(expiryTimer);
 }
 
 void RoutingTable6::initialize(int stage)
@@ -87,6 +91,8 @@ void RoutingTable6::initialize(int stage)
         ift = InterfaceTableAccess().get();
         nb = NotificationBoardAccess().get();
 
+        expiryTimer = new cMessage("expiryTimer");
+
         nb->subscribe(this, NF_INTERFACE_CREATED);
         nb->subscribe(this, NF_INTERFACE_DELETED);
         nb->subscribe(this, NF_INTERFACE_STATE_CHANGED);
@@ -179,7 +185,10 @@ void RoutingTable6::updateDisplayString()
 
 void RoutingTable6::handleMessage(cMessage *msg)
 {
-    opp_error("This module doesn't process messages");
+    if (msg==expiryTimer)
+        purgeExpiredRoutes();
+    else
+        opp_error("This module doesn't process messages");
 }
 
 void RoutingTable6::receiveChangeNotification(int category, const cPolymorphic *details)
@@ -418,31 +427,31 @@ const IPv6Route *RoutingTable6::doLongestPrefixMatch(const IPv6Address& dest)
 {
     Enter_Method("doLongestPrefixMatch(%s)", dest.str().c_str());
 
-    // we'll just stop at the first match, because the table is sorted
+    // we'll just stop at the first usable match, because the table is sorted
     // by prefix lengths and metric (see addRoute())
     for (RouteList::const_iterator it=routeList.begin(); it!=routeList.end(); it++)
     {
-        if (dest.matches((*it)->getDestPrefix(),(*it)->getPrefixLength()))
+        const IPv6Route *route = *it;
+        if (!dest.matches(route->getDestPrefix(),route->getPrefixLength()))
+            continue;
+
+        // expired prefixes are removed by expiryTimer; 0 represents infinity
+        if (route->getExpiryTime() != 0 && simTime() > route->getExpiryTime())
         {
-            // FIXME proofread this code, iterator invalidation-wise, etc
-            bool entryExpired = false;
-            if (simTime() > (*it)->getExpiryTime() && (*it)->getExpiryTime() != 0)//since 0 represents infinity.
-            {
-                EV << "Expired prefix detected!!" << endl;
-                removeOnLinkPrefix((*it)->getDestPrefix(), (*it)->getPrefixLength());
-                entryExpired = true;
-            }
-            if (entryExpired == false) return *it;
+            EV << "Expired prefix detected, skipping it" << endl;
+            continue;
         }
+        if (isDeleted(route))
+            continue;
+        return route;
     }
-    // FIXME todo: if we selected an expired route, throw it out and select again!
     return NULL;
 }
 
 bool RoutingTable6::isPrefixPresent(const IPv6Address& prefix) const
 {
     for (RouteList::const_iterator it=routeList.begin(); it!=routeList.end(); it++)
-        if (prefix.matches((*it)->getDestPrefix(),128))
+        if (prefix.matches((*it)->getDestPrefix(),128) && !isDeleted(*it))
             return true;
     return false;
 }
@@ -488,7 +497,7 @@ void RoutingTable6::addOrUpdateOnLinkPrefix(const IPv6Address& destPrefix, int p
     IPv6Route *route = NULL;
     for (RouteList::iterator it=routeList.begin(); it!=routeList.end(); it++)
     {
-        if ((*it)->getSrc()==IPv6Route::FROM_RA && (*it)->getDestPrefix()==destPrefix && (*it)->getPrefixLength()==prefixLength)
+        if ((*it)->getSrc()==IPv6Route::FROM_RA && (*it)->getDestPrefix()==destPrefix && (*it)->getPrefixLength()==prefixLength && !isDeleted(*it))
         {
             route = *it;
             break;
@@ -509,13 +518,19 @@ void RoutingTable6::addOrUpdateOnLinkPrefix(const IPv6Address& destPrefix, int p
     else
     {
         // update existing one; notification-wise, we pretend the route got removed then re-added
-        nb->fireChangeNotification(NF_IPv6_ROUTE_DELETED, route);
+        if (updateDepth>0)
+            routesChangedInUpdate = true;
+        else
+            nb->fireChangeNotification(NF_IPv6_ROUTE_DELETED, route);
         route->setInterfaceId(interfaceId);
         route->setExpiryTime(expiryTime);
-        nb->fireChangeNotification(NF_IPv6_ROUTE_ADDED, route);
+        scheduleExpiryTimer(expiryTime);
+        if (updateDepth==0)
+            nb->fireChangeNotification(NF_IPv6_ROUTE_ADDED, route);
     }
 
-    updateDisplayString();
+    if (updateDepth==0)
+        updateDisplayString();
 }
 
 void RoutingTable6::addOrUpdateOwnAdvPrefix(const IPv6Address& destPrefix, int prefixLength,
@@ -527,7 +542,7 @@ void RoutingTable6::addOrUpdateOwnAdvPrefix(const IPv6Address& destPrefix, int p
     IPv6Route *route = NULL;
     for (RouteList::iterator it=routeList.begin(); it!=routeList.end(); it++)
     {
-        if ((*it)->getSrc()==IPv6Route::OWN_ADV_PREFIX && (*it)->getDestPrefix()==destPrefix && (*it)->getPrefixLength()==prefixLength)
+        if ((*it)->getSrc()==IPv6Route::OWN_ADV_PREFIX && (*it)->getDestPrefix()==destPrefix && (*it)->getPrefixLength()==prefixLength && !isDeleted(*it))
         {
             route = *it;
             break;
@@ -548,13 +563,19 @@ void RoutingTable6::addOrUpdateOwnAdvPrefix(const IPv6Address& destPrefix, int p
     else
     {
         // update existing one; notification-wise, we pretend the route got removed then re-added
-        nb->fireChangeNotification(NF_IPv6_ROUTE_DELETED, route);
+        if (updateDepth>0)
+            routesChangedInUpdate = true;
+        else
+            nb->fireChangeNotification(NF_IPv6_ROUTE_DELETED, route);
         route->setInterfaceId(interfaceId);
         route->setExpiryTime(expiryTime);
-        nb->fireChangeNotification(NF_IPv6_ROUTE_ADDED, route);
+        scheduleExpiryTimer(expiryTime);
+        if (updateDepth==0)
+            nb->fireChangeNotification(NF_IPv6_ROUTE_ADDED, route);
     }
 
-    updateDisplayString();
+    if (updateDepth==0)
+        updateDisplayString();
 }
 
 void RoutingTable6::removeOnLinkPrefix(const IPv6Address& destPrefix, int prefixLength)
@@ -562,14 +583,12 @@ void RoutingTable6::removeOnLinkPrefix(const IPv6Address& destPrefix, int prefix
     // scan the routing table for this prefix and remove it
     for (RouteList::iterator it=routeList.begin(); it!=routeList.end(); it++)
     {
-        if ((*it)->getSrc()==IPv6Route::FROM_RA && (*it)->getDestPrefix()==destPrefix && (*it)->getPrefixLength()==prefixLength)
+        if ((*it)->getSrc()==IPv6Route::FROM_RA && (*it)->getDestPrefix()==destPrefix && (*it)->getPrefixLength()==prefixLength && !isDeleted(*it))
         {
-            routeList.erase(it);
+            removeRoute(*it);
             return; // there can be only one such route, addOrUpdateOnLinkPrefix() guarantees that
         }
     }
-
-    updateDisplayString();
 }
 
 void RoutingTable6::addStaticRoute(const IPv6Address& destPrefix, int prefixLength,
@@ -609,7 +628,7 @@ void RoutingTable6::addRoutingProtocolRoute(IPv6Route *route)
 
 bool RoutingTable6::routeLessThan(const IPv6Route *a, const IPv6Route *b)
 {
-    // helper for sort() in addRoute(). We want routes with longer
+    // helper for addRoute(). We want routes with longer
     // prefixes to be at front, so we compare them as "less".
     // For metric, a smaller value is better (we report that as "less").
     if (a->getPrefixLength()!=b->getPrefixLength())
@@ -617,13 +636,37 @@ bool RoutingTable6::routeLessThan(const IPv6Route *a, const IPv6Route *b)
     return a->getMetric() < b->getMetric();
 }
 
-void RoutingTable6::addRoute(IPv6Route *route)
+void RoutingTable6::purgeDeletedRoutes()
 {
-    routeList.push_back(route);
+    if (deletedRoutes.empty())
+        return;
 
+    // compact in one pass
+    int n = routeList.size();
+    int k = 0;
+    for (int i=0; i<n; i++)
+    {
+        if (deletedRoutes.find(routeList[i])==deletedRoutes.end())
+            routeList[k++] = routeList[i];
+        else
+            delete routeList[i];
+    }
+    routeList.resize(k);
+    deletedRoutes.clear();
+}
+
+void RoutingTable6::addRoute(IPv6Route *route)
+{
     // we keep entries sorted by prefix length in routeList, so that we can
     // stop at the first match when doing the longest prefix matching
-    std::sort(routeList.begin(), routeList.end(), routeLessThan);
+    routeList.insert(std::upper_bound(routeList.begin(), routeList.end(), route, routeLessThan), route);
+    scheduleExpiryTimer(route->getExpiryTime());
+
+    if (updateDepth>0)
+    {
+        routesChangedInUpdate = true;
+        return;
+    }
 
     updateDisplayString();
 
@@ -632,6 +675,15 @@ void RoutingTable6::addRoute(IPv6Route *route)
 
 void RoutingTable6::removeRoute(IPv6Route *route)
 {
+    if (updateDepth>0)
+    {
+        // only mark it as deleted; it'll be removed from routeList in commit()
+        if (!deletedRoutes.insert(route).second)
+            error("removeRoute(): route already deleted");
+        routesChangedInUpdate = true;
+        return;
+    }
+
     RouteList::iterator it = std::find(routeList.begin(), routeList.end(), route);
     ASSERT(it!=routeList.end());
 
@@ -643,14 +695,89 @@ void RoutingTable6::removeRoute(IPv6Route *route)
     updateDisplayString();
 }
 
+void RoutingTable6::beginUpdate()
+{
+    Enter_Method_Silent();
+    updateDepth++;
+}
+
+void RoutingTable6::commit()
+{
+    Enter_Method_Silent();
+    if (updateDepth==0)
+        error("commit() called without matching beginUpdate()");
+    if (--updateDepth > 0)
+        return;
+    if (!routesChangedInUpdate)
+        return;
+    routesChangedInUpdate = false;
+
+    purgeDeletedRoutes();
+    updateDisplayString();
+    nb->fireChangeNotification(NF_IPv6_ROUTES_CHANGED, NULL);
+}
+
 int RoutingTable6::getNumRoutes() const
 {
-    return routeList.size();
+    return routeList.size() - deletedRoutes.size();
 }
 
 IPv6Route *RoutingTable6::getRoute(int i)
 {
-    ASSERT(i>=0 && i<(int)routeList.size());
-    return routeList[i];
+    ASSERT(i>=0 && i<getNumRoutes());
+    if (deletedRoutes.empty())
+        return routeList[i];
+
+    // during a batch update, skip the routes marked as deleted
+    for (RouteList::const_iterator it=routeList.begin(); it!=routeList.end(); it++)
+    {
+        if (isDeleted(*it))
+            continue;
+        if (i==0)
+            return *it;
+        i--;
+    }
+    return NULL;
+}
+
+void RoutingTable6::scheduleExpiryTimer(simtime_t expiryTime)
+{
+    if (expiryTime==0)
+        return; // never expires
+
+    Enter_Method_Silent();
+
+    // if an earlier expiry time got extended meanwhile, the timer fires in
+    // vain, and purgeExpiredRoutes() reschedules it
+    if (!expiryTimer->isScheduled() || expiryTime < expiryTimer->getArrivalTime())
+    {
+        cancelEvent(expiryTimer);
+        scheduleAt(std::max(expiryTime, simTime()), expiryTimer);
+    }
+}
+
+void RoutingTable6::purgeExpiredRoutes()
+{
+    simtime_t nextExpiryTime = 0;
+
+    beginUpdate();
+    for (RouteList::const_iterator it=routeList.begin(); it!=routeList.end(); it++)
+    {
+        IPv6Route *route = *it;
+        simtime_t expiryTime = route->getExpiryTime();
+        if (expiryTime==0 || isDeleted(route))
+            continue;
+        if (expiryTime <= simTime())
+        {
+            EV << "Prefix expired, removing route: " << route->info() << endl;
+            removeRoute(route); // only marks it as deleted, routeList is compacted in commit()
+        }
+        else if (nextExpiryTime==0 || expiryTime < nextExpiryTime)
+            nextExpiryTime = expiryTime;
+    }
+    commit();
+
+    if (nextExpiryTime!=0)
+        scheduleExpiryTimer(nextExpiryTime);
 }
 
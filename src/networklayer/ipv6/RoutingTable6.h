@@ -21,6 +21,7 @@
 #include <vector>
 #include <omnetpp.h>
 #include "INETDefs.h"
+#include "INETHashMap.h"
 #include "IPv6Address.h"
 #include "IInterfaceTable.h"
 #include "NotificationBoard.h"
@@ -124,11 +125,28 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
     typedef std::vector<IPv6Route*> RouteList;
     RouteList routeList;
 
+    // batch update state, see beginUpdate()/commit()
+    int updateDepth;
+    bool routesChangedInUpdate;
+    typedef std::tr1::unordered_set<const IPv6Route *> RouteSet;
+    RouteSet deletedRoutes; // routes deleted in the ongoing update, still in routeList
+
+    // scheduled for the earliest expiry time of the routes
+    cMessage *expiryTimer;
+
   protected:
     // internal: routes of different type can only be added via well-defined functions
     virtual void addRoute(IPv6Route *route);
     // helper for addRoute()
     static bool routeLessThan(const IPv6Route *a, const IPv6Route *b);
+    // removes the routes deleted during a batch update from routeList
+    void purgeDeletedRoutes();
+    // true if the route was deleted in the ongoing batch update
+    bool isDeleted(const IPv6Route *route) const  {return !deletedRoutes.empty() && deletedRoutes.find(route)!=deletedRoutes.end();}
+    // makes sure expiryTimer fires no later than the given expiry time (0 means never)
+    void scheduleExpiryTimer(simtime_t expiryTime);
+    // removes the expired routes, and reschedules expiryTimer
+    virtual void purgeExpiredRoutes();
     // internal
     virtual void configureInterfaceForIPv6(InterfaceEntry *ie);
     /**
@@ -154,7 +172,8 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
     virtual void parseXMLConfigFile();
 
     /**
-     * Raises an error.
+     * Removes the expired routes when expiryTimer fires; raises an error
+     * for other messages.
      */
     virtual void handleMessage(cMessage *);
 
@@ -201,7 +220,8 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
 
     /**
      * Performs longest prefix match in the routing table and returns
-     * the resulting route, or NULL if there was no match.
+     * the resulting route, or NULL if there was no match. Expired routes
+     * are skipped (they are removed by a timer); the table is not modified.
      */
     const IPv6Route *doLongestPrefixMatch(const IPv6Address& dest);
 
@@ -291,13 +311,28 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
      */
     virtual void removeRoute(IPv6Route *route);
 
+    /**
+     * Starts a batch update. Routes deleted until the matching commit() are
+     * only marked as such (lookups skip them), and the table is compacted
+     * once at commit(). No per-route notifications are fired during the
+     * update. Calls may be nested, only the outermost commit() takes effect.
+     */
+    virtual void beginUpdate();
+
+    /**
+     * Ends a batch update started with beginUpdate(). If routes were added
+     * or deleted, compacts the table, updates the display string and fires
+     * a single NF_IPv6_ROUTES_CHANGED.
+     */
+    virtual void commit();
+
     /**
      * Return the number of routes.
      */
     virtual int getNumRoutes() const;
 
     /**
-     * Return the ith route.
+     * Return the ith route. Does not modify the table.
      */
     virtual IPv6Route *getRoute(int i);
     //@}
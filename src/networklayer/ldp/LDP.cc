@@ -138,6 +138,7 @@ void LDP::initialize(int stage)
     // listen for routing table modifications
     nb->subscribe(this, NF_IPv4_ROUTE_ADDED);
     nb->subscribe(this, NF_IPv4_ROUTE_DELETED);
+    nb->subscribe(this, NF_IPv4_ROUTES_CHANGED);
 }
 
 void LDP::handleMessage(cMessage *msg)
@@ -376,9 +377,38 @@ void LDP::rebuildFecList()
         }
     }
 
-    // we must keep this list sorted for matching to work correctly
-    // this is probably slower than it must be
+    // keep the list sorted by prefix length (longest first)
     std::sort(fecList.begin(), fecList.end(), fecPrefixCompare);
+
+    // rebuild the classifier; in case of duplicate prefixes, the first one wins
+    fecTrie.clear();
+    for (FecVector::iterator it = fecList.begin(); it != fecList.end(); it++)
+    {
+        if (fecTrie.find(it->addr, it->length))
+            continue;
+        fecTrie.insert(it->addr, it->length).fecid = it->fecid;
+        updateFecTrieEntry(*it);
+    }
+}
+
+void LDP::updateFecTrieEntry(const fec_t& fec)
+{
+    fec_class_t *entry = fecTrie.find(fec.addr, fec.length);
+    if (!entry || entry->fecid != fec.fecid)
+        return;
+
+    FecBindVector::iterator dit = findFecEntry(fecDown, fec.fecid, fec.nextHop);
+    entry->mapped = (dit != fecDown.end());
+    if (entry->mapped)
+    {
+        entry->outLabel = LIBTable::pushLabel(dit->label);
+        entry->outInterface = findInterfaceFromPeerAddr(fec.nextHop);
+    }
+    else
+    {
+        entry->outLabel.clear();
+        entry->outInterface.clear();
+    }
 }
 
 void LDP::updateFecList(IPAddress nextHop)
@@ -390,6 +420,7 @@ void LDP::updateFecList(IPAddress nextHop)
             continue;
 
         updateFecListEntry(*it);
+        updateFecTrieEntry(*it);
     }
 }
 
@@ -1096,6 +1127,7 @@ void LDP::processLABEL_WITHDRAW(LDPLabelMapping *packet)
     sendToPeer(fromIP, packet);
 
     updateFecListEntry(*it);
+    updateFecTrieEntry(*it);
 }
 
 void LDP::processLABEL_MAPPING(LDPLabelMapping *packet)
@@ -1122,6 +1154,8 @@ void LDP::processLABEL_MAPPING(LDPLabelMapping *packet)
     newItem.label = label;
     fecDown.push_back(newItem);
 
+    updateFecTrieEntry(*it);
+
     // respond to pending requests
 
     PendingVector::iterator pit;
@@ -1194,42 +1228,37 @@ bool LDP::lookupLabel(IPDatagram *ipdatagram, LabelOpVector& outLabel, std::stri
     if (protocol == IP_PROT_OSPF)
         return false;
 
-    // LDP traffic (both discovery...
-    if (protocol == IP_PROT_UDP && check_and_cast<UDPPacket*>(ipdatagram->getEncapsulatedPacket())->getDestinationPort() == LDP_PORT)
-        return false;
+    // regular traffic, classify, label etc.
 
-    // ...and session)
-    if (protocol == IP_PROT_TCP && check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedPacket())->getDestPort() == LDP_PORT)
-        return false;
-    if (protocol == IP_PROT_TCP && check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedPacket())->getSrcPort() == LDP_PORT)
+    fec_class_t *fec = fecTrie.longestMatch(destAddr);
+    if (!fec)
         return false;
 
-    // regular traffic, classify, label etc.
+    EV << "FEC matched: fecid=" << fec->fecid << endl;
 
-    FecVector::iterator it;
-    for (it = fecList.begin(); it != fecList.end(); it++)
+    if (!fec->mapped)
     {
-        if (!destAddr.prefixMatches(it->addr, it->length))
-            continue;
+        EV << "no mapping for this FEC exists" << endl;
+        return false;
+    }
 
-        EV << "FEC matched: " << *it << endl;
+    // LDP traffic (both discovery...
+    if (protocol == IP_PROT_UDP && check_and_cast<UDPPacket*>(ipdatagram->getEncapsulatedPacket())->getDestinationPort() == LDP_PORT)
+        return false;
 
-        FecBindVector::iterator dit = findFecEntry(fecDown, it->fecid, it->nextHop);
-        if (dit != fecDown.end())
-        {
-            outLabel = LIBTable::pushLabel(dit->label);
-            outInterface = findInterfaceFromPeerAddr(it->nextHop);
-            color = LDP_USER_TRAFFIC;
-            EV << "mapping found, outLabel=" << outLabel << ", outInterface=" << outInterface << endl;
-            return true;
-        }
-        else
-        {
-            EV << "no mapping for this FEC exists" << endl;
+    // ...and session)
+    if (protocol == IP_PROT_TCP)
+    {
+        TCPSegment *tcpseg = check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedPacket());
+        if (tcpseg->getDestPort() == LDP_PORT || tcpseg->getSrcPort() == LDP_PORT)
             return false;
-        }
     }
-    return false;
+
+    outLabel = fec->outLabel;
+    outInterface = fec->outInterface;
+    color = LDP_USER_TRAFFIC;
+    EV << "mapping found, outLabel=" << outLabel << ", outInterface=" << outInterface << endl;
+    return true;
 }
 
 void LDP::receiveChangeNotification(int category, const cPolymorphic *details)
@@ -1237,7 +1266,7 @@ void LDP::receiveChangeNotification(int category, const cPolymorphic *details)
     Enter_Method_Silent();
     printNotificationBanner(category, details);
 
-    ASSERT(category==NF_IPv4_ROUTE_ADDED || category==NF_IPv4_ROUTE_DELETED);
+    ASSERT(category==NF_IPv4_ROUTE_ADDED || category==NF_IPv4_ROUTE_DELETED || category==NF_IPv4_ROUTES_CHANGED);
 
     EV << "routing table changed, rebuild list of known FEC" << endl;
 
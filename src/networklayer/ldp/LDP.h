@@ -27,6 +27,7 @@
 #include "TCPSocket.h"
 #include "TCPSocketMap.h"
 #include "IClassifier.h"
+#include "PrefixTrie.h"
 #include "NotificationBoard.h"
 
 #define LDP_PORT  646
@@ -65,6 +66,19 @@ class INET_API LDP: public cSimpleModule, public TCPSocket::CallbackInterface, p
     };
     typedef std::vector<fec_t> FecVector;
 
+    /**
+     * Classification result for a FEC, stored in the FEC trie: what to do
+     * with datagrams that match the FEC, according to the mapping from
+     * its next hop.
+     */
+    struct fec_class_t
+    {
+        int fecid;
+        bool mapped;              // whether we have a mapping from next hop
+        LabelOpVector outLabel;   // only if mapped
+        std::string outInterface; // only if mapped
+    };
+
 
     struct fec_bind_t
     {
@@ -100,6 +114,8 @@ class INET_API LDP: public cSimpleModule, public TCPSocket::CallbackInterface, p
 
     // currently recognized FECs
     FecVector fecList;
+    // FECs by prefix, for classifying datagrams (see lookupLabel())
+    PrefixTrie<fec_class_t> fecTrie;
     // bindings advertised upstream
     FecBindVector fecUp;
     // mappings learnt from downstream
@@ -169,6 +185,7 @@ class INET_API LDP: public cSimpleModule, public TCPSocket::CallbackInterface, p
     virtual void rebuildFecList();
     virtual void updateFecList(IPAddress nextHop);
     virtual void updateFecListEntry(fec_t oldItem);
+    virtual void updateFecTrieEntry(const fec_t& fec);
 
     virtual void announceLinkChange(int tedlinkindex);
 
@@ -0,0 +1,139 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_PREFIXTRIE_H
+#define __INET_PREFIXTRIE_H
+
+#include <omnetpp.h>
+#include "IPAddress.h"
+
+/**
+ * Binary trie keyed by IP address prefixes (address, prefix length), used
+ * by the MPLS classifiers (LDP, SimpleClassifier) to map datagrams to FECs.
+ * A lookup walks at most 32 nodes, regardless of the number of entries.
+ *
+ * Values are stored by value in the nodes; pointers returned by the
+ * lookup methods remain valid until clear() is called.
+ */
+template<class T>
+class PrefixTrie
+{
+  protected:
+    struct Node
+    {
+        Node *child[2];
+        bool hasValue;
+        T value;
+        Node() : hasValue(false) {child[0] = child[1] = NULL;}
+    };
+
+    Node *root;
+    int count;
+
+  private:
+    // not copyable
+    PrefixTrie(const PrefixTrie&);
+    PrefixTrie& operator=(const PrefixTrie&);
+
+  protected:
+    static int bit(const IPAddress& addr, int i) {return (addr.getInt() >> (31 - i)) & 1;}
+
+    static void deleteChildren(Node *node)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            if (node->child[i])
+            {
+                deleteChildren(node->child[i]);
+                delete node->child[i];
+                node->child[i] = NULL;
+            }
+        }
+    }
+
+  public:
+    PrefixTrie() {root = new Node(); count = 0;}
+    ~PrefixTrie() {deleteChildren(root); delete root;}
+
+    /** Number of entries stored */
+    int size() const {return count;}
+
+    /** Removes all entries */
+    void clear()
+    {
+        deleteChildren(root);
+        root->hasValue = false;
+        root->value = T();
+        count = 0;
+    }
+
+    /**
+     * Returns the value of the given prefix, creating a default-constructed
+     * one if it did not exist.
+     */
+    T& insert(const IPAddress& prefix, int length)
+    {
+        ASSERT(length >= 0 && length <= 32);
+        Node *node = root;
+        for (int i = 0; i < length; i++)
+        {
+            Node *& next = node->child[bit(prefix, i)];
+            if (!next)
+                next = new Node();
+            node = next;
+        }
+        if (!node->hasValue)
+        {
+            node->hasValue = true;
+            node->value = T();
+            count++;
+        }
+        return node->value;
+    }
+
+    /** Returns the value of exactly the given prefix, or NULL. */
+    T *find(const IPAddress& prefix, int length)
+    {
+        ASSERT(length >= 0 && length <= 32);
+        Node *node = root;
+        for (int i = 0; i < length && node; i++)
+            node = node->child[bit(prefix, i)];
+        return (node && node->hasValue) ? &node->value : NULL;
+    }
+
+    /**
+     * Returns the value of the longest prefix that matches the address,
+     * or NULL.
+     */
+    T *longestMatch(const IPAddress& addr)
+    {
+        Node *node = root;
+        Node *best = NULL;
+        for (int i = 0; node; i++)
+        {
+            if (node->hasValue)
+                best = node;
+            if (i == 32)
+                break;
+            node = node->child[bit(addr, i)];
+        }
+        return best ? &best->value : NULL;
+    }
+};
+
+#endif
+
@@ -872,6 +872,7 @@ void OSPF::Router::RebuildRoutingTable(void)
         }
     }
 
+    simRoutingTable->beginUpdate();
     unsigned int eraseCount = eraseEntries.size();
     for (i = 0; i < eraseCount; i++) {
         simRoutingTable->deleteRoute(eraseEntries[i]);
@@ -884,6 +885,7 @@ void OSPF::Router::RebuildRoutingTable(void)
             simRoutingTable->addRoute(new OSPF::RoutingTableEntry(*(routingTable[i])));
         }
     }
+    simRoutingTable->commit();
 
     NotifyAboutRoutingTableChanges(oldTable);
 
@@ -25,6 +25,7 @@
 #include "LIBTableAccess.h"
 #include "NotifierConsts.h"
 
+// Path and Resv states are refreshed per neighbor, see processREFRESH_TIMER()
 #define PSB_REFRESH_INTERVAL    5.0
 #define RSB_REFRESH_INTERVAL    6.0
 
@@ -35,6 +36,9 @@
 #define PATH_ERR_PREEMPTED      2
 #define PATH_ERR_NEXTHOP_FAILED 3
 
+// common RSVP header, the only part of a Bundle besides the bundled messages
+#define BUNDLE_HEADER_LENGTH    8
+
 Define_Module(RSVP);
 
 
@@ -44,7 +48,26 @@ RSVP::RSVP()
 
 RSVP::~RSVP()
 {
-    // TODO cancelAndDelete timers in all data structures
+    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
+        cancelAndDelete(it->timeoutMsg);
+
+    for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
+    {
+        cancelAndDelete(it->commitTimerMsg);
+        cancelAndDelete(it->timeoutMsg);
+    }
+
+    for (HelloVector::iterator it = HelloList.begin(); it != HelloList.end(); it++)
+    {
+        cancelAndDelete(it->timer);
+        cancelAndDelete(it->timeout);
+    }
+
+    for (NeighborMap::iterator it = NeighborList.begin(); it != NeighborList.end(); it++)
+    {
+        cancelAndDelete(it->second.refreshTimer);
+        cancelAndDelete(it->second.sendTimer);
+    }
 }
 
 void RSVP::initialize(int stage)
@@ -66,8 +89,13 @@ void RSVP::initialize(int stage)
         maxPsbId = 0;
         maxRsbId = 0;
         maxSrcInstance = 0;
+        maxMessageId = 0;
 
         retryInterval = 1.0;
+        refreshReduction = par("refreshReduction");
+
+        // setup refresh state of neighbors
+        setupNeighbors();
 
         // setup hello
         setupHello();
@@ -119,7 +147,7 @@ void RSVP::createPath(const SessionObj_t& session, const SenderTemplateObj_t& se
     if (psb)
     {
         // PSB successfully created, send path message downstream
-        scheduleRefreshTimer(psb, 0.0);
+        triggerRefresh(psb);
     }
     else
     {
@@ -365,6 +393,30 @@ void RSVP::setupHello()
     }
 }
 
+void RSVP::setupNeighbors()
+{
+    cStringTokenizer tokenizer(par("peers"));
+    const char *token;
+    while ((token = tokenizer.nextToken())!=NULL)
+    {
+        ASSERT(ift->getInterfaceByName(token));
+
+        IPAddress peer = tedmod->getPeerByLocalAddress(ift->getInterfaceByName(token)->ipv4Data()->getIPAddress());
+
+        NeighborState_t& n = NeighborList[peer];
+
+        n.peer = peer;
+
+        n.refreshTimer = new RefreshTimerMsg("refresh timer");
+        n.refreshTimer->setPeer(peer);
+        n.pathRefreshTime = 0;
+        n.resvRefreshTime = 0;
+
+        n.sendTimer = new SendTimerMsg("send timer");
+        n.sendTimer->setPeer(peer);
+    }
+}
+
 void RSVP::startHello(IPAddress peer, simtime_t delay)
 {
     EV << "scheduling hello start in " << delay << " seconds" << endl;
@@ -467,15 +519,6 @@ void RSVP::processHELLO_TIMER(HelloTimerMsg* msg)
     scheduleAt(simTime() + helloInterval, msg);
 }
 
-void RSVP::processPSB_TIMER(PsbTimerMsg *msg)
-{
-    PathStateBlock_t *psb = findPsbById(msg->getId());
-    ASSERT(psb);
-
-    refreshPath(psb);
-    scheduleRefreshTimer(psb, PSB_REFRESH_INTERVAL);
-}
-
 void RSVP::processPSB_TIMEOUT(PsbTimeoutMsg* msg)
 {
     PathStateBlock_t *psb = findPsbById(msg->getId());
@@ -493,22 +536,6 @@ void RSVP::processPSB_TIMEOUT(PsbTimeoutMsg* msg)
 }
 
 
-void RSVP::processRSB_REFRESH_TIMER(RsbRefreshTimerMsg *msg)
-{
-    ResvStateBlock_t *rsb = findRsbById(msg->getId());
-    if (rsb->commitTimerMsg->isScheduled())
-    {
-        // reschedule after commit
-        scheduleRefreshTimer(rsb, 0.0);
-    }
-    else
-    {
-        refreshResv(rsb);
-
-        scheduleRefreshTimer(rsb, RSB_REFRESH_INTERVAL);
-    }
-}
-
 void RSVP::processRSB_COMMIT_TIMER(RsbCommitTimerMsg *msg)
 {
     ResvStateBlock_t *rsb = findRsbById(msg->getId());
@@ -539,15 +566,13 @@ bool RSVP::doCACCheck(const SessionObj_t& session, const SenderTspecObj_t& tspec
 
     double sharedBW = 0.0;
 
-    for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
+    std::pair<RSBSessionMap::iterator, RSBSessionMap::iterator> range = RSBBySession.equal_range(session);
+    for (RSBSessionMap::iterator it = range.first; it != range.second; it++)
     {
-        if (it->Session_Object != session)
+        if (it->second->Flowspec_Object.req_bandwidth <= sharedBW)
             continue;
 
-        if (it->Flowspec_Object.req_bandwidth <= sharedBW)
-            continue;
-
-        sharedBW = it->Flowspec_Object.req_bandwidth;
+        sharedBW = it->second->Flowspec_Object.req_bandwidth;
     }
 
     EV << "CACCheck: link=" << OI <<
@@ -559,7 +584,7 @@ bool RSVP::doCACCheck(const SessionObj_t& session, const SenderTspecObj_t& tspec
     return (tedmod->ted[k].UnResvBandwidth[session.setupPri] + sharedBW >= tspec.req_bandwidth);
 }
 
-void RSVP::refreshPath(PathStateBlock_t *psbEle)
+RSVPPathMsg *RSVP::createPathMsg(PathStateBlock_t *psbEle)
 {
     EV << "refresh path (PSB " << psbEle->id << ")" << endl;
 
@@ -587,77 +612,41 @@ void RSVP::refreshPath(PathStateBlock_t *psbEle)
 
     pm->setByteLength(length);
 
-    IPAddress nextHop = tedmod->getPeerByLocalAddress(OI);
-
-    ASSERT(ERO.size() == 0 ||ERO[0].node.equals(nextHop) || ERO[0].L);
+    ASSERT(ERO.size() == 0 || ERO[0].node.equals(tedmod->getPeerByLocalAddress(OI)) || ERO[0].L);
 
-    sendToIP(pm, nextHop);
+    return pm;
 }
 
-void RSVP::refreshResv(ResvStateBlock_t *rsbEle)
-{
-    EV << "refresh reservation (RSB " << rsbEle->id << ")" << endl;
-
-    IPAddressVector phops;
-
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
-    {
-        if (it->OutInterface != rsbEle->OI)
-            continue;
-
-        for (int i = 0; i < (int)rsbEle->FlowDescriptor.size(); i++)
-        {
-            if ((FilterSpecObj_t&)it->Sender_Template_Object != rsbEle->FlowDescriptor[i].Filter_Spec_Object)
-                continue;
-
-            if (tedmod->isLocalAddress(it->Previous_Hop_Address))
-                continue; // IR nothing to refresh
-
-            if (!find(phops, it->Previous_Hop_Address))
-                phops.push_back(it->Previous_Hop_Address);
-        }
-
-        for (IPAddressVector::iterator it = phops.begin(); it != phops.end(); it++)
-            refreshResv(rsbEle, *it);
-    }
-}
-
-void RSVP::refreshResv(ResvStateBlock_t *rsbEle, IPAddress PHOP)
+RSVPResvMsg *RSVP::createResvMsg(ResvStateBlock_t *rsbEle, IPAddress PHOP)
 {
     EV << "refresh reservation (RSB " << rsbEle->id << ") PHOP " << PHOP << endl;
 
-    RSVPResvMsg *msg = new RSVPResvMsg("    Resv");
+    NeighborState_t *n = findNeighbor(PHOP);
+    ASSERT(n);
 
     FlowDescriptorVector flows;
 
-    msg->setSession(rsbEle->Session_Object);
-
-    RsvpHopObj_t hop;
-    hop.Logical_Interface_Handle = tedmod->peerRemoteInterface(PHOP);
-    hop.Next_Hop_Address = PHOP;
-    msg->setHop(hop);
-
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
+    // paths from PHOP
+    for (std::set<int>::iterator it = n->pathsFrom.begin(); it != n->pathsFrom.end(); it++)
     {
-        if (it->Previous_Hop_Address != PHOP)
-            continue;
+        PathStateBlock_t *psb = findPsbById(*it);
 
-        //if (it->LIH != LIH)
+        //if (psb->LIH != LIH)
         //  continue;
 
-        if (it->Session_Object != rsbEle->Session_Object)
+        if (psb->Session_Object != rsbEle->Session_Object)
             continue;
 
         for (unsigned int c = 0; c < rsbEle->FlowDescriptor.size(); c++)
         {
-            if ((FilterSpecObj_t&)it->Sender_Template_Object != rsbEle->FlowDescriptor[c].Filter_Spec_Object)
+            if ((FilterSpecObj_t&)psb->Sender_Template_Object != rsbEle->FlowDescriptor[c].Filter_Spec_Object)
                 continue;
 
             ASSERT(rsbEle->inLabelVector.size() == rsbEle->FlowDescriptor.size());
 
             FlowDescriptor_t flow;
-            flow.Filter_Spec_Object = (FilterSpecObj_t&)it->Sender_Template_Object;
-            flow.Flowspec_Object = (FlowSpecObj_t&)it->Sender_Tspec_Object;
+            flow.Filter_Spec_Object = (FilterSpecObj_t&)psb->Sender_Template_Object;
+            flow.Flowspec_Object = (FlowSpecObj_t&)psb->Sender_Tspec_Object;
             flow.RRO = rsbEle->FlowDescriptor[c].RRO;
             flow.RRO.push_back(routerId);
             flow.label = rsbEle->inLabelVector[c];
@@ -667,6 +656,21 @@ void RSVP::refreshResv(ResvStateBlock_t *rsbEle, IPAddress PHOP)
         }
     }
 
+    if (flows.size() == 0)
+    {
+        EV << "no flows to refresh towards PHOP " << PHOP << endl;
+        return NULL;
+    }
+
+    RSVPResvMsg *msg = new RSVPResvMsg("    Resv");
+
+    msg->setSession(rsbEle->Session_Object);
+
+    RsvpHopObj_t hop;
+    hop.Logical_Interface_Handle = tedmod->peerRemoteInterface(PHOP);
+    hop.Next_Hop_Address = PHOP;
+    msg->setHop(hop);
+
     msg->setFlowDescriptor(flows);
 
     int fd_length = 0;
@@ -680,7 +684,7 @@ void RSVP::refreshResv(ResvStateBlock_t *rsbEle, IPAddress PHOP)
 
     msg->setByteLength(length);
 
-    sendToIP(msg, PHOP);
+    return msg;
 }
 
 void RSVP::preempt(IPAddress OI, int priority, double bandwidth)
@@ -849,6 +853,8 @@ void RSVP::commitResv(ResvStateBlock_t *rsb)
 
     // install labels into lib
 
+    bool labelsChanged = false;
+
     for (unsigned int i = 0; i < rsb->FlowDescriptor.size(); i++)
     {
         int lspid = rsb->FlowDescriptor[i].Filter_Spec_Object.Lsp_Id;
@@ -922,20 +928,26 @@ void RSVP::commitResv(ResvStateBlock_t *rsb)
         {
             // remember our current label
             rsb->inLabelVector[i] = inLabel;
+            labelsChanged = true;
 
             // bind fec
             rpct->bind(psb->Session_Object, psb->Sender_Template_Object, inLabel);
         }
 
         // schedule commit of merging backups too...
-        for (unsigned int j = 0; j < RSBList.size(); j++)
+        for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
         {
-            if (RSBList[j].OI != lspid)
+            if (it->OI != lspid)
                 continue;
 
-            scheduleCommitTimer(&RSBList[j]);
+            scheduleCommitTimer(&(*it));
         }
     }
+
+    // new labels must be sent upstream; the Resv state has changed, so
+    // this cannot wait for the next (possibly summary) refresh
+    if (labelsChanged)
+        triggerRefresh(rsb);
 }
 
 RSVP::ResvStateBlock_t* RSVP::createRSB(RSVPResvMsg *msg)
@@ -947,12 +959,11 @@ RSVP::ResvStateBlock_t* RSVP::createRSB(RSVPResvMsg *msg)
     rsbEle.timeoutMsg = new RsbTimeoutMsg("rsb timeout");
     rsbEle.timeoutMsg->setId(rsbEle.id);
 
-    rsbEle.refreshTimerMsg = new RsbRefreshTimerMsg("rsb timer");
-    rsbEle.refreshTimerMsg->setId(rsbEle.id);
-
     rsbEle.commitTimerMsg = new RsbCommitTimerMsg("rsb commit");
     rsbEle.commitTimerMsg->setId(rsbEle.id);
 
+    rsbEle.rcvMessageId = 0;
+
     rsbEle.Session_Object = msg->getSession();
     rsbEle.Next_Hop_Address = msg->getNHOP();
     rsbEle.OI = msg->getLIH();
@@ -967,7 +978,7 @@ RSVP::ResvStateBlock_t* RSVP::createRSB(RSVPResvMsg *msg)
     }
 
     RSBList.push_back(rsbEle);
-    ResvStateBlock_t *rsb = &(*(RSBList.end() - 1));
+    ResvStateBlock_t *rsb = registerRSB(--RSBList.end());
 
     EV << "created new RSB " << rsb->id << endl;
 
@@ -1015,7 +1026,7 @@ void RSVP::updateRSB(ResvStateBlock_t* rsb, RSVPResvMsg *msg)
             // resv is new and must be forwarded
 
             scheduleCommitTimer(rsb);
-            scheduleRefreshTimer(rsb, 0.0);
+            triggerRefresh(rsb);
         }
     }
 }
@@ -1047,11 +1058,9 @@ void RSVP::removeRSB(ResvStateBlock_t *rsb)
 
     EV << "removing empty RSB " << rsb->id << endl;
 
-    cancelEvent(rsb->refreshTimerMsg);
     cancelEvent(rsb->commitTimerMsg);
     cancelEvent(rsb->timeoutMsg);
 
-    delete rsb->refreshTimerMsg;
     delete rsb->commitTimerMsg;
     delete rsb->timeoutMsg;
 
@@ -1061,15 +1070,38 @@ void RSVP::removeRSB(ResvStateBlock_t *rsb)
         allocateResource(rsb->OI, rsb->Session_Object, -rsb->Flowspec_Object.req_bandwidth);
     }
 
-    for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
+    // remove from neighbor refresh state
+
+    for (NeighborMap::iterator it = NeighborList.begin(); it != NeighborList.end(); it++)
+    {
+        it->second.pendingResvs.erase(rsb->id);
+        forgetMessageId(&it->second, false, rsb->id);
+    }
+
+    if (rsb->rcvMessageId != 0)
     {
-        if (it->id != rsb->id)
+        NeighborState_t *n = findNeighbor(rsb->rcvMessageIdPeer);
+        if (n)
+            n->rcvMessageIds.erase(rsb->rcvMessageId);
+    }
+
+    // remove from indices and from the list
+
+    std::pair<RSBSessionMap::iterator, RSBSessionMap::iterator> range = RSBBySession.equal_range(rsb->Session_Object);
+    for (RSBSessionMap::iterator it = range.first; it != range.second; it++)
+    {
+        if (it->second != rsb)
             continue;
 
-        RSBList.erase(it);
-        return;
+        RSBBySession.erase(it);
+        break;
     }
-    ASSERT(false);
+
+    RSBIdMap::iterator it = RSBById.find(rsb->id);
+    ASSERT(it != RSBById.end());
+    RSBVector::iterator rit = it->second;
+    RSBById.erase(it);
+    RSBList.erase(rit);
 }
 
 void RSVP::removePSB(PathStateBlock_t *psb)
@@ -1093,21 +1125,36 @@ void RSVP::removePSB(PathStateBlock_t *psb)
 
     // proceed with actual removal *********************************************
 
-    cancelEvent(psb->timerMsg);
     cancelEvent(psb->timeoutMsg);
 
-    delete psb->timerMsg;
     delete psb->timeoutMsg;
 
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
+    for (NeighborMap::iterator it = NeighborList.begin(); it != NeighborList.end(); it++)
     {
-        if (it->id != psb->id)
-            continue;
+        NeighborState_t& n = it->second;
+        n.pathsTo.erase(psb->id);
+        n.pathsFrom.erase(psb->id);
+        n.pendingPaths.erase(psb->id);
+        forgetMessageId(&n, true, psb->id);
+    }
 
-        PSBList.erase(it);
-        return;
+    if (psb->rcvMessageId != 0)
+    {
+        NeighborState_t *n = findNeighbor(psb->rcvMessageIdPeer);
+        if (n)
+            n->rcvMessageIds.erase(psb->rcvMessageId);
     }
-    ASSERT(false);
+
+    SenderKey key;
+    key.session = psb->Session_Object;
+    key.sender = psb->Sender_Template_Object;
+    PSBBySender.erase(key);
+
+    PSBIdMap::iterator it = PSBById.find(psb->id);
+    ASSERT(it != PSBById.end());
+    PSBVector::iterator pit = it->second;
+    PSBById.erase(it);
+    PSBList.erase(pit);
 }
 
 bool RSVP::evalNextHopInterface(IPAddress destAddr, const EroVector& ERO, IPAddress& OI)
@@ -1208,9 +1255,6 @@ RSVP::PathStateBlock_t* RSVP::createPSB(RSVPPathMsg *msg)
     psbEle.timeoutMsg = new PsbTimeoutMsg("psb timeout");
     psbEle.timeoutMsg->setId(psbEle.id);
 
-    psbEle.timerMsg = new PsbTimerMsg("psb timer");
-    psbEle.timerMsg->setId(psbEle.id);
-
     psbEle.Session_Object = msg->getSession();
     psbEle.Sender_Template_Object = msg->getSenderTemplate();
     psbEle.Sender_Tspec_Object = msg->getSenderTspec();
@@ -1224,8 +1268,10 @@ RSVP::PathStateBlock_t* RSVP::createPSB(RSVPPathMsg *msg)
     psbEle.color = msg->getColor();
     psbEle.handler = -1;
 
+    psbEle.rcvMessageId = 0;
+
     PSBList.push_back(psbEle);
-    PathStateBlock_t *cPSB = &(*(PSBList.end() - 1));
+    PathStateBlock_t *cPSB = registerPSB(--PSBList.end());
 
     EV << "created new PSB " << cPSB->id << endl;
 
@@ -1258,9 +1304,6 @@ RSVP::PathStateBlock_t* RSVP::createIngressPSB(const traffic_session_t& session,
     psbEle.timeoutMsg = new PsbTimeoutMsg("psb timeout");
     psbEle.timeoutMsg->setId(psbEle.id);
 
-    psbEle.timerMsg = new PsbTimerMsg("psb timer");
-    psbEle.timerMsg->setId(psbEle.id);
-
     psbEle.Session_Object = session.sobj;
     psbEle.Sender_Template_Object = path.sender;
     psbEle.Sender_Tspec_Object = path.tspec;
@@ -1273,8 +1316,10 @@ RSVP::PathStateBlock_t* RSVP::createIngressPSB(const traffic_session_t& session,
 
     psbEle.handler = path.owner;
 
+    psbEle.rcvMessageId = 0;
+
     PSBList.push_back(psbEle);
-    PathStateBlock_t *cPSB = &(*(PSBList.end() - 1));
+    PathStateBlock_t *cPSB = registerPSB(--PSBList.end());
 
     return cPSB;
 }
@@ -1289,12 +1334,11 @@ RSVP::ResvStateBlock_t* RSVP::createEgressRSB(PathStateBlock_t *psb)
     rsbEle.timeoutMsg = new RsbTimeoutMsg("rsb timeout");
     rsbEle.timeoutMsg->setId(rsbEle.id);
 
-    rsbEle.refreshTimerMsg = new RsbRefreshTimerMsg("rsb timer");
-    rsbEle.refreshTimerMsg->setId(rsbEle.id);
-
     rsbEle.commitTimerMsg = new RsbCommitTimerMsg("rsb commit");
     rsbEle.commitTimerMsg->setId(rsbEle.id);
 
+    rsbEle.rcvMessageId = 0;
+
     rsbEle.Session_Object = psb->Session_Object;
     rsbEle.Next_Hop_Address = psb->Previous_Hop_Address;
 
@@ -1309,7 +1353,7 @@ RSVP::ResvStateBlock_t* RSVP::createEgressRSB(PathStateBlock_t *psb)
     rsbEle.inLabelVector.push_back(-1);
 
     RSBList.push_back(rsbEle);
-    ResvStateBlock_t *rsb = &(*(RSBList.end() - 1));
+    ResvStateBlock_t *rsb = registerRSB(--RSBList.end());
 
     EV << "created new (egress) RSB " << rsb->id << endl;
 
@@ -1360,6 +1404,18 @@ void RSVP::processRSVPMessage(RSVPMessage *msg)
             processPathErrMsg(check_and_cast<RSVPPathError*>(msg));
             break;
 
+        case BUNDLE_MESSAGE:
+            processBundleMsg(check_and_cast<RSVPBundleMsg*>(msg));
+            break;
+
+        case SREFRESH_MESSAGE:
+            processSrefreshMsg(check_and_cast<RSVPSrefreshMsg*>(msg));
+            break;
+
+        case ACK_MESSAGE:
+            processAckMsg(check_and_cast<RSVPAckMsg*>(msg));
+            break;
+
         default:
             ASSERT(false);
     }
@@ -1526,9 +1582,11 @@ void RSVP::processPathTearMsg(RSVPPathTear *msg)
 
     bool modified = false;
 
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
+    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); )
     {
-        if (it->OutInterface.getInt() != lspid)
+        PathStateBlock_t *backup = &(*it++);
+
+        if (backup->OutInterface.getInt() != lspid)
             continue;
 
         // merging backup exists
@@ -1542,8 +1600,7 @@ void RSVP::processPathTearMsg(RSVPPathTear *msg)
 
         EV << "merging backup must be removed too" << endl;
 
-        removePSB(&(*it));
-        --it;
+        removePSB(backup);
 
         modified = true;
     }
@@ -1598,7 +1655,7 @@ void RSVP::processPathMsg(RSVPPathMsg *msg)
             delete msg;
             return;
         }
-        scheduleRefreshTimer(psb, 0.0);
+        triggerRefresh(psb);
 
         if (tedmod->isLocalAddress(psb->OutInterface))
         {
@@ -1614,6 +1671,9 @@ void RSVP::processPathMsg(RSVPPathMsg *msg)
 
     scheduleTimeout(psb);
 
+    if (msg->getMessageId() != 0)
+        recordMessageId(getNeighborOf(msg), msg->getMessageId(), true, psb->id, psb->rcvMessageId, psb->rcvMessageIdPeer);
+
     // create RSB if we're egress and doesn't exist yet ************************
 
     unsigned int index;
@@ -1628,7 +1688,7 @@ void RSVP::processPathMsg(RSVPPathMsg *msg)
     }
 
     if (rsb)
-        scheduleRefreshTimer(rsb, 0.0);
+        triggerRefresh(rsb);
 
     delete msg;
 }
@@ -1666,18 +1726,16 @@ void RSVP::processResvMsg(RSVPResvMsg *msg)
     // find matching RSB *******************************************************
 
     ResvStateBlock_t *rsb = NULL;
-    for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
+    std::pair<RSBSessionMap::iterator, RSBSessionMap::iterator> range = RSBBySession.equal_range(msg->getSession());
+    for (RSBSessionMap::iterator it = range.first; it != range.second; it++)
     {
-        if (!(msg->isInSession(&it->Session_Object)))
+        if (it->second->Next_Hop_Address != msg->getNHOP())
             continue;
 
-        if (it->Next_Hop_Address != msg->getNHOP())
+        if (it->second->OI != msg->getLIH())
             continue;
 
-        if (it->OI != msg->getLIH())
-            continue;
-
-        rsb = &(*it);
+        rsb = it->second;
         break;
     }
 
@@ -1688,13 +1746,16 @@ void RSVP::processResvMsg(RSVPResvMsg *msg)
         scheduleCommitTimer(rsb);
 
         // reservation is new, propagate upstream immediately
-        scheduleRefreshTimer(rsb, 0.0);
+        triggerRefresh(rsb);
     }
     else
         updateRSB(rsb, msg);
 
     scheduleTimeout(rsb);
 
+    if (msg->getMessageId() != 0)
+        recordMessageId(getNeighborOf(msg), msg->getMessageId(), false, rsb->id, rsb->rcvMessageId, rsb->rcvMessageIdPeer);
+
     delete msg;
 }
 
@@ -1712,13 +1773,10 @@ void RSVP::recoveryEvent(IPAddress peer)
         tedmod->rebuildRoutingTable();
 
     // refresh all paths towards this neighbour
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
-    {
-        if (it->OutInterface != tedmod->ted[index].local)
-            continue;
-
-        scheduleRefreshTimer(&(*it), 0.0);
-    }
+    NeighborState_t *n = findNeighbor(peer);
+    ASSERT(n);
+    for (std::set<int>::iterator it = n->pathsTo.begin(); it != n->pathsTo.end(); it++)
+        triggerRefresh(findPsbById(*it));
 }
 
 void RSVP::processSignallingMessage(SignallingMsg *msg)
@@ -1726,18 +1784,10 @@ void RSVP::processSignallingMessage(SignallingMsg *msg)
     int command = msg->getCommand();
     switch(command)
     {
-        case MSG_PSB_TIMER:
-            processPSB_TIMER(check_and_cast<PsbTimerMsg*>(msg));
-            break;
-
         case MSG_PSB_TIMEOUT:
             processPSB_TIMEOUT(check_and_cast<PsbTimeoutMsg*>(msg));
             break;
 
-        case MSG_RSB_REFRESH_TIMER:
-            processRSB_REFRESH_TIMER(check_and_cast<RsbRefreshTimerMsg*>(msg));
-            break;
-
         case MSG_RSB_COMMIT_TIMER:
             processRSB_COMMIT_TIMER(check_and_cast<RsbCommitTimerMsg*>(msg));
             break;
@@ -1758,6 +1808,14 @@ void RSVP::processSignallingMessage(SignallingMsg *msg)
             processPATH_NOTIFY(check_and_cast<PathNotifyMsg*>(msg));
             break;
 
+        case MSG_REFRESH_TIMER:
+            processREFRESH_TIMER(check_and_cast<RefreshTimerMsg*>(msg));
+            break;
+
+        case MSG_SEND_TIMER:
+            processSEND_TIMER(check_and_cast<SendTimerMsg*>(msg));
+            break;
+
         default:
             ASSERT(false);
     }
@@ -2003,6 +2061,375 @@ void RSVP::sendToIP(cMessage *msg, IPAddress destAddr)
     send(msg, "ipOut");
 }
 
+void RSVP::sendToNeighbor(NeighborState_t *n, std::vector<RSVPMessage *>& msgs)
+{
+    if (msgs.size() == 0)
+        return;
+
+    if (!refreshReduction || msgs.size() == 1)
+    {
+        for (unsigned int i = 0; i < msgs.size(); i++)
+            sendToIP(msgs[i], n->peer);
+        return;
+    }
+
+    // send all messages in a single Bundle message
+
+    RSVPBundleMsg *bm = new RSVPBundleMsg("Bundle");
+
+    bm->setByteLength(BUNDLE_HEADER_LENGTH);
+
+    for (unsigned int i = 0; i < msgs.size(); i++)
+        bm->addMessage(msgs[i]);
+
+    EV << "sending " << msgs.size() << " messages to " << n->peer << " in a bundle" << endl;
+
+    sendToIP(bm, n->peer);
+}
+
+void RSVP::processREFRESH_TIMER(RefreshTimerMsg *msg)
+{
+    NeighborState_t *n = findNeighbor(msg->getPeer());
+    ASSERT(n);
+
+    bool refreshPaths = n->pathRefreshTime <= simTime();
+    bool refreshResvs = n->resvRefreshTime <= simTime();
+
+    EV << "refreshing " << (refreshPaths ? (refreshResvs ? "Path and Resv" : "Path") : "Resv")
+       << " states of neighbor " << n->peer << endl;
+
+    std::vector<RSVPMessage *> msgs;
+    std::vector<int> srefreshIds;
+
+    // refresh paths towards the neighbor
+
+    for (std::set<int>::iterator it = n->pathsTo.begin(); refreshPaths && it != n->pathsTo.end(); it++)
+    {
+        if (n->pendingPaths.find(*it) != n->pendingPaths.end())
+            continue; // triggered message will be sent anyway
+
+        int messageId = 0;
+
+        if (refreshReduction)
+        {
+            IdMap::iterator mit = n->pathMessageIds.find(*it);
+            if (mit != n->pathMessageIds.end() && n->sentMessageIds[mit->second].acked)
+            {
+                // neighbor knows this state, summary refresh is enough
+                srefreshIds.push_back(mit->second);
+                continue;
+            }
+
+            messageId = (mit != n->pathMessageIds.end()) ? mit->second : assignMessageId(n, true, *it);
+        }
+
+        RSVPPathMsg *pm = createPathMsg(findPsbById(*it));
+        pm->setMessageId(messageId);
+        msgs.push_back(pm);
+    }
+
+    // refresh reservations of the paths coming from the neighbor
+
+    std::set<int> rsbIds;
+
+    for (std::set<int>::iterator it = n->pathsFrom.begin(); refreshResvs && it != n->pathsFrom.end(); it++)
+    {
+        PathStateBlock_t *psb = findPsbById(*it);
+
+        std::pair<RSBSessionMap::iterator, RSBSessionMap::iterator> range = RSBBySession.equal_range(psb->Session_Object);
+        for (RSBSessionMap::iterator rit = range.first; rit != range.second; rit++)
+        {
+            if (rit->second->OI != psb->OutInterface)
+                continue;
+
+            rsbIds.insert(rit->second->id);
+        }
+    }
+
+    for (std::set<int>::iterator it = rsbIds.begin(); it != rsbIds.end(); it++)
+    {
+        if (n->pendingResvs.find(*it) != n->pendingResvs.end())
+            continue; // triggered message will be sent anyway
+
+        ResvStateBlock_t *rsb = findRsbById(*it);
+
+        if (rsb->commitTimerMsg->isScheduled())
+            continue; // being modified, changes will be sent after commit
+
+        int messageId = 0;
+
+        IdMap::iterator mit = n->resvMessageIds.find(*it);
+
+        if (refreshReduction && mit != n->resvMessageIds.end() && n->sentMessageIds[mit->second].acked)
+        {
+            // neighbor knows this state, summary refresh is enough
+            srefreshIds.push_back(mit->second);
+            continue;
+        }
+
+        RSVPResvMsg *rm = createResvMsg(rsb, n->peer);
+        if (!rm)
+            continue;
+
+        if (refreshReduction)
+            messageId = (mit != n->resvMessageIds.end()) ? mit->second : assignMessageId(n, false, *it);
+
+        rm->setMessageId(messageId);
+        msgs.push_back(rm);
+    }
+
+    if (srefreshIds.size() > 0)
+    {
+        RSVPSrefreshMsg *sm = new RSVPSrefreshMsg("Srefresh");
+
+        sm->setMessageIdsArraySize(srefreshIds.size());
+        for (unsigned int i = 0; i < srefreshIds.size(); i++)
+            sm->setMessageIds(i, srefreshIds[i]);
+
+        int length = 16 + srefreshIds.size() * 4;
+
+        sm->setByteLength(length);
+
+        msgs.push_back(sm);
+    }
+
+    sendToNeighbor(n, msgs);
+
+    scheduleRefresh(n);
+}
+
+void RSVP::processSEND_TIMER(SendTimerMsg *msg)
+{
+    NeighborState_t *n = findNeighbor(msg->getPeer());
+    ASSERT(n);
+
+    std::vector<RSVPMessage *> msgs;
+
+    // triggered Path messages
+
+    for (std::set<int>::iterator it = n->pendingPaths.begin(); it != n->pendingPaths.end(); it++)
+    {
+        RSVPPathMsg *pm = createPathMsg(findPsbById(*it));
+        if (refreshReduction)
+            pm->setMessageId(assignMessageId(n, true, *it));
+        msgs.push_back(pm);
+    }
+    n->pendingPaths.clear();
+
+    // triggered Resv messages
+
+    std::set<int> deferred;
+
+    for (std::set<int>::iterator it = n->pendingResvs.begin(); it != n->pendingResvs.end(); it++)
+    {
+        ResvStateBlock_t *rsb = findRsbById(*it);
+
+        if (rsb->commitTimerMsg->isScheduled())
+        {
+            // reschedule after commit
+            deferred.insert(*it);
+            continue;
+        }
+
+        RSVPResvMsg *rm = createResvMsg(rsb, n->peer);
+        if (!rm)
+            continue;
+
+        if (refreshReduction)
+            rm->setMessageId(assignMessageId(n, false, *it));
+        msgs.push_back(rm);
+    }
+    n->pendingResvs.swap(deferred);
+
+    // acknowledgements
+
+    if (n->pendingAcks.size() > 0 || n->pendingNacks.size() > 0)
+    {
+        RSVPAckMsg *am = new RSVPAckMsg("Ack");
+
+        am->setAckIdsArraySize(n->pendingAcks.size());
+        for (unsigned int i = 0; i < n->pendingAcks.size(); i++)
+            am->setAckIds(i, n->pendingAcks[i]);
+
+        am->setNackIdsArraySize(n->pendingNacks.size());
+        for (unsigned int i = 0; i < n->pendingNacks.size(); i++)
+            am->setNackIds(i, n->pendingNacks[i]);
+
+        int length = 8 + (n->pendingAcks.size() + n->pendingNacks.size()) * 12;
+
+        am->setByteLength(length);
+
+        msgs.push_back(am);
+
+        n->pendingAcks.clear();
+        n->pendingNacks.clear();
+    }
+
+    sendToNeighbor(n, msgs);
+
+    if (n->pendingResvs.size() > 0)
+        scheduleSend(n);
+}
+
+void RSVP::processBundleMsg(RSVPBundleMsg *msg)
+{
+    EV << "Received BUNDLE" << endl;
+
+    IPControlInfo *controlInfo = check_and_cast<IPControlInfo*>(msg->getControlInfo());
+
+    std::vector<RSVPMessage *> msgs = msg->removeMessages();
+
+    for (unsigned int i = 0; i < msgs.size(); i++)
+    {
+        msgs[i]->setControlInfo(controlInfo->dup());
+        processRSVPMessage(msgs[i]);
+    }
+
+    delete msg;
+}
+
+void RSVP::processSrefreshMsg(RSVPSrefreshMsg *msg)
+{
+    EV << "Received SREFRESH" << endl;
+
+    NeighborState_t *n = findNeighbor(getNeighborOf(msg));
+    if (!n)
+    {
+        EV << "sender is not an RSVP peer, ignoring summary refresh" << endl;
+        delete msg;
+        return;
+    }
+
+    for (unsigned int i = 0; i < msg->getMessageIdsArraySize(); i++)
+    {
+        int messageId = msg->getMessageIds(i);
+
+        RcvMessageIdMap::iterator it = n->rcvMessageIds.find(messageId);
+        if (it == n->rcvMessageIds.end())
+        {
+            // we don't have this state (anymore), ask for a full refresh
+            EV << "no state for MESSAGE_ID " << messageId << ", sending NACK" << endl;
+            n->pendingNacks.push_back(messageId);
+            continue;
+        }
+
+        if (it->second.isPath)
+            scheduleTimeout(findPsbById(it->second.stateId));
+        else
+            scheduleTimeout(findRsbById(it->second.stateId));
+    }
+
+    if (n->pendingNacks.size() > 0)
+        scheduleSend(n);
+
+    delete msg;
+}
+
+void RSVP::processAckMsg(RSVPAckMsg *msg)
+{
+    EV << "Received ACK" << endl;
+
+    NeighborState_t *n = findNeighbor(getNeighborOf(msg));
+    if (!n)
+    {
+        EV << "sender is not an RSVP peer, ignoring acknowledgement" << endl;
+        delete msg;
+        return;
+    }
+
+    for (unsigned int i = 0; i < msg->getAckIdsArraySize(); i++)
+    {
+        // ACKs of MESSAGE_IDs that have since been replaced are ignored
+        SentMessageIdMap::iterator it = n->sentMessageIds.find(msg->getAckIds(i));
+        if (it != n->sentMessageIds.end())
+            it->second.acked = true;
+    }
+
+    for (unsigned int i = 0; i < msg->getNackIdsArraySize(); i++)
+    {
+        SentMessageIdMap::iterator it = n->sentMessageIds.find(msg->getNackIds(i));
+        if (it == n->sentMessageIds.end())
+            continue;
+
+        // neighbor has lost the state, send it again in full
+        EV << "MESSAGE_ID " << it->first << " NACKed, sending full refresh" << endl;
+
+        if (it->second.isPath)
+            n->pendingPaths.insert(it->second.stateId);
+        else
+            n->pendingResvs.insert(it->second.stateId);
+
+        scheduleSend(n);
+    }
+
+    delete msg;
+}
+
+int RSVP::assignMessageId(NeighborState_t *n, bool isPath, int stateId)
+{
+    forgetMessageId(n, isPath, stateId);
+
+    int messageId = ++maxMessageId;
+
+    if (isPath)
+        n->pathMessageIds[stateId] = messageId;
+    else
+        n->resvMessageIds[stateId] = messageId;
+
+    SentMessageId_t& e = n->sentMessageIds[messageId];
+    e.isPath = isPath;
+    e.stateId = stateId;
+    e.acked = false;
+
+    return messageId;
+}
+
+void RSVP::forgetMessageId(NeighborState_t *n, bool isPath, int stateId)
+{
+    IdMap& ids = isPath ? n->pathMessageIds : n->resvMessageIds;
+
+    IdMap::iterator it = ids.find(stateId);
+    if (it == ids.end())
+        return;
+
+    n->sentMessageIds.erase(it->second);
+    ids.erase(it);
+}
+
+void RSVP::recordMessageId(IPAddress peer, int messageId, bool isPath, int stateId, int& stateMessageId, IPAddress& stateMessageIdPeer)
+{
+    NeighborState_t *n = findNeighbor(peer);
+    if (!n)
+    {
+        EV << "sender " << peer << " is not an RSVP peer, MESSAGE_ID ignored" << endl;
+        return;
+    }
+
+    if (stateMessageId != 0)
+    {
+        NeighborState_t *old = findNeighbor(stateMessageIdPeer);
+        if (old)
+            old->rcvMessageIds.erase(stateMessageId);
+    }
+
+    RcvMessageId_t& e = n->rcvMessageIds[messageId];
+    e.isPath = isPath;
+    e.stateId = stateId;
+
+    stateMessageId = messageId;
+    stateMessageIdPeer = peer;
+
+    // acknowledge, so that the neighbor can switch to summary refresh
+    n->pendingAcks.push_back(messageId);
+    scheduleSend(n);
+}
+
+IPAddress RSVP::getNeighborOf(RSVPMessage *msg)
+{
+    IPControlInfo *controlInfo = check_and_cast<IPControlInfo*>(msg->getControlInfo());
+    return tedmod->primaryAddress(controlInfo->getSrcAddr());
+}
+
 void RSVP::scheduleTimeout(PathStateBlock_t *psbEle)
 {
     ASSERT(psbEle);
@@ -2013,7 +2440,7 @@ void RSVP::scheduleTimeout(PathStateBlock_t *psbEle)
     scheduleAt(simTime() + PSB_TIMEOUT_INTERVAL, psbEle->timeoutMsg);
 }
 
-void RSVP::scheduleRefreshTimer(PathStateBlock_t *psbEle, simtime_t delay)
+void RSVP::triggerRefresh(PathStateBlock_t *psbEle)
 {
     ASSERT(psbEle);
 
@@ -2023,12 +2450,13 @@ void RSVP::scheduleRefreshTimer(PathStateBlock_t *psbEle, simtime_t delay)
     if (!tedmod->isLocalAddress(psbEle->OutInterface))
         return;
 
-    if (psbEle->timerMsg->isScheduled())
-        cancelEvent(psbEle->timerMsg);
+    NeighborState_t *n = findNeighbor(tedmod->getPeerByLocalAddress(psbEle->OutInterface));
+    ASSERT(n);
 
-    EV << "scheduling PSB " << psbEle->id << " refresh " << (simTime() + delay) << endl;
+    EV << "scheduling PSB " << psbEle->id << " refresh to " << n->peer << endl;
 
-    scheduleAt(simTime() + delay, psbEle->timerMsg);
+    n->pendingPaths.insert(psbEle->id);
+    scheduleSend(n);
 }
 
 void RSVP::scheduleTimeout(ResvStateBlock_t *rsbEle)
@@ -2041,14 +2469,26 @@ void RSVP::scheduleTimeout(ResvStateBlock_t *rsbEle)
     scheduleAt(simTime() + RSB_TIMEOUT_INTERVAL, rsbEle->timeoutMsg);
 }
 
-void RSVP::scheduleRefreshTimer(ResvStateBlock_t *rsbEle, simtime_t delay)
+void RSVP::triggerRefresh(ResvStateBlock_t *rsbEle)
 {
     ASSERT(rsbEle);
 
-    if (rsbEle->refreshTimerMsg->isScheduled())
-        cancelEvent(rsbEle->refreshTimerMsg);
+    // send Resv to the PHOPs of the flows
+    for (unsigned int i = 0; i < rsbEle->FlowDescriptor.size(); i++)
+    {
+        PathStateBlock_t *psb = findPSB(rsbEle->Session_Object, rsbEle->FlowDescriptor[i].Filter_Spec_Object);
+        if (!psb || psb->OutInterface != rsbEle->OI)
+            continue;
+
+        if (tedmod->isLocalAddress(psb->Previous_Hop_Address))
+            continue; // IR nothing to refresh
+
+        NeighborState_t *n = findNeighbor(psb->Previous_Hop_Address);
+        ASSERT(n);
 
-    scheduleAt(simTime() + delay, rsbEle->refreshTimerMsg);
+        n->pendingResvs.insert(rsbEle->id);
+        scheduleSend(n);
+    }
 }
 
 void RSVP::scheduleCommitTimer(ResvStateBlock_t *rsbEle)
@@ -2061,75 +2501,124 @@ void RSVP::scheduleCommitTimer(ResvStateBlock_t *rsbEle)
     scheduleAt(simTime(), rsbEle->commitTimerMsg);
 }
 
+void RSVP::scheduleRefresh(NeighborState_t *n)
+{
+    if (n->refreshTimer->isScheduled())
+        return;
+
+    if (n->pathsTo.size() == 0 && n->pathsFrom.size() == 0)
+        return; // nothing to refresh
+
+    // with refresh reduction, Resv states are refreshed together with Path
+    // states, so that they can share the Bundle and Srefresh messages
+    simtime_t resvInterval = refreshReduction ? PSB_REFRESH_INTERVAL : RSB_REFRESH_INTERVAL;
+
+    if (n->pathRefreshTime <= simTime())
+        n->pathRefreshTime = simTime() + PSB_REFRESH_INTERVAL;
+    if (n->resvRefreshTime <= simTime())
+        n->resvRefreshTime = simTime() + resvInterval;
+
+    scheduleAt(n->pathRefreshTime < n->resvRefreshTime ? n->pathRefreshTime : n->resvRefreshTime, n->refreshTimer);
+}
+
+void RSVP::scheduleSend(NeighborState_t *n)
+{
+    // send in a separate event, to collect all messages created in this one
+    if (!n->sendTimer->isScheduled())
+        scheduleAt(simTime(), n->sendTimer);
+}
+
+RSVP::PathStateBlock_t* RSVP::registerPSB(PSBVector::iterator it)
+{
+    PathStateBlock_t *psb = &(*it);
+
+    PSBById[psb->id] = it;
+
+    SenderKey key;
+    key.session = psb->Session_Object;
+    key.sender = psb->Sender_Template_Object;
+    ASSERT(PSBBySender.find(key) == PSBBySender.end());
+    PSBBySender[key] = psb;
+
+    // paths are refreshed per neighbor
+
+    if (!psb->OutInterface.isUnspecified() && tedmod->isLocalAddress(psb->OutInterface))
+    {
+        NeighborState_t *n = findNeighbor(tedmod->getPeerByLocalAddress(psb->OutInterface));
+        ASSERT(n);
+        n->pathsTo.insert(psb->id);
+        scheduleRefresh(n);
+    }
+
+    NeighborState_t *n = findNeighbor(psb->Previous_Hop_Address);
+    if (n)
+    {
+        n->pathsFrom.insert(psb->id);
+        scheduleRefresh(n);
+    }
+
+    return psb;
+}
+
+RSVP::ResvStateBlock_t* RSVP::registerRSB(RSBVector::iterator it)
+{
+    ResvStateBlock_t *rsb = &(*it);
+
+    RSBById[rsb->id] = it;
+    RSBBySession.insert(std::make_pair(rsb->Session_Object, rsb));
+
+    return rsb;
+}
+
 RSVP::ResvStateBlock_t* RSVP::findRSB(const SessionObj_t& session, const SenderTemplateObj_t& sender, unsigned int& index)
 {
-    RSBVector::iterator it;
+    // there may be more RSBs with this sender (if outInterface is different),
+    // return the oldest one
+    ResvStateBlock_t *rsb = NULL;
 
-    for (it = RSBList.begin(); it != RSBList.end(); it++)
+    std::pair<RSBSessionMap::iterator, RSBSessionMap::iterator> range = RSBBySession.equal_range(session);
+    for (RSBSessionMap::iterator it = range.first; it != range.second; it++)
     {
-        if (it->Session_Object != session)
+        if (rsb && rsb->id < it->second->id)
             continue;
 
-        FlowDescriptorVector::iterator fit;
-        index = 0;
-        for (fit = it->FlowDescriptor.begin(); fit != it->FlowDescriptor.end(); fit++)
+        FlowDescriptorVector& flows = it->second->FlowDescriptor;
+        for (unsigned int i = 0; i < flows.size(); i++)
         {
-            if ((SenderTemplateObj_t&)fit->Filter_Spec_Object != sender)
-            {
-                ++index;
+            if ((SenderTemplateObj_t&)flows[i].Filter_Spec_Object != sender)
                 continue;
-            }
 
-            return &(*it);
+            rsb = it->second;
+            index = i;
+            break;
         }
-
-        // don't break here, may be in different (if outInterface is different)
     }
-    return NULL;
+    return rsb;
 }
 
 RSVP::PathStateBlock_t* RSVP::findPSB(const SessionObj_t& session, const SenderTemplateObj_t& sender)
 {
-    PSBVector::iterator it;
-    for (it = PSBList.begin(); it != PSBList.end(); it++)
-    {
-        if (it->Session_Object != session)
-            continue;
-
-        if (it->Sender_Template_Object != sender)
-            continue;
-
-        return &(*it);
-    }
+    SenderKey key;
+    key.session = session;
+    key.sender = sender;
 
-    return NULL;
+    PSBSenderMap::iterator it = PSBBySender.find(key);
+    return it == PSBBySender.end() ? NULL : it->second;
 }
 
 RSVP::PathStateBlock_t* RSVP::findPsbById(int id)
 {
-    for (unsigned int i = 0; i < PSBList.size(); i++)
-    {
-        if (PSBList[i].id != id)
-            continue;
-
-        return &PSBList[i];
-    }
-    ASSERT(false);
-    return NULL; // prevent warning
+    PSBIdMap::iterator it = PSBById.find(id);
+    ASSERT(it != PSBById.end());
+    return &(*it->second);
 }
 
 
 RSVP::ResvStateBlock_t* RSVP::findRsbById(int id)
 {
-    for (unsigned int i = 0; i < RSBList.size(); i++)
-    {
-        if (RSBList[i].id != id)
-            continue;
-
-        return &RSBList[i];
-    }
-    ASSERT(false);
-    return NULL; // prevent warning
+    RSBIdMap::iterator it = RSBById.find(id);
+    ASSERT(it != RSBById.end());
+    return &(*it->second);
 }
 
 RSVP::HelloState_t* RSVP::findHello(IPAddress peer)
@@ -2144,6 +2633,12 @@ RSVP::HelloState_t* RSVP::findHello(IPAddress peer)
     return NULL;
 }
 
+RSVP::NeighborState_t* RSVP::findNeighbor(IPAddress peer)
+{
+    NeighborMap::iterator it = NeighborList.find(peer);
+    return it == NeighborList.end() ? NULL : &it->second;
+}
+
 bool operator==(const SessionObj_t& a, const SessionObj_t& b)
 {
     return (a.DestAddress == b.DestAddress &&
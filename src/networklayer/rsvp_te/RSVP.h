@@ -16,13 +16,18 @@
 #define __INET_RSVP_H
 
 #include <vector>
+#include <list>
+#include <map>
+#include <set>
 #include <omnetpp.h>
 
+#include "INETHashMap.h"
 #include "IScriptable.h"
 #include "IntServ.h"
 #include "RSVPPathMsg.h"
 #include "RSVPResvMsg.h"
 #include "RSVPHelloMsg.h"
+#include "RSVPRefreshMsg.h"
 #include "SignallingMsg_m.h"
 #include "IRSVPClassifier.h"
 #include "NotificationBoard.h"
@@ -33,6 +38,15 @@ class IInterfaceTable;
 class TED;
 class LIBTable;
 
+bool operator==(const SessionObj_t& a, const SessionObj_t& b);
+bool operator!=(const SessionObj_t& a, const SessionObj_t& b);
+
+bool operator==(const FilterSpecObj_t& a, const FilterSpecObj_t& b);
+bool operator!=(const FilterSpecObj_t& a, const FilterSpecObj_t& b);
+
+bool operator==(const SenderTemplateObj_t& a, const SenderTemplateObj_t& b);
+bool operator!=(const SenderTemplateObj_t& a, const SenderTemplateObj_t& b);
+
 
 /**
  * TODO documentation
@@ -95,15 +109,19 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
         // XXX nam colors
         int color;
 
-        // timer/timeout routines
-        PsbTimerMsg *timerMsg;
+        // timeout routine (refreshes are sent per neighbor, see NeighborState_t)
         PsbTimeoutMsg *timeoutMsg;
 
         // handler module
         int handler;
+
+        // MESSAGE_ID of the last Path message received for this state, and its sender
+        int rcvMessageId;
+        IPAddress rcvMessageIdPeer;
     };
 
-    typedef std::vector<PathStateBlock_t> PSBVector;
+    // list, so that pointers to PSBs remain valid while others are added or removed
+    typedef std::list<PathStateBlock_t> PSBVector;
 
     /**
      * Reservation State Block (RSB) structure
@@ -134,13 +152,49 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
         // RSB unique identifier
         int id;
 
-        // timer/timeout routines
-        RsbRefreshTimerMsg *refreshTimerMsg;
+        // timer/timeout routines (refreshes are sent per neighbor, see NeighborState_t)
         RsbCommitTimerMsg *commitTimerMsg;
         RsbTimeoutMsg *timeoutMsg;
+
+        // MESSAGE_ID of the last Resv message received for this state, and its sender
+        int rcvMessageId;
+        IPAddress rcvMessageIdPeer;
+    };
+
+    // list, so that pointers to RSBs remain valid while others are added or removed
+    typedef std::list<ResvStateBlock_t> RSBVector;
+
+    //
+    // Hash indices of the state blocks
+    //
+    struct SessionHash
+    {
+        size_t operator()(const SessionObj_t& s) const {
+            return inet_hashCombine(inet_hashCombine(s.Tunnel_Id, s.Extended_Tunnel_Id), s.DestAddress.getInt());
+        }
     };
 
-    typedef std::vector<ResvStateBlock_t> RSBVector;
+    struct SenderKey
+    {
+        SessionObj_t session;
+        SenderTemplateObj_t sender;
+
+        inline bool operator==(const SenderKey& b) const {
+            return session==b.session && sender==b.sender;
+        }
+    };
+
+    struct SenderKeyHash
+    {
+        size_t operator()(const SenderKey& k) const {
+            return inet_hashCombine(inet_hashCombine(SessionHash()(k.session), k.sender.SrcAddress.getInt()), k.sender.Lsp_Id);
+        }
+    };
+
+    typedef std::tr1::unordered_map<int, PSBVector::iterator> PSBIdMap;
+    typedef std::tr1::unordered_map<int, RSBVector::iterator> RSBIdMap;
+    typedef std::tr1::unordered_map<SenderKey, PathStateBlock_t*, SenderKeyHash> PSBSenderMap;
+    typedef std::tr1::unordered_multimap<SessionObj_t, ResvStateBlock_t*, SessionHash> RSBSessionMap;
 
     /**
      * RSVP Hello State structure
@@ -165,9 +219,76 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
 
     typedef std::vector<HelloState_t> HelloVector;
 
+    /**
+     * MESSAGE_ID sent to a neighbor (RFC 2961), and the state it refers to
+     */
+    struct SentMessageId_t
+    {
+        bool isPath;  // PSB or RSB
+        int stateId;  // PSB or RSB id
+        bool acked;   // neighbor has acknowledged it, so it can be refreshed with Srefresh
+    };
+
+    /**
+     * MESSAGE_ID received from a neighbor (RFC 2961), and the state it refers to
+     */
+    struct RcvMessageId_t
+    {
+        bool isPath;  // PSB or RSB
+        int stateId;  // PSB or RSB id
+    };
+
+    typedef std::tr1::unordered_map<int, int> IdMap;
+    typedef std::tr1::unordered_map<int, SentMessageId_t> SentMessageIdMap;
+    typedef std::tr1::unordered_map<int, RcvMessageId_t> RcvMessageIdMap;
+
+    /**
+     * Per-neighbor refresh state. Path and Resv states towards a neighbor
+     * are refreshed together, by a single timer per neighbor. Triggered
+     * messages are collected and sent by the send timer, so that messages
+     * created in the same event can be bundled.
+     */
+    struct NeighborState_t
+    {
+        IPAddress peer;
+
+        // PSBs whose Path messages go to this neighbor (downstream)
+        std::set<int> pathsTo;
+        // PSBs whose Path messages come from this neighbor (upstream); their
+        // reservations are sent to this neighbor in Resv messages
+        std::set<int> pathsFrom;
+
+        // states with a triggered Path or Resv message waiting to be sent
+        std::set<int> pendingPaths;
+        std::set<int> pendingResvs;
+
+        // MESSAGE_IDs waiting to be acknowledged (ACK) or rejected (NACK)
+        std::vector<int> pendingAcks;
+        std::vector<int> pendingNacks;
+
+        // MESSAGE_IDs of the last Path/Resv message sent to the neighbor, by PSB/RSB id
+        IdMap pathMessageIds;
+        IdMap resvMessageIds;
+        SentMessageIdMap sentMessageIds;
+
+        // MESSAGE_IDs received from the neighbor
+        RcvMessageIdMap rcvMessageIds;
+
+        // when the Path/Resv states of the neighbor are due for refresh;
+        // refreshTimer is scheduled for the earlier one
+        simtime_t pathRefreshTime;
+        simtime_t resvRefreshTime;
+
+        RefreshTimerMsg *refreshTimer;
+        SendTimerMsg *sendTimer;
+    };
+
+    typedef std::map<IPAddress, NeighborState_t> NeighborMap;
+
     simtime_t helloInterval;
     simtime_t helloTimeout;
     simtime_t retryInterval;
+    bool refreshReduction;
 
   protected:
     TED *tedmod;
@@ -182,29 +303,39 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     int maxRsbId;
 
     int maxSrcInstance;
+    int maxMessageId;
 
     IPAddress routerId;
 
     PSBVector PSBList;
     RSBVector RSBList;
     HelloVector HelloList;
+    NeighborMap NeighborList;
+
+    PSBIdMap PSBById;
+    RSBIdMap RSBById;
+    PSBSenderMap PSBBySender;
+    RSBSessionMap RSBBySession;
 
   protected:
     virtual void processSignallingMessage(SignallingMsg *msg);
-    virtual void processPSB_TIMER(PsbTimerMsg *msg);
     virtual void processPSB_TIMEOUT(PsbTimeoutMsg* msg);
-    virtual void processRSB_REFRESH_TIMER(RsbRefreshTimerMsg *msg);
     virtual void processRSB_COMMIT_TIMER(RsbCommitTimerMsg *msg);
     virtual void processRSB_TIMEOUT(RsbTimeoutMsg* msg);
     virtual void processHELLO_TIMER(HelloTimerMsg* msg);
     virtual void processHELLO_TIMEOUT(HelloTimeoutMsg* msg);
     virtual void processPATH_NOTIFY(PathNotifyMsg* msg);
+    virtual void processREFRESH_TIMER(RefreshTimerMsg* msg);
+    virtual void processSEND_TIMER(SendTimerMsg* msg);
     virtual void processRSVPMessage(RSVPMessage* msg);
     virtual void processHelloMsg(RSVPHelloMsg* msg);
     virtual void processPathMsg(RSVPPathMsg* msg);
     virtual void processResvMsg(RSVPResvMsg* msg);
     virtual void processPathTearMsg(RSVPPathTear* msg);
     virtual void processPathErrMsg(RSVPPathError* msg);
+    virtual void processBundleMsg(RSVPBundleMsg* msg);
+    virtual void processSrefreshMsg(RSVPSrefreshMsg* msg);
+    virtual void processAckMsg(RSVPAckMsg* msg);
 
     virtual PathStateBlock_t* createPSB(RSVPPathMsg *msg);
     virtual PathStateBlock_t* createIngressPSB(const traffic_session_t& session, const traffic_path_t& path);
@@ -215,14 +346,16 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     virtual void removeRSB(ResvStateBlock_t *rsb);
     virtual void removeRsbFilter(ResvStateBlock_t *rsb, unsigned int index);
 
-    virtual void refreshPath(PathStateBlock_t *psbEle);
-    virtual void refreshResv(ResvStateBlock_t *rsbEle);
-    virtual void refreshResv(ResvStateBlock_t *rsbEle, IPAddress PHOP);
+    virtual PathStateBlock_t* registerPSB(PSBVector::iterator it);
+    virtual ResvStateBlock_t* registerRSB(RSBVector::iterator it);
+
+    virtual RSVPPathMsg *createPathMsg(PathStateBlock_t *psbEle);
+    virtual RSVPResvMsg *createResvMsg(ResvStateBlock_t *rsbEle, IPAddress PHOP);
     virtual void commitResv(ResvStateBlock_t *rsb);
 
-    virtual void scheduleRefreshTimer(PathStateBlock_t *psbEle, simtime_t delay);
+    virtual void triggerRefresh(PathStateBlock_t *psbEle);
+    virtual void triggerRefresh(ResvStateBlock_t *rsbEle);
     virtual void scheduleTimeout(PathStateBlock_t *psbEle);
-    virtual void scheduleRefreshTimer(ResvStateBlock_t *rsbEle, simtime_t delay);
     virtual void scheduleCommitTimer(ResvStateBlock_t *rsbEle);
     virtual void scheduleTimeout(ResvStateBlock_t *rsbEle);
 
@@ -232,6 +365,7 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     virtual void sendPathNotify(int handler, const SessionObj_t& session, const SenderTemplateObj_t& sender, int status, simtime_t delay);
 
     virtual void setupHello();
+    virtual void setupNeighbors();
     virtual void startHello(IPAddress peer, simtime_t delay);
 
     virtual void recoveryEvent(IPAddress peer);
@@ -242,6 +376,14 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     virtual void announceLinkChange(int tedlinkindex);
 
     virtual void sendToIP(cMessage *msg, IPAddress destAddr);
+    virtual void sendToNeighbor(NeighborState_t *n, std::vector<RSVPMessage *>& msgs);
+
+    virtual void scheduleRefresh(NeighborState_t *n);
+    virtual void scheduleSend(NeighborState_t *n);
+    virtual int assignMessageId(NeighborState_t *n, bool isPath, int stateId);
+    virtual void forgetMessageId(NeighborState_t *n, bool isPath, int stateId);
+    virtual void recordMessageId(IPAddress peer, int messageId, bool isPath, int stateId, int& stateMessageId, IPAddress& stateMessageIdPeer);
+    virtual IPAddress getNeighborOf(RSVPMessage *msg);
 
     virtual bool evalNextHopInterface(IPAddress destAddr, const EroVector& ERO, IPAddress& OI);
 
@@ -255,6 +397,7 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     std::vector<traffic_path_t>::iterator findPath(traffic_session_t *session, const SenderTemplateObj_t &sender);
 
     virtual HelloState_t* findHello(IPAddress peer);
+    virtual NeighborState_t* findNeighbor(IPAddress peer);
 
     virtual void print(RSVPPathMsg *p);
     virtual void print(RSVPResvMsg *r);
@@ -290,15 +433,6 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
 
 };
 
-bool operator==(const SessionObj_t& a, const SessionObj_t& b);
-bool operator!=(const SessionObj_t& a, const SessionObj_t& b);
-
-bool operator==(const FilterSpecObj_t& a, const FilterSpecObj_t& b);
-bool operator!=(const FilterSpecObj_t& a, const FilterSpecObj_t& b);
-
-bool operator==(const SenderTemplateObj_t& a, const SenderTemplateObj_t& b);
-bool operator!=(const SenderTemplateObj_t& a, const SenderTemplateObj_t& b);
-
 std::ostream& operator<<(std::ostream& os, const SessionObj_t& a);
 std::ostream& operator<<(std::ostream& os, const SenderTemplateObj_t& a);
 std::ostream& operator<<(std::ostream& os, const FlowSpecObj_t& a);
@@ -0,0 +1,118 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This library is free software, you can redistribute it
+// and/or modify
+// it under  the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation;
+// either version 2 of the License, or any later version.
+// The library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+
+#ifndef __INET_RSVPREFRESHMSG_H
+#define __INET_RSVPREFRESHMSG_H
+
+#include <vector>
+#include "RSVPRefresh_m.h"
+
+
+/**
+ * RSVP BUNDLE message
+ *
+ * Owns the bundled messages; the byte length of the bundle includes
+ * the lengths of the bundled messages.
+ */
+class RSVPBundleMsg : public RSVPBundleMsg_Base
+{
+  protected:
+    std::vector<RSVPMessage *> messages;
+
+  private:
+    void copy(const RSVPBundleMsg& other) {
+        for (unsigned int i = 0; i < other.messages.size(); i++) {
+            RSVPMessage *msg = other.messages[i]->dup();
+            take(msg);
+            messages.push_back(msg);
+        }
+    }
+    void clear() {
+        for (unsigned int i = 0; i < messages.size(); i++)
+            dropAndDelete(messages[i]);
+        messages.clear();
+    }
+
+  public:
+    RSVPBundleMsg(const char *name=NULL, int kind=RSVP_TRAFFIC) : RSVPBundleMsg_Base(name,kind) {}
+    RSVPBundleMsg(const RSVPBundleMsg& other) : RSVPBundleMsg_Base(other.getName()) {operator=(other);}
+    virtual ~RSVPBundleMsg() {clear();}
+    RSVPBundleMsg& operator=(const RSVPBundleMsg& other) {
+        if (this==&other) return *this;
+        RSVPBundleMsg_Base::operator=(other);
+        clear();
+        copy(other);
+        return *this;
+    }
+    virtual RSVPBundleMsg *dup() const {return new RSVPBundleMsg(*this);}
+
+    virtual void forEachChild(cVisitor *v) {
+        RSVPBundleMsg_Base::forEachChild(v);
+        for (unsigned int i = 0; i < messages.size(); i++)
+            v->visit(messages[i]);
+    }
+
+    /** Adds a message to the bundle, and increases the bundle's length accordingly. */
+    void addMessage(RSVPMessage *msg) {
+        take(msg);
+        messages.push_back(msg);
+        addByteLength(msg->getByteLength());
+    }
+
+    /** Returns the number of bundled messages. */
+    unsigned int getNumMessages() const {return messages.size();}
+
+    /** Removes all bundled messages from the bundle, and returns them. */
+    std::vector<RSVPMessage *> removeMessages() {
+        std::vector<RSVPMessage *> result;
+        result.swap(messages);
+        for (unsigned int i = 0; i < result.size(); i++)
+            drop(result[i]);
+        setByteLength(0);
+        return result;
+    }
+};
+
+
+/**
+ * RSVP SREFRESH message
+ *
+ * Carries the MESSAGE_IDs of the states being refreshed (RFC 2961).
+ */
+class RSVPSrefreshMsg : public RSVPSrefreshMsg_Base
+{
+  public:
+    RSVPSrefreshMsg(const char *name=NULL, int kind=RSVP_TRAFFIC) : RSVPSrefreshMsg_Base(name,kind) {}
+    RSVPSrefreshMsg(const RSVPSrefreshMsg& other) : RSVPSrefreshMsg_Base(other.getName()) {operator=(other);}
+    RSVPSrefreshMsg& operator=(const RSVPSrefreshMsg& other) {RSVPSrefreshMsg_Base::operator=(other); return *this;}
+    virtual RSVPSrefreshMsg *dup() const {return new RSVPSrefreshMsg(*this);}
+};
+
+
+/**
+ * RSVP ACK message
+ *
+ * Carries the acknowledged and the NACKed MESSAGE_IDs (RFC 2961).
+ */
+class RSVPAckMsg : public RSVPAckMsg_Base
+{
+  public:
+    RSVPAckMsg(const char *name=NULL, int kind=RSVP_TRAFFIC) : RSVPAckMsg_Base(name,kind) {}
+    RSVPAckMsg(const RSVPAckMsg& other) : RSVPAckMsg_Base(other.getName()) {operator=(other);}
+    RSVPAckMsg& operator=(const RSVPAckMsg& other) {RSVPAckMsg_Base::operator=(other); return *this;}
+    virtual RSVPAckMsg *dup() const {return new RSVPAckMsg(*this);}
+};
+
+#endif
+
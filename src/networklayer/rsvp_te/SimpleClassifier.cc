@@ -66,13 +66,21 @@ bool SimpleClassifier::lookupLabel(IPDatagram *ipdatagram, LabelOpVector& outLab
             ;
     }
 
-    // forwarding decision for non-labeled datagrams
-
-    std::vector<FECEntry>::iterator it;
-    for (it = bindings.begin(); it != bindings.end(); it++)
+    // forwarding decision for non-labeled datagrams: candidates are the
+    // bindings for this destination and those for any destination, and
+    // the first one in the table whose source matches wins
+
+    static const std::vector<int> none;
+    const std::vector<int> *hostBindings = bindingTrie.find(ipdatagram->getDestAddress(), 32);
+    const std::vector<int> *anyBindings = bindingTrie.find(IPAddress(), 0);
+    const std::vector<int>& a = hostBindings ? *hostBindings : none;
+    const std::vector<int>& b = anyBindings ? *anyBindings : none;
+
+    unsigned int i = 0, j = 0;
+    while (i < a.size() || j < b.size())
     {
-        if (!it->dest.isUnspecified() && !it->dest.equals(ipdatagram->getDestAddress()))
-            continue;
+        int k = (j == b.size() || (i < a.size() && a[i] < b[j])) ? a[i++] : b[j++];
+        std::vector<FECEntry>::iterator it = bindings.begin() + k;
 
         if (!it->src.isUnspecified() && !it->src.equals(ipdatagram->getSrcAddress()))
             continue;
@@ -112,6 +120,7 @@ void SimpleClassifier::processCommand(const cXMLElement& node)
     if (!strcmp(node.getTagName(), "bind-fec"))
     {
         readItemFromXML(&node);
+        rebuildBindingTrie();
     }
     else
         ASSERT(false);
@@ -128,6 +137,17 @@ void SimpleClassifier::readTableFromXML(const cXMLElement *fectable)
     cXMLElementList list = fectable->getChildrenByTagName("fecentry");
     for (cXMLElementList::iterator it=list.begin(); it != list.end(); it++)
         readItemFromXML(*it);
+    rebuildBindingTrie();
+}
+
+void SimpleClassifier::rebuildBindingTrie()
+{
+    bindingTrie.clear();
+    for (unsigned int i = 0; i < bindings.size(); i++)
+    {
+        const IPAddress& dest = bindings[i].dest;
+        bindingTrie.insert(dest, dest.isUnspecified() ? 0 : 32).push_back(i);
+    }
 }
 
 void SimpleClassifier::readItemFromXML(const cXMLElement *fec)
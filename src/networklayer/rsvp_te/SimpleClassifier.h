@@ -24,6 +24,7 @@
 #include "IScriptable.h"
 #include "IRSVPClassifier.h"
 #include "LIBTable.h"
+#include "PrefixTrie.h"
 #include "IntServ.h"
 
 class RSVP;
@@ -52,6 +53,9 @@ class INET_API SimpleClassifier: public cSimpleModule, public IScriptable, publi
     int maxLabel;
 
     std::vector<FECEntry> bindings;
+    // indices into bindings[] (in increasing order) by destination:
+    // host prefixes, and the zero-length prefix for "any destination"
+    PrefixTrie<std::vector<int> > bindingTrie;
     LIBTable *lt;
     RSVP *rsvp;
 
@@ -72,8 +76,10 @@ class INET_API SimpleClassifier: public cSimpleModule, public IScriptable, publi
 
   protected:
     virtual void readTableFromXML(const cXMLElement *fectable);
+    // updates bindings[] only; the caller must call rebuildBindingTrie() afterwards
     virtual void readItemFromXML(const cXMLElement *fec);
     std::vector<FECEntry>::iterator findFEC(int fecid);
+    virtual void rebuildBindingTrie();
 };
 
 #endif
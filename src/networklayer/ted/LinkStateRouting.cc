@@ -160,6 +160,7 @@ void LinkStateRouting::processLINK_STATE_MESSAGE(LinkStateMsg* msg, IPAddress se
                     match->UnResvBandwidth[i] = link.UnResvBandwidth[i];
                 match->MaxBandwidth = link.MaxBandwidth;
                 match->metric = link.metric;
+                tedmod->linkChanged(match - &tedmod->ted[0]);
             }
 
             forward.push_back(link);
@@ -14,6 +14,8 @@
 
 #include <omnetpp.h>
 #include <algorithm>
+#include <functional>
+#include <queue>
 
 #include "TED.h"
 #include "IPControlInfo.h"
@@ -25,10 +27,13 @@
 
 #define LS_INFINITY   1e16
 
+#define MAX_CSPF_CLASSES  16  // max number of (bandwidth, priority) classes cached
+
 Define_Module(TED);
 
 TED::TED()
 {
+    numSPFRuns = numCSPFCacheHits = 0;
 }
 
 TED::~TED()
@@ -126,9 +131,13 @@ void TED::initialize(int stage)
             interfaceAddrs.push_back(ie->ipv4Data()->getIPAddress());
     }
 
+    nb->subscribe(this, NF_TED_CHANGED);
+
     rebuildRoutingTable();
 
     WATCH_VECTOR(ted);
+    WATCH(numSPFRuns);
+    WATCH(numCSPFCacheHits);
 }
 
 void TED::handleMessage(cMessage * msg)
@@ -136,6 +145,19 @@ void TED::handleMessage(cMessage * msg)
     ASSERT(false);
 }
 
+void TED::receiveChangeNotification(int category, const cPolymorphic *details)
+{
+    Enter_Method_Silent();
+    printNotificationBanner(category, details);
+
+    ASSERT(category == NF_TED_CHANGED);
+
+    TEDChangeInfo *d = check_and_cast<TEDChangeInfo *>(details);
+
+    for (unsigned int i = 0; i < d->getTedLinkIndicesArraySize(); i++)
+        linkChanged(d->getTedLinkIndices(i));
+}
+
 std::ostream & operator<<(std::ostream & os, const TELinkStateInfo& info)
 {
     os << "advrouter:" << info.advrouter;
@@ -151,34 +173,265 @@ std::ostream & operator<<(std::ostream & os, const TELinkStateInfo& info)
     return os;
 }
 
-// FIXME should this be called findOrCreateVertex() or something like that?
-int TED::assignIndex(std::vector<vertex_t>& vertices, IPAddress nodeAddr)
+namespace {
+
+// path used by the k-shortest path calculation
+struct Path
 {
-    // find node in vertices[] whose IP address is nodeAddr
-    for (unsigned int i = 0 ; i < vertices.size(); i++)
-        if (vertices[i].node == nodeAddr)
-            return i;
+    double cost;
+    std::vector<int> links; // indices into ted[]
+    std::vector<int> nodes; // vertex indices, one more than links
+};
+
+void fillPath(const TED::graph_t& graph, Path& path)
+{
+    ASSERT(!path.links.empty());
+    path.cost = 0.0;
+    path.nodes.clear();
+    path.nodes.push_back(graph.edges[path.links[0]].src);
+    for (unsigned int i = 0; i < path.links.size(); i++)
+    {
+        path.cost += graph.edges[path.links[i]].metric;
+        path.nodes.push_back(graph.edges[path.links[i]].dest);
+    }
+}
+
+// appends the links from src to target in the shortest path tree
+void appendTreePath(const TED::graph_t& graph, const std::vector<int>& parentLink,
+        int src, int target, std::vector<int>& links)
+{
+    unsigned int k = links.size();
+    for (int v = target; v != src; v = graph.edges[parentLink[v]].src)
+        links.push_back(parentLink[v]);
+    std::reverse(links.begin() + k, links.end());
+}
 
-    // if not found, create
-    vertex_t newVertex;
-    newVertex.node = nodeAddr;
-    newVertex.dist = LS_INFINITY;
-    newVertex.parent = -1;
+bool containsPath(const std::vector<Path>& paths, const Path& path)
+{
+    for (unsigned int i = 0; i < paths.size(); i++)
+        if (paths[i].nodes == path.nodes)
+            return true;
+    return false;
+}
 
-    vertices.push_back(newVertex);
-    return vertices.size() - 1;
+// removes all links src->dest from the pruned topology
+void excludeLinks(const TED::graph_t& graph, std::vector<bool>& usable, int src, int dest)
+{
+    const std::vector<int>& out = graph.outEdges[src];
+    for (unsigned int i = 0; i < out.size(); i++)
+        if (graph.edges[out[i]].dest == dest)
+            usable[graph.edges[out[i]].link] = false;
+}
+
+// removes all links leaving the vertex from the pruned topology
+void excludeVertex(const TED::graph_t& graph, std::vector<bool>& usable, int v)
+{
+    const std::vector<int>& out = graph.outEdges[v];
+    for (unsigned int i = 0; i < out.size(); i++)
+        usable[graph.edges[out[i]].link] = false;
+}
+
+}
+
+bool TED::isUsable(const TELinkStateInfo& link, double req_bandwidth, int priority)
+{
+    return link.state && link.UnResvBandwidth[priority] >= req_bandwidth;
+}
+
+int TED::findOrCreateVertex(graph_t& graph, IPAddress nodeAddr)
+{
+    graph_t::VertexIndex::iterator it = graph.vertexIndex.find(nodeAddr);
+    if (it != graph.vertexIndex.end())
+        return it->second;
+
+    int index = graph.nodes.size();
+    graph.nodes.push_back(nodeAddr);
+    graph.outEdges.push_back(std::vector<int>());
+    graph.vertexIndex[nodeAddr] = index;
+    return index;
+}
+
+void TED::buildGraph(const TELinkStateInfoVector& topology, graph_t& graph)
+{
+    graph.nodes.clear();
+    graph.vertexIndex.clear();
+    graph.edges.clear();
+    graph.outEdges.clear();
+
+    // we are always present, even without links
+    findOrCreateVertex(graph, routerId);
+
+    for (unsigned int i = 0; i < topology.size(); i++)
+    {
+        edge_t edge;
+        edge.src = findOrCreateVertex(graph, topology[i].advrouter);
+        edge.dest = findOrCreateVertex(graph, topology[i].linkid);
+        edge.metric = topology[i].metric;
+        edge.link = i;
+        ASSERT(edge.src != edge.dest);
+
+        graph.edges.push_back(edge);
+        graph.outEdges[edge.src].push_back(i);
+    }
+}
+
+void TED::runDijkstra(const graph_t& graph, const std::vector<bool>& usable,
+        int src, int target, std::vector<vertex_t>& vertices, std::vector<int>& parentLink)
+{
+    numSPFRuns++;
+
+    int n = graph.nodes.size();
+    vertices.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        vertices[i].node = graph.nodes[i];
+        vertices[i].parent = -1;
+        vertices[i].dist = LS_INFINITY;
+    }
+    parentLink.assign(n, -1);
+    std::vector<bool> done(n, false);
+
+    // (distance, vertex) pairs; items made obsolete by a later decrease
+    // of the distance are skipped when they come up
+    typedef std::pair<double, int> QueueItem;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > queue;
+
+    vertices[src].dist = 0.0;
+    queue.push(QueueItem(0.0, src));
+
+    while (!queue.empty())
+    {
+        int u = queue.top().second;
+        queue.pop();
+
+        if (done[u])
+            continue;
+        done[u] = true;
+
+        if (u == target)
+            break;
+
+        const std::vector<int>& out = graph.outEdges[u];
+        for (unsigned int j = 0; j < out.size(); j++)
+        {
+            const edge_t& edge = graph.edges[out[j]];
+            if (!usable[edge.link])
+                continue;
+
+            double dist = vertices[u].dist + edge.metric;
+            if (dist >= vertices[edge.dest].dist)
+                continue;
+
+            vertices[edge.dest].dist = dist;
+            vertices[edge.dest].parent = u;
+            parentLink[edge.dest] = edge.link;
+            queue.push(QueueItem(dist, edge.dest));
+        }
+    }
+}
+
+TED::cspf_class_t& TED::getCSPFClass(double req_bandwidth, int priority)
+{
+    // links are only ever appended to ted[]; if there are new ones,
+    // reindex the graph and forget all cached classes. The graph also
+    // needs to be built if ted[] is empty, so that we have a vertex.
+    if (tedGraph.nodes.empty() || tedGraph.edges.size() != ted.size())
+    {
+        buildGraph(ted, tedGraph);
+        cspfCache.clear();
+    }
+
+    std::list<cspf_class_t>::iterator it;
+    for (it = cspfCache.begin(); it != cspfCache.end(); ++it)
+        if (it->bandwidth == req_bandwidth && it->priority == priority)
+            break;
+
+    if (it == cspfCache.end())
+    {
+        if (cspfCache.size() >= MAX_CSPF_CLASSES)
+            cspfCache.pop_back();
+
+        cspfCache.push_front(cspf_class_t());
+        it = cspfCache.begin();
+        it->bandwidth = req_bandwidth;
+        it->priority = priority;
+        it->usable.resize(ted.size());
+        for (unsigned int i = 0; i < ted.size(); i++)
+            it->usable[i] = isUsable(ted[i], req_bandwidth, priority);
+        it->valid = false;
+    }
+    else if (it != cspfCache.begin())
+    {
+        cspfCache.splice(cspfCache.begin(), cspfCache, it);
+    }
+
+    if (it->valid)
+    {
+        numCSPFCacheHits++;
+    }
+    else
+    {
+        runDijkstra(tedGraph, it->usable, tedGraph.vertexIndex[routerId], -1, it->tree, it->parentLink);
+        it->valid = true;
+    }
+    return *it;
+}
+
+void TED::linkChanged(unsigned int index)
+{
+    ASSERT(index < ted.size());
+
+    // if links were added, everything gets rebuilt on next use anyway
+    if (tedGraph.edges.size() != ted.size())
+        return;
+
+    const TELinkStateInfo& link = ted[index];
+    edge_t& edge = tedGraph.edges[index];
+    double oldMetric = edge.metric;
+    edge.metric = link.metric;
+
+    for (std::list<cspf_class_t>::iterator it = cspfCache.begin(); it != cspfCache.end(); ++it)
+    {
+        bool wasUsable = it->usable[index];
+        bool usable = isUsable(link, it->bandwidth, it->priority);
+        if (wasUsable == usable && (!usable || oldMetric == link.metric))
+            continue; // link didn't change in this class
+
+        it->usable[index] = usable;
+
+        if (!it->valid)
+            continue;
+
+        // the tree stays valid if the link isn't part of it, and
+        // doesn't offer a shorter path to its far end either
+        if (it->parentLink[edge.dest] == (int)index)
+            it->valid = false;
+        else if (usable && it->tree[edge.src].dist + link.metric < it->tree[edge.dest].dist)
+            it->valid = false;
+    }
 }
 
 IPAddressVector TED::calculateShortestPath(IPAddressVector dest,
             const TELinkStateInfoVector& topology, double req_bandwidth, int priority)
 {
-    // FIXME comment: what do we do here?
-    std::vector<vertex_t> V = calculateShortestPaths(topology, req_bandwidth, priority);
+    // shortest path tree from us; cached if topology is our own database
+    std::vector<vertex_t> uncached;
+    const std::vector<vertex_t> *tree;
+    if (&topology == &ted)
+    {
+        tree = &getCSPFClass(req_bandwidth, priority).tree;
+    }
+    else
+    {
+        uncached = calculateShortestPaths(topology, req_bandwidth, priority);
+        tree = &uncached;
+    }
+    const std::vector<vertex_t>& V = *tree;
 
     double minDist = LS_INFINITY;
     int minIndex = -1;
 
-    // FIXME comment: what do we do in this block?
+    // select the closest reachable destination
     for (unsigned int i = 0; i < V.size(); i++)
     {
         if (V[i].dist >= minDist)
@@ -196,12 +449,137 @@ IPAddressVector TED::calculateShortestPath(IPAddressVector dest,
     if (minIndex < 0)
         return result;
 
-    result.push_back(V[minIndex].node);
-    while (V[minIndex].parent != -1)
+    // walk back to the root
+    for (int i = minIndex; i != -1; i = V[i].parent)
+        result.push_back(V[i].node);
+    std::reverse(result.begin(), result.end());
+
+    return result;
+}
+
+std::vector<IPAddressVector> TED::calculateKShortestPaths(IPAddress dest,
+            int k, double req_bandwidth, int priority)
+{
+    std::vector<IPAddressVector> result;
+
+    cspf_class_t& cspfClass = getCSPFClass(req_bandwidth, priority);
+
+    graph_t::VertexIndex::iterator it = tedGraph.vertexIndex.find(dest);
+    if (k <= 0 || it == tedGraph.vertexIndex.end())
+        return result;
+
+    int src = tedGraph.vertexIndex[routerId];
+    int target = it->second;
+    if (cspfClass.tree[target].parent == -1)
+        return result; // unreachable, or ourselves
+
+    std::vector<Path> accepted;   // in increasing order of cost
+    std::vector<Path> candidates;
+
+    accepted.push_back(Path());
+    appendTreePath(tedGraph, cspfClass.parentLink, src, target, accepted.back().links);
+    fillPath(tedGraph, accepted.back());
+
+    std::vector<vertex_t> vertices;
+    std::vector<int> parentLink;
+    while ((int)accepted.size() < k)
+    {
+        // deviate from the last accepted path at each of its nodes (spur node),
+        // keeping the part before it (root path)
+        const Path& prev = accepted.back();
+        for (unsigned int i = 0; i + 1 < prev.nodes.size(); i++)
+        {
+            int spur = prev.nodes[i];
+            std::vector<bool> usable = cspfClass.usable;
+
+            // don't repeat the next hop of accepted paths with the same root path
+            for (unsigned int j = 0; j < accepted.size(); j++)
+            {
+                const Path& p = accepted[j];
+                if (p.nodes.size() > i + 1 && std::equal(prev.nodes.begin(), prev.nodes.begin() + i + 1, p.nodes.begin()))
+                    excludeLinks(tedGraph, usable, spur, p.nodes[i + 1]);
+            }
+
+            // don't loop back into the root path
+            for (unsigned int j = 0; j < i; j++)
+                excludeVertex(tedGraph, usable, prev.nodes[j]);
+
+            runDijkstra(tedGraph, usable, spur, target, vertices, parentLink);
+            if (vertices[target].dist >= LS_INFINITY)
+                continue;
+
+            Path candidate;
+            candidate.links.assign(prev.links.begin(), prev.links.begin() + i);
+            appendTreePath(tedGraph, parentLink, spur, target, candidate.links);
+            fillPath(tedGraph, candidate);
+
+            if (!containsPath(accepted, candidate) && !containsPath(candidates, candidate))
+                candidates.push_back(candidate);
+        }
+
+        if (candidates.empty())
+            break;
+
+        unsigned int best = 0;
+        for (unsigned int j = 1; j < candidates.size(); j++)
+            if (candidates[j].cost < candidates[best].cost)
+                best = j;
+
+        accepted.push_back(candidates[best]);
+        candidates.erase(candidates.begin() + best);
+    }
+
+    for (unsigned int i = 0; i < accepted.size(); i++)
+    {
+        IPAddressVector path;
+        for (unsigned int j = 0; j < accepted[i].nodes.size(); j++)
+            path.push_back(tedGraph.nodes[accepted[i].nodes[j]]);
+        result.push_back(path);
+    }
+    return result;
+}
+
+IPAddressVector TED::calculateDisjointPath(const IPAddressVector& primary,
+            double req_bandwidth, int priority, bool nodeDisjoint)
+{
+    IPAddressVector result;
+
+    if (primary.size() < 2)
+        return result;
+
+    cspf_class_t& cspfClass = getCSPFClass(req_bandwidth, priority);
+
+    std::vector<int> nodes;
+    for (unsigned int i = 0; i < primary.size(); i++)
+    {
+        graph_t::VertexIndex::iterator it = tedGraph.vertexIndex.find(primary[i]);
+        if (it == tedGraph.vertexIndex.end())
+            return result;
+        nodes.push_back(it->second);
+    }
+
+    // prune the links of the primary path (in both directions), and
+    // its intermediate nodes if requested
+    std::vector<bool> usable = cspfClass.usable;
+    for (unsigned int i = 0; i + 1 < nodes.size(); i++)
     {
-        minIndex = V[minIndex].parent;
-        result.insert(result.begin(), V[minIndex].node);
+        excludeLinks(tedGraph, usable, nodes[i], nodes[i + 1]);
+        excludeLinks(tedGraph, usable, nodes[i + 1], nodes[i]);
     }
+    if (nodeDisjoint)
+        for (unsigned int i = 1; i + 1 < nodes.size(); i++)
+            excludeVertex(tedGraph, usable, nodes[i]);
+
+    std::vector<vertex_t> vertices;
+    std::vector<int> parentLink;
+    int target = nodes.back();
+    runDijkstra(tedGraph, usable, nodes.front(), target, vertices, parentLink);
+    if (vertices[target].dist >= LS_INFINITY)
+        return result;
+
+    for (int i = target; i != -1; i = vertices[i].parent)
+        result.push_back(vertices[i].node);
+    std::reverse(result.begin(), result.end());
 
     return result;
 }
@@ -210,22 +588,23 @@ void TED::rebuildRoutingTable()
 {
     EV << "rebuilding routing table at " << routerId << endl;
 
+    // the routing table is rebuilt after changes to ted[] that may not
+    // have been announced (yet), so check all links against the cache
+    for (unsigned int i = 0; i < ted.size(); i++)
+        linkChanged(i);
+
     std::vector<vertex_t> V = calculateShortestPaths(ted, 0.0, 7);
 
+    // apply all changes in one batch
+    rt->beginUpdate();
+
     // remove all routing entries, except multicast ones (we don't care about them)
     int n = rt->getNumRoutes();
-    int j = 0;
     for (int i = 0; i < n; i++)
     {
-        const IPRoute *entry = rt->getRoute(j);
-        if (entry->getHost().isMulticast())
-        {
-            ++j;
-        }
-        else
-        {
+        const IPRoute *entry = rt->getRoute(i);
+        if (!entry->getHost().isMulticast())
             rt->deleteRoute(entry);
-        }
     }
 
 //  for (unsigned int i = 0; i < V.size(); i++)
@@ -300,6 +679,8 @@ void TED::rebuildRoutingTable()
 
         rt->addRoute(entry);
     }
+
+    rt->commit();
 }
 
 IPAddress TED::getInterfaceAddrByPeerAddress(IPAddress peerIP)
@@ -335,60 +716,20 @@ bool TED::isLocalPeer(IPAddress inetAddr)
 std::vector<TED::vertex_t> TED::calculateShortestPaths(const TELinkStateInfoVector& topology,
             double req_bandwidth, int priority)
 {
-    std::vector<vertex_t> vertices;
-    std::vector<edge_t> edges;
-
-    // select edges that have enough bandwidth left, and store them into edges[].
-    // meanwhile, collect vertices in vectices[].
-    for (unsigned int i = 0; i < topology.size(); i++)
-    {
-        if (!topology[i].state)
-            continue;
-
-        if (topology[i].UnResvBandwidth[priority] < req_bandwidth)
-            continue;
-
-        edge_t edge;
-        edge.src = assignIndex(vertices, topology[i].advrouter);
-        edge.dest = assignIndex(vertices, topology[i].linkid);
-        edge.metric = topology[i].metric;
-        edges.push_back(edge);
-    }
-
-    IPAddress srcAddr = routerId;
+    if (&topology == &ted)
+        return getCSPFClass(req_bandwidth, priority).tree;
 
-    int srcIndex = assignIndex(vertices, srcAddr);
-    vertices[srcIndex].dist = 0.0;
+    // some other topology: calculate from scratch
+    graph_t graph;
+    buildGraph(topology, graph);
 
-    // FIXME comment: Dijkstra? just guessing...
-    for (unsigned int i = 1; i < vertices.size(); i++)
-    {
-        bool mod = false;
-
-        for (unsigned int j = 0; j < edges.size(); j++)
-        {
-            int src = edges[j].src;
-            int dest = edges[j].dest;
-
-            ASSERT(src >= 0);
-            ASSERT(dest >= 0);
-            ASSERT(src < (int)vertices.size());
-            ASSERT(dest < (int)vertices.size());
-            ASSERT(src != dest);
-
-            if (vertices[src].dist + edges[j].metric >= vertices[dest].dist)
-                continue;
-
-            vertices[dest].dist = vertices[src].dist + edges[j].metric;
-            vertices[dest].parent = src;
-
-            mod = true;
-        }
-
-        if (!mod)
-            break;
-    }
+    std::vector<bool> usable(topology.size());
+    for (unsigned int i = 0; i < topology.size(); i++)
+        usable[i] = isUsable(topology[i], req_bandwidth, priority);
 
+    std::vector<vertex_t> vertices;
+    std::vector<int> parentLink;
+    runDijkstra(graph, usable, graph.vertexIndex[routerId], -1, vertices, parentLink);
     return vertices;
 }
 
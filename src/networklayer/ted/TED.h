@@ -16,6 +16,9 @@
 #define __INET_TED_H
 
 #include <omnetpp.h>
+#include <list>
+#include "INETHashMap.h"
+#include "INotifiable.h"
 #include "TED_m.h"
 #include "IntServ.h"
 
@@ -31,7 +34,7 @@ class NotificationBoard;
  *
  * See NED file for more info.
  */
-class TED : public cSimpleModule
+class TED : public cSimpleModule, public INotifiable
 {
   public:
     /**
@@ -54,10 +57,45 @@ class TED : public cSimpleModule
         int src;       // index into the vertex_t[] vector
         int dest;      // index into the vertex_t[] vector
         double metric; // link cost
+        int link;      // index into the TELinkStateInfoVector
+    };
+
+    /**
+     * Only used internally, during shortest path calculation: adjacency
+     * index of the graph we build from links in TELinkStateInfoVector.
+     * It contains every link regardless of its state; links are pruned
+     * by the usable[] masks at calculation time.
+     */
+    struct graph_t
+    {
+        typedef std::tr1::unordered_map<IPAddress, int, IPAddressHash> VertexIndex;
+
+        std::vector<IPAddress> nodes;            // vertex index -> node address
+        VertexIndex vertexIndex;                 // node address -> vertex index
+        std::vector<edge_t> edges;               // one per link, same indices as the link vector
+        std::vector<std::vector<int> > outEdges; // vertex index -> outgoing edges (indices into edges[])
+    };
+
+    /**
+     * Only used internally: cached constrained shortest path tree for one
+     * (bandwidth, priority) class, over the ted[] graph.
+     */
+    struct cspf_class_t
+    {
+        double bandwidth;
+        int priority;
+        std::vector<bool> usable;    // per link: up and has enough unreserved bandwidth
+        bool valid;                  // false if tree must be recalculated
+        std::vector<vertex_t> tree;  // shortest path tree rooted at this router
+        std::vector<int> parentLink; // per vertex: link to parent in tree, or -1
     };
 
     /**
      * The link state database. (TELinkStateInfoVector is defined in TED.msg)
+     *
+     * Modules that modify entries directly must fire NF_TED_CHANGED or call
+     * linkChanged(), otherwise cached CSPF results may become stale.
+     * Appending new entries needs no notification.
      */
     TELinkStateInfoVector ted;
 
@@ -70,8 +108,8 @@ class TED : public cSimpleModule
     virtual int numInitStages() const  {return 5;}
     virtual void handleMessage(cMessage *msg);
 
-    virtual IPAddressVector calculateShortestPath(IPAddressVector dest,
-        const TELinkStateInfoVector& topology, double req_bandwidth, int priority);
+    // INotifiable
+    virtual void receiveChangeNotification(int category, const cPolymorphic *details);
 
   public:
     /** @name Public interface to the Traffic Engineering Database */
@@ -87,6 +125,42 @@ class TED : public cSimpleModule
     virtual IPAddressVector getLocalAddress();
 
     virtual void rebuildRoutingTable();
+
+    /**
+     * Must be called after ted[index] has been modified without firing
+     * NF_TED_CHANGED; invalidates the cached CSPF results that depend on it.
+     */
+    virtual void linkChanged(unsigned int index);
+    //@}
+
+    /** @name Constrained shortest path computation (CSPF) */
+    //@{
+    /**
+     * Returns the shortest path from this router to the closest of the
+     * given destinations, over links that are up and have at least
+     * req_bandwidth unreserved bandwidth at the given priority. The path
+     * is a list of nodes starting with this router; it is empty if there
+     * is no such path.
+     */
+    virtual IPAddressVector calculateShortestPath(IPAddressVector dest,
+        const TELinkStateInfoVector& topology, double req_bandwidth, int priority);
+
+    /**
+     * Returns up to k loopless paths from this router to dest in increasing
+     * order of cost (Yen's algorithm), under the same constraints as
+     * calculateShortestPath().
+     */
+    virtual std::vector<IPAddressVector> calculateKShortestPaths(IPAddress dest,
+        int k, double req_bandwidth, int priority);
+
+    /**
+     * Returns the shortest path between the endpoints of the primary path
+     * that shares no links with it in either direction (or, if nodeDisjoint
+     * is set, no intermediate nodes either), e.g. for a backup LSP. Returns
+     * an empty vector if there is no such path.
+     */
+    virtual IPAddressVector calculateDisjointPath(const IPAddressVector& primary,
+        double req_bandwidth, int priority, bool nodeDisjoint);
     //@}
 
   protected:
@@ -100,7 +174,29 @@ class TED : public cSimpleModule
   protected:
     int maxMessageId;
 
-    virtual int assignIndex(std::vector<vertex_t>& vertices, IPAddress nodeAddr);
+    graph_t tedGraph;                  // adjacency index of ted[]
+    std::list<cspf_class_t> cspfCache; // most recently used first
+
+    long numSPFRuns;
+    long numCSPFCacheHits;
+
+    static bool isUsable(const TELinkStateInfo& link, double req_bandwidth, int priority);
+
+    virtual int findOrCreateVertex(graph_t& graph, IPAddress nodeAddr);
+    virtual void buildGraph(const TELinkStateInfoVector& topology, graph_t& graph);
+
+    /**
+     * Dijkstra from src over the usable edges of the graph. If target is
+     * not -1, the calculation stops as soon as its distance is final.
+     */
+    virtual void runDijkstra(const graph_t& graph, const std::vector<bool>& usable,
+        int src, int target, std::vector<vertex_t>& vertices, std::vector<int>& parentLink);
+
+    /**
+     * Returns the CSPF class for the given constraints, with an up-to-date
+     * shortest path tree. Rebuilds the graph if links were added to ted[].
+     */
+    virtual cspf_class_t& getCSPFClass(double req_bandwidth, int priority);
 
     std::vector<vertex_t> calculateShortestPaths(const TELinkStateInfoVector& topology,
         double req_bandwidth, int priority);
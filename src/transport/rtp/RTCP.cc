@@ -227,7 +227,7 @@ void RTCP::createSocket()
 
 void RTCP::scheduleInterval(){
 
-    simtime_t intervalLength = _averagePacketSize * (simtime_t)(_participantInfos->size()) / (simtime_t)(_bandwidth * _rtcpPercentage * (_senderInfo->isSender() ? 1.0 : 0.75) / 100.0);
+    simtime_t intervalLength = _averagePacketSize * (simtime_t)(_participantMap.size()) / (simtime_t)(_bandwidth * _rtcpPercentage * (_senderInfo->isSender() ? 1.0 : 0.75) / 100.0);
 
     // interval length must be at least 5 seconds
     if (intervalLength < 5.0)
@@ -254,7 +254,7 @@ void RTCP::chooseSSRC(){
     } while (ssrcConflict);
     ev << "chooseSSRC" << ssrc;
     _senderInfo->setSSRC(ssrc);
-    _participantInfos->add(_senderInfo);
+    addParticipantInfo(_senderInfo);
     _ssrcChosen = true;
 }
 
@@ -277,24 +277,22 @@ void RTCP::createPacket()
     reportPacket->setSSRC(_senderInfo->getSSRC());
 
 
-    // insert receiver reports for packets from other sources
-    for (int i = 0; i < _participantInfos->size(); i++) {
-
-        if (_participantInfos->exist(i)) {
-            RTPParticipantInfo *participantInfo = (RTPParticipantInfo *)(_participantInfos->get(i));
-            if (participantInfo->getSSRC() != _senderInfo->getSSRC()) {
-                ReceptionReport *report = ((RTPReceiverInfo *)participantInfo)->receptionReport(simTime());
-                if (report != NULL) {
-                    reportPacket->addReceptionReport(report);
-                }
+    // insert receiver reports for packets from other sources; advance
+    // the iterator first, as the participant may get deleted
+    for (ParticipantMap::iterator it = _participantMap.begin(); it != _participantMap.end(); ) {
+        RTPParticipantInfo *participantInfo = it->second;
+        ++it;
+        if (participantInfo->getSSRC() != _senderInfo->getSSRC()) {
+            ReceptionReport *report = ((RTPReceiverInfo *)participantInfo)->receptionReport(simTime());
+            if (report != NULL) {
+                reportPacket->addReceptionReport(report);
             }
-            participantInfo->nextInterval(simTime());
+        }
+        participantInfo->nextInterval(simTime());
 
-            if (participantInfo->toBeDeleted(simTime())) {
-                _participantInfos->remove(participantInfo);
-                delete participantInfo;
-                // perhaps inform the profile
-            }
+        if (participantInfo->toBeDeleted(simTime())) {
+            deleteParticipantInfo(participantInfo);
+            // perhaps inform the profile
         }
     }
     // insert source description items (at least common name)
@@ -350,7 +348,7 @@ void RTCP::processIncomingRTPPacket(RTPPacket *packet, IPAddress address, int po
         participantInfo = new RTPParticipantInfo(ssrc);
         participantInfo->setAddress(address);
         participantInfo->setRTPPort(port);
-        _participantInfos->add(participantInfo);
+        addParticipantInfo(participantInfo);
     }
     else {
         // check for ssrc conflict
@@ -389,7 +387,7 @@ void RTCP::processIncomingRTCPPacket(RTCPCompoundPacket *packet, IPAddress addre
                     participantInfo = new RTPReceiverInfo(ssrc);
                     participantInfo->setAddress(address);
                     participantInfo->setRTCPPort(port);
-                    _participantInfos->add(participantInfo);
+                    addParticipantInfo(participantInfo);
                 }
                 else {
                     if (participantInfo->getAddress() == address) {
@@ -431,7 +429,7 @@ void RTCP::processIncomingRTCPPacket(RTCPCompoundPacket *packet, IPAddress addre
                     participantInfo = new RTPReceiverInfo(ssrc);
                     participantInfo->setAddress(address);
                     participantInfo->setRTCPPort(port);
-                    _participantInfos->add(participantInfo);
+                    addParticipantInfo(participantInfo);
                 }
                 else {
                     if (participantInfo->getAddress() == address) {
@@ -481,7 +479,7 @@ void RTCP::processIncomingRTCPPacket(RTCPCompoundPacket *packet, IPAddress addre
                             participantInfo = new RTPReceiverInfo(ssrc);
                             participantInfo->setAddress(address);
                             participantInfo->setRTCPPort(port);
-                            _participantInfos->add(participantInfo);
+                            addParticipantInfo(participantInfo);
                         }
                         else {
                             // check for ssrc conflict
@@ -498,9 +496,7 @@ void RTCP::processIncomingRTCPPacket(RTCPCompoundPacket *packet, IPAddress addre
                 RTPParticipantInfo *participantInfo = findParticipantInfo(ssrc);
 
                 if (participantInfo != NULL && participantInfo != _senderInfo) {
-                    _participantInfos->remove(participantInfo);
-
-                    delete participantInfo;
+                    deleteParticipantInfo(participantInfo);
                     // perhaps it would be useful to inform
                     // the profile to remove the corresponding
                     // receiver module
@@ -518,14 +514,25 @@ void RTCP::processIncomingRTCPPacket(RTCPCompoundPacket *packet, IPAddress addre
 
 RTPParticipantInfo *RTCP::findParticipantInfo(uint32 ssrc)
 {
-    char *ssrcString = RTPParticipantInfo::ssrcToName(ssrc);
-    int participantIndex = _participantInfos->find(ssrcString);
-    if (participantIndex != -1) {
-        return (RTPParticipantInfo *)(_participantInfos->get(participantIndex));
-    }
-    else {
-        return NULL;
-    }
+    ParticipantMap::iterator it = _participantMap.find(ssrc);
+    return it != _participantMap.end() ? it->second : NULL;
+}
+
+
+void RTCP::addParticipantInfo(RTPParticipantInfo *participantInfo)
+{
+    uint32 ssrc = participantInfo->getSSRC();
+    ASSERT(_participantMap.find(ssrc) == _participantMap.end());
+    _participantMap[ssrc] = participantInfo;
+    _participantInfos->add(participantInfo);
+}
+
+
+void RTCP::deleteParticipantInfo(RTPParticipantInfo *participantInfo)
+{
+    _participantMap.erase(participantInfo->getSSRC());
+    _participantInfos->remove(participantInfo);
+    delete participantInfo;
 }
 
 
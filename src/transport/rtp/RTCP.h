@@ -22,6 +22,7 @@
 #ifndef __INET_RTCPENDSYSTEMMODULE_H
 #define __INET_RTCPENDSYSTEMMODULE_H
 
+#include <map>
 #include "INETDefs.h"
 #include "IPAddress.h"
 #include "RTPInnerPacket.h"
@@ -149,10 +150,19 @@ class INET_API RTCP : public cSimpleModule
 
         /**
          * Information about all known rtp end system participating in
-         * this rtp session.
+         * this rtp session. Owns the RTPParticipantInfo objects, but it is
+         * only kept for inspection; lookups and iteration use
+         * _participantMap.
          */
         cArray *_participantInfos;
 
+        /**
+         * The known participants, keyed by ssrc. An ordered map, so that
+         * reports list the participants in a deterministic order.
+         */
+        typedef std::map<uint32, RTPParticipantInfo *> ParticipantMap;
+        ParticipantMap _participantMap;
+
         /**
          * The server socket for receiving rtcp packets.
          */
@@ -224,6 +234,16 @@ class INET_API RTCP : public cSimpleModule
          */
         virtual RTPParticipantInfo* findParticipantInfo(uint32 ssrc);
 
+        /**
+         * Stores the RTPParticipantInfo object, which must not be known yet.
+         */
+        virtual void addParticipantInfo(RTPParticipantInfo *participantInfo);
+
+        /**
+         * Forgets and deletes the RTPParticipantInfo object.
+         */
+        virtual void deleteParticipantInfo(RTPParticipantInfo *participantInfo);
+
         /**
          * Recalculates the average size of an RTCPCompoundPacket when
          * one of this size has been sent or received.
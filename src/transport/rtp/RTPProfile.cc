@@ -278,21 +278,17 @@ void RTPProfile::processOutgoingPacket(RTPInnerPacket *rinp)
 
 RTPProfile::SSRCGate *RTPProfile::findSSRCGate(uint32 ssrc)
 {
-    const char *name = RTPParticipantInfo::ssrcToName(ssrc);
-    int objectIndex = _ssrcGates->find(name);
-    if (objectIndex == -1) {
-        return NULL;
-    }
-    else {
-        cObject *co = (_ssrcGates->get(objectIndex));
-        return (SSRCGate *)co;
-    }
+    SSRCGateMap::iterator it = _ssrcGateMap.find(ssrc);
+    return it != _ssrcGateMap.end() ? it->second : NULL;
 }
 
 
 RTPProfile::SSRCGate *RTPProfile::newSSRCGate(uint32 ssrc)
 {
     SSRCGate *ssrcGate = new SSRCGate(ssrc);
+    char *name = RTPParticipantInfo::ssrcToName(ssrc);
+    ssrcGate->setName(name);
+    delete [] name;
     bool assigned = false;
     int receiverGateId = findGate("payloadReceiverOut",0);
     for (int i = receiverGateId; i < receiverGateId + _maxReceivers && !assigned; i++) {
@@ -306,6 +302,7 @@ RTPProfile::SSRCGate *RTPProfile::newSSRCGate(uint32 ssrc)
         opp_error("Can't manage more senders");
 
     _ssrcGates->add(ssrcGate);
+    _ssrcGateMap[ssrc] = ssrcGate;
     return ssrcGate;
 }
 
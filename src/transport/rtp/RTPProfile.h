@@ -23,6 +23,7 @@
 #define __INET_RTPPROFILE_H
 
 #include "INETDefs.h"
+#include "INETHashMap.h"
 #include "RTPInnerPacket.h"
 
 
@@ -185,10 +186,17 @@ class INET_API RTPProfile : public cSimpleModule
 
         /**
          * Stores information to which gate rtp data packets
-         * from a ssrc must be forwarded.
+         * from a ssrc must be forwarded. Owns the SSRCGate objects, but it
+         * is only kept for inspection; lookups use _ssrcGateMap.
          */
         cArray *_ssrcGates;
 
+        /**
+         * The SSRCGate objects in _ssrcGates, keyed by ssrc.
+         */
+        typedef std::tr1::unordered_map<uint32, SSRCGate *> SSRCGateMap;
+        SSRCGateMap _ssrcGateMap;
+
         /**
          * The percentage of the available bandwidth to be used for rtcp.
          */
@@ -19,6 +19,7 @@
 //
 
 
+#include <algorithm> // std::min
 #include "TCPDump.h"
 #include "IPControlInfo_m.h"
 #include "SCTPMessage.h"
@@ -31,8 +32,6 @@
 #include <netinet/in.h>  // htonl, ntohl, ...
 #endif
 
-#define MAXBUFLENGTH 65536
-
 TCPDumper::TCPDumper(std::ostream& out)
 {
      outp = &out;
@@ -628,9 +627,6 @@ void TCPDump::handleMessage(cMessage *msg)
 
     if (tcpdump.dumpfile!=NULL && dynamic_cast<IPDatagram *>(msg))
     {
-        uint8 buf[MAXBUFLENGTH];
-        memset((void*)&buf, 0, sizeof(buf));
-
         const simtime_t stime = simulation.getSimTime();
         // Write PCap header
 
@@ -644,13 +640,20 @@ void TCPDump::handleMessage(cMessage *msg)
         // IP header:
         //struct sockaddr_in *to = (struct sockaddr_in*) malloc(sizeof(struct sockaddr_in));
         //int32 tosize = sizeof(struct sockaddr_in);
-        int32 serialized_ip = IPSerializer().serialize(ipPacket, buf, sizeof(buf));
-        ph.incl_len = serialized_ip + sizeof(uint32);
+        // if the packet doesn't fit into snaplen, the payload would be cut
+        // anyway: only serialize the headers
+        int32 serialized_ip;
+        if (ipPacket->getByteLength() + sizeof(uint32) > snaplen)
+            serialized_ip = IPSerializer().serializeHeaders(ipPacket, buffer, sizeof(buffer));
+        else
+            serialized_ip = IPSerializer().serialize(ipPacket, buffer, sizeof(buffer));
+        uint32 orig_len = ntohs(((uint16 *)buffer)[1]) + sizeof(uint32);  // total length from the IP header
+        ph.incl_len = std::min((uint32)(serialized_ip + sizeof(uint32)), (uint32)snaplen);
 
-        ph.orig_len = ph.incl_len;
+        ph.orig_len = orig_len;
         fwrite(&ph, sizeof(ph), 1, tcpdump.dumpfile);
         fwrite(&hdr, sizeof(uint32), 1, tcpdump.dumpfile);
-        fwrite(buf, serialized_ip, 1, tcpdump.dumpfile);
+        fwrite(buffer, ph.incl_len - sizeof(uint32), 1, tcpdump.dumpfile);
     }
 
 
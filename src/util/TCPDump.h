@@ -31,6 +31,7 @@
 
 #define PCAP_MAGIC           0xa1b2c3d4
 #define RBUFFER_SIZE 65535
+#define MAXBUFLENGTH 65536
 
 /* "libpcap" file header (minus magic number). */
 struct pcap_hdr {
@@ -103,6 +104,7 @@ class INET_API TCPDump : public cSimpleModule
         TCPDumper tcpdump;
         unsigned int snaplen;
         unsigned long first, last, space;
+        uint8 buffer[MAXBUFLENGTH];  // for serializing packets into the dump file
 
     public:
 
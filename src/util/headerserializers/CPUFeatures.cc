@@ -0,0 +1,78 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "CPUFeatures.h"
+
+#ifdef INET_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+bool CPUFeatures::detected = false;
+bool CPUFeatures::sse2 = false;
+bool CPUFeatures::sse42 = false;
+bool CPUFeatures::avx2 = false;
+
+#ifdef INET_X86
+static void cpuid(unsigned int leaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+    __cpuidex((int *)regs, leaf, 0);
+#else
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// returns the OS-enabled register state components (XCR0)
+static unsigned long long xgetbv0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+void CPUFeatures::detect()
+{
+#ifdef INET_X86
+    unsigned int regs[4];  // eax, ebx, ecx, edx
+    cpuid(0, regs);
+    unsigned int maxLeaf = regs[0];
+
+    cpuid(1, regs);
+    sse2 = (regs[3] & (1<<26)) != 0;
+    sse42 = (regs[2] & (1<<20)) != 0;
+
+    // AVX2 also needs the OS to save YMM registers on context switches
+    bool osxsave = (regs[2] & (1<<27)) != 0;
+    bool avx = (regs[2] & (1<<28)) != 0;
+    if (maxLeaf >= 7 && osxsave && avx && (xgetbv0() & 6) == 6)
+    {
+        cpuid(7, regs);
+        avx2 = (regs[1] & (1<<5)) != 0;
+    }
+#endif
+    detected = true;
+}
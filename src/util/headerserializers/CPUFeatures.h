@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_CPUFEATURES_H
+#define __INET_CPUFEATURES_H
+
+// INET_X86: x86 or x86-64 target, where SSE2/AVX2/SSE4.2 kernels can be compiled
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define INET_X86
+#endif
+
+// INET_TARGET(x): lets a function use instructions of the given instruction
+// set, regardless of compiler flags. MSVC doesn't need it.
+#if defined(INET_X86) && defined(__clang__)
+#define INET_TARGET(x)  __attribute__((target(x)))
+#elif defined(INET_X86) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define INET_TARGET(x)  __attribute__((target(x)))
+#elif defined(INET_X86) && defined(_MSC_VER) && _MSC_VER >= 1700
+#define INET_TARGET(x)
+#else
+#undef INET_X86  // compiler can't build the kernels
+#endif
+
+/**
+ * Run-time detection of CPU features used by the checksum kernels
+ * (TCPIPchecksum, CRC32c). The CPU is queried once, on first use.
+ * All functions return false on non-x86 platforms.
+ */
+class CPUFeatures
+{
+  protected:
+    static bool detected;
+    static bool sse2;
+    static bool sse42;
+    static bool avx2;
+
+    static void detect();
+
+  public:
+    static bool hasSSE2()  {if (!detected) detect(); return sse2;}
+    static bool hasSSE42() {if (!detected) detect(); return sse42;}
+    static bool hasAVX2()  {if (!detected) detect(); return avx2;}
+};
+
+#endif
@@ -0,0 +1,144 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <string.h>
+#include "CRC32c.h"
+#include "CPUFeatures.h"
+
+#ifdef INET_X86
+#include <nmmintrin.h>
+#endif
+
+#define CRC32C_POLY 0x82F63B78  /* Castagnoli polynomial, reflected */
+
+CRC32c::Kernel CRC32c::kernel = CRC32c::KERNEL_AUTO;
+uint32_t (*CRC32c::updateKernel)(uint32_t crc, const uint8_t *buf, unsigned int len) = NULL;
+
+// slice-by-8 tables: table[0] is the usual byte-at-a-time table,
+// table[k][i] is the CRC of byte i followed by k zero bytes
+static uint32_t table[8][256];
+static bool tableInitialized = false;
+
+static void initTable()
+{
+    for (int i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        table[0][i] = crc;
+    }
+    for (int i = 0; i < 256; i++)
+        for (int k = 1; k < 8; k++)
+            table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xFF];
+    tableInitialized = true;
+}
+
+static uint32_t updateSliceBy8(uint32_t crc, const uint8_t *p, unsigned int len)
+{
+    // bytes are assembled explicitly, so this works on any byte order
+    while (len >= 8)
+    {
+        uint32_t lo = crc ^ (p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+        uint32_t hi = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t)p[7] << 24);
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^
+              table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^
+              table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+
+    while (len--)
+        crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xFF];
+
+    return crc;
+}
+
+#ifdef INET_X86
+INET_TARGET("sse4.2")
+static uint32_t updateSSE42(uint32_t crc, const uint8_t *p, unsigned int len)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    while (len >= 8)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        crc = (uint32_t)_mm_crc32_u64(crc, v);
+        p += 8;
+        len -= 8;
+    }
+#else
+    while (len >= 4)
+    {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        crc = _mm_crc32_u32(crc, v);
+        p += 4;
+        len -= 4;
+    }
+#endif
+
+    while (len--)
+        crc = _mm_crc32_u8(crc, *p++);
+
+    return crc;
+}
+#endif
+
+bool CRC32c::selectKernel(Kernel k)
+{
+    if (k == KERNEL_AUTO)
+        return selectKernel(KERNEL_SSE42) || selectKernel(KERNEL_SLICE_BY_8);
+
+    uint32_t (*f)(uint32_t, const uint8_t *, unsigned int) = NULL;
+    switch (k)
+    {
+        case KERNEL_SLICE_BY_8:
+            if (!tableInitialized)
+                initTable();
+            f = updateSliceBy8;
+            break;
+#ifdef INET_X86
+        case KERNEL_SSE42: if (CPUFeatures::hasSSE42()) f = updateSSE42; break;
+#endif
+        default: break;
+    }
+    if (!f)
+        return false;
+    updateKernel = f;
+    kernel = k;
+    return true;
+}
+
+const char *CRC32c::getKernelName(Kernel k)
+{
+    switch (k)
+    {
+        case KERNEL_AUTO: return "auto";
+        case KERNEL_SLICE_BY_8: return "slice-by-8";
+        case KERNEL_SSE42: return "SSE4.2";
+        default: return "?";
+    }
+}
+
+uint32_t CRC32c::update(uint32_t crc, const void *buf, unsigned int len)
+{
+    if (!updateKernel)
+        selectKernel(KERNEL_AUTO);
+    return updateKernel(crc, (const uint8_t *)buf, len);
+}
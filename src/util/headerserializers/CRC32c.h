@@ -0,0 +1,74 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_CRC32C_H
+#define __INET_CRC32C_H
+
+#include "headers/defs.h"
+
+/**
+ * CRC32c (Castagnoli), as used by SCTP (RFC 3309, RFC 4960 Appendix B).
+ *
+ * Computed with the SSE4.2 CRC32 instruction if the CPU supports it,
+ * otherwise with the slice-by-8 table algorithm, which processes 8 bytes
+ * per step instead of one. The kernel is selected at the first call; it
+ * can also be selected explicitly, for testing and benchmarking.
+ */
+class CRC32c
+{
+  public:
+    enum Kernel {KERNEL_AUTO, KERNEL_SLICE_BY_8, KERNEL_SSE42};
+
+  protected:
+    static Kernel kernel;
+    static uint32_t (*updateKernel)(uint32_t crc, const uint8_t *buf, unsigned int len);
+
+  public:
+    /**
+     * Returns the CRC32c of the buffer. The result is in host byte order;
+     * in SCTP, it is transmitted least significant byte first.
+     */
+    static uint32_t compute(const void *buf, unsigned int len) {
+        return ~update(0xFFFFFFFF, buf, len);
+    }
+
+    /**
+     * Continues the CRC computation with the given bytes. crc is the value
+     * returned by the previous update() call, or 0xFFFFFFFF initially;
+     * the final CRC is the bitwise complement of the last value.
+     */
+    static uint32_t update(uint32_t crc, const void *buf, unsigned int len);
+
+    /**
+     * Selects the kernel; KERNEL_AUTO selects the fastest one supported
+     * by the CPU. Returns false (and changes nothing) if the kernel is not
+     * supported on this CPU or platform.
+     */
+    static bool selectKernel(Kernel k);
+
+    /**
+     * Returns the kernel in use.
+     */
+    static Kernel getKernel() {if (!updateKernel) selectKernel(KERNEL_AUTO); return kernel;}
+
+    /**
+     * Returns the name of the given kernel, e.g. "SSE4.2".
+     */
+    static const char *getKernelName(Kernel k);
+};
+
+#endif
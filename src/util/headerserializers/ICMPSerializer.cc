@@ -25,6 +25,7 @@ namespace INETFw // load headers into a namespace, to avoid conflicts with platf
 #include "headers/ip.h"
 #include "headers/ip_icmp.h"
 };
+#include <string.h>
 #include "IPSerializer.h"
 #include "ICMPSerializer.h"
 #include "PingPayload_m.h"
@@ -43,6 +44,10 @@ int ICMPSerializer::serialize(const ICMPMessage *pkt, unsigned char *buf, unsign
     struct icmp *icmp = (struct icmp *) (buf);
     int packetLength;
 
+    if (bufsize < ICMP_MINLEN)
+        opp_error("ICMPSerializer: buffer too small (%u bytes) for the ICMP header", bufsize);
+    memset(buf, 0, ICMP_MINLEN); // the buffer may be reused: clear checksum and unused fields
+
     packetLength = ICMP_MINLEN;
 
     switch(pkt->getType())
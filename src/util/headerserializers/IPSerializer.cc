@@ -17,6 +17,7 @@
 //
 
 #include <algorithm> // std::min
+#include <string.h>
 #include <platdep/sockets.h>
 #include "headers/defs.h"
 
@@ -33,6 +34,7 @@ namespace INETFw // load headers into a namespace, to avoid conflicts with platf
 #include "UDPSerializer.h"
 #include "SCTPSerializer.h"    //I.R.
 #include "TCPSerializer.h"    //I.R.
+#include "TCPIPchecksum.h"
 
 #if defined(_MSC_VER)
 #undef s_addr   /* MSVC #definition interferes with us */
@@ -55,10 +57,23 @@ using namespace INETFw;
 
 
 int IPSerializer::serialize(const IPDatagram *dgram, unsigned char *buf, unsigned int bufsize)
+{
+    return serialize(dgram, buf, bufsize, false);
+}
+
+int IPSerializer::serializeHeaders(const IPDatagram *dgram, unsigned char *buf, unsigned int bufsize)
+{
+    return serialize(dgram, buf, bufsize, true);
+}
+
+int IPSerializer::serialize(const IPDatagram *dgram, unsigned char *buf, unsigned int bufsize, bool headersOnly)
 {
     int packetLength;
     struct ip *ip = (struct ip *) buf;
 
+    if (bufsize < (unsigned int)IP_HEADER_BYTES)
+        opp_error("IPSerializer: buffer too small (%u bytes) for the IP header", bufsize);
+
     ip->ip_hl         = IP_HEADER_BYTES >> 2;
     ip->ip_v          = dgram->getVersion();
     ip->ip_tos        = dgram->getDiffServCodePoint();
@@ -73,35 +88,74 @@ int IPSerializer::serialize(const IPDatagram *dgram, unsigned char *buf, unsigne
     if (dgram->getHeaderLength() > IP_HEADER_BYTES)
         EV << "Serializing an IP packet with options. Dropping the options.\n";
 
-    packetLength = IP_HEADER_BYTES;
+    unsigned char *payload = buf+IP_HEADER_BYTES;
+    unsigned int payloadsize = bufsize-IP_HEADER_BYTES;
+    int transportLength = 0, writtenLength = 0;
 
     cMessage *encapPacket = dgram->getEncapsulatedPacket();
     switch (dgram->getTransportProtocol())
     {
       case IP_PROT_ICMP:
-        packetLength += ICMPSerializer().serialize(check_and_cast<ICMPMessage *>(encapPacket),
-                                                   buf+IP_HEADER_BYTES, bufsize-IP_HEADER_BYTES);
+        transportLength = writtenLength = ICMPSerializer().serialize(check_and_cast<ICMPMessage *>(encapPacket),
+                                                   payload, payloadsize);
         break;
       case IP_PROT_UDP:
-        packetLength += UDPSerializer().serialize(check_and_cast<UDPPacket *>(encapPacket),
-                                                   buf+IP_HEADER_BYTES, bufsize-IP_HEADER_BYTES);
+        if (headersOnly)
+        {
+            UDPPacket *udpPacket = check_and_cast<UDPPacket *>(encapPacket);
+            writtenLength = UDPSerializer().serializeHeader(udpPacket, payload, payloadsize);
+            transportLength = udpPacket->getByteLength();
+        }
+        else
+            transportLength = writtenLength = UDPSerializer().serialize(check_and_cast<UDPPacket *>(encapPacket),
+                                                   payload, payloadsize);
         break;
-      case IP_PROT_SCTP:    //I.R.
-        packetLength += SCTPSerializer().serialize(check_and_cast<SCTPMessage *>(encapPacket),
-                                                   buf+IP_HEADER_BYTES, bufsize-IP_HEADER_BYTES);
+      case IP_PROT_SCTP: {  //I.R.
+        // SCTPSerializer relies on a cleared buffer (padding, checksum field)
+        SCTPMessage *sctpMsg = check_and_cast<SCTPMessage *>(encapPacket);
+        memset(payload, 0, std::min((unsigned int)sctpMsg->getByteLength(), payloadsize));
+        transportLength = writtenLength = SCTPSerializer().serialize(sctpMsg, payload, payloadsize);
         break;
+      }
       case IP_PROT_TCP:        //I.R.
-        packetLength += TCPSerializer().serialize(check_and_cast<TCPSegment *>(encapPacket),
-                                                   buf+IP_HEADER_BYTES, bufsize-IP_HEADER_BYTES,
+        if (headersOnly)
+        {
+            TCPSegment *tcpseg = check_and_cast<TCPSegment *>(encapPacket);
+            writtenLength = TCPSerializer().serializeHeader(tcpseg, payload, payloadsize,
+                                                   dgram->getSrcAddress(), dgram->getDestAddress());
+            transportLength = tcpseg->getByteLength();
+        }
+        else
+            transportLength = writtenLength = TCPSerializer().serialize(check_and_cast<TCPSegment *>(encapPacket),
+                                                   payload, payloadsize,
                                                    dgram->getSrcAddress(), dgram->getDestAddress());
         break;
       default:
         opp_error("IPSerializer: cannot serialize protocol %d", dgram->getTransportProtocol());
     }
 
+    packetLength = IP_HEADER_BYTES + transportLength;
+    writtenLength += IP_HEADER_BYTES;
+
     ip->ip_len = htons(packetLength);
+    ip->ip_sum = TCPIPchecksum::checksum(buf, IP_HEADER_BYTES);
+
+    return writtenLength;
+}
+
+int IPSerializer::decrementTimeToLive(unsigned char *buf)
+{
+    struct ip *ip = (struct ip *) buf;
+    ASSERT(ip->ip_ttl > 0);
+
+    // TTL and protocol form one 16-bit word of the header
+    uint16_t oldWord, newWord;
+    memcpy(&oldWord, &ip->ip_ttl, 2);
+    ip->ip_ttl--;
+    memcpy(&newWord, &ip->ip_ttl, 2);
+    ip->ip_sum = TCPIPchecksum::adjust(ip->ip_sum, oldWord, newWord);
 
-    return packetLength;
+    return ip->ip_ttl;
 }
 
 void IPSerializer::parse(const unsigned char *buf, unsigned int bufsize, IPDatagram *dest)
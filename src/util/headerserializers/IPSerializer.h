@@ -31,17 +31,38 @@ class IPSerializer
 
         /**
          * Serializes an IPDatagram for transmission on the wire.
-         * The checksum is NOT filled in. (The kernel does that when sending
-         * the frame over a raw socket.)
+         * The header checksum is filled in, so decrementTimeToLive() can be
+         * used on the result. The buffer need not be cleared beforehand,
+         * and can be reused for several packets.
          * Returns the length of data written into buffer.
          */
         int serialize(const IPDatagram *dgram, unsigned char *buf, unsigned int bufsize);
 
+        /**
+         * Like serialize(), but the dummy payload of TCP segments and UDP
+         * packets is not written, only the headers; the length fields and
+         * checksums are the same as with serialize(). ICMP and SCTP packets
+         * are serialized completely.
+         * Returns the length of data written into buffer; the length of
+         * the whole datagram is in the IP header.
+         */
+        int serializeHeaders(const IPDatagram *dgram, unsigned char *buf, unsigned int bufsize);
+
+        /**
+         * Decrements the TTL in a serialized IP header, and updates the header
+         * checksum incrementally (RFC 1624) instead of recomputing it. The TTL
+         * must be positive. Returns the new TTL.
+         */
+        static int decrementTimeToLive(unsigned char *buf);
+
         /**
          * Puts a packet sniffed from the wire into an IPDatagram. Does NOT
          * verify the checksum.
          */
         void parse(const unsigned char *buf, unsigned int bufsize, IPDatagram *dest);
+
+    protected:
+        int serialize(const IPDatagram *dgram, unsigned char *buf, unsigned int bufsize, bool headersOnly);
 };
 
 #endif
@@ -22,23 +22,204 @@
 #include <netinet/in.h>  // htonl, ntohl, ...
 #endif
 
-uint16_t TCPIPchecksum::_checksum(const void *addr, unsigned int count)
+#include <string.h>
+#include "CPUFeatures.h"
+
+#ifdef INET_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+TCPIPchecksum::Kernel TCPIPchecksum::kernel = TCPIPchecksum::KERNEL_AUTO;
+uint64_t (*TCPIPchecksum::sumKernel)(const uint8_t *addr, unsigned int count) = NULL;
+
+//
+// The kernels return the one's complement sum of the buffer's 16-bit words
+// in native byte order, unfolded. Adding 32-bit (or wider) words instead of
+// 16-bit ones gives the same result after folding, because 2^16 = 1 modulo
+// 2^16-1. Buffers need not be aligned.
+//
+
+static uint64_t sumPortable(const uint8_t *p, unsigned int count)
 {
-    uint32_t sum = 0;
+    uint64_t sum = 0;
+
+    while (count >= 8)
+    {
+        uint32_t w[2];
+        memcpy(w, p, 8);
+        sum += w[0];
+        sum += w[1];
+        p += 8;
+        count -= 8;
+    }
 
     while (count > 1)
     {
-        sum += *((const uint16_t *&)addr)++;
-        if (sum & 0x80000000)
-            sum = (sum & 0xFFFF) + (sum >> 16);
+        uint16_t w;
+        memcpy(&w, p, 2);
+        sum += w;
+        p += 2;
         count -= 2;
     }
 
     if (count)
-        sum += *(const uint8_t *)addr;
+    {
+        // last octet is padded on the right with zero
+        uint8_t last[2] = {*p, 0};
+        uint16_t w;
+        memcpy(&w, last, 2);
+        sum += w;
+    }
+
+    return sum;
+}
+
+#ifdef INET_X86
+INET_TARGET("sse2")
+static uint64_t sumSSE2(const uint8_t *p, unsigned int count)
+{
+    uint64_t sum = 0;
+    const __m128i zero = _mm_setzero_si128();
+
+    while (count >= 16)
+    {
+        // each 32-bit lane gets two 16-bit words per iteration, so it can
+        // take 32768 iterations before it could overflow
+        unsigned int n = count / 16;
+        if (n > 32768)
+            n = 32768;
+        count -= n * 16;
+
+        __m128i acc = zero;
+        for (; n > 0; n--)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)p);
+            acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+            acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+            p += 16;
+        }
+
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, acc);
+        sum += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    return sum + sumPortable(p, count);
+}
+
+INET_TARGET("avx2")
+static uint64_t sumAVX2(const uint8_t *p, unsigned int count)
+{
+    uint64_t sum = 0;
+    const __m256i zero = _mm256_setzero_si256();
+
+    while (count >= 32)
+    {
+        // see sumSSE2()
+        unsigned int n = count / 32;
+        if (n > 32768)
+            n = 32768;
+        count -= n * 32;
+
+        __m256i acc = zero;
+        for (; n > 0; n--)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i *)p);
+            acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+            acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+            p += 32;
+        }
+
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, acc);
+        for (int i = 0; i < 8; i++)
+            sum += lanes[i];
+    }
+
+    return sum + sumPortable(p, count);
+}
+#endif
 
+bool TCPIPchecksum::selectKernel(Kernel k)
+{
+    if (k == KERNEL_AUTO)
+    {
+        if (selectKernel(KERNEL_AVX2) || selectKernel(KERNEL_SSE2))
+            return true;
+        return selectKernel(KERNEL_PORTABLE);
+    }
+
+    uint64_t (*f)(const uint8_t *, unsigned int) = NULL;
+    switch (k)
+    {
+        case KERNEL_PORTABLE: f = sumPortable; break;
+#ifdef INET_X86
+        case KERNEL_SSE2: if (CPUFeatures::hasSSE2()) f = sumSSE2; break;
+        case KERNEL_AVX2: if (CPUFeatures::hasAVX2()) f = sumAVX2; break;
+#endif
+        default: break;
+    }
+    if (!f)
+        return false;
+    sumKernel = f;
+    kernel = k;
+    return true;
+}
+
+const char *TCPIPchecksum::getKernelName(Kernel k)
+{
+    switch (k)
+    {
+        case KERNEL_AUTO: return "auto";
+        case KERNEL_PORTABLE: return "portable";
+        case KERNEL_SSE2: return "SSE2";
+        case KERNEL_AVX2: return "AVX2";
+        default: return "?";
+    }
+}
+
+uint16_t TCPIPchecksum::_checksum(const void *addr, unsigned int count)
+{
+    if (!sumKernel)
+        selectKernel(KERNEL_AUTO);
+
+    uint64_t sum = sumKernel((const uint8_t *)addr, count);
+
+    // fold into 16 bits
     while (sum >> 16)
         sum = (sum & 0xFFFF) + (sum >> 16);
 
     return (uint16_t)sum;
 }
+
+uint16_t TCPIPchecksum::_fillChecksum(uint8_t byte, unsigned int count)
+{
+    uint8_t pair[2] = {byte, byte};
+    uint8_t last[2] = {byte, 0};
+    uint16_t w, lastw;
+    memcpy(&w, pair, 2);
+    memcpy(&lastw, last, 2);
+
+    uint64_t sum = (uint64_t)w * (count / 2);
+    if (count & 1)
+        sum += lastw;
+
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+
+    return (uint16_t)sum;
+}
+
+uint16_t TCPIPchecksum::adjust(uint16_t checksum, uint16_t oldWord, uint16_t newWord)
+{
+    // RFC 1624, eqn. 3: HC' = ~(~HC + ~m + m')
+    uint32_t sum = (uint16_t)~checksum;
+    sum += (uint16_t)~oldWord;
+    sum += newWord;
+
+    while (sum >> 16)
+        sum = (sum & 0xFFFF) + (sum >> 16);
+
+    return (uint16_t)~sum;
+}
@@ -30,9 +30,21 @@
 
 /**
  * Calculates checksum.
+ *
+ * The one's complement sum is computed by the fastest kernel the CPU
+ * supports (AVX2, SSE2, or portable code that adds 32-bit words into
+ * a 64-bit accumulator), selected at the first call. The kernel can also
+ * be selected explicitly, for testing and benchmarking.
  */
 class TCPIPchecksum
 {
+    public:
+        enum Kernel {KERNEL_AUTO, KERNEL_PORTABLE, KERNEL_SSE2, KERNEL_AVX2};
+
+    protected:
+        static Kernel kernel;
+        static uint64_t (*sumKernel)(const uint8_t *addr, unsigned int count);
+
     public:
         TCPIPchecksum() {}
 
@@ -49,6 +61,39 @@ class TCPIPchecksum
         }
 
         static uint16_t _checksum(const void *addr, unsigned int count);
+
+        /**
+         * Returns the (folded, not complemented) one's complement sum of
+         * count octets of the given value, starting at an even offset.
+         * Used for computing checksums over payloads that are not actually
+         * written into the buffer.
+         */
+        static uint16_t _fillChecksum(uint8_t byte, unsigned int count);
+
+        /**
+         * Incremental update of a checksum (RFC 1624) when a 16-bit word
+         * covered by it changes from oldWord to newWord. The words must be
+         * read from the buffer as they are (network byte order), like the
+         * checksum itself.
+         */
+        static uint16_t adjust(uint16_t checksum, uint16_t oldWord, uint16_t newWord);
+
+        /**
+         * Selects the kernel used by _checksum(); KERNEL_AUTO selects the
+         * fastest one supported by the CPU. Returns false (and changes
+         * nothing) if the kernel is not supported on this CPU or platform.
+         */
+        static bool selectKernel(Kernel k);
+
+        /**
+         * Returns the kernel in use.
+         */
+        static Kernel getKernel() {if (!sumKernel) selectKernel(KERNEL_AUTO); return kernel;}
+
+        /**
+         * Returns the name of the given kernel, e.g. "SSE2".
+         */
+        static const char *getKernelName(Kernel k);
 };
 
 #endif
@@ -40,15 +40,18 @@ namespace INETFw // load headers into a namespace, to avoid conflicts with platf
 
 using namespace INETFw;
 
-int TCPSerializer::serialize(const TCPSegment *tcpseg,
+int TCPSerializer::serializeHeader(const TCPSegment *tcpseg,
         unsigned char *buf, unsigned int bufsize)
 {
     ASSERT(buf);
     ASSERT(tcpseg);
-    //cMessage* cmsg;
+    if (bufsize < TCP_HEADER_OCTETS)
+        opp_error("TCPSerializer: buffer too small (%u bytes) for the TCP header", bufsize);
+
+    // the buffer may be reused and contain garbage: clear the fixed part
+    // of the header (reserved bits); options and padding are written below
+    memset(buf, 0, TCP_HEADER_OCTETS);
     struct tcphdr *tcp = (struct tcphdr*) (buf);
-    //int writtenbytes = sizeof(struct tcphdr)+tcpseg->payloadLength();
-    int writtenbytes = tcpseg->getByteLength();
 
     // fill TCP header structure
     tcp->th_sum = 0;
@@ -82,6 +85,8 @@ int TCPSerializer::serialize(const TCPSegment *tcpseg,
     if (numOptions > 0) // options present?
     {
         unsigned int maxOptLength = tcpseg->getHeaderLength()-TCP_HEADER_OCTETS;
+        if (TCP_HEADER_OCTETS + maxOptLength > bufsize)
+            opp_error("TCPSerializer: buffer too small (%u bytes) for the TCP header", bufsize);
 
         for (unsigned short i=0; i < numOptions; i++)
         {
@@ -120,25 +125,25 @@ int TCPSerializer::serialize(const TCPSegment *tcpseg,
         tcp->th_offs = (TCP_HEADER_OCTETS+lengthCounter)/4; // TCP_HEADER_OCTETS = 20
     } // if options present
 
+    return TCP_HEADER_OCTETS+lengthCounter;
+}
+
+int TCPSerializer::serialize(const TCPSegment *tcpseg,
+        unsigned char *buf, unsigned int bufsize)
+{
+    //int writtenbytes = sizeof(struct tcphdr)+tcpseg->payloadLength();
+    int writtenbytes = tcpseg->getByteLength();
+    int headerbytes = serializeHeader(tcpseg, buf, bufsize);
+
     // write data
-    if (tcpseg->getByteLength() > tcpseg->getHeaderLength()) // data present? FIXME TODO: || tcpseg->getEncapsulatedPacket()!=NULL
+    unsigned int dataLength = getDummyDataLength(tcpseg);
+    if (dataLength > 0) // data present? FIXME TODO: || tcpseg->getEncapsulatedPacket()!=NULL
     {
-        unsigned int dataLength = tcpseg->getByteLength() - tcpseg->getHeaderLength();
+        if (headerbytes + dataLength > bufsize)
+            opp_error("TCPSerializer: buffer too small (%u bytes) for a %d-byte TCP segment", bufsize, writtenbytes);
         // TCPPayloadMessage *tcpP = check_and_cast<TCPPayloadMessage* >(tcpseg->getEncapsulatedPacket()); // FIXME
-        char *tcpData = (char *)options+lengthCounter;
-        memset(tcpData, 't', dataLength); // fill data part with 't'
-        /*
-        for (unsigned int i=0; i < dataLength; i++)
-        {
-            if (i < tcpseg->getPayloadArraySize())
-            {
-//              tcpData[i] = (unsigned char) tcpP.msg; // FIXME
-                tcpData[i] = 't'; // FIXME - write 't' as dummy data
-            }
-            else
-                {tcpData[i] = 't';} // write 't' as dummy data
-        }
-        */
+        char *tcpData = (char *)buf+headerbytes;
+        memset(tcpData, DUMMY_DATA, dataLength); // fill data part with 't'
     }
     return writtenbytes;
 }
@@ -154,6 +159,26 @@ int TCPSerializer::serialize(const TCPSegment *tcpseg,
     return writtenbytes;
 }
 
+int TCPSerializer::serializeHeader(const TCPSegment *tcpseg,
+        unsigned char *buf, unsigned int bufsize,
+        const IPvXAddress &srcIp, const IPvXAddress &destIp)
+{
+    int headerbytes = serializeHeader(tcpseg, buf, bufsize);
+
+    // the checksum covers the data that serialize() would write
+    uint32_t sum = TCPIPchecksum::_checksum(buf, headerbytes);
+    sum += TCPIPchecksum::_fillChecksum(DUMMY_DATA, getDummyDataLength(tcpseg));
+    struct tcphdr *tcp = (struct tcphdr*) (buf);
+    tcp->th_sum = finishChecksum(sum, tcpseg->getByteLength(), srcIp, destIp);
+
+    return headerbytes;
+}
+
+unsigned int TCPSerializer::getDummyDataLength(const TCPSegment *tcpseg)
+{
+    return tcpseg->getByteLength() > tcpseg->getHeaderLength() ? tcpseg->getByteLength() - tcpseg->getHeaderLength() : 0;
+}
+
 void TCPSerializer::parse(const unsigned char *buf, unsigned int bufsize, TCPSegment *tcpseg)
 {
     ASSERT(buf);
@@ -241,8 +266,12 @@ void TCPSerializer::parse(const unsigned char *buf, unsigned int bufsize, TCPSeg
 uint16_t TCPSerializer::checksum(const void *addr, unsigned int count,
         const IPvXAddress &srcIp, const IPvXAddress &destIp)
 {
-    uint32_t sum = TCPIPchecksum::_checksum(addr, count);
+    return finishChecksum(TCPIPchecksum::_checksum(addr, count), count, srcIp, destIp);
+}
 
+uint16_t TCPSerializer::finishChecksum(uint32_t sum, unsigned int count,
+        const IPvXAddress &srcIp, const IPvXAddress &destIp)
+{
     ASSERT(srcIp.wordCount() == destIp.wordCount());
 
     //sum += srcip;
@@ -33,6 +33,10 @@
  */
 class TCPSerializer
 {
+    public:
+        /** Byte used for the data part of segments (data is not modelled) */
+        static const unsigned char DUMMY_DATA = 't';
+
     public:
         TCPSerializer() {}
 
@@ -55,6 +59,23 @@ class TCPSerializer
         int serialize(const TCPSegment *source, unsigned char *destbuf, unsigned int bufsize,
                 const IPvXAddress &srcIp, const IPvXAddress &destIp);
 
+        /**
+         * Serializes only the header (with options) of a TCPSegment; the data
+         * part is not written. The buffer need not be cleared beforehand.
+         * The checksum is NOT filled in.
+         * Returns the length of the header.
+         */
+        int serializeHeader(const TCPSegment *source, unsigned char *destbuf, unsigned int bufsize);
+
+        /**
+         * Like serializeHeader(), but also fills in the checksum, computed as
+         * if the data part written by serialize() were present. This gives
+         * the same header as serialize(), without writing and summing the data.
+         * Returns the length of the header.
+         */
+        int serializeHeader(const TCPSegment *source, unsigned char *destbuf, unsigned int bufsize,
+                const IPvXAddress &srcIp, const IPvXAddress &destIp);
+
         /**
          * Puts a packet sniffed from the wire into a TCPSegment.
          * TODO dest why not reference?
@@ -66,6 +87,17 @@ class TCPSerializer
          */
         static uint16_t checksum(const void *addr, unsigned int count,
                 const IPvXAddress &srcIp, const IPvXAddress &destIp);
+
+    protected:
+        /**
+         * Adds the pseudo header to a one's complement sum of count bytes
+         * of TCP header and data, and returns the checksum.
+         */
+        static uint16_t finishChecksum(uint32_t sum, unsigned int count,
+                const IPvXAddress &srcIp, const IPvXAddress &destIp);
+
+        /** Length of the data part of the segment */
+        static unsigned int getDummyDataLength(const TCPSegment *tcpseg);
 };
 
 #endif
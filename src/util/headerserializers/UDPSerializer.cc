@@ -25,6 +25,7 @@ namespace INETFw // load headers into a namespace, to avoid conflicts with platf
 #include "headers/udp.h"
 };
 
+#include <string.h>
 #include "UDPSerializer.h"
 
 #include "TCPIPchecksum.h"
@@ -38,16 +39,29 @@ using namespace INETFw;
 
 
 int UDPSerializer::serialize(const UDPPacket *pkt, unsigned char *buf, unsigned int bufsize)
+{
+    int packetLength = pkt->getByteLength();
+    if ((unsigned int)packetLength > bufsize)
+        opp_error("UDPSerializer: buffer too small (%u bytes) for a %d-byte UDP packet", bufsize, packetLength);
+
+    // payload is not modelled, it is all zeroes, and it does not change the checksum
+    int headerLength = serializeHeader(pkt, buf, bufsize);
+    memset(buf + headerLength, 0, packetLength - headerLength);
+    return packetLength;
+}
+
+int UDPSerializer::serializeHeader(const UDPPacket *pkt, unsigned char *buf, unsigned int bufsize)
 {
     struct udphdr *udphdr = (struct udphdr *) (buf);
-    int packetLength;
+    if (bufsize < sizeof(struct udphdr))
+        opp_error("UDPSerializer: buffer too small (%u bytes) for the UDP header", bufsize);
 
-    packetLength = pkt->getByteLength();
     udphdr->uh_sport = htons(pkt->getSourcePort());
     udphdr->uh_dport = htons(pkt->getDestinationPort());
-    udphdr->uh_ulen  = htons(packetLength);
-    udphdr->uh_sum   = TCPIPchecksum::checksum(buf, packetLength);
-    return packetLength;
+    udphdr->uh_ulen  = htons(pkt->getByteLength());
+    udphdr->uh_sum   = 0;
+    udphdr->uh_sum   = TCPIPchecksum::checksum(buf, sizeof(struct udphdr));
+    return sizeof(struct udphdr);
 }
 
 void UDPSerializer::parse(const unsigned char *buf, unsigned int bufsize, UDPPacket *dest)
@@ -36,6 +36,13 @@ class UDPSerializer
          */
         int serialize(const UDPPacket *pkt, unsigned char *buf, unsigned int bufsize);
 
+        /**
+         * Serializes only the header of an UDPPacket; the (all-zero) payload
+         * is not written. The checksum is the same as with serialize().
+         * Returns the length of the header.
+         */
+        int serializeHeader(const UDPPacket *pkt, unsigned char *buf, unsigned int bufsize);
+
         /**
          * Puts a packet sniffed from the wire into an UDPPacket.
          */
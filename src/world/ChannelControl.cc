@@ -27,7 +27,9 @@ Define_Module(ChannelControl);
 
 std::ostream& operator<<(std::ostream& os, const ChannelControl::HostEntry& h)
 {
-    os << h.host->getFullPath() << " (x=" << h.pos.x << ",y=" << h.pos.y << "), "
+    // with lazy mobility, h.pos is the last reported position
+    const Coord& pos = h.mobility ? h.mobility->getCurrentPosition() : h.pos;
+    os << h.host->getFullPath() << " (x=" << pos.x << ",y=" << pos.y << "), "
        << h.neighbors.size() << " neighbor(s)";
     return os;
 }
@@ -149,6 +151,8 @@ ChannelControl::HostRef ChannelControl::registerHost(cModule *host, const Coord&
     he.host = host;
     he.radioInGate = radioInGate;
     he.pos = initialPos;
+    he.mobility = NULL;
+    he.maxDrift = 0;
     he.isNeighborListValid = false;
     he.channel = 0;  // for now
     hosts.push_back(he);
@@ -189,7 +193,15 @@ void ChannelControl::updateConnections(HostRef h)
 
         // get the distance between the two hosts.
         // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
-        bool inRange = hpos.sqrdist(hi->pos) < maxDistSquared;
+        bool inRange;
+        if (h->maxDrift == 0 && hi->maxDrift == 0)
+            inRange = hpos.sqrdist(hi->pos) < maxDistSquared;
+        else
+        {
+            // the hosts may have moved since they reported their positions
+            double maxDist = maxInterferenceDistance + h->maxDrift + hi->maxDrift;
+            inRange = hpos.sqrdist(hi->pos) < maxDist * maxDist;
+        }
 
         if (inRange)
         {
@@ -225,6 +237,16 @@ void ChannelControl::updateHostPosition(HostRef h, const Coord& pos)
     updateConnections(h);
 }
 
+void ChannelControl::registerLazyMobility(HostRef h, ILazyMobility *mobility, double maxDrift)
+{
+    Enter_Method_Silent();
+    if (maxDrift <= 0)
+        error("registerLazyMobility(): maxDrift must be positive");
+    h->mobility = mobility;
+    h->maxDrift = maxDrift;
+    updateConnections(h);
+}
+
 void ChannelControl::updateHostChannel(HostRef h, const int channel)
 {
     Enter_Method_Silent();
@@ -295,15 +317,26 @@ void ChannelControl::sendToChannel(cSimpleModule *srcRadioMod, HostRef srcHost,
     const HostRefVector& neighbors = getNeighbors(srcHost);
     int n = neighbors.size();
     int channel = airFrame->getChannelNumber();
+    const Coord& srcPos = getHostPosition(srcHost);
     for (int i=0; i<n; i++)
     {
         HostRef h = neighbors[i];
         if (h->channel == channel)
         {
+            double distance = srcPos.distance(getHostPosition(h));
+
+            // with lazy mobility, the neighbor list also contains hosts
+            // that may have been in range since the last position updates
+            if ((srcHost->mobility || h->mobility) && distance >= maxInterferenceDistance)
+            {
+                coreEV << "skipping host out of range\n";
+                continue;
+            }
+
             coreEV << "sending message to host listening on the same channel\n";
             // account for propagation delay, based on distance in meters
             // Over 300m, dt=1us=10 bit times @ 10Mbps
-            simtime_t delay = srcHost->pos.distance(h->pos) / LIGHT_SPEED;
+            simtime_t delay = distance / LIGHT_SPEED;
             srcRadioMod->sendDirect(airFrame->dup(), delay, airFrame->getDuration(), h->radioInGate);
         }
         else
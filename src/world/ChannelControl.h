@@ -24,6 +24,7 @@
 #include <omnetpp.h>
 #include "AirFrame_m.h"
 #include "Coord.h"
+#include "ILazyMobility.h"
 
 #define LIGHT_SPEED 3.0E+8
 #define TRANSMISSION_PURGE_INTERVAL 1.0
@@ -57,6 +58,8 @@ class INET_API ChannelControl : public cSimpleModule
         cGate *radioInGate;
         int channel;
         Coord pos; // cached
+        ILazyMobility *mobility; // if not NULL, pos is only updated every maxDrift meters
+        double maxDrift; // max distance between pos and the actual position
         std::set<HostRef> neighbors;  // cached neighbour list
 
         // we cache neighbors set in an std::vector, because std::set iteration is slow;
@@ -134,6 +137,16 @@ class INET_API ChannelControl : public cSimpleModule
     /** @brief To be called when the host moved; updates proximity info */
     virtual void updateHostPosition(HostRef h, const Coord& pos);
 
+    /**
+     * @brief For mobility models that update the position lazily: from now on
+     * the host position is asked from the mobility model, and the host is only
+     * guaranteed to call updateHostPosition() when it has got maxDrift meters
+     * away from the last reported position. Hosts this close to the
+     * interference distance are kept in the neighbor lists, and sendToChannel()
+     * checks the actual distance.
+     */
+    virtual void registerLazyMobility(HostRef h, ILazyMobility *mobility, double maxDrift);
+
     /** @brief Called when host switches channel */
     virtual void updateHostChannel(HostRef h, const int channel);
 
@@ -143,8 +156,8 @@ class INET_API ChannelControl : public cSimpleModule
     /** @brief Notifies the channel control with an ongoing transmission */
     virtual void addOngoingTransmission(HostRef h, AirFrame *frame);
 
-    /** @brief Returns the host's position */
-    const Coord& getHostPosition(HostRef h)  {return h->pos;}
+    /** @brief Returns the host's position; for lazy mobility, the one calculated for the current time */
+    const Coord& getHostPosition(HostRef h)  {return h->mobility ? h->mobility->getCurrentPosition() : h->pos;}
 
     /** @brief Get the list of modules in range of the given host */
     const HostRefVector& getNeighbors(HostRef h);
@@ -0,0 +1,48 @@
+//
+// Copyright (C) 2011 Andras Varga
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef __INET_ILAZYMOBILITY_H
+#define __INET_ILAZYMOBILITY_H
+
+#include <omnetpp.h>
+#include "Coord.h"
+
+
+/**
+ * Mobility models that only calculate the host position when somebody
+ * asks for it implement this interface, and register themselves with
+ * ChannelControl::registerLazyMobility(). ChannelControl then asks the
+ * mobility model for the position of the host, instead of returning the
+ * last position reported via ChannelControl::updateHostPosition().
+ *
+ * @see ChannelControl, BasicMobility
+ */
+class INET_API ILazyMobility
+{
+  public:
+    virtual ~ILazyMobility() {}
+
+    /**
+     * Returns the position of the host at the current simulation time.
+     * The reference is valid until the simulation time advances.
+     */
+    virtual const Coord& getCurrentPosition() = 0;
+};
+
+#endif
+
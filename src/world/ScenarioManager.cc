@@ -15,19 +15,32 @@
 // along with this program; if not, see <http://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
 #include "ScenarioManager.h"
 
 Define_Module(ScenarioManager);
 
 
+ScenarioManager::~ScenarioManager()
+{
+    cancelAndDelete(nextBatchMsg);
+    for (CommandVector::iterator it = commands.begin(); it != commands.end(); ++it)
+    {
+        delete it->modulePattern;
+        delete it->gatePattern;
+    }
+}
+
 void ScenarioManager::initialize()
 {
     cXMLElement *script = par("script");
 
     numChanges = numDone = 0;
+    modulePathsLastModuleId = 0;
     WATCH(numChanges);
     WATCH(numDone);
 
+    // compile the script into a command vector sorted by time
     for (cXMLElement *node=script->getFirstChild(); node; node = node->getNextSibling())
     {
         // check attr t is present
@@ -35,47 +48,101 @@ void ScenarioManager::initialize()
         if (!tAttr)
             error("attribute 't' missing at %s", node->getSourceLocation());
 
-        // schedule self-message
-        simtime_t t = STR_SIMTIME(tAttr);
-        cMessage *msg = new cMessage("scenario-event");
-        msg->setContextPointer(node);
-        scheduleAt(t, msg);
-
-        // count it
-        numChanges++;
+        compileCommand(node, STR_SIMTIME(tAttr));
     }
+    // stable sort: commands with the same time stay in script order
+    std::stable_sort(commands.begin(), commands.end());
+    numChanges = commands.size();
 
-    updateDisplayString();
-}
-
-void ScenarioManager::handleMessage(cMessage *msg)
-{
-    cXMLElement *node = (cXMLElement *) msg->getContextPointer();
-    delete msg;
-
-    processCommand(node);
+    // commands are carried out in batches, one event per distinct time
+    nextCommand = 0;
+    nextBatchMsg = new cMessage("scenario-event");
+    scheduleNextBatch();
 
-    numDone++;
     updateDisplayString();
 }
 
-void ScenarioManager::processCommand(cXMLElement *node)
+void ScenarioManager::compileCommand(cXMLElement *node, simtime_t t)
 {
     const char *tag = node->getTagName();
-    EV << "processing <" << tag << "> command...\n";
 
     if (!strcmp(tag,"at"))
-        processAtCommand(node);
-    else if (!strcmp(tag,"set-param"))
-        processSetParamCommand(node);
+    {
+        for (cXMLElement *child=node->getFirstChild(); child; child=child->getNextSibling())
+            compileCommand(child, t);
+        return;
+    }
+
+    Command cmd;
+    cmd.t = t;
+    cmd.node = node;
+    cmd.moduleId = -1;
+    cmd.modulePattern = NULL;
+    cmd.gatePattern = NULL;
+    cmd.matchedLastModuleId = -1;
+
+    if (!strcmp(tag,"set-param"))
+    {
+        cmd.code = SET_PARAM;
+        const char *moduleAttr = getRequiredAttribute(node, "module");
+        if (isPattern(moduleAttr))
+            cmd.modulePattern = createPatternMatcher(moduleAttr, true);
+    }
     else if (!strcmp(tag,"set-channel-attr"))
-        processSetChannelAttrCommand(node);
+    {
+        cmd.code = SET_CHANNEL_ATTR;
+        const char *moduleAttr = getRequiredAttribute(node, "src-module");
+        const char *gateAttr = getRequiredAttribute(node, "src-gate");
+        if (isPattern(moduleAttr))
+            cmd.modulePattern = createPatternMatcher(moduleAttr, true);
+        if (isPattern(gateAttr))
+            cmd.gatePattern = createPatternMatcher(gateAttr, false);
+    }
     // else if (!strcmp(tag,"create-module"))
     //    processCreateModuleCommand(node);
     // else if (!strcmp(tag,"connect"))
     //    processConnectCommand(node);
     else
-        processModuleSpecificCommand(node);
+    {
+        cmd.code = MODULE_SPECIFIC;
+        getRequiredAttribute(node, "module");
+    }
+    commands.push_back(cmd);
+}
+
+void ScenarioManager::scheduleNextBatch()
+{
+    if (nextCommand < commands.size())
+        scheduleAt(commands[nextCommand].t, nextBatchMsg);
+}
+
+void ScenarioManager::handleMessage(cMessage *msg)
+{
+    ASSERT(msg == nextBatchMsg);
+
+    // carry out all commands due now
+    simtime_t now = simTime();
+    while (nextCommand < commands.size() && commands[nextCommand].t == now)
+    {
+        processCommand(commands[nextCommand++]);
+        numDone++;
+    }
+    scheduleNextBatch();
+
+    updateDisplayString();
+}
+
+void ScenarioManager::processCommand(Command& cmd)
+{
+    EV << "processing <" << cmd.node->getTagName() << "> command...\n";
+
+    switch (cmd.code)
+    {
+        case SET_PARAM: processSetParamCommand(cmd); break;
+        case SET_CHANNEL_ATTR: processSetChannelAttrCommand(cmd); break;
+        case MODULE_SPECIFIC: processModuleSpecificCommand(cmd); break;
+        default: error("unknown command code %d", cmd.code);
+    }
 }
 
 // helper function
@@ -96,6 +163,24 @@ static bool parseIndexedName(const char *s, std::string& name, int& index)
     }
 }
 
+// helper function
+static cGate *findGate(cModule *mod, const char *gateStr)
+{
+    std::string gname;
+    int gindex;
+    return parseIndexedName(gateStr, gname, gindex) ? mod->gate(gname.c_str(), gindex) : mod->gate(gname.c_str());
+}
+
+bool ScenarioManager::isPattern(const char *s)
+{
+    return strpbrk(s, "*?{") != NULL;
+}
+
+cPatternMatcher *ScenarioManager::createPatternMatcher(const char *pattern, bool dottedPath)
+{
+    return new cPatternMatcher(pattern, dottedPath, true, true);
+}
+
 const char *ScenarioManager::getRequiredAttribute(cXMLElement *node, const char *attr)
 {
     const char *s = node->getAttribute(attr);
@@ -114,47 +199,143 @@ cModule *ScenarioManager::getRequiredModule(cXMLElement *node, const char *attr)
     return mod;
 }
 
+cModule *ScenarioManager::getRequiredModule(Command& cmd, const char *attr)
+{
+    // the module is looked up by path only the first time, and whenever
+    // it has been deleted since (e.g. replaced by FailureManager)
+    cModule *mod = cmd.moduleId == -1 ? NULL : simulation.getModule(cmd.moduleId);
+    if (!mod)
+    {
+        mod = getRequiredModule(cmd.node, attr);
+        cmd.moduleId = mod->getId();
+    }
+    return mod;
+}
+
 cGate *ScenarioManager::getRequiredGate(cXMLElement *node, const char *modAttr, const char *gateAttr)
 {
     cModule *mod = getRequiredModule(node, modAttr);
     const char *gateStr = getRequiredAttribute(node, gateAttr);
-    std::string gname;
-    int gindex;
-    cGate *g = parseIndexedName(gateStr, gname, gindex) ? mod->gate(gname.c_str(), gindex) : mod->gate(gname.c_str());
+    cGate *g = findGate(mod, gateStr);
     if (!g)
         error("module '%s' has no gate '%s' at %s", mod->getFullPath().c_str(), gateStr, node->getSourceLocation());
     return g;
 }
 
-void ScenarioManager::processAtCommand(cXMLElement *node)
+cGate *ScenarioManager::getRequiredGate(Command& cmd, const char *modAttr, const char *gateAttr)
 {
-    for (cXMLElement *child=node->getFirstChild(); child; child=child->getNextSibling())
-        processCommand(child);
+    cModule *mod = getRequiredModule(cmd, modAttr);
+    const char *gateStr = getRequiredAttribute(cmd.node, gateAttr);
+    cGate *g = findGate(mod, gateStr);
+    if (!g)
+        error("module '%s' has no gate '%s' at %s", mod->getFullPath().c_str(), gateStr, cmd.node->getSourceLocation());
+    return g;
+}
+
+void ScenarioManager::getMatchingModules(Command& cmd, std::vector<cModule *>& result)
+{
+    result.clear();
+    if (!cmd.modulePattern)
+    {
+        result.push_back(getRequiredModule(cmd, "module"));
+        return;
+    }
+
+    // the modules matched when the command was first carried out are reused,
+    // unless one of them has been deleted or new modules have been created since
+    bool stale = cmd.matchedLastModuleId != simulation.getLastModuleId();
+    for (unsigned int i = 0; i < cmd.matchedModuleIds.size() && !stale; i++)
+    {
+        cModule *mod = simulation.getModule(cmd.matchedModuleIds[i]);
+        if (!mod)
+            stale = true;
+        else
+            result.push_back(mod);
+    }
+    if (!stale)
+        return;
+
+    resolveMatchingModules(cmd);
+    result.clear();
+    for (unsigned int i = 0; i < cmd.matchedModuleIds.size(); i++)
+        result.push_back(simulation.getModule(cmd.matchedModuleIds[i]));
 }
 
-void ScenarioManager::processModuleSpecificCommand(cXMLElement *node)
+void ScenarioManager::resolveMatchingModules(Command& cmd)
+{
+    updateModulePaths();
+
+    cmd.matchedModuleIds.clear();
+    for (unsigned int i = 0; i < modulePaths.size(); i++)
+        if (simulation.getModule(modulePaths[i].first) && cmd.modulePattern->matches(modulePaths[i].second.c_str()))
+            cmd.matchedModuleIds.push_back(modulePaths[i].first);
+    cmd.matchedLastModuleId = simulation.getLastModuleId();
+}
+
+void ScenarioManager::updateModulePaths()
+{
+    // Like module paths in the script, module patterns don't contain the
+    // network name. Only modules created since the last update are added.
+    std::string prefix = std::string(simulation.getSystemModule()->getFullName()) + ".";
+    for (int id = modulePathsLastModuleId + 1; id <= simulation.getLastModuleId(); id++)
+    {
+        cModule *mod = simulation.getModule(id);
+        if (!mod || mod == simulation.getSystemModule())
+            continue;
+        std::string path = mod->getFullPath();
+        if (path.compare(0, prefix.size(), prefix) == 0)
+            path.erase(0, prefix.size());
+        modulePaths.push_back(std::make_pair(id, path));
+    }
+    modulePathsLastModuleId = simulation.getLastModuleId();
+}
+
+void ScenarioManager::processModuleSpecificCommand(Command& cmd)
 {
     // find which module we'll need to invoke
-    cModule *mod = getRequiredModule(node, "module");
+    cModule *mod = getRequiredModule(cmd, "module");
 
     // see if it supports the IScriptable interface
     IScriptable *scriptable = dynamic_cast<IScriptable *>(mod);
     if (!scriptable)
         error("<%s> not understood: it is not a built-in command of %s, and module class %s "
               "is not scriptable (does not subclass from IScriptable) at %s",
-              node->getTagName(), getClassName(), mod->getClassName(), node->getSourceLocation());
+              cmd.node->getTagName(), getClassName(), mod->getClassName(), cmd.node->getSourceLocation());
 
     // ok, trust it to process this command
-    scriptable->processCommand(*node);
+    scriptable->processCommand(*cmd.node);
 }
 
-void ScenarioManager::processSetParamCommand(cXMLElement *node)
+void ScenarioManager::processSetParamCommand(Command& cmd)
 {
     // process <set-param> command
-    cModule *mod = getRequiredModule(node, "module");
-    const char *parAttr = getRequiredAttribute(node, "par");
-    const char *valueAttr = getRequiredAttribute(node, "value");
+    const char *parAttr = getRequiredAttribute(cmd.node, "par");
+    const char *valueAttr = getRequiredAttribute(cmd.node, "value");
+
+    if (!cmd.modulePattern)
+    {
+        setParam(getRequiredModule(cmd, "module"), parAttr, valueAttr);
+        return;
+    }
+
+    // bulk version: all modules matching the pattern
+    std::vector<cModule *> modules;
+    getMatchingModules(cmd, modules);
+    int numSet = 0;
+    for (unsigned int i = 0; i < modules.size(); i++)
+    {
+        if (modules[i]->hasPar(parAttr))
+        {
+            setParam(modules[i], parAttr, valueAttr);
+            numSet++;
+        }
+    }
+    EV << "Set " << parAttr << " = " << valueAttr << " in " << numSet << " modules matching "
+       << cmd.node->getAttribute("module") << "\n";
+}
 
+void ScenarioManager::setParam(cModule *mod, const char *parAttr, const char *valueAttr)
+{
     EV << "Setting " << mod->getFullPath() << "." << parAttr << " = " << valueAttr << "\n";
     bubble((std::string("setting: ")+mod->getFullPath()+"."+parAttr+" = "+valueAttr).c_str());
 
@@ -163,13 +344,46 @@ void ScenarioManager::processSetParamCommand(cXMLElement *node)
     param.parse(valueAttr);
 }
 
-void ScenarioManager::processSetChannelAttrCommand(cXMLElement *node)
+void ScenarioManager::processSetChannelAttrCommand(Command& cmd)
 {
     // process <set-channel-attr> command
-    cGate *g = getRequiredGate(node, "src-module", "src-gate");
-    const char *attrAttr = getRequiredAttribute(node, "attr");
-    const char *valueAttr = getRequiredAttribute(node, "value");
+    const char *attrAttr = getRequiredAttribute(cmd.node, "attr");
+    const char *valueAttr = getRequiredAttribute(cmd.node, "value");
+
+    if (!cmd.modulePattern && !cmd.gatePattern)
+    {
+        setChannelAttr(getRequiredGate(cmd, "src-module", "src-gate"), cmd.node, attrAttr, valueAttr);
+        return;
+    }
 
+    // bulk version: channels of all connected output gates that match the
+    // gate pattern, in all modules that match the module pattern
+    const char *gateAttr = cmd.node->getAttribute("src-gate");
+    std::vector<cModule *> modules;
+    if (cmd.modulePattern)
+        getMatchingModules(cmd, modules);
+    else
+        modules.push_back(getRequiredModule(cmd, "src-module"));
+    int numChannels = 0;
+    for (unsigned int i = 0; i < modules.size(); i++)
+    {
+        for (cModule::GateIterator it(modules[i]); !it.end(); it++)
+        {
+            cGate *g = it();
+            if (g->getType() != cGate::OUTPUT || !g->getChannel())
+                continue;
+            if (cmd.gatePattern ? cmd.gatePattern->matches(g->getFullName()) : !strcmp(g->getFullName(), gateAttr))
+            {
+                setChannelAttr(g, cmd.node, attrAttr, valueAttr);
+                numChannels++;
+            }
+        }
+    }
+    EV << "Set channel attribute " << attrAttr << " = " << valueAttr << " on " << numChannels << " channels\n";
+}
+
+void ScenarioManager::setChannelAttr(cGate *g, cXMLElement *node, const char *attrAttr, const char *valueAttr)
+{
     EV << "Setting channel attribute: " << attrAttr << " = " << valueAttr
        << " of gate " << g->getFullPath() << "\n";
     bubble((std::string("setting channel attr: ")+attrAttr+" = "+valueAttr).c_str());
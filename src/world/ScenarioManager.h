@@ -18,6 +18,7 @@
 #ifndef SCENARIOMANAGER_H
 #define SCENARIOMANAGER_H
 
+#include <vector>
 #include <omnetpp.h>
 #include "INETDefs.h"
 #include "IScriptable.h"
@@ -30,6 +31,9 @@
  * the IScriptable interface. The \<at> built-in command can be used to
  * group commands to be carried out at the same simulation time.
  *
+ * The script is compiled at initialization into a vector of commands sorted
+ * by time, and commands with the same time are carried out in one event.
+ *
  * See NED file for details.
  *
  * @see IScriptable
@@ -38,6 +42,34 @@
 class INET_API ScenarioManager : public cSimpleModule
 {
   protected:
+    enum CommandCode {SET_PARAM, SET_CHANNEL_ATTR, MODULE_SPECIFIC};
+
+    // a compiled command of the script
+    struct Command
+    {
+        simtime_t t;
+        CommandCode code;
+        cXMLElement *node;                // the command element, for attributes and error messages
+        int moduleId;                     // module of the "module" attribute, once looked up; or -1
+        cPatternMatcher *modulePattern;   // for commands on all modules matching a pattern; or NULL
+        cPatternMatcher *gatePattern;     // for set-channel-attr on all gates matching a pattern; or NULL
+        std::vector<int> matchedModuleIds; // modules matching modulePattern, looked up when first carried out
+        int matchedLastModuleId;          // simulation.getLastModuleId() when matchedModuleIds was filled; or -1
+
+        bool operator<(const Command& other) const {return t < other.t;}
+    };
+    typedef std::vector<Command> CommandVector;
+
+    CommandVector commands;   // sorted by t
+    unsigned int nextCommand; // index of the first command not yet carried out
+    cMessage *nextBatchMsg;
+
+    // ids and paths (without the network name) of all modules, for matching
+    // module patterns; extended when modules are created, and since module
+    // ids are not reused, deleted modules are simply skipped
+    std::vector<std::pair<int, std::string> > modulePaths;
+    int modulePathsLastModuleId;
+
     // total number of changes, and number of changes already done
     int numChanges;
     int numDone;
@@ -46,23 +78,38 @@ class INET_API ScenarioManager : public cSimpleModule
     // utilities
     const char *getRequiredAttribute(cXMLElement *node, const char *attr);
     virtual cModule *getRequiredModule(cXMLElement *node, const char *attr);
+    virtual cModule *getRequiredModule(Command& cmd, const char *attr);
     virtual cGate *getRequiredGate(cXMLElement *node, const char *modattr, const char *gateattr);
+    virtual cGate *getRequiredGate(Command& cmd, const char *modattr, const char *gateattr);
+    virtual void getMatchingModules(Command& cmd, std::vector<cModule *>& result);
+    virtual void resolveMatchingModules(Command& cmd);
+    virtual void updateModulePaths();
+    static bool isPattern(const char *s);
+    static cPatternMatcher *createPatternMatcher(const char *pattern, bool dottedPath);
+
+    // compiling the script
+    virtual void compileCommand(cXMLElement *node, simtime_t t);
+    virtual void scheduleNextBatch();
 
     // dispatch to command processors
-    virtual void processCommand(cXMLElement *node);
+    virtual void processCommand(Command& cmd);
 
     // command processors
-    virtual void processAtCommand(cXMLElement *node);
-    virtual void processSetParamCommand(cXMLElement *node);
-    virtual void processSetChannelAttrCommand(cXMLElement *node);
+    virtual void processSetParamCommand(Command& cmd);
+    virtual void processSetChannelAttrCommand(Command& cmd);
     virtual void processCreateModuleCommand(cXMLElement *node);
     virtual void processDeleteModuleCommand(cXMLElement *node);
     virtual void processConnectCommand(cXMLElement *node);
     virtual void processDisconnectCommand(cXMLElement *node);
-    virtual void processModuleSpecificCommand(cXMLElement *node);
+    virtual void processModuleSpecificCommand(Command& cmd);
+
+    // helpers of the command processors
+    virtual void setParam(cModule *mod, const char *parAttr, const char *valueAttr);
+    virtual void setChannelAttr(cGate *g, cXMLElement *node, const char *attrAttr, const char *valueAttr);
 
   public:
-    ScenarioManager() {}
+    ScenarioManager() {nextBatchMsg = NULL;}
+    virtual ~ScenarioManager();
 
   protected:
     virtual void initialize();